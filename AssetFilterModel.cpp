@@ -0,0 +1,188 @@
+#include "AssetFilterModel.h"
+#include <algorithm>
+
+AssetFilterModel::AssetFilterModel(QObject* parent) : QSortFilterProxyModel(parent), m_assetModel(nullptr), m_project(nullptr), m_settingsTableValid(false), m_filterCategory(false), m_category(Opf::ObjectCategory::Other), m_onlyWithMeshes(false)
+{
+}
+
+void AssetFilterModel::setAssetModel(AssetTreeModel* model)
+{
+    m_assetModel = model;
+    setSourceModel(model);
+}
+
+void AssetFilterModel::setProject(const Opf::PackedProject* project)
+{
+    m_project = project;
+    if (project)
+    {
+        m_searchIndex.build(*project);
+    }
+    else
+    {
+        m_searchIndex.clear();
+    }
+
+    // A query stays in effect for the new project
+    m_settingsTable.clear();
+    m_settingsTableValid = false;
+    m_settingsMask.clear();
+    if (project && !m_settingsQuery.isEmpty())
+    {
+        QString query = m_settingsQuery;
+        m_settingsQuery.clear();
+        if (setSettingsQuery(query) < 0)
+        {
+            m_settingsQuery.clear();
+        }
+    }
+}
+
+int AssetFilterModel::setSettingsQuery(const QString& query, QString* error)
+{
+    QString trimmed = query.trimmed();
+    if (trimmed.isEmpty())
+    {
+        if (!m_settingsQuery.isEmpty())
+        {
+            m_settingsQuery.clear();
+            m_settingsMask.clear();
+            invalidateFilter();
+        }
+        return 0;
+    }
+
+    if (!m_project)
+    {
+        if (error) *error = "No project loaded";
+        return -1;
+    }
+
+    if (!m_settingsTableValid)
+    {
+        m_settingsTable.build(*m_project, Opf::SettingsTable::knownSettingNames());
+        m_settingsTableValid = true;
+    }
+
+    QVector<quint8> mask;
+    if (!m_settingsTable.evaluate(trimmed, mask))
+    {
+        if (error) *error = m_settingsTable.lastError();
+        return -1;
+    }
+
+    m_settingsQuery = trimmed;
+    m_settingsMask = mask;
+    invalidateFilter();
+    return int(std::count(mask.constBegin(), mask.constEnd(), quint8(1)));
+}
+
+void AssetFilterModel::updateObject(const Opf::Object* object)
+{
+    m_searchIndex.updateObject(*object);
+    if (m_settingsTableValid)
+    {
+        updateSettingsRow(*object);
+    }
+    invalidateFilter();
+}
+
+void AssetFilterModel::updateSettingsRow(const Opf::Object& object)
+{
+    // Only the object's row is read again and tested against the query
+    if (!m_settingsTable.updateObject(object))
+    {
+        invalidateSettingsTable();
+        return;
+    }
+
+    int row = m_settingsTable.rowOf(&object);
+    if (m_settingsQuery.isEmpty() || row >= m_settingsMask.size())
+    {
+        return;
+    }
+
+    bool matches = false;
+    if (!m_settingsTable.evaluateRow(m_settingsQuery, row, matches))
+    {
+        invalidateSettingsTable();
+        return;
+    }
+    m_settingsMask[row] = matches;
+}
+
+void AssetFilterModel::invalidateSettingsTable()
+{
+    m_settingsTableValid = false;
+    if (!m_project || m_settingsQuery.isEmpty()) return;
+
+    // Parsed before, but a column may have changed type since
+    QString query = m_settingsQuery;
+    if (setSettingsQuery(query) < 0)
+    {
+        m_settingsQuery.clear();
+        m_settingsMask.clear();
+        invalidateFilter();
+    }
+}
+
+void AssetFilterModel::setSearchFilter(const QString& filter)
+{
+    if (filter.toLower() == m_searchIndex.query()) return;
+
+    m_searchIndex.setQuery(filter);
+    invalidateFilter();
+}
+
+void AssetFilterModel::setCategoryFilter(const QString& category)
+{
+    Opf::ObjectCategory value = Opf::ObjectCategory::Other;
+    bool filter = category != "All" && Opf::objectCategoryFromName(category, value);
+    if (filter == m_filterCategory && value == m_category) return;
+
+    m_filterCategory = filter;
+    m_category = value;
+    invalidateFilter();
+}
+
+void AssetFilterModel::setOnlyWithMeshes(bool enabled)
+{
+    if (enabled == m_onlyWithMeshes) return;
+
+    m_onlyWithMeshes = enabled;
+    invalidateFilter();
+}
+
+bool AssetFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+{
+    if (!m_assetModel) return true;
+
+    QModelIndex index = m_assetModel->index(sourceRow, 0, sourceParent);
+    switch (m_assetModel->itemType(index))
+    {
+    case AssetTreeModel::TextureItem:
+        return m_searchIndex.textureMatches(m_assetModel->recordIndex(index));
+
+    case AssetTreeModel::MaterialItem:
+        return m_searchIndex.materialMatches(m_assetModel->recordIndex(index));
+
+    case AssetTreeModel::ObjectItem:
+    {
+        Opf::Object* obj = m_assetModel->objectAt(index);
+        if (!obj) return true;
+
+        if (!m_searchIndex.objectMatches(obj)) return false;
+        if (m_filterCategory && m_searchIndex.objectCategory(obj) != m_category) return false;
+        if (m_onlyWithMeshes && obj->meshes().isEmpty()) return false;
+        if (!m_settingsQuery.isEmpty())
+        {
+            int row = m_settingsTable.rowOf(obj);
+            return row >= 0 && row < m_settingsMask.size() && m_settingsMask[row];
+        }
+        return true;
+    }
+
+    default:
+        return true;
+    }
+}
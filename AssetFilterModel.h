@@ -0,0 +1,73 @@
+#ifndef ASSETFILTERMODEL_H
+#define ASSETFILTERMODEL_H
+
+#include <QSortFilterProxyModel>
+#include "AssetTreeModel.h"
+#include "AssetSearchIndex.h"
+#include "SettingsTable.h"
+
+// ============================================================================
+// ASSET FILTER MODEL - search, category and mesh filters over AssetTreeModel
+// ============================================================================
+//
+// A row is shown if it and all its ancestors match, so only rows under
+// visible, fetched parents are ever tested. Category and info rows always
+// match. Searches go through an AssetSearchIndex, so testing a row is a
+// lookup; setProject() rebuilds it. Settings queries (see SettingsTable)
+// filter object rows by a mask computed once per query.
+
+class AssetFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit AssetFilterModel(QObject* parent = nullptr);
+
+    void setAssetModel(AssetTreeModel* model);
+    AssetTreeModel* assetModel() const { return m_assetModel; }
+
+    // Builds the search index; call before the asset model shows 'project'.
+    // nullptr drops it.
+    void setProject(const Opf::PackedProject* project);
+
+    // Searches the object's edited settings, or the object itself if it was
+    // added to the project, from now on. Its settings table row is read
+    // again and tested against the settings query.
+    void updateObject(const Opf::Object* object);
+
+    void setSearchFilter(const QString& filter);
+    void setCategoryFilter(const QString& category);
+    void setOnlyWithMeshes(bool enabled);
+
+    // Only objects matching 'query' are shown; empty shows all. Returns the
+    // number of matching objects, or -1 with 'error' set if the query does
+    // not parse (the previous query stays in effect).
+    int setSettingsQuery(const QString& query, QString* error = nullptr);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+
+private:
+    void updateSettingsRow(const Opf::Object& object);
+
+    // The table is read again, right away if a query is in effect so that
+    // its result follows the edit
+    void invalidateSettingsTable();
+
+    AssetTreeModel* m_assetModel;
+    const Opf::PackedProject* m_project;
+    Opf::AssetSearchIndex m_searchIndex;
+
+    // Built on the first settings query
+    Opf::SettingsTable m_settingsTable;
+    bool m_settingsTableValid;
+    QString m_settingsQuery;
+    QVector<quint8> m_settingsMask;     // by SettingsTable row
+
+    // No category filter for "All"
+    bool m_filterCategory;
+    Opf::ObjectCategory m_category;
+    bool m_onlyWithMeshes;
+};
+
+#endif // ASSETFILTERMODEL_H
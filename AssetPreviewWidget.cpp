@@ -1,67 +1,16 @@
 #include "AssetPreviewWidget.h"
+#include "TextureCache.h"
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QScrollArea>
+#include <QPixmapCache>
 #include <QDebug>
 
-// ============================================================================
-// HELPER FUNCTIONS FOR RECURSIVE MESH COUNTING
-// ============================================================================
-
-namespace {
-// Helper: Count all meshes recursively (including children)
-int countAllMeshesRecursive(const Opf::Object* object)
-{
-    if (!object) return 0;
-
-    int count = object->meshes().size();
-    for (const Opf::Object* child : object->children)
-    {
-        count += countAllMeshesRecursive(child);
-    }
-    return count;
-}
-
-// Helper: Count all vertices recursively
-int countAllVerticesRecursive(const Opf::Object* object)
-{
-    if (!object) return 0;
-
-    int count = 0;
-    for (const auto& mesh : object->meshes())
-    {
-        count += mesh.vertices.size();
-    }
-    for (const Opf::Object* child : object->children)
-    {
-        count += countAllVerticesRecursive(child);
-    }
-    return count;
-}
-
-// Helper: Count all faces recursively
-int countAllFacesRecursive(const Opf::Object* object)
-{
-    if (!object) return 0;
-
-    int count = 0;
-    for (const auto& mesh : object->meshes())
-    {
-        count += mesh.indices.size() / 3;
-    }
-    for (const Opf::Object* child : object->children)
-    {
-        count += countAllFacesRecursive(child);
-    }
-    return count;
-}
-}
-
 // ============================================================================
 // CONSTRUCTOR & SETUP
 // ============================================================================
 
-AssetPreviewWidget::AssetPreviewWidget(QWidget *parent) : QWidget(parent), m_currentTexture(nullptr), m_showingAlpha(false), m_currentZoom(1.0)
+AssetPreviewWidget::AssetPreviewWidget(QWidget *parent) : QWidget(parent), m_currentObject(nullptr), m_currentTexture(nullptr), m_showingAlpha(false), m_currentZoom(1.0)
 {
     setupUI();
 }
@@ -101,12 +50,12 @@ void AssetPreviewWidget::setupUI()
 
     m_customSettingsWidget = new CustomSettingsWidget(this);
     connect(m_customSettingsWidget, &CustomSettingsWidget::settingsModified,
-            this, &AssetPreviewWidget::objectModified);
+            this, [this]() { emit objectModified(m_currentObject); });
     m_settingsTabs->addTab(m_customSettingsWidget, "All Settings");
 
     m_canBuildWidget = new CanBuildUnitWidget(this);
     connect(m_canBuildWidget, &CanBuildUnitWidget::settingsModified,
-            this, &AssetPreviewWidget::objectModified);
+            this, [this]() { emit objectModified(m_currentObject); });
     m_settingsTabs->addTab(m_canBuildWidget, "Can Build Units");
 
     settingsMainLayout->addWidget(m_settingsTabs);
@@ -188,6 +137,7 @@ void AssetPreviewWidget::setupUI()
 
 void AssetPreviewWidget::showObject(Opf::Object* object)
 {
+    m_currentObject = object;
     m_currentTexture = nullptr;
 
     // Show/hide tabs
@@ -238,18 +188,19 @@ void AssetPreviewWidget::showObject(Opf::Object* object)
     int directFaces = 0;
     for (const auto& mesh : object->meshes())
     {
-        directVertices += mesh.vertices.size();
-        directFaces += mesh.indices.size() / 3;
+        directVertices += mesh.vertexCount();
+        directFaces += mesh.indexCount / 3;
     }
 
     stats += QString("Direct Meshes: %1\n").arg(directMeshes);
     stats += QString("Direct Vertices: %1\n").arg(directVertices);
     stats += QString("Direct Faces: %1\n").arg(directFaces);
 
-    // Total including children (RECURSIVE)
-    int totalMeshes = countAllMeshesRecursive(object);
-    int totalVertices = countAllVerticesRecursive(object);
-    int totalFaces = countAllFacesRecursive(object);
+    // Total including children (cached per subtree)
+    const Opf::SubtreeStats& subtree = object->subtreeStats();
+    int totalMeshes = subtree.meshes;
+    int totalVertices = subtree.vertices;
+    int totalFaces = subtree.faces;
 
     // Only show "including children" section if there ARE children with meshes
     if (totalMeshes != directMeshes)
@@ -260,6 +211,13 @@ void AssetPreviewWidget::showObject(Opf::Object* object)
         stats += QString("Total Faces: %1\n").arg(totalFaces);
     }
 
+    if (subtree.hasBounds)
+    {
+        stats += QString("Bounds: (%1, %2, %3) - (%4, %5, %6)\n")
+                     .arg(subtree.boundsMin.x, 0, 'f', 2).arg(subtree.boundsMin.y, 0, 'f', 2).arg(subtree.boundsMin.z, 0, 'f', 2)
+                     .arg(subtree.boundsMax.x, 0, 'f', 2).arg(subtree.boundsMax.y, 0, 'f', 2).arg(subtree.boundsMax.z, 0, 'f', 2);
+    }
+
     stats += "\n";
 
     // Children details
@@ -271,7 +229,7 @@ void AssetPreviewWidget::showObject(Opf::Object* object)
             if (child)
             {
                 int childDirectMeshes = child->meshes().size();
-                int childTotalMeshes = countAllMeshesRecursive(child);
+                int childTotalMeshes = child->subtreeStats().meshes;
 
                 stats += QString("  [+] %1").arg(child->name);
 
@@ -335,6 +293,7 @@ void AssetPreviewWidget::showObject(Opf::Object* object)
 
 void AssetPreviewWidget::showTexture(const Opf::Texture* texture)
 {
+    m_currentObject = nullptr;
     m_customSettingsWidget->clear();
     m_canBuildWidget->clear();
 
@@ -373,14 +332,14 @@ void AssetPreviewWidget::showTexture(const Opf::Texture* texture)
 
     if (texture->hasColorChannel)
     {
-        stats += QString("Color Data: %1 KB\n").arg(texture->colorData.size() / 1024.0, 0, 'f', 2);
+        stats += QString("Color Data: %1 KB\n").arg(texture->colorDataSize() / 1024.0, 0, 'f', 2);
         stats += QString("Color BPP: %1\n").arg(texture->colorBitsPerPixel);
         stats += QString("Color Format: %1\n\n").arg(texture->colorBitmapType == 0 ? "BMP" : "JPEG");
     }
 
     if (texture->hasAlphaChannel)
     {
-        stats += QString("Alpha Data: %1 KB\n").arg(texture->alphaData.size() / 1024.0, 0, 'f', 2);
+        stats += QString("Alpha Data: %1 KB\n").arg(texture->alphaDataSize() / 1024.0, 0, 'f', 2);
         stats += QString("Alpha BPP: %1\n").arg(texture->alphaBitsPerPixel);
     }
 
@@ -397,6 +356,7 @@ void AssetPreviewWidget::showTexture(const Opf::Texture* texture)
 
 void AssetPreviewWidget::showMaterial(const Opf::Material* material)
 {
+    m_currentObject = nullptr;
     m_currentTexture = nullptr;
 
     // Show/hide tabs
@@ -449,6 +409,7 @@ void AssetPreviewWidget::clear()
 
     m_textureScene->clear();
     m_textureItem = nullptr;
+    m_currentObject = nullptr;
     m_currentTexture = nullptr;
 
     m_customSettingsWidget->clear();
@@ -477,12 +438,12 @@ void AssetPreviewWidget::updateStatistics(const QString& stats)
 
 void AssetPreviewWidget::showTexturePreview(const Opf::Texture* texture)
 {
-    if (!texture || texture->colorData.isEmpty())
+    if (!texture || !texture->hasColorData())
     {
         return;
     }
 
-    m_toggleAlphaButton->setEnabled(texture->hasAlphaChannel && !texture->alphaData.isEmpty());
+    m_toggleAlphaButton->setEnabled(texture->hasAlphaChannel && texture->hasAlphaData());
     m_toggleAlphaButton->setText("Show Alpha");
     m_zoomSlider->setValue(100);
     m_currentZoom = 1.0;
@@ -494,12 +455,21 @@ void AssetPreviewWidget::updateTexturePreview()
 {
     if (!m_currentTexture) return;
 
-    QImage image = createTextureImage(m_currentTexture, m_showingAlpha);
+    // Pixmaps of recently shown textures are kept, so going back to one
+    // (or toggling alpha) neither decodes nor uploads again
+    QString pixmapKey = QString("opf-texture/%1/%2/%3").arg(m_currentTexture->projectID).arg(m_currentTexture->id).arg(m_showingAlpha ? "alpha" : "color");
 
-    if (image.isNull()) return;
+    QPixmap pixmap;
+    if (!QPixmapCache::find(pixmapKey, &pixmap))
+    {
+        QImage image = createTextureImage(m_currentTexture, m_showingAlpha);
+        if (image.isNull()) return;
+
+        pixmap = QPixmap::fromImage(image);
+        QPixmapCache::insert(pixmapKey, pixmap);
+    }
 
     m_textureScene->clear();
-    QPixmap pixmap = QPixmap::fromImage(image);
     m_textureItem = m_textureScene->addPixmap(pixmap);
     m_textureScene->setSceneRect(pixmap.rect());
 
@@ -511,63 +481,14 @@ QImage AssetPreviewWidget::createTextureImage(const Opf::Texture* texture, bool
 {
     if (!texture) return QImage();
 
-    QImage image;
+    Opf::TextureCache& cache = Opf::TextureCache::instance();
 
-    if (alphaOnly && texture->hasAlphaChannel && !texture->alphaData.isEmpty())
+    if (alphaOnly && texture->hasAlphaChannel && texture->hasAlphaData())
     {
-        if (texture->alphaBitmapType != 0)
-        {
-            image.loadFromData(texture->alphaData, "JPEG");
-        }
-
-        else
-        {
-            if (texture->alphaBitsPerPixel == 8)
-            {
-                image = QImage((const uchar*)texture->alphaData.data(), texture->width, texture->height, QImage::Format_Grayscale8).copy();
-            }
-        }
-    }
-
-    else
-    {
-        if (texture->colorBitmapType != 0)
-        {
-            image.loadFromData(texture->colorData, "JPEG");
-        }
-
-        else
-        {
-            if (texture->colorBitsPerPixel == 32)
-            {
-                image = QImage((const uchar*)texture->colorData.data(), texture->width, texture->height, QImage::Format_RGBA8888).copy();
-            }
-
-            else if (texture->colorBitsPerPixel == 24)
-            {
-                image = QImage((const uchar*)texture->colorData.data(), texture->width, texture->height, QImage::Format_RGB888).copy();
-            }
-
-            else if (texture->colorBitsPerPixel == 16) {
-
-                image = QImage(texture->width, texture->height, QImage::Format_RGB888);
-                const quint16* src = (const quint16*)texture->colorData.data();
-                for (quint32 y = 0; y < texture->height; y++)
-                {
-                    for (quint32 x = 0; x < texture->width; x++)
-                    {
-                        quint16 pixel = src[y * texture->width + x];
-                        quint8 r = ((pixel >> 11) & 0x1F) << 3;
-                        quint8 g = ((pixel >> 5) & 0x3F) << 2;
-                        quint8 b = (pixel & 0x1F) << 3;
-                        image.setPixel(x, y, qRgb(r, g, b));
-                    }
-                }
-            }
-        }
+        return cache.image(*texture, Opf::TextureCache::Variant::Alpha);
     }
 
-    return image;
+    return cache.image(*texture, Opf::TextureCache::Variant::Color);
 }
 
 // ============================================================================
@@ -30,7 +30,8 @@ public:
     void setAvailableUnits(const QStringList& units);
 
 signals:
-    void objectModified();
+    // The settings of the shown object were edited
+    void objectModified(Opf::Object* object);
 
 private slots:
     void onZoomChanged(int value);
@@ -71,6 +72,7 @@ private:
     QPushButton* m_resetZoomButton;
     QPushButton* m_toggleAlphaButton;
 
+    Opf::Object* m_currentObject;
     const Opf::Texture* m_currentTexture;
     bool m_showingAlpha;
     double m_currentZoom;
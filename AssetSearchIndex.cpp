@@ -0,0 +1,301 @@
+#include "AssetSearchIndex.h"
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <utility>
+
+namespace Opf {
+
+namespace {
+
+// Entries in both sorted lists
+QVector<int> intersectSorted(const QVector<int>& a, const QVector<int>& b)
+{
+    QVector<int> result;
+    result.reserve(qMin(a.size(), b.size()));
+    std::set_intersection(a.constBegin(), a.constEnd(), b.constBegin(), b.constEnd(), std::back_inserter(result));
+    return result;
+}
+
+// Checking this few candidates is cheaper than intersecting more lists
+const int kVerifyDirectly = 64;
+
+} // namespace
+
+void AssetSearchIndex::clear()
+{
+    m_texts.clear();
+    m_trigrams.clear();
+    m_textureCount = 0;
+    m_materialCount = 0;
+    m_objectEntries.clear();
+    m_objectCategories.clear();
+    m_results.clear();
+    m_matches.clear();
+}
+
+void AssetSearchIndex::build(const PackedProject& project)
+{
+    clear();
+
+    for (const Texture& texture : project.textures)
+    {
+        addEntry(texture.name);
+    }
+    m_textureCount = project.textures.size();
+
+    for (const Material& material : project.materials)
+    {
+        addEntry(material.name);
+    }
+    m_materialCount = project.materials.size();
+
+    // Class names are interned, so each distinct one is categorized once
+    QHash<uint32, ObjectCategory> categoriesByClass;
+    for (const Object* object : project.objects)
+    {
+        if (object)
+        {
+            addObject(*object, categoriesByClass);
+        }
+    }
+
+    m_matches.fill(0, m_texts.size());
+
+    // Results of the current query for the new entries
+    QString query = m_query;
+    m_query.clear();
+    setQuery(query);
+}
+
+QString AssetSearchIndex::objectText(const Object& object)
+{
+    QString text = object.name + '\n' + object.className;
+    for (const CustomSetting& setting : object.customSettings)
+    {
+        text += '\n';
+        text += setting.value;
+    }
+    return text;
+}
+
+void AssetSearchIndex::addObject(const Object& object, QHash<uint32, ObjectCategory>& categoriesByClass)
+{
+    m_objectEntries.insert(&object, m_texts.size());
+    addEntry(objectText(object));
+
+    if (object.classNameId == NameTable::kNoName)
+    {
+        m_objectCategories.append(object.category());
+    }
+    else
+    {
+        auto it = categoriesByClass.find(object.classNameId);
+        if (it == categoriesByClass.end())
+        {
+            it = categoriesByClass.insert(object.classNameId, object.category());
+        }
+        m_objectCategories.append(it.value());
+    }
+
+    // A new object's children may have been indexed under another parent
+    for (const Object* child : object.children)
+    {
+        if (child && !m_objectEntries.contains(child))
+        {
+            addObject(*child, categoriesByClass);
+        }
+    }
+}
+
+void AssetSearchIndex::addEntry(const QString& text)
+{
+    int entry = m_texts.size();
+    QString lower = text.toLower();
+
+    // Entries are added in order, so each posting list stays sorted and
+    // a repeated trigram only has to be compared with the last id
+    const QChar* data = lower.constData();
+    for (int i = 0; i + 3 <= lower.size(); i++)
+    {
+        QVector<int>& postings = m_trigrams[trigramKey(data + i)];
+        if (postings.isEmpty() || postings.last() != entry)
+        {
+            postings.append(entry);
+        }
+    }
+
+    m_texts.append(lower);
+}
+
+void AssetSearchIndex::updateObject(const Object& object)
+{
+    int entry = m_objectEntries.value(&object, -1);
+    if (entry < 0)
+    {
+        // Added to the project after the index was built. New entries get
+        // the highest ids, so the posting lists stay sorted.
+        QHash<uint32, ObjectCategory> categoriesByClass;
+        addObject(object, categoriesByClass);
+        m_matches.resize(m_texts.size());
+    }
+    else
+    {
+        QString lower = objectText(object).toLower();
+        if (lower != m_texts[entry])
+        {
+            removePostings(entry, m_texts[entry]);
+            addPostings(entry, lower);
+            m_texts[entry] = lower;
+        }
+        m_objectCategories[entry - m_textureCount - m_materialCount] = object.category();
+    }
+
+    // The entry may match the current query now, or no longer
+    QString query = m_query;
+    m_query.clear();
+    setQuery(query);
+}
+
+void AssetSearchIndex::addPostings(int entry, const QString& lower)
+{
+    const QChar* data = lower.constData();
+    for (int i = 0; i + 3 <= lower.size(); i++)
+    {
+        QVector<int>& postings = m_trigrams[trigramKey(data + i)];
+        auto it = std::lower_bound(postings.begin(), postings.end(), entry);
+        if (it == postings.end() || *it != entry)
+        {
+            postings.insert(it, entry);
+        }
+    }
+}
+
+void AssetSearchIndex::removePostings(int entry, const QString& lower)
+{
+    const QChar* data = lower.constData();
+    for (int i = 0; i + 3 <= lower.size(); i++)
+    {
+        auto list = m_trigrams.find(trigramKey(data + i));
+        if (list == m_trigrams.end())
+        {
+            continue;
+        }
+
+        QVector<int>& postings = list.value();
+        auto it = std::lower_bound(postings.begin(), postings.end(), entry);
+        if (it != postings.end() && *it == entry)
+        {
+            postings.erase(it);
+        }
+        if (postings.isEmpty())
+        {
+            m_trigrams.erase(list);
+        }
+    }
+}
+
+void AssetSearchIndex::setQuery(const QString& query)
+{
+    QString lower = query.toLower();
+    if (lower == m_query && !m_query.isEmpty())
+    {
+        return;
+    }
+
+    QVector<int> candidates;
+    bool narrowed = !m_query.isEmpty() && lower.contains(m_query);
+    if (narrowed)
+    {
+        candidates = m_results;
+    }
+
+    for (int entry : std::as_const(m_results))
+    {
+        m_matches[entry] = 0;
+    }
+    m_results.clear();
+    m_query = lower;
+
+    if (lower.isEmpty())
+    {
+        return;
+    }
+
+    if (lower.size() >= 3)
+    {
+        // Shortest posting lists first; a trigram nobody has means no results
+        QVector<const QVector<int>*> lists;
+        const QChar* data = lower.constData();
+        for (int i = 0; i + 3 <= lower.size(); i++)
+        {
+            auto it = m_trigrams.constFind(trigramKey(data + i));
+            if (it == m_trigrams.constEnd())
+            {
+                return;
+            }
+            lists.append(&it.value());
+        }
+        std::sort(lists.begin(), lists.end(), [](const QVector<int>* a, const QVector<int>* b) {
+            return a->size() < b->size();
+        });
+        lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+        int next = 0;
+        if (!narrowed)
+        {
+            candidates = *lists[next++];
+        }
+        for (; next < lists.size() && candidates.size() > kVerifyDirectly; next++)
+        {
+            candidates = intersectSorted(candidates, *lists[next]);
+        }
+    }
+    else if (!narrowed)
+    {
+        candidates.resize(m_texts.size());
+        std::iota(candidates.begin(), candidates.end(), 0);
+    }
+
+    for (int entry : std::as_const(candidates))
+    {
+        if (m_texts[entry].contains(m_query))
+        {
+            m_results.append(entry);
+            m_matches[entry] = 1;
+        }
+    }
+}
+
+bool AssetSearchIndex::entryMatches(int entry) const
+{
+    return m_query.isEmpty() || (entry >= 0 && entry < m_matches.size() && m_matches[entry]);
+}
+
+bool AssetSearchIndex::textureMatches(int index) const
+{
+    return index >= 0 && index < m_textureCount ? entryMatches(index) : m_query.isEmpty();
+}
+
+bool AssetSearchIndex::materialMatches(int index) const
+{
+    return index >= 0 && index < m_materialCount ? entryMatches(m_textureCount + index) : m_query.isEmpty();
+}
+
+bool AssetSearchIndex::objectMatches(const Object* object) const
+{
+    int entry = m_objectEntries.value(object, -1);
+    return entry >= 0 ? entryMatches(entry) : m_query.isEmpty();
+}
+
+ObjectCategory AssetSearchIndex::objectCategory(const Object* object) const
+{
+    int entry = m_objectEntries.value(object, -1) - m_textureCount - m_materialCount;
+    if (entry >= 0 && entry < m_objectCategories.size())
+    {
+        return m_objectCategories[entry];
+    }
+    return object ? object->category() : ObjectCategory::Other;
+}
+
+} // namespace Opf
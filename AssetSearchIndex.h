@@ -0,0 +1,76 @@
+#ifndef ASSETSEARCHINDEX_H
+#define ASSETSEARCHINDEX_H
+
+#include "OpfStructs.h"
+#include <QHash>
+#include <QVector>
+
+namespace Opf {
+
+// ============================================================================
+// ASSET SEARCH INDEX - trigram index for the asset tree filter
+// ============================================================================
+//
+// One entry per texture, material and object (children included). An
+// entry's text is its name, plus class name and custom setting values for
+// objects, lowercased. A query is a case-insensitive substring: candidates
+// come from intersecting the posting lists of the query's trigrams and are
+// then checked against the text. A query that contains the previous one
+// (the user kept typing) only checks the previous results.
+//
+// The index refers to objects by address and must be rebuilt when the
+// project changes; updateObject() covers edits to one object and objects
+// added since.
+
+class AssetSearchIndex
+{
+public:
+    void build(const PackedProject& project);
+    void clear();
+
+    // Indexes the object's current name, class and setting values again and
+    // re-runs the query, e.g. after its settings were edited. An object the
+    // index does not know yet is added, with its children.
+    void updateObject(const Object& object);
+
+    // Selects the entries matching 'query'; empty matches everything
+    void setQuery(const QString& query);
+    const QString& query() const { return m_query; }
+    int resultCount() const { return m_query.isEmpty() ? m_texts.size() : m_results.size(); }
+
+    bool textureMatches(int index) const;
+    bool materialMatches(int index) const;
+    bool objectMatches(const Object* object) const;
+
+    // Computed when the index is built; Other for unknown objects
+    ObjectCategory objectCategory(const Object* object) const;
+
+private:
+    static QString objectText(const Object& object);
+    void addEntry(const QString& text);
+    void addPostings(int entry, const QString& lower);
+    void removePostings(int entry, const QString& lower);
+    void addObject(const Object& object, QHash<uint32, ObjectCategory>& categoriesByClass);
+    bool entryMatches(int entry) const;
+
+    static quint64 trigramKey(const QChar* text)
+    {
+        return (quint64(text[0].unicode()) << 32) | (quint64(text[1].unicode()) << 16) | quint64(text[2].unicode());
+    }
+
+    QVector<QString> m_texts;
+    QHash<quint64, QVector<int>> m_trigrams;    // sorted entry ids per trigram
+
+    int m_textureCount = 0;
+    int m_materialCount = 0;
+    QHash<const Object*, int> m_objectEntries;
+    QVector<ObjectCategory> m_objectCategories; // by entry - first object entry
+
+    QString m_query;                            // lowercased
+    QVector<int> m_results;                     // sorted entry ids
+    QVector<char> m_matches;                    // by entry, for m_results
+};
+
+} // namespace Opf
+
+#endif // ASSETSEARCHINDEX_H
@@ -0,0 +1,376 @@
+#include "AssetTreeModel.h"
+#include <QMap>
+#include <utility>
+
+AssetTreeModel::AssetTreeModel(QObject* parent) : QAbstractItemModel(parent), m_project(nullptr), m_root(new Node())
+{
+}
+
+AssetTreeModel::~AssetTreeModel()
+{
+    delete m_root;
+}
+
+void AssetTreeModel::setProject(const Opf::PackedProject* project)
+{
+    beginResetModel();
+
+    delete m_root;
+    m_root = new Node();
+    m_project = project;
+
+    // Only the category rows exist up front
+    if (m_project)
+    {
+        m_root->children = createChildren(m_root);
+    }
+    m_root->populated = true;
+
+    endResetModel();
+}
+
+AssetTreeModel::Node* AssetTreeModel::nodeAt(const QModelIndex& index) const
+{
+    return index.isValid() ? static_cast<Node*>(index.internalPointer()) : m_root;
+}
+
+AssetTreeModel::ItemType AssetTreeModel::itemType(const QModelIndex& index) const
+{
+    return nodeAt(index)->type;
+}
+
+Opf::Object* AssetTreeModel::objectAt(const QModelIndex& index) const
+{
+    Node* node = nodeAt(index);
+    return node->type == ObjectItem ? node->object : nullptr;
+}
+
+Opf::Texture* AssetTreeModel::textureAt(const QModelIndex& index) const
+{
+    Node* node = nodeAt(index);
+    if (!m_project || node->type != TextureItem) return nullptr;
+
+    if (node->index >= 0 && node->index < m_project->textures.size())
+    {
+        return const_cast<Opf::Texture*>(&m_project->textures[node->index]);
+    }
+    return nullptr;
+}
+
+Opf::Material* AssetTreeModel::materialAt(const QModelIndex& index) const
+{
+    Node* node = nodeAt(index);
+    if (!m_project || node->type != MaterialItem) return nullptr;
+
+    if (node->index >= 0 && node->index < m_project->materials.size())
+    {
+        return const_cast<Opf::Material*>(&m_project->materials[node->index]);
+    }
+    return nullptr;
+}
+
+int AssetTreeModel::recordIndex(const QModelIndex& index) const
+{
+    Node* node = nodeAt(index);
+    return node->type == TextureItem || node->type == MaterialItem ? node->index : -1;
+}
+
+void AssetTreeModel::objectChanged(const Opf::Object* object)
+{
+    // Unpopulated parts of the tree have no rows to update
+    QVector<Node*> nodes;
+    findObjectNodes(m_root, object, nodes);
+    for (Node* node : std::as_const(nodes))
+    {
+        emit dataChanged(createIndex(node->row, 0, node), createIndex(node->row, columnCount() - 1, node));
+    }
+}
+
+void AssetTreeModel::findObjectNodes(Node* node, const Opf::Object* object, QVector<Node*>& nodes) const
+{
+    for (Node* child : std::as_const(node->children))
+    {
+        if (child->type == ObjectItem && child->object == object)
+        {
+            nodes.append(child);
+        }
+        findObjectNodes(child, object, nodes);
+    }
+}
+
+QModelIndex AssetTreeModel::index(int row, int column, const QModelIndex& parent) const
+{
+    Node* node = nodeAt(parent);
+    if (row < 0 || row >= node->children.size() || column < 0 || column >= columnCount())
+    {
+        return QModelIndex();
+    }
+    return createIndex(row, column, node->children[row]);
+}
+
+QModelIndex AssetTreeModel::parent(const QModelIndex& child) const
+{
+    if (!child.isValid()) return QModelIndex();
+
+    Node* parent = nodeAt(child)->parent;
+    if (!parent || parent == m_root)
+    {
+        return QModelIndex();
+    }
+    return createIndex(parent->row, 0, parent);
+}
+
+int AssetTreeModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.column() > 0) return 0;
+
+    return nodeAt(parent)->children.size();
+}
+
+int AssetTreeModel::columnCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return 3;
+}
+
+bool AssetTreeModel::hasChildren(const QModelIndex& parent) const
+{
+    if (parent.column() > 0) return false;
+
+    Node* node = nodeAt(parent);
+    return node->populated ? !node->children.isEmpty() : willHaveChildren(node);
+}
+
+bool AssetTreeModel::canFetchMore(const QModelIndex& parent) const
+{
+    if (parent.column() > 0) return false;
+
+    Node* node = nodeAt(parent);
+    return !node->populated && willHaveChildren(node);
+}
+
+void AssetTreeModel::fetchMore(const QModelIndex& parent)
+{
+    Node* node = nodeAt(parent);
+    if (node->populated) return;
+
+    QVector<Node*> children = createChildren(node);
+    node->populated = true;
+    if (children.isEmpty()) return;
+
+    beginInsertRows(parent, 0, children.size() - 1);
+    node->children = children;
+    endInsertRows();
+}
+
+bool AssetTreeModel::willHaveChildren(const Node* node) const
+{
+    if (!m_project) return false;
+
+    switch (node->type)
+    {
+    case ProjectInfo:
+        return true;
+    case TextureCategory:
+        return !m_project->textures.isEmpty();
+    case MaterialCategory:
+        return !m_project->materials.isEmpty();
+    case ObjectCategory:
+        return !m_project->objects.isEmpty();
+    case ObjectSubCategory:
+        return !node->objects.isEmpty();
+    case ObjectItem:
+        return node->object && !node->object->children.isEmpty();
+    default:
+        return false;
+    }
+}
+
+QVector<AssetTreeModel::Node*> AssetTreeModel::createChildren(Node* node) const
+{
+    QVector<Node*> children;
+    auto add = [&](ItemType type) {
+        Node* child = new Node();
+        child->parent = node;
+        child->row = children.size();
+        child->type = type;
+        children.append(child);
+        return child;
+    };
+
+    if (node == m_root)
+    {
+        add(ProjectInfo);
+        add(TextureCategory);
+        add(MaterialCategory);
+        add(ObjectCategory);
+        return children;
+    }
+
+    switch (node->type)
+    {
+    case ProjectInfo:
+        for (int i = 0; i < 6; i++)
+        {
+            add(InfoLine)->index = i;
+        }
+        break;
+
+    case TextureCategory:
+        children.reserve(m_project->textures.size());
+        for (int i = 0; i < m_project->textures.size(); i++)
+        {
+            add(TextureItem)->index = i;
+        }
+        break;
+
+    case MaterialCategory:
+        children.reserve(m_project->materials.size());
+        for (int i = 0; i < m_project->materials.size(); i++)
+        {
+            add(MaterialItem)->index = i;
+        }
+        break;
+
+    case ObjectCategory:
+    {
+        QMap<QString, QVector<Opf::Object*>> categorized;
+        for (Opf::Object* obj : m_project->objects)
+        {
+            if (obj)
+            {
+                categorized[obj->getCategory()].append(obj);
+            }
+        }
+
+        for (auto it = categorized.begin(); it != categorized.end(); ++it)
+        {
+            Node* child = add(ObjectSubCategory);
+            child->category = it.key();
+            child->objects = it.value();
+        }
+        break;
+    }
+
+    case ObjectSubCategory:
+        children.reserve(node->objects.size());
+        for (Opf::Object* obj : node->objects)
+        {
+            add(ObjectItem)->object = obj;
+        }
+        break;
+
+    case ObjectItem:
+        for (Opf::Object* child : node->object->children)
+        {
+            if (child)
+            {
+                add(ObjectItem)->object = child;
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return children;
+}
+
+QVariant AssetTreeModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || !m_project) return QVariant();
+
+    Node* node = nodeAt(index);
+    if (role == Qt::DisplayRole)
+    {
+        return displayText(node, index.column());
+    }
+    if (role == ItemTypeRole && index.column() == 0)
+    {
+        return node->type;
+    }
+    return QVariant();
+}
+
+QVariant AssetTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+
+    switch (section)
+    {
+    case 0: return "Name";
+    case 1: return "ID";
+    case 2: return "Type";
+    default: return QVariant();
+    }
+}
+
+QString AssetTreeModel::displayText(const Node* node, int column) const
+{
+    const Opf::PackedProject& project = *m_project;
+
+    switch (node->type)
+    {
+    case ProjectInfo:
+        return column == 0 ? QString("Project Info") : QString();
+
+    case InfoLine:
+        if (column != 0) return QString();
+        switch (node->index)
+        {
+        case 0: return QString("Name: %1").arg(project.projectName);
+        case 1: return QString("Author: %1").arg(project.author);
+        case 2: return QString("Version: %1").arg(project.version);
+        case 3: return QString("ProjectID: %1").arg(project.projectID);
+        case 4: return QString("Dependencies: %1").arg(project.dependencies.size());
+        default: return QString("Events: %1").arg(project.eventDescs.size());
+        }
+
+    case TextureCategory:
+        return column == 0 ? QString("Textures (%1)").arg(project.textures.size()) : QString();
+
+    case MaterialCategory:
+        return column == 0 ? QString("Materials (%1)").arg(project.materials.size()) : QString();
+
+    case ObjectCategory:
+        return column == 0 ? QString("Objects (%1)").arg(project.objects.size()) : QString();
+
+    case ObjectSubCategory:
+        return column == 0 ? QString("%1 (%2)").arg(node->category).arg(node->objects.size()) : QString();
+
+    case TextureItem:
+    {
+        if (node->index >= project.textures.size()) return QString();
+
+        const Opf::Texture& texture = project.textures[node->index];
+        if (column == 0) return texture.name;
+        if (column == 1) return QString::number(texture.id);
+        return QString("%1x%2").arg(texture.width).arg(texture.height);
+    }
+
+    case MaterialItem:
+    {
+        if (node->index >= project.materials.size()) return QString();
+
+        const Opf::Material& material = project.materials[node->index];
+        if (column == 0) return material.name;
+        if (column == 1) return QString::number(material.id);
+        return material.doubleSided ? "2-sided" : "1-sided";
+    }
+
+    case ObjectItem:
+    {
+        const Opf::Object* object = node->object;
+        if (column == 1) return QString("%1/%2").arg(object->uniqueID).arg(object->projectID);
+        if (column == 2) return object->className;
+
+        QString displayName = object->name;
+        if (object->hasLight) displayName = "* " + displayName;
+        if (!object->customSettings.isEmpty()) displayName += QString(" [%1]").arg(object->customSettings.size());
+        return displayName;
+    }
+    }
+
+    return QString();
+}
@@ -0,0 +1,104 @@
+#ifndef ASSETTREEMODEL_H
+#define ASSETTREEMODEL_H
+
+#include <QAbstractItemModel>
+#include "OpfStructs.h"
+
+// ============================================================================
+// ASSET TREE MODEL - project info, textures, materials and objects
+// ============================================================================
+//
+// Rows are created one level at a time when the view first shows them
+// (canFetchMore / fetchMore), so opening a project only builds the category
+// rows and nested children cost nothing until they are expanded. The model
+// reads the project directly; it must be reset with setProject(nullptr)
+// before the project is destroyed.
+
+class AssetTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum ItemType
+    {
+        ProjectInfo,
+        TextureCategory,
+        MaterialCategory,
+        ObjectCategory,
+        TextureItem,
+        MaterialItem,
+        ObjectItem,
+        ObjectSubCategory,
+        InfoLine
+    };
+
+    // data() role holding the ItemType
+    static const int ItemTypeRole = Qt::UserRole;
+
+    explicit AssetTreeModel(QObject* parent = nullptr);
+    ~AssetTreeModel() override;
+
+    void setProject(const Opf::PackedProject* project);
+    const Opf::PackedProject* project() const { return m_project; }
+
+    ItemType itemType(const QModelIndex& index) const;
+
+    // The record behind an item, nullptr for other item types
+    Opf::Object* objectAt(const QModelIndex& index) const;
+    Opf::Texture* textureAt(const QModelIndex& index) const;
+    Opf::Material* materialAt(const QModelIndex& index) const;
+
+    // Position in textures / materials of a texture or material item, or -1
+    int recordIndex(const QModelIndex& index) const;
+
+    // Emits dataChanged for the object's rows that exist so far
+    void objectChanged(const Opf::Object* object);
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    struct Node
+    {
+        Node* parent = nullptr;
+        int row = 0;
+        ItemType type = ProjectInfo;
+
+        // Position in textures / materials, or the info line
+        int index = -1;
+        Opf::Object* object = nullptr;
+
+        // Top-level objects of an ObjectSubCategory
+        QString category;
+        QVector<Opf::Object*> objects;
+
+        bool populated = false;
+        QVector<Node*> children;
+
+        ~Node() { qDeleteAll(children); }
+    };
+
+    Node* nodeAt(const QModelIndex& index) const;
+
+    // Whether the node has rows once it is populated, without populating it
+    bool willHaveChildren(const Node* node) const;
+
+    // The node's rows, not inserted yet
+    QVector<Node*> createChildren(Node* node) const;
+
+    QString displayText(const Node* node, int column) const;
+
+    void findObjectNodes(Node* node, const Opf::Object* object, QVector<Node*>& nodes) const;
+
+    const Opf::PackedProject* m_project;
+    Node* m_root;
+};
+
+#endif // ASSETTREEMODEL_H
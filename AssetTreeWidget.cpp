@@ -3,14 +3,16 @@
 #include <QDebug>
 #include <QKeyEvent>
 
-AssetTreeWidget::AssetTreeWidget(QWidget *parent) : QTreeWidget(parent), m_currentProject(nullptr), m_categoryFilter("All"), m_onlyWithMeshes(false)
+AssetTreeWidget::AssetTreeWidget(QWidget *parent) : QTreeView(parent), m_model(new AssetTreeModel(this)), m_filterModel(new AssetFilterModel(this)), m_searchTimer(new QTimer(this))
 {
     setupUI();
 }
 
 void AssetTreeWidget::setupUI()
 {
-    setHeaderLabels(QStringList() << "Name" << "ID" << "Type");
+    m_filterModel->setAssetModel(m_model);
+    setModel(m_filterModel);
+
     setColumnWidth(0, 300);
     setColumnWidth(1, 80);
     setColumnWidth(2, 120);
@@ -18,284 +20,166 @@ void AssetTreeWidget::setupUI()
     setAlternatingRowColors(true);
     setAnimated(true);
 
-    connect(this, &QTreeWidget::itemClicked, this, &AssetTreeWidget::onItemClicked);
-}
-
-void AssetTreeWidget::loadProject(const Opf::PackedProject& project)
-{
-    clear();
-    m_currentProject = &project;
-
-    addProjectInfo(project);
-    addTextures(project.textures);
-    addMaterials(project.materials);
-    addObjects(project.objects);
-
-    expandToDepth(1);
-}
+    // Every row is one line of text; lets the view lay out huge lists
+    // without measuring each row
+    setUniformRowHeights(true);
 
-void AssetTreeWidget::clear()
-{
-    QTreeWidget::clear();
-    m_currentProject = nullptr;
-}
+    connect(this, &QTreeView::clicked, this, &AssetTreeWidget::onItemClicked);
 
-void AssetTreeWidget::addProjectInfo(const Opf::PackedProject& project)
-{
-    QTreeWidgetItem* infoItem = new QTreeWidgetItem(this);
-    infoItem->setText(0, "Project Info");
-    infoItem->setData(0, Qt::UserRole, ProjectInfo);
-
-    new QTreeWidgetItem(infoItem, QStringList() << QString("Name: %1").arg(project.projectName));
-    new QTreeWidgetItem(infoItem, QStringList() << QString("Author: %1").arg(project.author));
-    new QTreeWidgetItem(infoItem, QStringList() << QString("Version: %1").arg(project.version));
-    new QTreeWidgetItem(infoItem, QStringList() << QString("ProjectID: %1").arg(project.projectID));
-    new QTreeWidgetItem(infoItem, QStringList() << QString("Dependencies: %1").arg(project.dependencies.size()));
-    new QTreeWidgetItem(infoItem, QStringList() << QString("Events: %1").arg(project.eventDescs.size()));
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(kSearchDelayMs);
+    connect(m_searchTimer, &QTimer::timeout, this, &AssetTreeWidget::applySearchFilter);
 }
 
-void AssetTreeWidget::addTextures(const QVector<Opf::Texture>& textures)
+void AssetTreeWidget::loadProject(const Opf::PackedProject& project)
 {
-    QTreeWidgetItem* categoryItem = new QTreeWidgetItem(this);
-    categoryItem->setText(0, QString("Textures (%1)").arg(textures.size()));
-    categoryItem->setData(0, Qt::UserRole, TextureCategory);
+    // The index first, so the rows are filtered against this project
+    m_filterModel->setProject(&project);
+    m_model->setProject(&project);
 
-    for (int i = 0; i < textures.size(); i++)
+    // Only the category rows; expanding deeper would fetch every object row
+    for (int row = 0; row < m_filterModel->rowCount(); row++)
     {
-        const Opf::Texture& texture = textures[i];
-        QTreeWidgetItem* item = new QTreeWidgetItem(categoryItem);
-        item->setText(0, texture.name);
-        item->setText(1, QString::number(texture.id));
-        item->setText(2, QString("%1x%2").arg(texture.width).arg(texture.height));
-        item->setData(0, Qt::UserRole, TextureItem);
-        item->setData(0, Qt::UserRole + 1, i);
+        expand(m_filterModel->index(row, 0));
     }
 }
 
-void AssetTreeWidget::addMaterials(const QVector<Opf::Material>& materials)
+void AssetTreeWidget::clear()
 {
-    QTreeWidgetItem* categoryItem = new QTreeWidgetItem(this);
-    categoryItem->setText(0, QString("Materials (%1)").arg(materials.size()));
-    categoryItem->setData(0, Qt::UserRole, MaterialCategory);
-
-    for (int i = 0; i < materials.size(); i++)
-    {
-        const Opf::Material& material = materials[i];
-        QTreeWidgetItem* item = new QTreeWidgetItem(categoryItem);
-        item->setText(0, material.name);
-        item->setText(1, QString::number(material.id));
-        item->setText(2, material.doubleSided ? "2-sided" : "1-sided");
-        item->setData(0, Qt::UserRole, MaterialItem);
-        item->setData(0, Qt::UserRole + 1, i);
-    }
+    m_model->setProject(nullptr);
+    m_filterModel->setProject(nullptr);
 }
 
-void AssetTreeWidget::addObjects(const QVector<Opf::Object*>& objects)
+QModelIndex AssetTreeWidget::sourceIndex(const QModelIndex& index) const
 {
-    QTreeWidgetItem* categoryItem = new QTreeWidgetItem(this);
-    categoryItem->setText(0, QString("Objects (%1)").arg(objects.size()));
-    categoryItem->setData(0, Qt::UserRole, ObjectCategory);
-
-    QMap<QString, QVector<Opf::Object*>> categorized;
-    for (Opf::Object* obj : objects)
-    {
-        if (obj)
-        {
-            QString category = obj->getCategory();
-            categorized[category].append(obj);
-        }
-    }
-
-    for (auto it = categorized.begin(); it != categorized.end(); ++it)
-    {
-        QTreeWidgetItem* subCategoryItem = new QTreeWidgetItem(categoryItem);
-        subCategoryItem->setText(0, QString("%1 (%2)").arg(it.key()).arg(it.value().size()));
-
-        for (Opf::Object* obj : it.value())
-        {
-            addObjectRecursive(subCategoryItem, obj);
-        }
-    }
-}
-
-void AssetTreeWidget::addObjectRecursive(QTreeWidgetItem* parent, Opf::Object* object)
-{
-    if (!object) return;
-
-    QTreeWidgetItem* item = new QTreeWidgetItem(parent);
-
-    QString displayName = object->name;
-    if (object->hasLight) displayName = "* " + displayName;
-    if (!object->customSettings.isEmpty()) displayName += QString(" [%1]").arg(object->customSettings.size());
-
-    item->setText(0, displayName);
-    item->setText(1, QString("%1/%2").arg(object->uniqueID).arg(object->projectID));
-    item->setText(2, object->className);
-    item->setData(0, Qt::UserRole, ObjectItem);
-    item->setData(0, Qt::UserRole + 1, QVariant::fromValue((void*)object));
-
-    for (Opf::Object* child : object->children)
-    {
-        addObjectRecursive(item, child);
-    }
+    return m_filterModel->mapToSource(index);
 }
 
 void AssetTreeWidget::keyPressEvent(QKeyEvent* event)
 {
-    QTreeWidget::keyPressEvent(event);
+    QTreeView::keyPressEvent(event);
 
     if (event->key() == Qt::Key_Up || event->key() == Qt::Key_Down || event->key() == Qt::Key_Home || event->key() == Qt::Key_End || event->key() == Qt::Key_PageUp || event->key() == Qt::Key_PageDown)
     {
-        QTreeWidgetItem* item = currentItem();
-        if (item)
+        QModelIndex index = currentIndex();
+        if (index.isValid())
         {
-            onItemClicked(item, 0);
+            onItemClicked(index);
         }
     }
 }
 
-void AssetTreeWidget::onItemClicked(QTreeWidgetItem* item, int column)
+void AssetTreeWidget::onItemClicked(const QModelIndex& index)
 {
-    Q_UNUSED(column);
-    if (!item || !m_currentProject) return;
+    if (!index.isValid() || !m_model->project()) return;
 
-    int itemType = item->data(0, Qt::UserRole).toInt();
+    QModelIndex source = sourceIndex(index);
+    AssetTreeModel::ItemType itemType = m_model->itemType(source);
 
-    if (itemType == ObjectItem)
+    if (itemType == AssetTreeModel::ObjectItem)
     {
-        Opf::Object* obj = static_cast<Opf::Object*>(item->data(0, Qt::UserRole + 1).value<void*>());
-        emit objectSelected(obj);
+        emit objectSelected(m_model->objectAt(source));
     }
-    else if (itemType == TextureItem)
+    else if (itemType == AssetTreeModel::TextureItem)
     {
-        int index = item->data(0, Qt::UserRole + 1).toInt();
-        if (index >= 0 && index < m_currentProject->textures.size())
+        if (Opf::Texture* texture = m_model->textureAt(source))
         {
-            emit textureSelected(const_cast<Opf::Texture*>(&m_currentProject->textures[index]));
+            emit textureSelected(texture);
         }
     }
-    else if (itemType == MaterialItem)
+    else if (itemType == AssetTreeModel::MaterialItem)
     {
-        int index = item->data(0, Qt::UserRole + 1).toInt();
-        if (index >= 0 && index < m_currentProject->materials.size())
+        if (Opf::Material* material = m_model->materialAt(source))
         {
-            emit materialSelected(const_cast<Opf::Material*>(&m_currentProject->materials[index]));
+            emit materialSelected(material);
         }
     }
 }
 
 Opf::Object* AssetTreeWidget::getSelectedObject() const
 {
-    QTreeWidgetItem* item = currentItem();
-    if (!item) return nullptr;
-
-    if (item->data(0, Qt::UserRole).toInt() != ObjectItem) return nullptr;
+    QModelIndex index = currentIndex();
+    if (!index.isValid()) return nullptr;
 
-    return static_cast<Opf::Object*>(item->data(0, Qt::UserRole + 1).value<void*>());
+    return m_model->objectAt(sourceIndex(index));
 }
 
 Opf::Texture* AssetTreeWidget::getSelectedTexture() const
 {
-    QTreeWidgetItem* item = currentItem();
-    if (!item || !m_currentProject) return nullptr;
+    QModelIndex index = currentIndex();
+    if (!index.isValid()) return nullptr;
 
-    if (item->data(0, Qt::UserRole).toInt() != TextureItem) return nullptr;
+    return m_model->textureAt(sourceIndex(index));
+}
+
+QVector<const Opf::Texture*> AssetTreeWidget::neighbouringTextures(int count) const
+{
+    QVector<const Opf::Texture*> textures;
+    QModelIndex current = currentIndex();
+    if (!current.isValid() || !m_model->project()) return textures;
+
+    auto textureOf = [this](const QModelIndex& index) -> const Opf::Texture* {
+        return m_model->textureAt(sourceIndex(index));
+    };
+
+    // Walks stop at the first item that is not a texture, i.e. at the
+    // edges of the texture category
+    QModelIndex above = indexAbove(current);
+    QModelIndex below = indexBelow(current);
 
-    int index = item->data(0, Qt::UserRole + 1).toInt();
-    if (index >= 0 && index < m_currentProject->textures.size())
+    for (int i = 0; i < count && (above.isValid() || below.isValid()); i++)
     {
-        return const_cast<Opf::Texture*>(&m_currentProject->textures[index]);
+        const Opf::Texture* next = below.isValid() ? textureOf(below) : nullptr;
+        const Opf::Texture* previous = above.isValid() ? textureOf(above) : nullptr;
+
+        if (next) textures.append(next);
+        if (previous) textures.append(previous);
+
+        below = next ? indexBelow(below) : QModelIndex();
+        above = previous ? indexAbove(above) : QModelIndex();
     }
-    return nullptr;
+
+    return textures;
 }
 
 Opf::Material* AssetTreeWidget::getSelectedMaterial() const
 {
-    QTreeWidgetItem* item = currentItem();
-    if (!item || !m_currentProject) return nullptr;
+    QModelIndex index = currentIndex();
+    if (!index.isValid()) return nullptr;
 
-    if (item->data(0, Qt::UserRole).toInt() != MaterialItem) return nullptr;
-
-    int index = item->data(0, Qt::UserRole + 1).toInt();
-    if (index >= 0 && index < m_currentProject->materials.size())
-    {
-        return const_cast<Opf::Material*>(&m_currentProject->materials[index]);
-    }
-    return nullptr;
+    return m_model->materialAt(sourceIndex(index));
 }
 
 void AssetTreeWidget::setSearchFilter(const QString& filter)
 {
-    m_searchFilter = filter.toLower();
-    applyFilters();
+    m_pendingSearch = filter;
+    m_searchTimer->start();
+}
+
+void AssetTreeWidget::applySearchFilter()
+{
+    m_filterModel->setSearchFilter(m_pendingSearch);
 }
 
 void AssetTreeWidget::setCategoryFilter(const QString& category)
 {
-    m_categoryFilter = category;
-    applyFilters();
+    m_filterModel->setCategoryFilter(category);
 }
 
 void AssetTreeWidget::setOnlyWithMeshes(bool enabled)
 {
-    m_onlyWithMeshes = enabled;
-    applyFilters();
+    m_filterModel->setOnlyWithMeshes(enabled);
 }
 
-void AssetTreeWidget::applyFilters()
+void AssetTreeWidget::refreshObject(const Opf::Object* object)
 {
-    if (!m_currentProject) return;
-
-    QTreeWidgetItemIterator it(this);
-    while (*it)
-    {
-        QTreeWidgetItem* item = *it;
-
-        int itemType = item->data(0, Qt::UserRole).toInt();
-        if (itemType == TextureCategory || itemType == MaterialCategory || itemType == ObjectCategory || itemType == ProjectInfo)
-        {
-            item->setHidden(false);
-            ++it;
-            continue;
-        }
-
-        bool visible = matchesFilter(item);
-        item->setHidden(!visible);
+    if (!object) return;
 
-        ++it;
-    }
+    m_filterModel->updateObject(object);
+    m_model->objectChanged(object);
 }
 
-bool AssetTreeWidget::matchesFilter(QTreeWidgetItem* item)
+int AssetTreeWidget::setSettingsQuery(const QString& query, QString* error)
 {
-    int itemType = item->data(0, Qt::UserRole).toInt();
-
-    if (!m_searchFilter.isEmpty())
-    {
-        QString itemText = item->text(0).toLower();
-        if (!itemText.contains(m_searchFilter))
-        {
-            return false;
-        }
-    }
-
-    if (itemType == ObjectItem && m_categoryFilter != "All")
-    {
-        Opf::Object* obj = static_cast<Opf::Object*>(item->data(0, Qt::UserRole + 1).value<void*>());
-        if (obj && obj->getCategory() != m_categoryFilter)
-        {
-            return false;
-        }
-    }
-
-    if (m_onlyWithMeshes && itemType == ObjectItem)
-    {
-        Opf::Object* obj = static_cast<Opf::Object*>(item->data(0, Qt::UserRole + 1).value<void*>());
-        if (obj && obj->meshes().isEmpty())
-        {
-            return false;
-        }
-    }
-
-    return true;
+    return m_filterModel->setSettingsQuery(query, error);
 }
@@ -1,10 +1,14 @@
 #ifndef ASSETTREEWIDGET_H
 #define ASSETTREEWIDGET_H
 
-#include <QTreeWidget>
-#include "OpfStructs.h"
+#include <QTreeView>
+#include <QTimer>
+#include "AssetTreeModel.h"
+#include "AssetFilterModel.h"
 
-class AssetTreeWidget : public QTreeWidget
+// Tree of the loaded project on AssetTreeModel, filtered by
+// AssetFilterModel. Rows are created when they are first expanded.
+class AssetTreeWidget : public QTreeView
 {
     Q_OBJECT
 
@@ -18,20 +22,21 @@ public:
     Opf::Texture* getSelectedTexture() const;
     Opf::Material* getSelectedMaterial() const;
 
+    // Textures of the visible items just above and below the current one,
+    // nearest first, at most 'count' in each direction
+    QVector<const Opf::Texture*> neighbouringTextures(int count) const;
+
+    // Applied once typing pauses for kSearchDelayMs
     void setSearchFilter(const QString& filter);
     void setCategoryFilter(const QString& category);
     void setOnlyWithMeshes(bool enabled);
 
-    enum ItemType
-    {
-        ProjectInfo,
-        TextureCategory,
-        MaterialCategory,
-        ObjectCategory,
-        TextureItem,
-        MaterialItem,
-        ObjectItem
-    };
+    // The object's settings were edited: updates its rows, search entry and
+    // settings query result
+    void refreshObject(const Opf::Object* object);
+
+    // See AssetFilterModel::setSettingsQuery()
+    int setSettingsQuery(const QString& query, QString* error = nullptr);
 
 signals:
     void objectSelected(Opf::Object* object);
@@ -42,23 +47,21 @@ protected:
     void keyPressEvent(QKeyEvent* event) override;
 
 private slots:
-    void onItemClicked(QTreeWidgetItem* item, int column);
+    void onItemClicked(const QModelIndex& index);
+    void applySearchFilter();
 
 private:
     void setupUI();
-    void addProjectInfo(const Opf::PackedProject& project);
-    void addTextures(const QVector<Opf::Texture>& textures);
-    void addMaterials(const QVector<Opf::Material>& materials);
-    void addObjects(const QVector<Opf::Object*>& objects);
-    void addObjectRecursive(QTreeWidgetItem* parent, Opf::Object* object);
-
-    void applyFilters();
-    bool matchesFilter(QTreeWidgetItem* item);
-
-    const Opf::PackedProject* m_currentProject;
-    QString m_searchFilter;
-    QString m_categoryFilter;
-    bool m_onlyWithMeshes;
+
+    // Index in AssetTreeModel of a view index
+    QModelIndex sourceIndex(const QModelIndex& index) const;
+
+    static const int kSearchDelayMs = 150;
+
+    AssetTreeModel* m_model;
+    AssetFilterModel* m_filterModel;
+    QTimer* m_searchTimer;
+    QString m_pendingSearch;
 };
 
 #endif // ASSETTREEWIDGET_H
@@ -0,0 +1,380 @@
+#include "BackupStore.h"
+#include "ContentHash.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QDebug>
+#include <utility>
+
+namespace Opf {
+
+namespace {
+
+const char kManifestMagic[8] = { 'O', 'P', 'F', 'B', 'A', 'C', 'K', 'M' };
+const quint32 kManifestFormatVersion = 1;
+
+// Chunks are between 16 and 256 KB, 80 KB on average
+const qint64 kMinChunkSize = 16 * 1024;
+const qint64 kMaxChunkSize = 256 * 1024;
+const quint64 kBoundaryMask = 0xFFFF000000000000ULL;
+
+// Favour speed: chunks are small and most of a backup is deduplicated
+const int kCompressionLevel = 1;
+
+struct ManifestHeader
+{
+    char magic[8];
+    quint32 formatVersion;
+    quint32 chunkCount;
+    qint64 created;         // ms since epoch, UTC
+    qint64 fileSize;
+    quint64 fileHash;
+    qint64 addedBytes;
+};
+
+// Random values for the gear hash, fixed so that chunk boundaries (and
+// with them deduplication) are the same in every run
+const quint64* gearTable()
+{
+    static const struct Table
+    {
+        quint64 values[256];
+
+        Table()
+        {
+            // splitmix64
+            quint64 state = 0x4F50464241434B55ULL;
+            for (quint64& value : values)
+            {
+                state += 0x9E3779B97F4A7C15ULL;
+                quint64 z = state;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                value = z ^ (z >> 31);
+            }
+        }
+    } table;
+    return table.values;
+}
+
+// End of the chunk starting at 'begin'. Each byte shifts the hash left by
+// one, so its top 16 bits depend on the last 64 bytes only and a boundary
+// is found again at the same content after an insertion or deletion.
+qint64 nextChunkEnd(const uchar* data, qint64 begin, qint64 size)
+{
+    const quint64* gear = gearTable();
+    qint64 end = qMin(begin + kMaxChunkSize, size);
+    qint64 i = qMin(begin + kMinChunkSize, end);
+
+    quint64 hash = 0;
+    for (; i < end; i++)
+    {
+        hash = (hash << 1) + gear[data[i]];
+        if ((hash & kBoundaryMask) == 0)
+        {
+            return i + 1;
+        }
+    }
+    return end;
+}
+
+QString hashName(quint64 hash)
+{
+    return QString::number(hash, 16).rightJustified(16, QLatin1Char('0'));
+}
+
+} // namespace
+
+// ============================================================================
+// BACKUP STORE
+// ============================================================================
+
+BackupStore::BackupStore(const QString& opfFilename)
+    : m_filename(opfFilename), m_storePath(storePathFor(opfFilename))
+{
+}
+
+QString BackupStore::storePathFor(const QString& opfFilename)
+{
+    return QFileInfo(opfFilename).absoluteFilePath() + ".backups";
+}
+
+QString BackupStore::chunkPath(quint64 hash) const
+{
+    QString name = hashName(hash);
+    return QString("%1/chunks/%2/%3.z").arg(m_storePath, name.left(2), name);
+}
+
+QString BackupStore::manifestPath(const QString& id) const
+{
+    return QString("%1/manifests/%2.manifest").arg(m_storePath, id);
+}
+
+bool BackupStore::backup(Entry* entry)
+{
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        m_lastError = QString("Cannot open file: %1").arg(m_filename);
+        return false;
+    }
+
+    qint64 size = file.size();
+    QByteArray contents;
+    uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+    const uchar* data = mapped;
+    if (!mapped)
+    {
+        contents = file.readAll();
+        data = reinterpret_cast<const uchar*>(contents.constData());
+    }
+
+    quint64 fileHash = contentHash(data, size);
+
+    // Saving twice without changes does not need a second backup
+    QVector<Entry> existing;
+    if (list(existing) && !existing.isEmpty() &&
+        existing.first().size == size && existing.first().fileHash == fileHash)
+    {
+        if (mapped)
+        {
+            file.unmap(mapped);
+        }
+        if (entry)
+        {
+            *entry = existing.first();
+        }
+        qDebug() << "Backup unchanged:" << existing.first().id;
+        return true;
+    }
+
+    QVector<ChunkRef> chunks;
+    qint64 addedBytes = 0;
+    bool success = true;
+
+    for (qint64 begin = 0; begin < size; )
+    {
+        qint64 end = nextChunkEnd(data, begin, size);
+        quint64 hash = contentHash(data + begin, end - begin);
+        if (!storeChunk(data + begin, end - begin, hash, addedBytes))
+        {
+            success = false;
+            break;
+        }
+
+        chunks.append(ChunkRef{ hash, quint32(end - begin), 0 });
+        begin = end;
+    }
+
+    if (mapped)
+    {
+        file.unmap(mapped);
+    }
+    file.close();
+
+    if (!success)
+    {
+        return false;
+    }
+
+    // The manifest is written last, so an interrupted backup never refers
+    // to chunks that are not there
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    QString id = now.toString("yyyyMMdd-HHmmss-zzz");
+    for (int suffix = 1; QFile::exists(manifestPath(id)); suffix++)
+    {
+        id = QString("%1-%2").arg(now.toString("yyyyMMdd-HHmmss-zzz")).arg(suffix);
+    }
+
+    ManifestHeader header;
+    memcpy(header.magic, kManifestMagic, sizeof(kManifestMagic));
+    header.formatVersion = kManifestFormatVersion;
+    header.chunkCount = quint32(chunks.size());
+    header.created = now.toMSecsSinceEpoch();
+    header.fileSize = size;
+    header.fileHash = fileHash;
+    header.addedBytes = addedBytes;
+
+    if (!QDir().mkpath(m_storePath + "/manifests"))
+    {
+        m_lastError = QString("Cannot create backup directory: %1").arg(m_storePath);
+        return false;
+    }
+
+    QSaveFile manifest(manifestPath(id));
+    if (!manifest.open(QIODevice::WriteOnly))
+    {
+        m_lastError = QString("Cannot write backup manifest: %1").arg(manifest.fileName());
+        return false;
+    }
+
+    manifest.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    manifest.write(reinterpret_cast<const char*>(chunks.constData()), qint64(chunks.size()) * qint64(sizeof(ChunkRef)));
+
+    if (!manifest.commit())
+    {
+        m_lastError = QString("Cannot write backup manifest: %1").arg(manifest.fileName());
+        return false;
+    }
+
+    if (entry)
+    {
+        entry->id = id;
+        entry->created = now.toLocalTime();
+        entry->size = size;
+        entry->fileHash = fileHash;
+        entry->chunkCount = chunks.size();
+        entry->addedBytes = addedBytes;
+    }
+
+    qDebug() << "Created backup" << id << "of" << m_filename << "-" << chunks.size() << "chunks," << addedBytes << "new bytes";
+    return true;
+}
+
+bool BackupStore::storeChunk(const uchar* data, qint64 size, quint64 hash, qint64& addedBytes)
+{
+    QString path = chunkPath(hash);
+    if (QFileInfo::exists(path))
+    {
+        return true;
+    }
+
+    if (!QDir().mkpath(QFileInfo(path).absolutePath()))
+    {
+        m_lastError = QString("Cannot create backup directory: %1").arg(QFileInfo(path).absolutePath());
+        return false;
+    }
+
+    QByteArray compressed = qCompress(data, int(size), kCompressionLevel);
+
+    QSaveFile chunk(path);
+    if (!chunk.open(QIODevice::WriteOnly) || chunk.write(compressed) != compressed.size() || !chunk.commit())
+    {
+        m_lastError = QString("Cannot write backup chunk: %1").arg(path);
+        return false;
+    }
+
+    addedBytes += compressed.size();
+    return true;
+}
+
+bool BackupStore::readManifest(const QString& id, Entry& entry, QVector<ChunkRef>* chunks)
+{
+    QFile file(manifestPath(id));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        m_lastError = QString("Cannot read backup manifest: %1").arg(file.fileName());
+        return false;
+    }
+
+    QByteArray data = file.readAll();
+
+    ManifestHeader header;
+    bool valid = data.size() >= int(sizeof(header));
+    if (valid)
+    {
+        memcpy(&header, data.constData(), sizeof(header));
+        valid = memcmp(header.magic, kManifestMagic, sizeof(kManifestMagic)) == 0
+                && header.formatVersion == kManifestFormatVersion
+                && qint64(data.size()) == qint64(sizeof(header)) + qint64(header.chunkCount) * qint64(sizeof(ChunkRef));
+    }
+
+    if (!valid)
+    {
+        m_lastError = QString("Backup manifest is corrupt: %1").arg(file.fileName());
+        return false;
+    }
+
+    entry.id = id;
+    entry.created = QDateTime::fromMSecsSinceEpoch(header.created);
+    entry.size = header.fileSize;
+    entry.fileHash = header.fileHash;
+    entry.chunkCount = int(header.chunkCount);
+    entry.addedBytes = header.addedBytes;
+
+    if (chunks)
+    {
+        chunks->resize(int(header.chunkCount));
+        memcpy(chunks->data(), data.constData() + sizeof(header), size_t(header.chunkCount) * sizeof(ChunkRef));
+    }
+    return true;
+}
+
+bool BackupStore::list(QVector<Entry>& entries)
+{
+    entries.clear();
+
+    QDir dir(m_storePath + "/manifests");
+    if (!dir.exists())
+    {
+        return true;
+    }
+
+    const QStringList names = dir.entryList(QStringList() << "*.manifest", QDir::Files, QDir::Name | QDir::Reversed);
+    for (const QString& name : names)
+    {
+        Entry entry;
+        if (!readManifest(QFileInfo(name).completeBaseName(), entry, nullptr))
+        {
+            qWarning() << m_lastError;
+            continue;
+        }
+        entries.append(entry);
+    }
+
+    return true;
+}
+
+bool BackupStore::restore(const QString& id, const QString& targetFilename)
+{
+    Entry entry;
+    QVector<ChunkRef> chunks;
+    if (!readManifest(id, entry, &chunks))
+    {
+        return false;
+    }
+
+    QSaveFile target(targetFilename);
+    if (!target.open(QIODevice::WriteOnly))
+    {
+        m_lastError = QString("Cannot open file for writing: %1").arg(targetFilename);
+        return false;
+    }
+
+    qint64 written = 0;
+    for (const ChunkRef& ref : std::as_const(chunks))
+    {
+        QFile chunk(chunkPath(ref.hash));
+        QByteArray data;
+        if (chunk.open(QIODevice::ReadOnly))
+        {
+            data = qUncompress(chunk.readAll());
+        }
+
+        if (data.size() != int(ref.size) || contentHash(data) != ref.hash)
+        {
+            m_lastError = QString("Backup %1 is damaged: chunk %2 is missing or corrupt").arg(id, hashName(ref.hash));
+            target.cancelWriting();
+            target.commit();
+            return false;
+        }
+
+        if (target.write(data) != data.size())
+        {
+            break;
+        }
+        written += data.size();
+    }
+
+    if (written != entry.size || !target.commit())
+    {
+        m_lastError = QString("Cannot write %1: %2").arg(targetFilename, target.errorString());
+        return false;
+    }
+
+    qDebug() << "Restored backup" << id << "to" << targetFilename;
+    return true;
+}
+
+} // namespace Opf
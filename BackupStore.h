@@ -0,0 +1,71 @@
+#ifndef BACKUPSTORE_H
+#define BACKUPSTORE_H
+
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+
+namespace Opf {
+
+// ============================================================================
+// BACKUP STORE - deduplicated save history of an .opf file
+// ============================================================================
+//
+// "<file>.opf.backups/" keeps every backed-up version of the file as a list
+// of content-defined chunks. Chunk boundaries are picked by a rolling gear
+// hash, so an edit only changes the chunks around it; each distinct chunk
+// is stored once, zlib-compressed and named by its content hash. A backup
+// adds one small manifest plus whatever chunks are new, i.e. roughly the
+// size of the change since the previous one.
+
+class BackupStore
+{
+public:
+    struct Entry
+    {
+        QString id;             // manifest name, sorts chronologically
+        QDateTime created;
+        qint64 size = 0;        // size of the backed-up file
+        quint64 fileHash = 0;   // contentHash() of the backed-up file
+        int chunkCount = 0;
+        qint64 addedBytes = 0;  // compressed bytes this backup added
+    };
+
+    explicit BackupStore(const QString& opfFilename);
+
+    static QString storePathFor(const QString& opfFilename);
+
+    // Adds the current contents of the file. Nothing is added if they are
+    // identical to the newest backup; 'entry' then describes that one.
+    bool backup(Entry* entry = nullptr);
+
+    // All backups, newest first
+    bool list(QVector<Entry>& entries);
+
+    // Writes backup 'id' to 'targetFilename', replacing it atomically
+    bool restore(const QString& id, const QString& targetFilename);
+
+    QString lastError() const { return m_lastError; }
+
+private:
+    struct ChunkRef
+    {
+        quint64 hash;
+        quint32 size;
+        quint32 reserved;
+    };
+
+    QString chunkPath(quint64 hash) const;
+    QString manifestPath(const QString& id) const;
+
+    bool storeChunk(const uchar* data, qint64 size, quint64 hash, qint64& addedBytes);
+    bool readManifest(const QString& id, Entry& entry, QVector<ChunkRef>* chunks);
+
+    QString m_filename;
+    QString m_storePath;
+    QString m_lastError;
+};
+
+} // namespace Opf
+
+#endif // BACKUPSTORE_H
@@ -0,0 +1,892 @@
+#include "CommandLine.h"
+#include "ProjectLoader.h"
+#include "OpfWriter.h"
+#include "TextureDecoder.h"
+#include "ObjWriter.h"
+#include "SettingsTable.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFileInfo>
+#include <QThread>
+#include <QDir>
+#include <QImage>
+#include <QRandomGenerator>
+#include <QBuffer>
+#include <QTextStream>
+#include <QDebug>
+#include <cstdio>
+#include <cstring>
+
+namespace Opf {
+
+namespace {
+
+const int kExitSuccess = 0;
+const int kExitFailure = 1;
+const int kExitUsage = 2;
+
+// Validation counts every problem but lists only this many
+const int kMaxReportedProblems = 50;
+
+const char* const kCommandFlags[] = {
+    "--export-all", "--export-templates", "--export-asset-list", "--validate", "--convert", "--query", "--benchmark-textures", "--benchmark-obj",
+    "--help", "-h", "--version", "-v"
+};
+
+void writeOut(const QByteArray& text)
+{
+    fwrite(text.constData(), 1, size_t(text.size()), stdout);
+    fflush(stdout);
+}
+
+void writeError(const QString& text)
+{
+    QByteArray bytes = text.toLocal8Bit() + '\n';
+    fwrite(bytes.constData(), 1, size_t(bytes.size()), stderr);
+}
+
+void checkMeshMaterials(const Object& object, const PackedProject& project, QJsonArray& problems, int& count)
+{
+    for (const Mesh& mesh : object.meshes())
+    {
+        // References into dependencies cannot be checked from this file
+        if (mesh.materialProjectID == project.projectID && !project.findMaterialByID(mesh.materialID))
+        {
+            if (++count <= kMaxReportedProblems)
+            {
+                problems.append(QString("Object '%1', mesh '%2': material %3 not found").arg(object.name, mesh.name).arg(mesh.materialID));
+            }
+        }
+    }
+
+    for (const Object* child : object.children)
+    {
+        checkMeshMaterials(*child, project, problems, count);
+    }
+}
+
+// The per-pixel decoding TextureDecoder replaced, kept as the benchmark
+// baseline: 5:6:5 color and a 16-bit alpha plane merged through
+// QImage::setPixel
+QImage decodePerPixel(const Texture& texture)
+{
+    QImage image(texture.width, texture.height, QImage::Format_RGB888);
+    const quint16* src = reinterpret_cast<const quint16*>(texture.colorData.constData());
+    for (quint32 y = 0; y < texture.height; y++)
+    {
+        for (quint32 x = 0; x < texture.width; x++)
+        {
+            quint16 pixel = src[y * texture.width + x];
+            quint8 r = ((pixel >> 11) & 0x1F) << 3;
+            quint8 g = ((pixel >> 5) & 0x3F) << 2;
+            quint8 b = (pixel & 0x1F) << 3;
+            image.setPixel(x, y, qRgb(r, g, b));
+        }
+    }
+
+    QImage alphaImage(texture.width, texture.height, QImage::Format_Grayscale8);
+    const quint16* alpha = reinterpret_cast<const quint16*>(texture.alphaData.constData());
+    for (quint32 y = 0; y < texture.height; y++)
+    {
+        for (quint32 x = 0; x < texture.width; x++)
+        {
+            quint8 gray = (alpha[y * texture.width + x] >> 8) & 0xFF;
+            alphaImage.setPixel(x, y, qRgb(gray, gray, gray));
+        }
+    }
+
+    image = image.convertToFormat(QImage::Format_RGBA8888);
+    for (quint32 y = 0; y < texture.height; y++)
+    {
+        for (quint32 x = 0; x < texture.width; x++)
+        {
+            QRgb rgb = image.pixel(x, y);
+            image.setPixel(x, y, qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), qGray(alphaImage.pixel(x, y))));
+        }
+    }
+    return image;
+}
+
+// The QTextStream / QString::arg OBJ output ObjWriter replaced, kept as the
+// benchmark baseline
+QByteArray legacyObjText(const Mesh& mesh, const QString& mtlFilename)
+{
+    QByteArray text;
+    QBuffer buffer(&text);
+    buffer.open(QIODevice::WriteOnly);
+    QTextStream out(&buffer);
+
+    VertexView vertices = mesh.vertices();
+    ArrayView<uint16> indices = mesh.indices();
+
+    out << "# Outforce OBJ Export v2.0\n";
+    out << "# Mesh: " << mesh.name << "\n";
+    out << "# Vertices: " << vertices.size() << "\n";
+    out << "# Faces: " << (indices.size() / 3) << "\n";
+    out << "# Material ID: " << mesh.materialID << "\n\n";
+    out << "mtllib " << mtlFilename << "\n\n";
+
+    for (const Vector3D& position : vertices.positions())
+    {
+        out << QString("v %1 %2 %3\n").arg(position.x, 0, 'f', 6).arg(position.y, 0, 'f', 6).arg(position.z, 0, 'f', 6);
+    }
+    out << "\n";
+
+    for (const Vector3D& normal : vertices.normals())
+    {
+        out << QString("vn %1 %2 %3\n").arg(normal.x, 0, 'f', 6).arg(normal.y, 0, 'f', 6).arg(normal.z, 0, 'f', 6);
+    }
+    out << "\n";
+
+    for (const Vertex& v : vertices)
+    {
+        out << QString("vt %1 %2\n").arg(v.texCoord.x, 0, 'f', 6).arg(1.0f - v.texCoord.y, 0, 'f', 6);
+    }
+    out << "\n";
+
+    out << "usemtl " << QString("material_%1").arg(mesh.materialID) << "\n\n";
+
+    out << "# Faces\n";
+    for (int i = 0; i < indices.size(); i += 3)
+    {
+        int i1 = indices[i] + 1;
+        int i2 = indices[i + 1] + 1;
+        int i3 = indices[i + 2] + 1;
+        out << QString("f %1/%1/%1 %2/%2/%2 %3/%3/%3\n").arg(i1).arg(i3).arg(i2);
+    }
+
+    out.flush();
+    return text;
+}
+
+// Milliseconds per call of 'work', best of 'iterations'
+template <typename Work>
+double bestTimeMs(int iterations, Work work)
+{
+    double best = 0.0;
+    for (int i = 0; i < iterations; i++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        work();
+        double ms = timer.nsecsElapsed() / 1e6;
+        best = (i == 0) ? ms : qMin(best, ms);
+    }
+    return best;
+}
+
+} // namespace
+
+// ============================================================================
+// COMMAND LINE
+// ============================================================================
+
+bool CommandLine::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        for (const char* flag : kCommandFlags)
+        {
+            if (strcmp(argv[i], flag) == 0)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int CommandLine::run(const QStringList& arguments)
+{
+    if (!parseArguments(arguments))
+    {
+        if (m_command == Command::None && m_lastError.isEmpty())
+        {
+            return kExitSuccess;    // --help / --version
+        }
+        writeError(m_lastError);
+        return kExitUsage;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (m_command == Command::BenchmarkTextures || m_command == Command::BenchmarkObj)
+    {
+        bool success = m_command == Command::BenchmarkTextures ? runBenchmarkTextures() : runBenchmarkObj();
+        printSummary(success, 0, timer.elapsed(), nullptr);
+        return success ? kExitSuccess : kExitFailure;
+    }
+
+    if (m_streaming)
+    {
+        bool success = runStreamingExport();
+        printSummary(success, 0, timer.elapsed(), nullptr);
+        if (!success)
+        {
+            writeError(m_lastError);
+        }
+        return success ? kExitSuccess : kExitFailure;
+    }
+
+    PackedProject* loaded = nullptr;
+    bool success = loadProject(loaded);
+    QScopedPointer<PackedProject> project(loaded);
+    qint64 loadMs = timer.restart();
+
+    if (success)
+    {
+        switch (m_command)
+        {
+        case Command::ExportAll:       success = runExportAll(*project); break;
+        case Command::ExportTemplates: success = runExportTemplates(*project); break;
+        case Command::ExportAssetList: success = runExportAssetList(*project); break;
+        case Command::Validate:        success = runValidate(*project); break;
+        case Command::Convert:         success = runConvert(*project); break;
+        case Command::Query:           success = runQuery(*project); break;
+        case Command::BenchmarkTextures:
+        case Command::BenchmarkObj:
+        case Command::None:            break;
+        }
+    }
+    qint64 commandMs = timer.elapsed();
+
+    printSummary(success, loadMs, commandMs, project.data());
+
+    if (!success)
+    {
+        writeError(m_lastError);
+    }
+    return success ? kExitSuccess : kExitFailure;
+}
+
+bool CommandLine::parseArguments(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Batch extraction, validation and conversion of Outforce .opf files.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption exportAllOption("export-all", "Export all assets of <input> into the directory <output>.");
+    QCommandLineOption exportTemplatesOption("export-templates", "Write the Map Editor templates of <input> to the JSON file <output>.");
+    QCommandLineOption exportAssetListOption("export-asset-list", "Write the asset list of <input> to the text file <output>.");
+    QCommandLineOption validateOption("validate", "Parse <input> and check its cross references.");
+    QCommandLineOption convertOption("convert", "Read <input> and write it back out as <output>.");
+    QCommandLineOption queryOption("query", "List the objects of <input> whose custom settings match <expression>, e.g. \"MaxHealth > 500 and Cost < 300\".", "expression");
+    QCommandLineOption benchmarkTexturesOption("benchmark-textures", "Time texture decoding on generated data, per instruction set.");
+    QCommandLineOption benchmarkObjOption("benchmark-obj", "Time OBJ text generation for a generated mesh.");
+
+    QCommandLineOption threadsOption("threads", "Worker threads for parsing and exporting (default: all cores).", "count", "0");
+    QCommandLineOption textureFormatOption("texture-format", "Exported texture format: png or jpeg (default: png).", "format", "png");
+    QCommandLineOption textureScaleOption("texture-scale", "Exported texture size in percent: 100, 50 or 25 (default: 100).", "percent", "100");
+    QCommandLineOption objPrecisionOption("obj-precision", "Decimals of OBJ coordinates, 0-9 or 'shortest' (default: 6).", "digits", "6");
+    QCommandLineOption glbOption("glb", "Also export one GLB model per object, textures embedded.");
+    QCommandLineOption glbReferenceTexturesOption("glb-reference-textures", "Reference the exported texture files from GLB models instead of embedding them.");
+    QCommandLineOption dedupOption("dedup", "Export identical meshes and textures once, see dedup_manifest.json.");
+    QCommandLineOption incrementalOption("incremental", "Only write files whose source changed since the last export into <output>.");
+    QCommandLineOption noObjOption("no-obj", "Do not export meshes as OBJ.");
+    QCommandLineOption noTexturesOption("no-textures", "Do not export textures.");
+    QCommandLineOption noJsonOption("no-json", "Do not export object and material JSON.");
+    QCommandLineOption noBlenderScriptOption("no-blender-script", "Do not write the Blender import script.");
+    QCommandLineOption cacheOption("cache", "Read and update the project cache next to <input>.");
+    QCommandLineOption streamingOption("streaming", "Export one object at a time instead of loading the whole project (--export-all, --export-asset-list).");
+    QCommandLineOption sizeOption("size", "Texture width and height for --benchmark-textures (default: 1024).", "pixels", "1024");
+    QCommandLineOption verticesOption("vertices", "Mesh vertex count for --benchmark-obj (default: 20000).", "count", "20000");
+    QCommandLineOption iterationsOption("iterations", "Timed runs per measurement for the benchmarks (default: 10).", "count", "10");
+
+    parser.addOptions({ exportAllOption, exportTemplatesOption, exportAssetListOption, validateOption, convertOption, queryOption, benchmarkTexturesOption, benchmarkObjOption,
+                        threadsOption, textureFormatOption, textureScaleOption, objPrecisionOption,
+                        glbOption, glbReferenceTexturesOption, dedupOption, incrementalOption, noObjOption, noTexturesOption, noJsonOption, noBlenderScriptOption, cacheOption, streamingOption,
+                        sizeOption, verticesOption, iterationsOption });
+    parser.addPositionalArgument("input", "The .opf file to read.");
+    parser.addPositionalArgument("output", "Output file or directory, if the command writes one.");
+
+    if (!parser.parse(arguments))
+    {
+        m_lastError = parser.errorText();
+        return false;
+    }
+
+    if (parser.isSet("help"))
+    {
+        writeOut(parser.helpText().toLocal8Bit());
+        return false;
+    }
+
+    if (parser.isSet("version"))
+    {
+        writeOut(QString("%1 %2\n").arg(QCoreApplication::applicationName(), QCoreApplication::applicationVersion()).toLocal8Bit());
+        return false;
+    }
+
+    struct CommandFlag
+    {
+        const QCommandLineOption* option;
+        Command command;
+        int arguments;      // positional: <input> [<output>]
+    };
+
+    const CommandFlag commands[] = {
+        { &exportAllOption,         Command::ExportAll,         2 },
+        { &exportTemplatesOption,   Command::ExportTemplates,   2 },
+        { &exportAssetListOption,   Command::ExportAssetList,   2 },
+        { &validateOption,          Command::Validate,          1 },
+        { &convertOption,           Command::Convert,           2 },
+        { &queryOption,             Command::Query,             1 },
+        { &benchmarkTexturesOption, Command::BenchmarkTextures, 0 },
+        { &benchmarkObjOption,      Command::BenchmarkObj,      0 },
+    };
+
+    int argumentCount = 0;
+    for (const CommandFlag& flag : commands)
+    {
+        if (!parser.isSet(*flag.option))
+        {
+            continue;
+        }
+        if (m_command != Command::None)
+        {
+            m_lastError = "Only one command can be given at a time";
+            m_command = Command::None;
+            return false;
+        }
+        m_command = flag.command;
+        m_commandName = flag.option->names().first();
+        argumentCount = flag.arguments;
+    }
+
+    if (m_command == Command::None)
+    {
+        m_lastError = "No command given, see --help";
+        return false;
+    }
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != argumentCount)
+    {
+        const char* const usage[] = { "no arguments", "<input>", "<input> <output>" };
+        m_lastError = QString("--%1 expects %2").arg(m_commandName, usage[argumentCount]);
+        return false;
+    }
+
+    m_input = argumentCount > 0 ? positional.at(0) : QString();
+    m_output = argumentCount > 1 ? positional.at(1) : QString();
+    m_query = parser.value(queryOption);
+
+    bool ok = false;
+    m_options.threadCount = parser.value(threadsOption).toInt(&ok);
+    if (!ok || m_options.threadCount < 0)
+    {
+        m_lastError = QString("Invalid thread count: %1").arg(parser.value(threadsOption));
+        return false;
+    }
+
+    QString format = parser.value(textureFormatOption).toLower();
+    if (format == "png")
+    {
+        m_options.textureFormat = SettingsManager::PNG;
+    }
+    else if (format == "jpeg" || format == "jpg")
+    {
+        m_options.textureFormat = SettingsManager::JPEG;
+    }
+    else
+    {
+        m_lastError = QString("Unknown texture format: %1").arg(format);
+        return false;
+    }
+
+    int scale = parser.value(textureScaleOption).toInt(&ok);
+    if (!ok || (scale != 100 && scale != 50 && scale != 25))
+    {
+        m_lastError = QString("Invalid texture scale: %1").arg(parser.value(textureScaleOption));
+        return false;
+    }
+    m_options.textureScale = SettingsManager::TextureScale(scale);
+
+    QString precision = parser.value(objPrecisionOption).toLower();
+    if (precision == "shortest")
+    {
+        m_options.objPrecision = ObjWriter::kShortestPrecision;
+    }
+    else
+    {
+        m_options.objPrecision = precision.toInt(&ok);
+        if (!ok || m_options.objPrecision < 0 || m_options.objPrecision > 9)
+        {
+            m_lastError = QString("Invalid OBJ precision: %1").arg(precision);
+            return false;
+        }
+    }
+
+    m_options.exportOBJ = !parser.isSet(noObjOption);
+    m_options.exportPNG = !parser.isSet(noTexturesOption);
+    m_options.exportJSON = !parser.isSet(noJsonOption);
+    m_options.exportBlenderScript = !parser.isSet(noBlenderScriptOption);
+    m_options.exportGLB = parser.isSet(glbOption) || parser.isSet(glbReferenceTexturesOption);
+    m_options.embedGlbTextures = !parser.isSet(glbReferenceTexturesOption);
+    m_options.deduplicate = parser.isSet(dedupOption);
+    m_options.incremental = parser.isSet(incrementalOption);
+    m_useCache = parser.isSet(cacheOption);
+    m_streaming = parser.isSet(streamingOption);
+
+    if (m_streaming)
+    {
+        // Streaming never holds the whole project, which these need
+        if (m_command != Command::ExportAll && m_command != Command::ExportAssetList)
+        {
+            m_lastError = QString("--streaming cannot be used with --%1").arg(m_commandName);
+            return false;
+        }
+        if (m_options.deduplicate || m_options.incremental || m_useCache)
+        {
+            m_lastError = "--streaming cannot be combined with --dedup, --incremental or --cache";
+            return false;
+        }
+        // Texture payloads are gone by the time objects arrive
+        if (m_options.exportGLB && m_options.embedGlbTextures)
+        {
+            m_lastError = "--streaming writes GLB files with --glb-reference-textures only";
+            return false;
+        }
+    }
+
+    m_benchmarkSize = parser.value(sizeOption).toInt(&ok);
+    if (!ok || m_benchmarkSize < 1 || m_benchmarkSize > 8192)
+    {
+        m_lastError = QString("Invalid benchmark size: %1").arg(parser.value(sizeOption));
+        return false;
+    }
+
+    m_benchmarkVertices = parser.value(verticesOption).toInt(&ok);
+    if (!ok || m_benchmarkVertices < 3 || m_benchmarkVertices > 65535)
+    {
+        m_lastError = QString("Invalid benchmark vertex count: %1").arg(parser.value(verticesOption));
+        return false;
+    }
+
+    m_benchmarkIterations = parser.value(iterationsOption).toInt(&ok);
+    if (!ok || m_benchmarkIterations < 1)
+    {
+        m_lastError = QString("Invalid iteration count: %1").arg(parser.value(iterationsOption));
+        return false;
+    }
+
+    // Only exports decode textures, and they drop each payload once written
+    m_lazyTextures = m_command != Command::Validate && m_command != Command::Convert;
+    return true;
+}
+
+bool CommandLine::loadProject(PackedProject*& project)
+{
+    ProjectLoader loader;
+    loader.setTextureLoadMode(m_lazyTextures ? OpfParser::TextureLoadMode::Lazy : OpfParser::TextureLoadMode::Eager);
+    loader.setObjectStorage(OpfParser::ObjectStorage::Arena);
+    loader.setMaxThreadCount(m_options.threadCount);
+    loader.setUseCache(m_useCache);
+
+    project = loader.load(m_input);
+    if (!project)
+    {
+        m_lastError = QString("Failed to load %1: %2").arg(m_input, loader.lastError());
+        return false;
+    }
+
+    // Cached projects reference their texture payloads in the .opf
+    if (loader.loadedFromCache() && !m_lazyTextures)
+    {
+        for (const Texture& texture : project->textures)
+        {
+            texture.detachDataSource();
+        }
+    }
+
+    m_details["fromCache"] = loader.loadedFromCache();
+    m_truncated = loader.wasTruncated();
+    return true;
+}
+
+bool CommandLine::runExportAll(const PackedProject& project)
+{
+    OpfExporter exporter;
+    exporter.setOptions(m_options);
+
+    if (!exporter.exportAll(project, m_output))
+    {
+        m_lastError = exporter.lastError();
+        return false;
+    }
+
+    m_details["threads"] = m_options.threadCount > 0 ? m_options.threadCount : QThread::idealThreadCount();
+    if (m_options.deduplicate)
+    {
+        m_details["dedup"] = exporter.dedupSummary();
+    }
+    if (m_options.incremental)
+    {
+        m_details["incremental"] = exporter.incrementalSummary();
+    }
+    return true;
+}
+
+bool CommandLine::runExportTemplates(const PackedProject& project)
+{
+    OpfExporter exporter;
+    exporter.setOptions(m_options);
+
+    if (!exporter.exportTemplatesToJson(project, m_output))
+    {
+        m_lastError = exporter.lastError();
+        return false;
+    }
+    return true;
+}
+
+bool CommandLine::runExportAssetList(const PackedProject& project)
+{
+    OpfExporter exporter;
+    exporter.setOptions(m_options);
+
+    if (!exporter.exportAssetListToTxt(project, m_output))
+    {
+        m_lastError = exporter.lastError();
+        return false;
+    }
+    return true;
+}
+
+bool CommandLine::runStreamingExport()
+{
+    OpfExporter exporter;
+    exporter.setOptions(m_options);
+
+    bool success = m_command == Command::ExportAll ? exporter.exportAllStreaming(m_input, m_output)
+                                                   : exporter.exportAssetListStreaming(m_input, m_output);
+    m_details["streaming"] = true;
+    m_details["peakObjectsHeld"] = exporter.peakObjectsHeld();
+    if (!success)
+    {
+        m_lastError = exporter.lastError();
+        return false;
+    }
+    return true;
+}
+
+bool CommandLine::runValidate(const PackedProject& project)
+{
+    QJsonArray problems;
+    int problemCount = 0;
+
+    if (m_truncated)
+    {
+        problemCount++;
+        problems.append(QString("Unexpected end of file, missing fields were left at their defaults"));
+    }
+
+    for (const Material& material : project.materials)
+    {
+        if (material.textureID != -1 && !project.findTextureByID(material.textureID))
+        {
+            if (++problemCount <= kMaxReportedProblems)
+            {
+                problems.append(QString("Material '%1': texture %2 not found").arg(material.name).arg(material.textureID));
+            }
+        }
+    }
+
+    for (const Object* object : project.objects)
+    {
+        checkMeshMaterials(*object, project, problems, problemCount);
+    }
+
+    m_details["problemCount"] = problemCount;
+    m_details["problems"] = problems;
+
+    if (problemCount > 0)
+    {
+        m_lastError = QString("%1 problem(s) found in %2").arg(problemCount).arg(m_input);
+        return false;
+    }
+    return true;
+}
+
+bool CommandLine::runQuery(const PackedProject& project)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    SettingsTable table;
+    table.build(project, SettingsTable::knownSettingNames());
+    double buildMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    QVector<const Object*> matches;
+    if (!table.select(m_query, matches))
+    {
+        m_lastError = QString("Invalid query: %1").arg(table.lastError());
+        return false;
+    }
+    double queryMs = timer.nsecsElapsed() / 1e6;
+
+    QJsonArray objects;
+    for (const Object* object : std::as_const(matches))
+    {
+        QJsonObject entry;
+        entry["name"] = object->name;
+        entry["uniqueID"] = static_cast<qint64>(object->uniqueID);
+        entry["class"] = object->className;
+        objects.append(entry);
+    }
+
+    m_details["query"] = m_query;
+    m_details["rows"] = table.rowCount();
+    m_details["columns"] = table.columnCount();
+    m_details["tableBuildMs"] = buildMs;
+    m_details["queryMs"] = queryMs;
+    m_details["matchCount"] = matches.size();
+    m_details["matches"] = objects;
+    return true;
+}
+
+bool CommandLine::runConvert(const PackedProject& project)
+{
+    if (QFileInfo(m_output).absoluteFilePath() == QFileInfo(m_input).absoluteFilePath())
+    {
+        m_lastError = "--convert cannot write over its input";
+        return false;
+    }
+
+    OpfWriter writer;
+    if (!writer.write(m_output, project))
+    {
+        m_lastError = writer.lastError();
+        return false;
+    }
+
+    m_details["outputSize"] = QFileInfo(m_output).size();
+    return true;
+}
+
+bool CommandLine::runBenchmarkTextures()
+{
+    using namespace TextureDecoder;
+
+    // 16-bit color with a 16-bit alpha plane, the slowest case before
+    Texture texture;
+    texture.name = "benchmark";
+    texture.width = quint32(m_benchmarkSize);
+    texture.height = quint32(m_benchmarkSize);
+    texture.colorBitsPerPixel = 16;
+    texture.alphaBitsPerPixel = 16;
+    texture.hasAlphaChannel = true;
+
+    const int pixels = m_benchmarkSize * m_benchmarkSize;
+    QRandomGenerator random(0x4F5046);
+    texture.colorData = QByteArray(pixels * 2, 0);
+    texture.alphaData = QByteArray(pixels * 2, 0);
+    random.fillRange(reinterpret_cast<quint32*>(texture.colorData.data()), pixels / 2);
+    random.fillRange(reinterpret_cast<quint32*>(texture.alphaData.data()), pixels / 2);
+
+    QByteArray rgb(pixels * 3, 0);
+    QByteArray alpha(pixels, 0);
+    QByteArray rgba(pixels * 4, 0);
+    random.fillRange(reinterpret_cast<quint32*>(rgb.data()), rgb.size() / 4);
+    random.fillRange(reinterpret_cast<quint32*>(alpha.data()), alpha.size() / 4);
+
+    const quint16* src565 = reinterpret_cast<const quint16*>(texture.colorData.constData());
+    const quint16* src16 = reinterpret_cast<const quint16*>(texture.alphaData.constData());
+    const uchar* srcRgb = reinterpret_cast<const uchar*>(rgb.constData());
+    const uchar* srcAlpha = reinterpret_cast<const uchar*>(alpha.constData());
+    uchar* dst = reinterpret_cast<uchar*>(rgba.data());
+    const int width = m_benchmarkSize;
+
+    QImage reference = decodePerPixel(texture);
+    double perPixelMs = bestTimeMs(m_benchmarkIterations, [&]() { decodePerPixel(texture); });
+
+    QImage decoded;
+    double decodeMs = bestTimeMs(m_benchmarkIterations, [&]() { decoded = decode(texture); });
+
+    bool identical = decoded == reference;
+
+    QJsonObject isas;
+    for (InstructionSet isa : { InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2 })
+    {
+        if (!isSupported(isa))
+        {
+            continue;
+        }
+
+        // Whole-texture passes, row by row like the decode functions
+        const RowKernels& k = kernels(isa);
+        auto rows = [&](auto row) {
+            return bestTimeMs(m_benchmarkIterations, [&]() {
+                for (int y = 0; y < m_benchmarkSize; y++)
+                {
+                    row(qint64(y) * width);
+                }
+            });
+        };
+
+        QJsonObject timings;
+        timings["rgb565ToRgb888Ms"] = rows([&](qint64 i) { k.rgb565ToRgb888(src565 + i, dst + i * 3, width); });
+        timings["rgb565ToRgba8888Ms"] = rows([&](qint64 i) { k.rgb565ToRgba8888(src565 + i, dst + i * 4, width); });
+        timings["gray16ToGray8Ms"] = rows([&](qint64 i) { k.gray16ToGray8(src16 + i, dst + i, width); });
+        timings["setAlphaMs"] = rows([&](qint64 i) { k.setAlpha(dst + i * 4, srcAlpha + i, width); });
+        timings["rgb888AlphaToRgba8888Ms"] = rows([&](qint64 i) { k.rgb888AlphaToRgba8888(srcRgb + i * 3, srcAlpha + i, dst + i * 4, width); });
+        isas[instructionSetName(isa)] = timings;
+    }
+
+    QJsonObject benchmark;
+    benchmark["size"] = m_benchmarkSize;
+    benchmark["iterations"] = m_benchmarkIterations;
+    benchmark["activeInstructionSet"] = instructionSetName(activeInstructionSet());
+    benchmark["perPixelDecodeMs"] = perPixelMs;
+    benchmark["decodeMs"] = decodeMs;
+    benchmark["speedup"] = decodeMs > 0.0 ? perPixelMs / decodeMs : 0.0;
+    benchmark["identicalOutput"] = identical;
+    benchmark["kernels"] = isas;
+    m_details["benchmark"] = benchmark;
+
+    if (!identical)
+    {
+        m_lastError = "Decoded texture differs from the per-pixel reference";
+        return false;
+    }
+    return true;
+}
+
+bool CommandLine::runBenchmarkObj()
+{
+    // One morph target with normals and texture coordinates, indices limited
+    // to 16 bits like in .opf files
+    QSharedPointer<GeometryPool> geometry = QSharedPointer<GeometryPool>::create();
+    const int vertexCount = m_benchmarkVertices;
+    const int indexCount = vertexCount * 6;
+
+    QRandomGenerator random(0x4F424A);
+    geometry->allocateVertices(vertexCount);
+    GeometryPool::allocate(geometry->texCoords, vertexCount);
+    GeometryPool::allocate(geometry->indices, indexCount);
+    for (int i = 0; i < vertexCount; i++)
+    {
+        geometry->positions[i] = Vector3D(float(random.bounded(200.0) - 100.0), float(random.bounded(200.0) - 100.0), float(random.bounded(200.0) - 100.0));
+        geometry->normals[i] = Vector3D(float(random.bounded(2.0) - 1.0), float(random.bounded(2.0) - 1.0), float(random.bounded(2.0) - 1.0));
+        geometry->texCoords[i] = Vector2D(float(random.bounded(1.0)), float(random.bounded(1.0)));
+    }
+    for (int i = 0; i < indexCount; i++)
+    {
+        geometry->indices[i] = uint16(random.bounded(vertexCount));
+    }
+
+    Mesh mesh;
+    mesh.name = "benchmark";
+    mesh.materialID = 1;
+    mesh.geometry = geometry;
+    mesh.morphSize = vertexCount;
+    mesh.numVertexMorphs = 1;
+    mesh.numTextureMorphs = 1;
+    mesh.indexCount = indexCount;
+    mesh.numFaces = indexCount / 3;
+
+    const QString mtlFilename = "benchmark.mtl";
+
+    QByteArray legacy;
+    double legacyMs = bestTimeMs(m_benchmarkIterations, [&]() { legacy = legacyObjText(mesh, mtlFilename); });
+
+    QByteArray fixed;
+    double fixedMs = bestTimeMs(m_benchmarkIterations, [&]() {
+        ObjWriter writer;
+        writer.writeMesh(mesh, mtlFilename);
+        fixed = writer.data();
+    });
+
+    QByteArray shortest;
+    double shortestMs = bestTimeMs(m_benchmarkIterations, [&]() {
+        ObjWriter writer(ObjWriter::kShortestPrecision);
+        writer.writeMesh(mesh, mtlFilename);
+        shortest = writer.data();
+    });
+
+    bool identical = fixed == legacy;
+
+    QJsonObject benchmark;
+    benchmark["vertices"] = vertexCount;
+    benchmark["faces"] = indexCount / 3;
+    benchmark["iterations"] = m_benchmarkIterations;
+    benchmark["legacyMs"] = legacyMs;
+    benchmark["objWriterMs"] = fixedMs;
+    benchmark["objWriterShortestMs"] = shortestMs;
+    benchmark["speedup"] = fixedMs > 0.0 ? legacyMs / fixedMs : 0.0;
+    benchmark["bytes"] = fixed.size();
+    benchmark["shortestBytes"] = shortest.size();
+    benchmark["identicalOutput"] = identical;
+    m_details["benchmark"] = benchmark;
+
+    if (!identical)
+    {
+        m_lastError = "ObjWriter output differs from the QTextStream reference";
+        return false;
+    }
+    return true;
+}
+
+QJsonObject CommandLine::projectCounts(const PackedProject& project)
+{
+    int meshes = 0;
+    int children = 0;
+
+    for (const Object* object : project.objects)
+    {
+        const SubtreeStats& stats = object->subtreeStats();
+        meshes += stats.meshes;
+        children += stats.descendants;
+    }
+
+    QJsonObject counts;
+    counts["objects"] = project.objects.size();
+    counts["childObjects"] = children;
+    counts["meshes"] = meshes;
+    counts["textures"] = project.textures.size();
+    counts["materials"] = project.materials.size();
+    counts["dependencies"] = project.dependencies.size();
+    counts["events"] = project.eventDescs.size();
+    return counts;
+}
+
+void CommandLine::printSummary(bool success, qint64 loadMs, qint64 commandMs, const PackedProject* project)
+{
+    QJsonObject summary = m_details;
+    summary["command"] = m_commandName;
+    if (!m_input.isEmpty())
+    {
+        summary["input"] = QFileInfo(m_input).absoluteFilePath();
+    }
+    if (!m_output.isEmpty())
+    {
+        summary["output"] = QFileInfo(m_output).absoluteFilePath();
+    }
+    summary["success"] = success;
+    if (!success)
+    {
+        summary["error"] = m_lastError;
+    }
+
+    if (project)
+    {
+        summary["project"] = project->projectName;
+        summary["counts"] = projectCounts(*project);
+    }
+
+    QJsonObject timings;
+    timings["loadMs"] = loadMs;
+    timings["commandMs"] = commandMs;
+    timings["totalMs"] = loadMs + commandMs;
+    summary["timings"] = timings;
+
+    writeOut(QJsonDocument(summary).toJson(QJsonDocument::Indented));
+}
+
+} // namespace Opf
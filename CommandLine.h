@@ -0,0 +1,79 @@
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include "OpfStructs.h"
+#include "OpfExporter.h"
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+
+namespace Opf {
+
+// ============================================================================
+// COMMAND LINE - headless batch mode
+// ============================================================================
+//
+//   UnitDeveloperTool --export-all in.opf outdir [--threads N] [--glb] [--dedup] [--incremental] [--streaming] [...]
+//   UnitDeveloperTool --export-templates in.opf templates.json
+//   UnitDeveloperTool --export-asset-list in.opf assets.txt [--streaming]
+//   UnitDeveloperTool --validate in.opf
+//   UnitDeveloperTool --convert in.opf out.opf
+//   UnitDeveloperTool --query "MaxHealth > 500 and Cost < 300" in.opf
+//   UnitDeveloperTool --benchmark-textures [--size N] [--iterations N]
+//   UnitDeveloperTool --benchmark-obj [--vertices N] [--iterations N]
+//
+// Runs under QCoreApplication, so no display is needed. Export settings come
+// from the flags only, never from the user's QSettings. A JSON summary with
+// counts and timings is printed to stdout; the exit code is 0 on success,
+// 1 if the command failed and 2 for usage errors. With --streaming the
+// exports read one top-level object at a time instead of loading the project.
+
+class CommandLine
+{
+public:
+    // True if the arguments ask for a batch command (or --help / --version)
+    // rather than the GUI
+    static bool isRequested(int argc, char* argv[]);
+
+    int run(const QStringList& arguments);
+
+private:
+    enum class Command { None, ExportAll, ExportTemplates, ExportAssetList, Validate, Convert, Query, BenchmarkTextures, BenchmarkObj };
+
+    bool parseArguments(const QStringList& arguments);
+    bool loadProject(PackedProject*& project);
+
+    bool runExportAll(const PackedProject& project);
+    bool runExportTemplates(const PackedProject& project);
+    bool runExportAssetList(const PackedProject& project);
+    bool runStreamingExport();
+    bool runValidate(const PackedProject& project);
+    bool runConvert(const PackedProject& project);
+    bool runQuery(const PackedProject& project);
+    bool runBenchmarkTextures();
+    bool runBenchmarkObj();
+
+    static QJsonObject projectCounts(const PackedProject& project);
+    void printSummary(bool success, qint64 loadMs, qint64 commandMs, const PackedProject* project);
+
+    Command m_command = Command::None;
+    QString m_commandName;
+    QString m_input;
+    QString m_output;
+    ExportOptions m_options;
+    QString m_query;
+    bool m_useCache = false;
+    bool m_streaming = false;
+    bool m_truncated = false;
+    bool m_lazyTextures = false;
+    int m_benchmarkSize = 1024;
+    int m_benchmarkVertices = 20000;
+    int m_benchmarkIterations = 10;
+
+    QJsonObject m_details;      // command-specific summary fields
+    QString m_lastError;
+};
+
+} // namespace Opf
+
+#endif // COMMANDLINE_H
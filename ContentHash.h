@@ -0,0 +1,134 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QByteArray>
+#include <cstring>
+
+namespace Opf {
+
+// ============================================================================
+// CONTENT HASH - fast 64-bit non-cryptographic hash (xxHash64 algorithm)
+// ============================================================================
+//
+// Used to detect whether file contents or serialized records changed. Works
+// on 32-byte stripes with four independent accumulators, so it runs at
+// memory bandwidth on large buffers.
+
+namespace ContentHashDetail {
+
+const quint64 kPrime1 = 11400714785074694791ULL;
+const quint64 kPrime2 = 14029467366897019727ULL;
+const quint64 kPrime3 = 1609587929392839161ULL;
+const quint64 kPrime4 = 9650029242287828579ULL;
+const quint64 kPrime5 = 2870177450012600261ULL;
+
+inline quint64 rotl(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline quint64 read64(const uchar* p)
+{
+    quint64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline quint32 read32(const uchar* p)
+{
+    quint32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline quint64 mixRound(quint64 acc, quint64 input)
+{
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline quint64 mergeRound(quint64 acc, quint64 value)
+{
+    acc ^= mixRound(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace ContentHashDetail
+
+inline quint64 contentHash(const void* data, qint64 size, quint64 seed = 0)
+{
+    using namespace ContentHashDetail;
+
+    const uchar* p = static_cast<const uchar*>(data);
+    const uchar* end = p + size;
+    quint64 h;
+
+    if (size >= 32)
+    {
+        quint64 v1 = seed + kPrime1 + kPrime2;
+        quint64 v2 = seed + kPrime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - kPrime1;
+
+        const uchar* limit = end - 32;
+        do
+        {
+            v1 = mixRound(v1, read64(p));
+            v2 = mixRound(v2, read64(p + 8));
+            v3 = mixRound(v3, read64(p + 16));
+            v4 = mixRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+
+    else
+    {
+        h = seed + kPrime5;
+    }
+
+    h += static_cast<quint64>(size);
+
+    while (p + 8 <= end)
+    {
+        h ^= mixRound(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+
+    if (p + 4 <= end)
+    {
+        h ^= static_cast<quint64>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+
+    while (p < end)
+    {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+inline quint64 contentHash(const QByteArray& data, quint64 seed = 0)
+{
+    return contentHash(data.constData(), data.size(), seed);
+}
+
+} // namespace Opf
+
+#endif // CONTENTHASH_H
@@ -47,8 +47,6 @@ private:
     QPushButton* m_removeButton;
     QComboBox* m_nameCombo;
     QLineEdit* m_valueEdit;
-
-    static const QStringList s_knownSettingNames;
 };
 
 class CanBuildUnitWidget : public QWidget
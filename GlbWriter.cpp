@@ -0,0 +1,608 @@
+#include "GlbWriter.h"
+#include "TextureCache.h"
+#include <QJsonDocument>
+#include <QBuffer>
+#include <QFile>
+#include <QImage>
+#include <QUrl>
+#include <QtEndian>
+#include <cmath>
+
+namespace Opf {
+
+namespace {
+
+// glTF enums
+const int kArrayBuffer = 34962;
+const int kElementArrayBuffer = 34963;
+const int kFloat = 5126;
+const int kUnsignedShort = 5123;
+
+const int kModePoints = 0;
+const int kModeLines = 1;
+const int kModeTriangles = 4;
+
+const int kNearest = 9728;
+const int kLinear = 9729;
+const int kNearestMipmapNearest = 9984;
+const int kLinearMipmapNearest = 9985;
+const int kNearestMipmapLinear = 9986;
+const int kLinearMipmapLinear = 9987;
+
+const int kRepeat = 10497;
+const int kMirroredRepeat = 33648;
+const int kClampToEdge = 33071;
+
+// GLB container
+const quint32 kGlbMagic = 0x46546C67;       // "glTF"
+const quint32 kGlbVersion = 2;
+const quint32 kChunkJson = 0x4E4F534A;      // "JSON"
+const quint32 kChunkBinary = 0x004E4942;    // "BIN\0"
+
+const char* const kUnlitExtension = "KHR_materials_unlit";
+
+static_assert(sizeof(Vector3D) == 3 * sizeof(float), "Vector3D is copied as three floats");
+static_assert(sizeof(Vector2D) == 2 * sizeof(float), "Vector2D is copied as two floats");
+
+int alignedSize(int size)
+{
+    return (size + 3) & ~3;
+}
+
+QJsonArray vectorArray(const Vector3D& v)
+{
+    return QJsonArray{ v.x, v.y, v.z };
+}
+
+// Euler angles in radians, applied like D3DXMatrixRotationYawPitchRoll:
+// roll (z) first, then pitch (x), then yaw (y). Returns x, y, z, w.
+QJsonArray rotationQuaternion(const Vector3D& rotation)
+{
+    double cx = std::cos(rotation.x * 0.5), sx = std::sin(rotation.x * 0.5);
+    double cy = std::cos(rotation.y * 0.5), sy = std::sin(rotation.y * 0.5);
+    double cz = std::cos(rotation.z * 0.5), sz = std::sin(rotation.z * 0.5);
+
+    // q = yaw * pitch * roll
+    double x = cy * sx * cz + sy * cx * sz;
+    double y = sy * cx * cz - cy * sx * sz;
+    double z = cy * cx * sz - sy * sx * cz;
+    double w = cy * cx * cz + sy * sx * sz;
+    return QJsonArray{ x, y, z, w };
+}
+
+// Stage 0 of the first render pass that has a texture, as OpfParser picks
+// Material::textureID
+const RenderPassStage* textureStage(const Material& material)
+{
+    for (const RenderPass1Stage& pass : material.renderPasses1Stage)
+    {
+        if (pass.stages[0].textureID != 0) return &pass.stages[0];
+    }
+    for (const RenderPass2Stage& pass : material.renderPasses2Stage)
+    {
+        if (pass.stages[0].textureID != 0) return &pass.stages[0];
+    }
+    for (const RenderPass3Stage& pass : material.renderPasses3Stage)
+    {
+        if (pass.stages[0].textureID != 0) return &pass.stages[0];
+    }
+    return nullptr;
+}
+
+const RenderPassSettings* firstPassSettings(const Material& material)
+{
+    if (!material.renderPasses1Stage.isEmpty()) return &material.renderPasses1Stage.first().settings;
+    if (!material.renderPasses2Stage.isEmpty()) return &material.renderPasses2Stage.first().settings;
+    if (!material.renderPasses3Stage.isEmpty()) return &material.renderPasses3Stage.first().settings;
+    return nullptr;
+}
+
+int wrapMode(ETextureAddress address)
+{
+    switch (address)
+    {
+    case ETextureAddress::Wrap:   return kRepeat;
+    case ETextureAddress::Mirror: return kMirroredRepeat;
+    case ETextureAddress::Clamp:
+    case ETextureAddress::Border: return kClampToEdge;
+    }
+    return kRepeat;
+}
+
+int minFilter(const RenderPassStage& stage)
+{
+    bool nearest = stage.maxTextureMinificationFilter == ETextureMinificationFilter::Point;
+    switch (stage.maxTextureMipmapFilter)
+    {
+    case ETextureMipmapFilter::None:  return nearest ? kNearest : kLinear;
+    case ETextureMipmapFilter::Point: return nearest ? kNearestMipmapNearest : kLinearMipmapNearest;
+    case ETextureMipmapFilter::Linear: return nearest ? kNearestMipmapLinear : kLinearMipmapLinear;
+    }
+    return kLinearMipmapLinear;
+}
+
+void appendUint32(QByteArray& data, quint32 value)
+{
+    quint32 le = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char*>(&le), sizeof(le));
+}
+
+} // namespace
+
+// ============================================================================
+// GLB WRITER
+// ============================================================================
+
+GlbWriter::GlbWriter(const PackedProject& project)
+    : m_project(project), m_textureScale(100), m_usesUnlit(false)
+{
+}
+
+void GlbWriter::clear()
+{
+    m_binary.clear();
+    m_nodes = QJsonArray();
+    m_meshes = QJsonArray();
+    m_materials = QJsonArray();
+    m_textures = QJsonArray();
+    m_images = QJsonArray();
+    m_samplers = QJsonArray();
+    m_bufferViews = QJsonArray();
+    m_accessors = QJsonArray();
+    m_usesUnlit = false;
+    m_materialIndex.clear();
+    m_imageIndex.clear();
+    m_samplerIndex.clear();
+    m_textureIndex.clear();
+}
+
+bool GlbWriter::write(const Object& object, const QString& filename)
+{
+    clear();
+    int root = addNode(object);
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        m_lastError = QString("Cannot write file: %1").arg(filename);
+        return false;
+    }
+
+    QJsonObject scene;
+    scene["name"] = object.name;
+    scene["nodes"] = QJsonArray{ root };
+
+    QJsonObject asset;
+    asset["version"] = "2.0";
+    asset["generator"] = "OutforceAssetBrowser";
+
+    QJsonObject gltf;
+    gltf["asset"] = asset;
+    gltf["scene"] = 0;
+    gltf["scenes"] = QJsonArray{ scene };
+    gltf["nodes"] = m_nodes;
+
+    auto setIfAny = [&gltf](const char* key, const QJsonArray& array) {
+        if (!array.isEmpty())
+        {
+            gltf[key] = array;
+        }
+    };
+    setIfAny("meshes", m_meshes);
+    setIfAny("materials", m_materials);
+    setIfAny("textures", m_textures);
+    setIfAny("images", m_images);
+    setIfAny("samplers", m_samplers);
+    setIfAny("bufferViews", m_bufferViews);
+    setIfAny("accessors", m_accessors);
+
+    if (!m_binary.isEmpty())
+    {
+        QJsonObject buffer;
+        buffer["byteLength"] = m_binary.size();
+        gltf["buffers"] = QJsonArray{ buffer };
+    }
+
+    if (m_usesUnlit)
+    {
+        gltf["extensionsUsed"] = QJsonArray{ kUnlitExtension };
+    }
+
+    QByteArray json = QJsonDocument(gltf).toJson(QJsonDocument::Compact);
+    json.append(QByteArray(alignedSize(json.size()) - json.size(), ' '));
+
+    QByteArray glb;
+    glb.reserve(12 + 8 + json.size() + 8 + m_binary.size());
+    appendUint32(glb, kGlbMagic);
+    appendUint32(glb, kGlbVersion);
+    appendUint32(glb, quint32(12 + 8 + json.size() + (m_binary.isEmpty() ? 0 : 8 + m_binary.size())));
+
+    appendUint32(glb, quint32(json.size()));
+    appendUint32(glb, kChunkJson);
+    glb.append(json);
+
+    if (!m_binary.isEmpty())
+    {
+        appendUint32(glb, quint32(m_binary.size()));
+        appendUint32(glb, kChunkBinary);
+        glb.append(m_binary);
+    }
+
+    if (file.write(glb) != glb.size())
+    {
+        m_lastError = QString("Cannot write file: %1").arg(filename);
+        return false;
+    }
+    return true;
+}
+
+int GlbWriter::addNode(const Object& object)
+{
+    // Children are added first, so reserve this node's index
+    int index = m_nodes.size();
+    m_nodes.append(QJsonObject());
+
+    QJsonObject node;
+    node["name"] = object.name;
+
+    const Vector3D& p = object.position;
+    if (p.x != 0.0f || p.y != 0.0f || p.z != 0.0f)
+    {
+        node["translation"] = vectorArray(p);
+    }
+
+    const Vector3D& r = object.rotation;
+    if (r.x != 0.0f || r.y != 0.0f || r.z != 0.0f)
+    {
+        node["rotation"] = rotationQuaternion(r);
+    }
+
+    // An all-zero scaling was never set
+    const Vector3D& s = object.scaling;
+    bool unset = s.x == 0.0f && s.y == 0.0f && s.z == 0.0f;
+    bool identity = s.x == 1.0f && s.y == 1.0f && s.z == 1.0f;
+    if (!unset && !identity)
+    {
+        node["scale"] = vectorArray(s);
+    }
+
+    int mesh = addMesh(object);
+    if (mesh >= 0)
+    {
+        node["mesh"] = mesh;
+    }
+
+    QJsonArray children;
+    for (const Object* child : object.children)
+    {
+        if (child)
+        {
+            children.append(addNode(*child));
+        }
+    }
+    if (!children.isEmpty())
+    {
+        node["children"] = children;
+    }
+
+    QJsonObject extras;
+    extras["className"] = object.className;
+    extras["uniqueID"] = object.uniqueID;
+    node["extras"] = extras;
+
+    m_nodes.replace(index, node);
+    return index;
+}
+
+int GlbWriter::addMesh(const Object& object)
+{
+    QJsonArray primitives;
+
+    for (const Mesh& mesh : object.meshes())
+    {
+        VertexView vertices = mesh.vertices();
+        ArrayView<uint16> indices = mesh.indices();
+        if (vertices.size() == 0 || indices.isEmpty())
+        {
+            continue;
+        }
+
+        // Triangles get their winding reversed; triangles or lines that
+        // reference missing vertices are dropped
+        int mode = kModeTriangles;
+        int corners = 3;
+        if (mesh.bufferType == EBufferType::Points)
+        {
+            mode = kModePoints;
+            corners = 1;
+        }
+        else if (mesh.bufferType == EBufferType::Lines)
+        {
+            mode = kModeLines;
+            corners = 2;
+        }
+
+        QVector<uint16> primitiveIndices;
+        primitiveIndices.reserve(indices.size());
+        for (int i = 0; i + corners <= indices.size(); i += corners)
+        {
+            bool valid = true;
+            for (int c = 0; c < corners; c++)
+            {
+                valid = valid && indices[i + c] < vertices.size();
+            }
+            if (!valid)
+            {
+                continue;
+            }
+
+            if (corners == 3)
+            {
+                primitiveIndices << indices[i] << indices[i + 2] << indices[i + 1];
+            }
+            else
+            {
+                for (int c = 0; c < corners; c++)
+                {
+                    primitiveIndices << indices[i + c];
+                }
+            }
+        }
+        if (primitiveIndices.isEmpty())
+        {
+            continue;
+        }
+
+        QJsonObject attributes;
+
+        ArrayView<Vector3D> positions = vertices.positions();
+        int positionAccessor = addAccessor(addBufferView(positions.constData(), positions.size() * int(sizeof(Vector3D)), kArrayBuffer),
+                                           kFloat, positions.size(), "VEC3");
+
+        // POSITION must carry its bounds
+        Vector3D minimum = positions[0];
+        Vector3D maximum = positions[0];
+        for (const Vector3D& position : positions)
+        {
+            minimum = Vector3D(qMin(minimum.x, position.x), qMin(minimum.y, position.y), qMin(minimum.z, position.z));
+            maximum = Vector3D(qMax(maximum.x, position.x), qMax(maximum.y, position.y), qMax(maximum.z, position.z));
+        }
+        QJsonObject accessor = m_accessors[positionAccessor].toObject();
+        accessor["min"] = vectorArray(minimum);
+        accessor["max"] = vectorArray(maximum);
+        m_accessors.replace(positionAccessor, accessor);
+        attributes["POSITION"] = positionAccessor;
+
+        ArrayView<Vector3D> normals = vertices.normals();
+        attributes["NORMAL"] = addAccessor(addBufferView(normals.constData(), normals.size() * int(sizeof(Vector3D)), kArrayBuffer),
+                                           kFloat, normals.size(), "VEC3");
+
+        ArrayView<Vector2D> texCoords = vertices.texCoords();
+        if (!texCoords.isEmpty())
+        {
+            attributes["TEXCOORD_0"] = addAccessor(addBufferView(texCoords.constData(), texCoords.size() * int(sizeof(Vector2D)), kArrayBuffer),
+                                                   kFloat, texCoords.size(), "VEC2");
+        }
+
+        QJsonObject primitive;
+        primitive["attributes"] = attributes;
+        primitive["indices"] = addAccessor(addBufferView(primitiveIndices.constData(), primitiveIndices.size() * int(sizeof(uint16)), kElementArrayBuffer),
+                                           kUnsignedShort, primitiveIndices.size(), "SCALAR");
+        primitive["material"] = addMaterial(mesh);
+        if (mode != kModeTriangles)
+        {
+            primitive["mode"] = mode;
+        }
+        primitives.append(primitive);
+    }
+
+    if (primitives.isEmpty())
+    {
+        return -1;
+    }
+
+    QJsonObject mesh;
+    mesh["name"] = object.name;
+    mesh["primitives"] = primitives;
+    m_meshes.append(mesh);
+    return m_meshes.size() - 1;
+}
+
+int GlbWriter::addMaterial(const Mesh& mesh)
+{
+    qint64 key = (qint64(mesh.materialProjectID) << 32) | quint32(mesh.materialID);
+    auto existing = m_materialIndex.constFind(key);
+    if (existing != m_materialIndex.constEnd())
+    {
+        return existing.value();
+    }
+
+    QJsonObject pbr;
+    pbr["metallicFactor"] = 0.0;
+    pbr["roughnessFactor"] = 1.0;
+
+    QJsonObject material;
+    material["name"] = QString("material_%1").arg(mesh.materialID);
+
+    // Same lookup as the OBJ export's MTL files
+    const Material* source = m_project.findMaterialByID(mesh.materialID);
+    if (source)
+    {
+        material["name"] = source->name;
+        material["doubleSided"] = source->doubleSided;
+
+        const Texture* texture = source->textureID != -1 ? m_project.findTextureByID(source->textureID) : nullptr;
+        if (texture)
+        {
+            const RenderPassStage* stage = textureStage(*source);
+            int textureIndex = addTexture(*texture, stage ? *stage : RenderPassStage());
+            if (textureIndex >= 0)
+            {
+                QJsonObject baseColor;
+                baseColor["index"] = textureIndex;
+                pbr["baseColorTexture"] = baseColor;
+            }
+        }
+
+        const RenderPassSettings* settings = firstPassSettings(*source);
+        if (settings && settings->alphaBlending)
+        {
+            material["alphaMode"] = "BLEND";
+        }
+        else if (settings && settings->testForAlphaBlending)
+        {
+            material["alphaMode"] = "MASK";
+            material["alphaCutoff"] = settings->alphaReference / 255.0;
+        }
+
+        if (!source->enabledLighting)
+        {
+            QJsonObject extensions;
+            extensions[kUnlitExtension] = QJsonObject();
+            material["extensions"] = extensions;
+            m_usesUnlit = true;
+        }
+
+        QJsonObject extras;
+        extras["id"] = source->id;
+        extras["projectID"] = source->projectID;
+        material["extras"] = extras;
+    }
+
+    material["pbrMetallicRoughness"] = pbr;
+    m_materials.append(material);
+
+    int index = m_materials.size() - 1;
+    m_materialIndex.insert(key, index);
+    return index;
+}
+
+int GlbWriter::addTexture(const Texture& texture, const RenderPassStage& stage)
+{
+    int image = addImage(texture);
+    if (image < 0)
+    {
+        return -1;
+    }
+    int sampler = addSampler(stage);
+
+    QString key = QString("%1/%2").arg(image).arg(sampler);
+    auto existing = m_textureIndex.constFind(key);
+    if (existing != m_textureIndex.constEnd())
+    {
+        return existing.value();
+    }
+
+    QJsonObject entry;
+    entry["source"] = image;
+    entry["sampler"] = sampler;
+    m_textures.append(entry);
+
+    int index = m_textures.size() - 1;
+    m_textureIndex.insert(key, index);
+    return index;
+}
+
+int GlbWriter::addImage(const Texture& texture)
+{
+    auto existing = m_imageIndex.constFind(texture.id);
+    if (existing != m_imageIndex.constEnd())
+    {
+        return existing.value();
+    }
+
+    QJsonObject image;
+    image["name"] = texture.name;
+
+    if (m_textureUri)
+    {
+        image["uri"] = QString::fromLatin1(QUrl::toPercentEncoding(m_textureUri(texture), "/"));
+    }
+    else
+    {
+        if (!texture.hasColorData())
+        {
+            return -1;
+        }
+
+        QImage decoded = TextureCache::instance().image(texture, TextureCache::Variant::Merged, m_textureScale);
+        if (decoded.isNull())
+        {
+            return -1;
+        }
+
+        QByteArray png;
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        if (!decoded.save(&buffer, "PNG"))
+        {
+            return -1;
+        }
+
+        image["bufferView"] = addBufferView(png.constData(), png.size(), 0);
+        image["mimeType"] = "image/png";
+    }
+
+    m_images.append(image);
+
+    int index = m_images.size() - 1;
+    m_imageIndex.insert(texture.id, index);
+    return index;
+}
+
+int GlbWriter::addSampler(const RenderPassStage& stage)
+{
+    int mag = stage.maxTextureMagnificationFilter == ETextureMagnificationFilter::Point ? kNearest : kLinear;
+    int min = minFilter(stage);
+    int wrapS = wrapMode(stage.textureAddressU);
+    int wrapT = wrapMode(stage.textureAddressV);
+
+    QString key = QString("%1/%2/%3/%4").arg(mag).arg(min).arg(wrapS).arg(wrapT);
+    auto existing = m_samplerIndex.constFind(key);
+    if (existing != m_samplerIndex.constEnd())
+    {
+        return existing.value();
+    }
+
+    QJsonObject sampler;
+    sampler["magFilter"] = mag;
+    sampler["minFilter"] = min;
+    sampler["wrapS"] = wrapS;
+    sampler["wrapT"] = wrapT;
+    m_samplers.append(sampler);
+
+    int index = m_samplers.size() - 1;
+    m_samplerIndex.insert(key, index);
+    return index;
+}
+
+int GlbWriter::addBufferView(const void* data, int bytes, int target)
+{
+    int offset = m_binary.size();
+    m_binary.append(static_cast<const char*>(data), bytes);
+    m_binary.append(QByteArray(alignedSize(bytes) - bytes, '\0'));
+
+    QJsonObject view;
+    view["buffer"] = 0;
+    view["byteOffset"] = offset;
+    view["byteLength"] = bytes;
+    if (target != 0)
+    {
+        view["target"] = target;
+    }
+    m_bufferViews.append(view);
+    return m_bufferViews.size() - 1;
+}
+
+int GlbWriter::addAccessor(int bufferView, int componentType, int count, const char* type)
+{
+    QJsonObject accessor;
+    accessor["bufferView"] = bufferView;
+    accessor["componentType"] = componentType;
+    accessor["count"] = count;
+    accessor["type"] = type;
+    m_accessors.append(accessor);
+    return m_accessors.size() - 1;
+}
+
+} // namespace Opf
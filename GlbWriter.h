@@ -0,0 +1,86 @@
+#ifndef GLBWRITER_H
+#define GLBWRITER_H
+
+#include "OpfStructs.h"
+#include <QByteArray>
+#include <QString>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QHash>
+#include <functional>
+
+namespace Opf {
+
+// ============================================================================
+// GLB WRITER - binary glTF 2.0 file for one object and its children
+// ============================================================================
+//
+// Each Object becomes a node with its position / rotation / scaling, child
+// objects become child nodes, and all meshes of an object are primitives of
+// one glTF mesh. Vertex and index data are packed into the single binary
+// chunk. Materials are built from the first render pass stage; textures are
+// embedded as PNG unless a uri function is set.
+//
+// Coordinates are written unchanged and faces with reversed winding, like
+// the OBJ export. Texture coordinates need no flip, glTF and Direct3D both
+// have the origin at the top left.
+
+class GlbWriter
+{
+public:
+    // Path of an already exported texture file, relative to the GLB file
+    using TextureUri = std::function<QString(const Texture&)>;
+
+    explicit GlbWriter(const PackedProject& project);
+
+    // Embedded textures only, in percent (100, 50 or 25)
+    void setTextureScale(int scalePercent) { m_textureScale = scalePercent; }
+
+    // Reference textures by uri instead of embedding them
+    void setTextureUri(const TextureUri& uri) { m_textureUri = uri; }
+
+    bool write(const Object& object, const QString& filename);
+
+    QString lastError() const { return m_lastError; }
+
+private:
+    void clear();
+
+    int addNode(const Object& object);
+    int addMesh(const Object& object);
+    int addMaterial(const Mesh& mesh);
+    int addTexture(const Texture& texture, const RenderPassStage& stage);
+    int addImage(const Texture& texture);
+    int addSampler(const RenderPassStage& stage);
+
+    // Appends 'bytes' to the binary chunk (4-byte aligned) and returns the
+    // buffer view index; 'target' is 0 for non-vertex data
+    int addBufferView(const void* data, int bytes, int target);
+    int addAccessor(int bufferView, int componentType, int count, const char* type);
+
+    const PackedProject& m_project;
+    int m_textureScale;
+    TextureUri m_textureUri;
+
+    QByteArray m_binary;
+    QJsonArray m_nodes;
+    QJsonArray m_meshes;
+    QJsonArray m_materials;
+    QJsonArray m_textures;
+    QJsonArray m_images;
+    QJsonArray m_samplers;
+    QJsonArray m_bufferViews;
+    QJsonArray m_accessors;
+    bool m_usesUnlit;
+
+    QHash<qint64, int> m_materialIndex;     // projectID << 32 | material id
+    QHash<int, int> m_imageIndex;           // texture id
+    QHash<QString, int> m_samplerIndex;     // "mag/min/wrapS/wrapT"
+    QHash<QString, int> m_textureIndex;     // "image/sampler"
+
+    QString m_lastError;
+};
+
+} // namespace Opf
+
+#endif // GLBWRITER_H
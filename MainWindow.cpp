@@ -1,5 +1,7 @@
 #include "MainWindow.h"
 #include "OpfWriter.h"
+#include "BackupStore.h"
+#include "TextureCache.h"
 
 //  Custom headers
 #include "ui_MainWindow.h"
@@ -11,6 +13,7 @@
 
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QInputDialog>
 #include <QSplitter>
 #include <QFileInfo>
 #include <QDir>
@@ -22,11 +25,27 @@
 #include <QApplication>
 #include <QDateTime>
 #include <QCoreApplication>
+#include <QPixmapCache>
+#include <QElapsedTimer>
+#include <QDebug>
 
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWindow), m_project(nullptr), m_effectsEditor(nullptr),m_aiEditor(nullptr)
+namespace {
+
+// Textures decoded ahead on each side of the selected one
+const int kTexturePrefetchCount = 2;
+
+} // namespace
+
+MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWindow), m_project(nullptr), m_loader(nullptr), m_loadProgress(nullptr), m_effectsEditor(nullptr),m_aiEditor(nullptr)
 {
     ui->setupUi(this);
 
+    m_loader = new Opf::ProjectLoader(this);
+    connect(m_loader, &Opf::ProjectLoader::finished, this, &MainWindow::onProjectLoaded);
+    connect(m_loader, &Opf::ProjectLoader::failed, this, &MainWindow::onProjectLoadFailed);
+    connect(m_loader, &Opf::ProjectLoader::canceled, this, &MainWindow::onProjectLoadCanceled);
+    connect(m_loader, &Opf::ProjectLoader::progressChanged, this, &MainWindow::onProjectLoadProgress);
+
     setWindowTitle("The Outforce - UnitDeveloper Tool. v3.0");
     resize(1400, 900);
 
@@ -34,10 +53,16 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     setupMenus();
     setupToolbar();
     setupStatusBar();
+
+    Opf::TextureCache::instance().setBudget(qint64(SettingsManager::instance().decodedTextureCacheMB()) * 1024 * 1024);
 }
 
 MainWindow::~MainWindow()
 {
+    // Stop a running load before the project it would hand over is gone
+    delete m_loader;
+    m_loader = nullptr;
+
     clearProject();
     delete ui;
 }
@@ -72,6 +97,17 @@ void MainWindow::setupUI()
     connect(m_meshFilterCheckbox, &QCheckBox::toggled, this, &MainWindow::onMeshFilterToggled);
     filterLayout->addWidget(m_meshFilterCheckbox);
 
+    filterLayout->addWidget(new QLabel("Query:", this));
+
+    m_queryBox = new QLineEdit(this);
+    m_queryBox->setPlaceholderText("e.g. MaxHealth > 500 and Cost < 300, Enter to apply");
+    m_queryBox->setClearButtonEnabled(true);
+    connect(m_queryBox, &QLineEdit::returnPressed, this, &MainWindow::onSettingsQueryEntered);
+    connect(m_queryBox, &QLineEdit::textChanged, this, [this](const QString& text) {
+        if (text.isEmpty()) onSettingsQueryEntered();
+    });
+    filterLayout->addWidget(m_queryBox, 1);
+
     mainLayout->addWidget(filterWidget);
 
     // Main splitter
@@ -120,6 +156,9 @@ void MainWindow::setupMenus()
     connect(saveAsAction, &QAction::triggered, this, &MainWindow::onSaveFileAs);
     fileMenu->addAction(saveAsAction);
 
+    QAction* restoreBackupAction = fileMenu->addAction(tr("Restore &Backup..."));
+    connect(restoreBackupAction, &QAction::triggered, this, &MainWindow::onRestoreBackup);
+
     fileMenu->addSeparator();
 
     QAction* extractSelAction = fileMenu->addAction(tr("&Extract Selected..."));
@@ -247,24 +286,95 @@ void MainWindow::onOpenFile()
 
 void MainWindow::openFile(const QString& filename)
 {
-    clearProject();
+    if (m_loader->isRunning())
+    {
+        return;
+    }
 
-    m_project = new Opf::PackedProject();
+    clearProject();
 
     m_statusLabel->setText("Parsing PackedProject.opf...");
-    QApplication::processEvents();
 
-    if (!m_parser.parse(filename, *m_project))
+    SettingsManager& settings = SettingsManager::instance();
+
+    m_loader->setTextureLoadMode(settings.lazyTextureLoading() ? Opf::OpfParser::TextureLoadMode::Lazy : Opf::OpfParser::TextureLoadMode::Eager);
+    m_loader->setObjectStorage(Opf::OpfParser::ObjectStorage::Arena);
+    m_loader->setUseCache(settings.useProjectCache());
+
+    // Non-blocking: the window keeps repainting while the loader works
+    m_loadProgress = new QProgressDialog(tr("Opening %1...").arg(QFileInfo(filename).fileName()), tr("Cancel"), 0, 1000, this);
+    m_loadProgress->setWindowTitle(tr("Loading"));
+    m_loadProgress->setWindowModality(Qt::WindowModal);
+    m_loadProgress->setMinimumDuration(300);
+    m_loadProgress->setAutoClose(false);
+    m_loadProgress->setAutoReset(false);
+    m_loadProgress->setValue(0);
+    connect(m_loadProgress, &QProgressDialog::canceled, m_loader, &Opf::ProjectLoader::cancel);
+
+    m_loader->start(filename);
+}
+
+void MainWindow::closeLoadProgress()
+{
+    if (m_loadProgress)
+    {
+        m_loadProgress->disconnect(m_loader);
+        m_loadProgress->close();
+        m_loadProgress->deleteLater();
+        m_loadProgress = nullptr;
+    }
+}
+
+void MainWindow::onProjectLoadProgress(qint64 position, qint64 total, const QString& section)
+{
+    if (!m_loadProgress || total <= 0)
     {
-        QMessageBox::critical(this, tr("Error"), tr("Failed to parse file:\n%1").arg(m_parser.lastError()));
-        clearProject();
-        m_statusLabel->setText("Failed to load file");
         return;
     }
 
+    // Per-mille, QProgressDialog only takes int ranges
+    m_loadProgress->setValue(int(qBound<qint64>(0, position * 1000 / total, 1000)));
+    m_loadProgress->setLabelText(tr("Loading %1... %2 / %3 MB").arg(section).arg(position / (1024.0 * 1024.0), 0, 'f', 1).arg(total / (1024.0 * 1024.0), 0, 'f', 1));
+}
+
+void MainWindow::onProjectLoadFailed(const QString& error)
+{
+    closeLoadProgress();
+
+    QMessageBox::critical(this, tr("Error"), tr("Failed to parse file:\n%1").arg(error));
+    m_statusLabel->setText("Failed to load file");
+}
+
+void MainWindow::onProjectLoadCanceled()
+{
+    closeLoadProgress();
+
+    m_statusLabel->setText("Loading canceled");
+}
+
+void MainWindow::onProjectLoaded(Opf::PackedProject* project)
+{
+    closeLoadProgress();
+
+    clearProject();
+    m_project = project;
+
+    QString filename = m_loader->fileName();
+    SettingsManager& settings = SettingsManager::instance();
+
+    // Cached projects reference texture payloads in the .opf; load them
+    // up front if on-demand loading is disabled
+    if (m_loader->loadedFromCache() && !settings.lazyTextureLoading())
+    {
+        for (const Opf::Texture& texture : m_project->textures)
+        {
+            texture.detachDataSource();
+        }
+    }
+
     m_currentFilePath = filename;
 
-    SettingsManager::instance().addRecentFile(filename);
+    settings.addRecentFile(filename);
     updateRecentFilesMenu();
 
     m_treeWidget->loadProject(*m_project);
@@ -356,7 +466,15 @@ void MainWindow::onExtractAll()
 
     m_statusLabel->setText("Exporting all assets...");
 
-    bool success = m_exporter.exportAll(*m_project, directory, &progress);
+    // The export runs on this thread, so the dialog is kept alive from here
+    m_exporter.setProgressCallback([&progress](int value, int maximum) {
+        progress.setMaximum(maximum);
+        progress.setValue(value);
+        QApplication::processEvents();
+        return !progress.wasCanceled();
+    });
+    bool success = m_exporter.exportAll(*m_project, directory);
+    m_exporter.setProgressCallback(nullptr);
 
     if (progress.wasCanceled())
     {
@@ -410,6 +528,8 @@ void MainWindow::onPreferences()
 {
     SettingsDialog dialog(this);
     dialog.exec();
+
+    Opf::TextureCache::instance().setBudget(qint64(SettingsManager::instance().decodedTextureCacheMB()) * 1024 * 1024);
 }
 
 void MainWindow::onAbout()
@@ -450,6 +570,13 @@ void MainWindow::onTextureSelected(Opf::Texture* texture)
 
     if (texture)
     {
+        // Keep lazily loaded texture payloads within the configured budget
+        size_t budget = size_t(SettingsManager::instance().textureMemoryBudgetMB()) * 1024 * 1024;
+        m_project->enforceTextureMemoryBudget(budget, texture);
+
+        // Decode the textures the user is likely to look at next
+        Opf::TextureCache::instance().prefetch(m_treeWidget->neighbouringTextures(kTexturePrefetchCount), Opf::TextureCache::Variant::Color);
+
         m_statusLabel->setText(QString("Selected: %1 [%2x%3]").arg(texture->name).arg(texture->width).arg(texture->height));
     }
 }
@@ -480,8 +607,26 @@ void MainWindow::onMeshFilterToggled(bool checked)
     m_treeWidget->setOnlyWithMeshes(checked);
 }
 
-void MainWindow::onObjectModified()
+void MainWindow::onSettingsQueryEntered()
+{
+    QString error;
+    QElapsedTimer timer;
+    timer.start();
+
+    int matches = m_treeWidget->setSettingsQuery(m_queryBox->text(), &error);
+    if (matches < 0)
+    {
+        m_statusLabel->setText(QString("Query error: %1").arg(error));
+    }
+    else if (!m_queryBox->text().trimmed().isEmpty())
+    {
+        m_statusLabel->setText(QString("Query: %1 object(s) match (%2 ms)").arg(matches).arg(timer.nsecsElapsed() / 1e6, 0, 'f', 2));
+    }
+}
+
+void MainWindow::onObjectModified(Opf::Object* object)
 {
+    m_treeWidget->refreshObject(object);
     setModified(true);
     m_statusLabel->setText("Object modified - unsaved changes");
 }
@@ -498,6 +643,10 @@ void MainWindow::clearProject()
     m_previewWidget->clear();
     m_currentFilePath.clear();
 
+    // Cached images are keyed by texture id, which the next project reuses
+    Opf::TextureCache::instance().clear();
+    QPixmapCache::clear();
+
     updateStatusBar();
     setWindowTitle("The Outforce - UnitDeveloper Tool. v3.1");
 }
@@ -581,7 +730,7 @@ void MainWindow::onSaveFile()
     {
         setModified(false);
         m_statusLabel->setText(QString("Saved: %1").arg(m_currentFilePath));
-        QMessageBox::information(this, tr("Success"),tr("Project saved successfully!\n\nBackup created in the same folder."));
+        QMessageBox::information(this, tr("Success"),tr("Project saved successfully!\n\nThe previous version was added to the backup history (File > Restore Backup)."));
     }
 
     else
@@ -626,6 +775,65 @@ void MainWindow::onSaveFileAs()
     }
 }
 
+void MainWindow::onRestoreBackup()
+{
+    if (m_currentFilePath.isEmpty())
+    {
+        QMessageBox::information(this, tr("Info"), tr("No project loaded."));
+        return;
+    }
+
+    Opf::BackupStore store(m_currentFilePath);
+    QVector<Opf::BackupStore::Entry> entries;
+    if (!store.list(entries) || entries.isEmpty())
+    {
+        QMessageBox::information(this, tr("Restore Backup"), tr("No backups found for:\n%1").arg(m_currentFilePath));
+        return;
+    }
+
+    QStringList items;
+    for (const Opf::BackupStore::Entry& entry : entries)
+    {
+        items << QString("%1  (%2 MB)").arg(entry.created.toLocalTime().toString("yyyy-MM-dd HH:mm:ss")).arg(entry.size / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+    bool ok = false;
+    QString choice = QInputDialog::getItem(this, tr("Restore Backup"), tr("Restore %1 to the version saved at:").arg(QFileInfo(m_currentFilePath).fileName()), items, 0, false, &ok);
+    if (!ok)
+    {
+        return;
+    }
+
+    const Opf::BackupStore::Entry& entry = entries[items.indexOf(choice)];
+
+    QString question = tr("Replace the current file with the backup from %1?").arg(entry.created.toLocalTime().toString("yyyy-MM-dd HH:mm:ss"));
+    if (m_isModified)
+    {
+        question += tr("\n\nUnsaved changes will be lost.");
+    }
+
+    if (QMessageBox::question(this, tr("Restore Backup"), question, QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes)
+    {
+        return;
+    }
+
+    m_statusLabel->setText("Restoring backup...");
+    QApplication::processEvents();
+
+    // The project may still read textures from the file; close it first.
+    // The current version is backed up too, so the restore can be undone.
+    QString filename = m_currentFilePath;
+    clearProject();
+    setModified(false);
+
+    if (!store.backup() || !store.restore(entry.id, filename))
+    {
+        QMessageBox::critical(this, tr("Error"), tr("Failed to restore backup:\n%1").arg(store.lastError()));
+    }
+
+    openFile(filename);
+}
+
 void MainWindow::setModified(bool modified)
 {
     m_isModified = modified;
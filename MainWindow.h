@@ -9,9 +9,11 @@
 #include <QComboBox>
 #include <QCheckBox>
 #include <QMenu>
+#include <QProgressDialog>
 
 #include "OpfStructs.h"
 #include "OpfParser.h"
+#include "ProjectLoader.h"
 #include "OpfExporter.h"
 #include "AssetTreeWidget.h"
 #include "AssetPreviewWidget.h"
@@ -52,12 +54,20 @@ private slots:
     void onSearchTextChanged(const QString& text);
     void onCategoryFilterChanged(int index);
     void onMeshFilterToggled(bool checked);
+    void onSettingsQueryEntered();
 
-    void onObjectModified();
+    void onObjectModified(Opf::Object* object);
+
+    //  Background loading
+    void onProjectLoaded(Opf::PackedProject* project);
+    void onProjectLoadFailed(const QString& error);
+    void onProjectLoadCanceled();
+    void onProjectLoadProgress(qint64 position, qint64 total, const QString& section);
 
     //  opf save
     void onSaveFile();
     void onSaveFileAs();
+    void onRestoreBackup();
 
     //  Effects Editor
     void onOpenEffectsEditor();
@@ -74,7 +84,8 @@ private:
     Ui::MainWindow *ui;
 
     Opf::PackedProject* m_project;
-    Opf::OpfParser m_parser;
+    Opf::ProjectLoader* m_loader;
+    QProgressDialog* m_loadProgress;
     Opf::OpfExporter m_exporter;
     QString m_currentFilePath;
 
@@ -87,6 +98,7 @@ private:
     QLineEdit* m_searchBox;
     QComboBox* m_categoryFilter;
     QCheckBox* m_meshFilterCheckbox;
+    QLineEdit* m_queryBox;
     QMenu* m_recentFilesMenu;
 
     //  Effects Editor window (single instance)
@@ -100,6 +112,7 @@ private:
     void clearProject();
     void updateRecentFilesMenu();
     void openFile(const QString& filename);
+    void closeLoadProgress();
 
     // Opf save
     bool m_isModified = false;
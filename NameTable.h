@@ -0,0 +1,97 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QReadWriteLock>
+
+namespace Opf {
+
+// ============================================================================
+// NAME TABLE - string interning for setting and class names
+// ============================================================================
+//
+// Every distinct name is stored once and identified by a small integer id,
+// so names can be compared as integers and all copies share one buffer.
+// Each project has its own table (PackedProject::names), shared with its
+// objects and freed with the last of them. Ids are only meaningful within
+// one table and are not persisted. Safe to use from several parser threads
+// at once.
+
+class NameTable
+{
+public:
+    static constexpr quint32 kNoName = 0xFFFFFFFFu;
+
+    // Interned by every table, so the id is known without a lookup
+    static constexpr quint32 kCanBuildUnit = 0;
+
+    NameTable()
+    {
+        intern("CanBuildUnit");
+    }
+
+    // Id of 'name', adding it if necessary
+    quint32 intern(const QString& name)
+    {
+        {
+            QReadLocker locker(&m_lock);
+            auto it = m_ids.constFind(name);
+            if (it != m_ids.constEnd())
+            {
+                return it.value();
+            }
+        }
+
+        QWriteLocker locker(&m_lock);
+        auto it = m_ids.constFind(name);
+        if (it != m_ids.constEnd())
+        {
+            return it.value();
+        }
+
+        quint32 id = m_names.size();
+        m_names.append(name);
+        m_ids.insert(name, id);
+        return id;
+    }
+
+    // Id of 'name', or kNoName if it was never interned
+    quint32 find(const QString& name) const
+    {
+        QReadLocker locker(&m_lock);
+        return m_ids.value(name, kNoName);
+    }
+
+    // Shared copy of the string with the given id
+    QString name(quint32 id) const
+    {
+        QReadLocker locker(&m_lock);
+        return id < quint32(m_names.size()) ? m_names[id] : QString();
+    }
+
+    // Shared copy of 'name' (interned on the way)
+    QString internedString(const QString& name)
+    {
+        return this->name(intern(name));
+    }
+
+    int size() const
+    {
+        QReadLocker locker(&m_lock);
+        return m_names.size();
+    }
+
+private:
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+
+    mutable QReadWriteLock m_lock;
+    QVector<QString> m_names;
+    QHash<QString, quint32> m_ids;
+};
+
+} // namespace Opf
+
+#endif // NAMETABLE_H
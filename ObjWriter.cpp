@@ -0,0 +1,192 @@
+#include "ObjWriter.h"
+#include <QFile>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace Opf {
+
+namespace {
+
+// Bytes per line reserved up front, enough for typical coordinates
+const int kEstimatedVertexLine = 40;
+const int kEstimatedTexCoordLine = 24;
+const int kEstimatedFaceLine = 32;
+
+} // namespace
+
+// ============================================================================
+// OBJ WRITER
+// ============================================================================
+
+ObjWriter::ObjWriter(int precision)
+    : m_size(0), m_precision(6)
+{
+    setPrecision(precision);
+}
+
+void ObjWriter::setPrecision(int precision)
+{
+    m_precision = precision < 0 ? kShortestPrecision : qMin(precision, 9);
+}
+
+char* ObjWriter::reserve(int bytes)
+{
+    if (m_size + bytes > m_buffer.size())
+    {
+        m_buffer.resize(qMax(m_size + bytes, m_buffer.size() * 2));
+    }
+    return m_buffer.data() + m_size;
+}
+
+void ObjWriter::append(const char* text)
+{
+    int length = int(strlen(text));
+    char* out = reserve(length);
+    memcpy(out, text, size_t(length));
+    commit(out + length);
+}
+
+void ObjWriter::append(const QByteArray& text)
+{
+    char* out = reserve(text.size());
+    memcpy(out, text.constData(), size_t(text.size()));
+    commit(out + text.size());
+}
+
+char* ObjWriter::writeFloat(char* out, float value) const
+{
+#if defined(__cpp_lib_to_chars)
+    std::to_chars_result result = m_precision == kShortestPrecision
+        ? std::to_chars(out, out + kMaxNumberLength, value)
+        : std::to_chars(out, out + kMaxNumberLength, value, std::chars_format::fixed, m_precision);
+    return result.ptr;
+#else
+    // Standard libraries without floating-point to_chars
+    int length = m_precision == kShortestPrecision
+        ? snprintf(out, kMaxNumberLength, "%.9g", double(value))
+        : snprintf(out, kMaxNumberLength, "%.*f", m_precision, double(value));
+    return out + qBound(0, length, kMaxNumberLength - 1);
+#endif
+}
+
+char* ObjWriter::writeInt(char* out, int value)
+{
+    return std::to_chars(out, out + kMaxNumberLength, value).ptr;
+}
+
+void ObjWriter::writeMesh(const Mesh& mesh, const QString& mtlFilename)
+{
+    VertexView vertices = mesh.vertices();
+    ArrayView<uint16> indices = mesh.indices();
+    ArrayView<Vector2D> texCoords = vertices.texCoords();
+
+    reserve(vertices.size() * (2 * kEstimatedVertexLine + kEstimatedTexCoordLine) + (indices.size() / 3) * kEstimatedFaceLine + 1024);
+
+    append("# Outforce OBJ Export v2.0\n# Mesh: ");
+    append(mesh.name.toUtf8());
+    append("\n# Vertices: ");
+    append(QByteArray::number(vertices.size()));
+    append("\n# Faces: ");
+    append(QByteArray::number(indices.size() / 3));
+    append("\n# Material ID: ");
+    append(QByteArray::number(mesh.materialID));
+    append("\n\nmtllib ");
+    append(mtlFilename.toUtf8());
+    append("\n\n");
+
+    // Vertices
+    for (const Vector3D& position : vertices.positions())
+    {
+        char* out = reserve(3 * kMaxNumberLength + 8);
+        *out++ = 'v';
+        *out++ = ' ';
+        out = writeFloat(out, position.x);
+        *out++ = ' ';
+        out = writeFloat(out, position.y);
+        *out++ = ' ';
+        out = writeFloat(out, position.z);
+        *out++ = '\n';
+        commit(out);
+    }
+    append("\n");
+
+    // Normals
+    for (const Vector3D& normal : vertices.normals())
+    {
+        char* out = reserve(3 * kMaxNumberLength + 8);
+        *out++ = 'v';
+        *out++ = 'n';
+        *out++ = ' ';
+        out = writeFloat(out, normal.x);
+        *out++ = ' ';
+        out = writeFloat(out, normal.y);
+        *out++ = ' ';
+        out = writeFloat(out, normal.z);
+        *out++ = '\n';
+        commit(out);
+    }
+    append("\n");
+
+    // Texture coordinates, V mirrored around the texture center. Meshes
+    // without coordinates get (0, 0) per vertex.
+    for (int i = 0; i < vertices.size(); i++)
+    {
+        Vector2D texCoord = texCoords.isEmpty() ? Vector2D() : texCoords[i];
+
+        char* out = reserve(2 * kMaxNumberLength + 8);
+        *out++ = 'v';
+        *out++ = 't';
+        *out++ = ' ';
+        out = writeFloat(out, texCoord.x);
+        *out++ = ' ';
+        out = writeFloat(out, 1.0f - texCoord.y);
+        *out++ = '\n';
+        commit(out);
+    }
+    append("\n");
+
+    // Material
+    append("usemtl material_");
+    append(QByteArray::number(mesh.materialID));
+    append("\n\n");
+
+    // Faces, i2 and i3 swapped to reverse the winding order
+    append("# Faces\n");
+    for (int i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const int corners[3] = { indices[i] + 1, indices[i + 2] + 1, indices[i + 1] + 1 };
+
+        char* out = reserve(9 * kMaxNumberLength + 8);
+        *out++ = 'f';
+        for (int corner : corners)
+        {
+            *out++ = ' ';
+            out = writeInt(out, corner);
+            *out++ = '/';
+            out = writeInt(out, corner);
+            *out++ = '/';
+            out = writeInt(out, corner);
+        }
+        *out++ = '\n';
+        commit(out);
+    }
+}
+
+bool ObjWriter::save(const QString& filename, QString* error) const
+{
+    // Text mode for native line endings, like the QTextStream output before
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text) ||
+        file.write(m_buffer.constData(), m_size) != m_size)
+    {
+        if (error)
+        {
+            *error = QString("Cannot write file: %1").arg(filename);
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace Opf
@@ -0,0 +1,62 @@
+#ifndef OBJWRITER_H
+#define OBJWRITER_H
+
+#include "OpfStructs.h"
+#include <QByteArray>
+#include <QString>
+
+namespace Opf {
+
+// ============================================================================
+// OBJ WRITER - Wavefront OBJ text for a mesh, built in one byte buffer
+// ============================================================================
+//
+// Numbers are formatted with std::to_chars straight into the buffer, so no
+// temporary strings are created per line. Texture coordinates are flipped
+// vertically and faces are written with reversed winding (DirectX CW to
+// OpenGL/Blender CCW), as the exporter always did.
+
+class ObjWriter
+{
+public:
+    // Shortest text that reads back as the same float
+    static const int kShortestPrecision = -1;
+
+    // 'precision' is the number of decimals (0-9) or kShortestPrecision
+    explicit ObjWriter(int precision = 6);
+
+    void setPrecision(int precision);
+    int precision() const { return m_precision; }
+
+    // Appends a complete OBJ file for 'mesh' referencing 'mtlFilename'
+    void writeMesh(const Mesh& mesh, const QString& mtlFilename);
+
+    // Appends raw text
+    void append(const char* text);
+    void append(const QByteArray& text);
+
+    QByteArray data() const { return m_buffer.left(m_size); }
+    int size() const { return m_size; }
+    void clear() { m_size = 0; }
+
+    // Writes the buffer to 'filename' with a single write call
+    bool save(const QString& filename, QString* error = nullptr) const;
+
+private:
+    // Room for the longest number written by writeFloat / writeInt
+    static const int kMaxNumberLength = 64;
+
+    char* reserve(int bytes);
+    void commit(char* end) { m_size = int(end - m_buffer.constData()); }
+
+    char* writeFloat(char* out, float value) const;
+    static char* writeInt(char* out, int value);
+
+    QByteArray m_buffer;
+    int m_size;
+    int m_precision;
+};
+
+} // namespace Opf
+
+#endif // OBJWRITER_H
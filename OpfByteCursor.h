@@ -0,0 +1,110 @@
+#ifndef OPFBYTECURSOR_H
+#define OPFBYTECURSOR_H
+
+#include "OpfStructs.h"
+#include <QtGlobal>
+#include <cstring>
+
+namespace Opf {
+
+// ============================================================================
+// BYTE CURSOR - bounds-checked reader over a memory block (e.g. mapped file)
+// ============================================================================
+
+class ByteCursor
+{
+public:
+    ByteCursor() = default;
+    ByteCursor(const uchar* data, qint64 size) : m_data(data), m_size(size), m_pos(0) {}
+
+    qint64 pos() const { return m_pos; }
+    qint64 size() const { return m_size; }
+    qint64 remaining() const { return m_size - m_pos; }
+    bool atEnd() const { return m_pos >= m_size; }
+    const uchar* data() const { return m_data; }
+
+    // Returns a pointer to the next 'count' bytes and advances, or nullptr
+    // (without advancing) if the block would run past the end.
+    const uchar* take(qint64 count)
+    {
+        if (count < 0 || count > m_size - m_pos)
+        {
+            return nullptr;
+        }
+        const uchar* block = m_data + m_pos;
+        m_pos += count;
+        return block;
+    }
+
+    bool seek(qint64 pos)
+    {
+        if (pos < 0 || pos > m_size)
+        {
+            return false;
+        }
+        m_pos = pos;
+        return true;
+    }
+
+    void skipToEnd() { m_pos = m_size; }
+
+private:
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_pos = 0;
+};
+
+// ============================================================================
+// BLOCK READER - unchecked decoder for a block already validated by the cursor
+// ============================================================================
+
+class BlockReader
+{
+public:
+    explicit BlockReader(const uchar* data) : m_data(data) {}
+
+    template<typename T>
+    T read()
+    {
+        T value;
+        memcpy(&value, m_data, sizeof(T));
+        m_data += sizeof(T);
+        return value;
+    }
+
+    Vector2D readVector2D()
+    {
+        Vector2D vec;
+        vec.x = read<fp32>();
+        vec.y = read<fp32>();
+        return vec;
+    }
+
+    Vector3D readVector3D()
+    {
+        Vector3D vec;
+        vec.x = read<fp32>();
+        vec.y = read<fp32>();
+        vec.z = read<fp32>();
+        return vec;
+    }
+
+    ColorValue readColorValue()
+    {
+        ColorValue color;
+        color.red = read<fp32>();
+        color.green = read<fp32>();
+        color.blue = read<fp32>();
+        color.alpha = read<fp32>();
+        return color;
+    }
+
+    void skip(int bytes) { m_data += bytes; }
+
+private:
+    const uchar* m_data;
+};
+
+} // namespace Opf
+
+#endif // OPFBYTECURSOR_H
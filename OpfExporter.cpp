@@ -1,5 +1,10 @@
 #include "OpfExporter.h"
 #include "SettingsManager.h"
+#include "OpfParser.h"
+#include "TextureCache.h"
+#include "ObjWriter.h"
+#include "GlbWriter.h"
+#include "ContentHash.h"
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -9,18 +14,61 @@
 #include <QDebug>
 #include <QTextStream>
 #include <QImage>
-#include <QProgressDialog>
-#include <QApplication>
 #include <QPainter>
 #include <QRegularExpression>
 #include <QFileInfo>
+#include <QSaveFile>
 #include <QDateTime>
+#include <QScopedPointer>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <atomic>
+#include <utility>
+#include <functional>
+#include <type_traits>
 
 namespace Opf
 {
 
-OpfExporter::OpfExporter(QObject* parent) : QObject(parent), m_currentProgress(0)
+ExportOptions ExportOptions::fromSettings()
 {
+    SettingsManager& settings = SettingsManager::instance();
+
+    ExportOptions options;
+    options.exportOBJ = settings.exportOBJ();
+    options.exportPNG = settings.exportPNG();
+    options.exportJSON = settings.exportJSON();
+    options.exportBlenderScript = settings.exportBlenderScript();
+    options.exportGLB = settings.exportGLB();
+    options.embedGlbTextures = settings.embedGlbTextures();
+    options.deduplicate = settings.deduplicateExport();
+    options.incremental = settings.incrementalExport();
+    options.textureFormat = settings.textureFormat();
+    options.textureScale = settings.textureScale();
+    return options;
+}
+
+OpfExporter::OpfExporter(QObject* parent) : QObject(parent), m_currentProgress(0), m_progressMaximum(0), m_hasOptions(false), m_peakObjectsHeld(0)
+{
+}
+
+void OpfExporter::setOptions(const ExportOptions& options)
+{
+    m_options = options;
+    m_hasOptions = true;
+}
+
+void OpfExporter::resetOptions()
+{
+    m_hasOptions = false;
+}
+
+ExportOptions OpfExporter::options() const
+{
+    return m_hasOptions ? m_options : ExportOptions::fromSettings();
 }
 
 QString OpfExporter::sanitizeFilename(const QString& filename)
@@ -92,128 +140,104 @@ QString OpfExporter::sanitizeFilename(const QString& filename)
     return result;
 }
 
-// ============================================================================
-// HELPER: Count all meshes recursively (including children)
-// ============================================================================
-static int countAllMeshesRecursive(const Object& object)
+bool OpfExporter::exportTemplatesToJson(const PackedProject& project, const QString& filename)
 {
-    int count = object.meshes().size();
-    for (const Object* child : object.children)
+    // Templates (objects)
+    QJsonArray templates;
+    for (const Object* obj : project.objects)
     {
-        if (child)
-        {
-            count += countAllMeshesRecursive(*child);
-        }
+        if (!obj) continue;
+        appendTemplateEntries(templates, *obj);
     }
-    return count;
+
+    return writeTemplatesJson(project, templates, filename);
 }
 
-// ============================================================================
-// HELPER: Check if object or any children have meshes
-// ============================================================================
-static bool hasAnyMeshesRecursive(const Object& object)
+void OpfExporter::appendTemplateEntries(QJsonArray& templates, const Object& object)
 {
-    if (!object.meshes().isEmpty())
+    const Object* obj = &object;
+
+    QJsonObject templ;
+    templ["id"] = static_cast<qint64>(obj->uniqueID);
+    templ["index"] = static_cast<int>(obj->projectID);
+    templ["name"] = obj->name;
+    templ["class"] = obj->className;
+    templ["category"] = obj->getCategory();
+    templ["isSpecial"] = obj->hasLight || obj->className.contains("Base");
+    templ["hasLight"] = obj->hasLight;
+    templ["isBillboard"] = obj->isBillboard;
+    templ["isDisabled"] = obj->isDisabled;
+    templ["meshCount"] = obj->meshes().size();
+    templ["totalMeshCount"] = obj->subtreeStats().meshes;  // NEW: includes children
+    templ["childCount"] = obj->children.size();
+
+    // Custom settings
+    QJsonArray customSettingsArray;
+    for (const auto& setting : obj->customSettings)
     {
-        return true;
+        QJsonObject settingObj;
+        settingObj["name"] = setting.name;
+        settingObj["value"] = setting.value;
+        customSettingsArray.append(settingObj);
     }
-    for (const Object* child : object.children)
+    templ["customSettings"] = customSettingsArray;
+
+    // CanBuildUnit list
+    QJsonArray canBuildArray;
+    for (const QString& unit : obj->getCanBuildUnits())
     {
-        if (child && hasAnyMeshesRecursive(*child))
+        canBuildArray.append(unit);
+    }
+    templ["canBuildUnits"] = canBuildArray;
+
+    templates.append(templ);
+
+    // Add children recursively
+    std::function<void(const Object*, const QString&)> addChildrenRecursive;
+    addChildrenRecursive = [&](const Object* parent, const QString& parentName) {
+        for (const Object* child : parent->children)
         {
-            return true;
+            if (!child) continue;
+
+            QJsonObject childTempl;
+            childTempl["id"] = static_cast<qint64>(child->uniqueID);
+            childTempl["index"] = static_cast<int>(child->projectID);
+            childTempl["name"] = child->name;
+            childTempl["class"] = child->className;
+            childTempl["category"] = child->getCategory();
+            childTempl["isSpecial"] = child->hasLight;
+            childTempl["parent"] = parentName;
+            childTempl["meshCount"] = child->meshes().size();
+            childTempl["totalMeshCount"] = child->subtreeStats().meshes;
+            childTempl["childCount"] = child->children.size();
+
+            QJsonArray childCustomSettings;
+            for (const auto& setting : child->customSettings)
+            {
+                QJsonObject settingObj;
+                settingObj["name"] = setting.name;
+                settingObj["value"] = setting.value;
+                childCustomSettings.append(settingObj);
+            }
+            childTempl["customSettings"] = childCustomSettings;
+
+            templates.append(childTempl);
+
+            // Recurse into grandchildren
+            addChildrenRecursive(child, child->name);
         }
-    }
-    return false;
+    };
+
+    addChildrenRecursive(obj, obj->name);
 }
 
-bool OpfExporter::exportTemplatesToJson(const PackedProject& project, const QString& filename)
+bool OpfExporter::writeTemplatesJson(const PackedProject& project, const QJsonArray& templates, const QString& filename)
 {
     QJsonObject root;
     root["version"] = "2.0";
     root["source"] = "PackedProject.opf";
     root["projectName"] = project.projectName;
     root["projectID"] = project.projectID;
-
-    // Templates (objects)
-    QJsonArray templates;
-    for (const Object* obj : project.objects)
-    {
-        if (!obj) continue;
-
-        QJsonObject templ;
-        templ["id"] = static_cast<qint64>(obj->uniqueID);
-        templ["index"] = static_cast<int>(obj->projectID);
-        templ["name"] = obj->name;
-        templ["class"] = obj->className;
-        templ["category"] = obj->getCategory();
-        templ["isSpecial"] = obj->hasLight || obj->className.contains("Base");
-        templ["hasLight"] = obj->hasLight;
-        templ["isBillboard"] = obj->isBillboard;
-        templ["isDisabled"] = obj->isDisabled;
-        templ["meshCount"] = obj->meshes().size();
-        templ["totalMeshCount"] = countAllMeshesRecursive(*obj);  // NEW: includes children
-        templ["childCount"] = obj->children.size();
-
-        // Custom settings
-        QJsonArray customSettingsArray;
-        for (const auto& setting : obj->customSettings)
-        {
-            QJsonObject settingObj;
-            settingObj["name"] = setting.name;
-            settingObj["value"] = setting.value;
-            customSettingsArray.append(settingObj);
-        }
-        templ["customSettings"] = customSettingsArray;
-
-        // CanBuildUnit list
-        QJsonArray canBuildArray;
-        for (const QString& unit : obj->getCanBuildUnits())
-        {
-            canBuildArray.append(unit);
-        }
-        templ["canBuildUnits"] = canBuildArray;
-
-        templates.append(templ);
-
-        // Add children recursively
-        std::function<void(const Object*, const QString&)> addChildrenRecursive;
-        addChildrenRecursive = [&](const Object* parent, const QString& parentName) {
-            for (const Object* child : parent->children)
-            {
-                if (!child) continue;
-
-                QJsonObject childTempl;
-                childTempl["id"] = static_cast<qint64>(child->uniqueID);
-                childTempl["index"] = static_cast<int>(child->projectID);
-                childTempl["name"] = child->name;
-                childTempl["class"] = child->className;
-                childTempl["category"] = child->getCategory();
-                childTempl["isSpecial"] = child->hasLight;
-                childTempl["parent"] = parentName;
-                childTempl["meshCount"] = child->meshes().size();
-                childTempl["totalMeshCount"] = countAllMeshesRecursive(*child);
-                childTempl["childCount"] = child->children.size();
-
-                QJsonArray childCustomSettings;
-                for (const auto& setting : child->customSettings)
-                {
-                    QJsonObject settingObj;
-                    settingObj["name"] = setting.name;
-                    settingObj["value"] = setting.value;
-                    childCustomSettings.append(settingObj);
-                }
-                childTempl["customSettings"] = childCustomSettings;
-
-                templates.append(childTempl);
-
-                // Recurse into grandchildren
-                addChildrenRecursive(child, child->name);
-            }
-        };
-
-        addChildrenRecursive(obj, obj->name);
-    }
     root["templates"] = templates;
 
     // Textures
@@ -291,6 +315,21 @@ bool OpfExporter::exportTemplatesToJson(const PackedProject& project, const QStr
 }
 
 bool OpfExporter::exportObject(const Object& object, const QString& filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        m_lastError = QString("Cannot write file: %1").arg(filename);
+        return false;
+    }
+
+    file.write(objectJson(object));
+    file.close();
+
+    return true;
+}
+
+QByteArray OpfExporter::objectJson(const Object& object)
 {
     QJsonObject root;
     root["name"] = object.name;
@@ -322,7 +361,7 @@ bool OpfExporter::exportObject(const Object& object, const QString& filename)
     root["isBillboard"] = object.isBillboard;
     root["childCount"] = object.children.size();
     root["meshCount"] = object.meshes().size();
-    root["totalMeshCount"] = countAllMeshesRecursive(object);
+    root["totalMeshCount"] = object.subtreeStats().meshes;
 
     // Custom settings
     QJsonArray customSettings;
@@ -348,7 +387,7 @@ bool OpfExporter::exportObject(const Object& object, const QString& filename)
                 childObj["class"] = child->className;
                 childObj["uniqueID"] = static_cast<qint64>(child->uniqueID);
                 childObj["meshCount"] = child->meshes().size();
-                childObj["totalMeshCount"] = countAllMeshesRecursive(*child);
+                childObj["totalMeshCount"] = child->subtreeStats().meshes;
                 childObj["childCount"] = child->children.size();
                 childrenArray.append(childObj);
             }
@@ -356,18 +395,7 @@ bool OpfExporter::exportObject(const Object& object, const QString& filename)
         root["children"] = childrenArray;
     }
 
-    QJsonDocument doc(root);
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly))
-    {
-        m_lastError = QString("Cannot write file: %1").arg(filename);
-        return false;
-    }
-
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
-
-    return true;
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
 }
 
 bool OpfExporter::exportTexture(const Texture& texture, const QString& filename)
@@ -402,75 +430,45 @@ bool OpfExporter::exportTexture(const Texture& texture, const QString& filename)
 
 bool OpfExporter::exportMeshToObj(const Mesh& mesh, const QString& filename, const PackedProject& project)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        m_lastError = QString("Cannot write file: %1").arg(filename);
-        return false;
-    }
-
-    QTextStream out(&file);
-
     QFileInfo fileInfo(filename);
     QString mtlFilename = fileInfo.completeBaseName() + ".mtl";
 
-    out << "# Outforce OBJ Export v2.0\n";
-    out << "# Mesh: " << mesh.name << "\n";
-    out << "# Vertices: " << mesh.vertices.size() << "\n";
-    out << "# Faces: " << (mesh.indices.size() / 3) << "\n";
-    out << "# Material ID: " << mesh.materialID << "\n\n";
-
-    out << "mtllib " << mtlFilename << "\n\n";
+    ObjWriter writer(options().objPrecision);
+    writer.writeMesh(mesh, mtlFilename);
 
-    // Vertices
-    for (const Vertex& v : mesh.vertices)
+    if (!writer.save(filename, &m_lastError))
     {
-        out << QString("v %1 %2 %3\n")
-        .arg(v.position.x, 0, 'f', 6)
-            .arg(v.position.y, 0, 'f', 6)
-            .arg(v.position.z, 0, 'f', 6);
-    }
-    out << "\n";
-
-    // Normals
-    for (const Vertex& v : mesh.vertices) {
-        out << QString("vn %1 %2 %3\n")
-        .arg(v.normal.x, 0, 'f', 6)
-            .arg(v.normal.y, 0, 'f', 6)
-            .arg(v.normal.z, 0, 'f', 6);
+        return false;
     }
-    out << "\n";
 
-    // Texture coordinates - FIX: Mirror Y around texture center (0.5)
-    for (const Vertex& v : mesh.vertices) {
-        out << QString("vt %1 %2\n")
-        .arg(v.texCoord.x, 0, 'f', 6)
-            .arg(1.0f - v.texCoord.y, 0, 'f', 6);
-    }
-    out << "\n";
+    // Export MTL
+    QString mtlPath = fileInfo.dir().filePath(mtlFilename);
+    exportMeshMtl(mesh, mtlPath, project);
 
-    // Material
-    QString mtlName = QString("material_%1").arg(mesh.materialID);
-    out << "usemtl " << mtlName << "\n\n";
+    return true;
+}
 
-    // Faces - FIX: Reverse winding order (DirectX CW to OpenGL/Blender CCW)
-    out << "# Faces\n";
-    for (int i = 0; i < mesh.indices.size(); i += 3) {
-        int i1 = mesh.indices[i] + 1;
-        int i2 = mesh.indices[i + 1] + 1;
-        int i3 = mesh.indices[i + 2] + 1;
+bool OpfExporter::exportObjectToGlb(const Object& object, const QString& filename, const PackedProject& project)
+{
+    ExportOptions options = this->options();
 
-        // Swap i2 and i3 to reverse winding order
-        out << QString("f %1/%1/%1 %2/%2/%2 %3/%3/%3\n")
-                   .arg(i1).arg(i3).arg(i2);
+    GlbWriter writer(project);
+    writer.setTextureScale(int(options.textureScale));
+    if (!options.embedGlbTextures)
+    {
+        // The files written by the texture export, next to the models directory
+        QString extension = options.textureFormat == SettingsManager::JPEG ? "jpg" : "png";
+        writer.setTextureUri([this, extension](const Texture& texture) {
+            const Texture& file = canonicalTexture(texture);
+            return QString("../textures/%1_%2.%3").arg(sanitizeFilename(file.name)).arg(file.id).arg(extension);
+        });
     }
 
-    file.close();
-
-    // Export MTL
-    QString mtlPath = fileInfo.dir().filePath(mtlFilename);
-    exportMeshMtl(mesh, mtlPath, project);
-
+    if (!writer.write(object, filename))
+    {
+        m_lastError = writer.lastError();
+        return false;
+    }
     return true;
 }
 
@@ -491,32 +489,42 @@ bool OpfExporter::exportObjectMeshes(const Object& object, const QString& direct
         }
     }
 
-    // Export this object's meshes
-    int meshIndex = 0;
-    for (const Mesh& mesh : object.meshes())
+    QVector<MeshFile> meshes;
+    collectObjectMeshes(object, dir, meshes);
+
+    for (const MeshFile& file : meshes)
     {
-        QString meshName = mesh.name;
-        if (meshName.isEmpty())
+        if (!exportMeshToObj(*file.mesh, file.filename, project))
         {
-            meshName = QString("%1_mesh_%2").arg(sanitizeFilename(object.name)).arg(meshIndex);
+            qWarning() << "Failed to export mesh:" << file.filename;
         }
         else
         {
-            meshName = sanitizeFilename(meshName);
+            qDebug() << "  Exported mesh:" << QFileInfo(file.filename).fileName() << "from object:" << object.name;
         }
+    }
+
+    return true;
+}
 
-        QString filename = dir.filePath(QString("%1.obj").arg(meshName));
+void OpfExporter::collectObjectMeshes(const Object& object, const QDir& dir, QVector<MeshFile>& meshes)
+{
+    // This object's meshes
+    for (int i = 0; i < object.meshes().size(); ++i)
+    {
+        const Mesh& mesh = object.meshes()[i];
 
-        if (!exportMeshToObj(mesh, filename, project))
+        QString meshName = mesh.name;
+        if (meshName.isEmpty())
         {
-            qWarning() << "Failed to export mesh:" << meshName;
+            meshName = QString("%1_mesh_%2").arg(sanitizeFilename(object.name)).arg(i);
         }
         else
         {
-            qDebug() << "  Exported mesh:" << meshName << "from object:" << object.name;
+            meshName = sanitizeFilename(meshName);
         }
 
-        meshIndex++;
+        meshes.append(MeshFile{ &mesh, dir.filePath(QString("%1.obj").arg(meshName)) });
     }
 
     // ========================================================================
@@ -526,8 +534,7 @@ bool OpfExporter::exportObjectMeshes(const Object& object, const QString& direct
     {
         if (!child) continue;
 
-        // Create subdirectory for child or export in same directory with prefixed names
-        // Option 1: Same directory with child name prefix
+        // Same directory with child name prefix
         for (int i = 0; i < child->meshes().size(); ++i)
         {
             const Mesh& mesh = child->meshes()[i];
@@ -543,34 +550,23 @@ bool OpfExporter::exportObjectMeshes(const Object& object, const QString& direct
                 meshName = QString("%1_%2").arg(sanitizeFilename(child->name), sanitizeFilename(meshName));
             }
 
-            QString filename = dir.filePath(QString("%1.obj").arg(meshName));
-
-            if (!exportMeshToObj(mesh, filename, project))
-            {
-                qWarning() << "Failed to export child mesh:" << meshName;
-            }
-            else
-            {
-                qDebug() << "  Exported child mesh:" << meshName << "from child:" << child->name;
-            }
+            meshes.append(MeshFile{ &mesh, dir.filePath(QString("%1.obj").arg(meshName)) });
         }
 
         // Recursively handle grandchildren
         if (!child->children.isEmpty())
         {
-            exportObjectMeshesRecursiveHelper(*child, dir, project, child->name);
+            collectNestedMeshes(*child, dir, child->name, meshes);
         }
     }
-
-    return true;
 }
 
 // ============================================================================
-// HELPER: Recursive mesh export for deeply nested children
+// HELPER: Recursive mesh collection for deeply nested children
 // ============================================================================
-void OpfExporter::exportObjectMeshesRecursiveHelper(const Object& object, const QDir& dir,
-                                                    const PackedProject& project,
-                                                    const QString& parentPrefix)
+void OpfExporter::collectNestedMeshes(const Object& object, const QDir& dir,
+                                      const QString& parentPrefix,
+                                      QVector<MeshFile>& meshes)
 {
     for (const Object* child : object.children)
     {
@@ -578,7 +574,6 @@ void OpfExporter::exportObjectMeshesRecursiveHelper(const Object& object, const
 
         QString childPrefix = parentPrefix + "_" + sanitizeFilename(child->name);
 
-        // Export this child's meshes
         for (int i = 0; i < child->meshes().size(); ++i)
         {
             const Mesh& mesh = child->meshes()[i];
@@ -593,205 +588,90 @@ void OpfExporter::exportObjectMeshesRecursiveHelper(const Object& object, const
                 meshName = QString("%1_%2").arg(childPrefix, sanitizeFilename(meshName));
             }
 
-            QString filename = dir.filePath(QString("%1.obj").arg(meshName));
-
-            if (!exportMeshToObj(mesh, filename, project))
-            {
-                qWarning() << "Failed to export grandchild mesh:" << meshName;
-            }
-            else
-            {
-                qDebug() << "  Exported grandchild mesh:" << meshName;
-            }
+            meshes.append(MeshFile{ &mesh, dir.filePath(QString("%1.obj").arg(meshName)) });
         }
 
         // Continue recursion
         if (!child->children.isEmpty())
         {
-            exportObjectMeshesRecursiveHelper(*child, dir, project, childPrefix);
+            collectNestedMeshes(*child, dir, childPrefix, meshes);
         }
     }
 }
 
 bool OpfExporter::exportMeshMtl(const Mesh& mesh, const QString& mtlFilename, const PackedProject& project)
 {
-    QFile file(mtlFilename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        m_lastError = QString("Cannot write MTL file: %1").arg(mtlFilename);
-        return false;
-    }
-
-    QTextStream out(&file);
-
-    out << "# Outforce MTL Export\n";
-    out << "# Mesh: " << mesh.name << "\n";
-    out << "# Material ID: " << mesh.materialID << "\n\n";
-
-    QString mtlName = QString("material_%1").arg(mesh.materialID);
-    out << "newmtl " << mtlName << "\n";
-
-    out << "Ka 1.0 1.0 1.0\n";
-    out << "Kd 1.0 1.0 1.0\n";
-    out << "Ks 0.0 0.0 0.0\n";
-    out << "d 1.0\n";
-    out << "illum 2\n";
+    ObjWriter writer;
+
+    writer.append("# Outforce MTL Export\n# Mesh: ");
+    writer.append(mesh.name.toUtf8());
+    writer.append("\n# Material ID: ");
+    writer.append(QByteArray::number(mesh.materialID));
+    writer.append("\n\nnewmtl material_");
+    writer.append(QByteArray::number(mesh.materialID));
+    writer.append("\n"
+                  "Ka 1.0 1.0 1.0\n"
+                  "Kd 1.0 1.0 1.0\n"
+                  "Ks 0.0 0.0 0.0\n"
+                  "d 1.0\n"
+                  "illum 2\n");
 
     const Texture* texture = findTextureForMaterial(mesh.materialID, project);
     if (texture)
     {
         QString textureName = sanitizeFilename(texture->name);
         QString texturePath = QString("../../textures/%1_%2.png").arg(textureName).arg(texture->id);
-        out << "map_Kd " << texturePath << "\n";
+        writer.append("map_Kd ");
+        writer.append(texturePath.toUtf8());
+        writer.append("\n");
     }
 
-    file.close();
+    if (!writer.save(mtlFilename))
+    {
+        m_lastError = QString("Cannot write MTL file: %1").arg(mtlFilename);
+        return false;
+    }
     return true;
 }
 
 const Texture* OpfExporter::findTextureForMaterial(int materialID, const PackedProject& project)
 {
-    const Material* material = nullptr;
-    for (const Material& mat : project.materials)
-    {
-        if (mat.id == materialID)
-        {
-            material = &mat;
-            break;
-        }
-    }
-
+    const Material* material = project.findMaterialByID(materialID);
     if (!material || material->textureID == -1)
     {
         return nullptr;
     }
 
-    return project.findTextureByID(material->textureID);
+    const Texture* texture = project.findTextureByID(material->textureID);
+    return texture ? &canonicalTexture(*texture) : nullptr;
+}
+
+const Texture& OpfExporter::canonicalTexture(const Texture& texture) const
+{
+    return *m_textureAliases.value(texture.id, &texture);
 }
 
 bool OpfExporter::exportTextureToPng(const Texture& texture, const QString& filename)
 {
-    if (texture.colorData.isEmpty())
+    if (!texture.hasColorData())
     {
         qDebug() << "Texture" << texture.name << "has no color data, skipping";
         return true;
     }
 
-    SettingsManager& settings = SettingsManager::instance();
-
-    QImage image;
-
-    // Decode color channel
-    if (texture.colorBitmapType != 0)
-    {
-        image.loadFromData(texture.colorData, "JPEG");
-        if (image.isNull())
-        {
-            qWarning() << "Failed to decode JPEG:" << texture.name;
-            return false;
-        }
-    }
-
-    else
-    {
-        if (texture.colorBitsPerPixel == 32)
-        {
-            image = QImage((const uchar*)texture.colorData.data(), texture.width, texture.height, QImage::Format_RGBA8888).copy();
-        }
-
-        else if (texture.colorBitsPerPixel == 24)
-        {
-            image = QImage((const uchar*)texture.colorData.data(), texture.width, texture.height, QImage::Format_RGB888).copy();
-        }
-
-        else if (texture.colorBitsPerPixel == 16)
-        {
-            image = QImage(texture.width, texture.height, QImage::Format_RGB888);
-            const quint16* src = (const quint16*)texture.colorData.data();
-
-            for (quint32 y = 0; y < texture.height; y++)
-            {
-                for (quint32 x = 0; x < texture.width; x++)
-                {
-                    quint16 pixel = src[y * texture.width + x];
-                    quint8 r = ((pixel >> 11) & 0x1F) << 3;
-                    quint8 g = ((pixel >> 5) & 0x3F) << 2;
-                    quint8 b = (pixel & 0x1F) << 3;
-                    image.setPixel(x, y, qRgb(r, g, b));
-                }
-            }
-        }
-
-        else
-        {
-            qWarning() << "Unsupported bit depth:" << texture.colorBitsPerPixel;
-            return false;
-        }
-    }
-
-    // Merge alpha channel
-    if (texture.hasAlphaChannel && !texture.alphaData.isEmpty())
-    {
-        QImage alphaImage;
-
-        if (texture.alphaBitmapType != 0)
-        {
-            alphaImage.loadFromData(texture.alphaData, "JPEG");
-        }
-
-        else
-        {
-            if (texture.alphaBitsPerPixel == 8)
-            {
-                alphaImage = QImage((const uchar*)texture.alphaData.data(), texture.width, texture.height, QImage::Format_Grayscale8).copy();
-            }
-
-            else if (texture.alphaBitsPerPixel == 16)
-            {
-                alphaImage = QImage(texture.width, texture.height, QImage::Format_Grayscale8);
-                const quint16* src = (const quint16*)texture.alphaData.data();
-                for (quint32 y = 0; y < texture.height; y++)
-                {
-                    for (quint32 x = 0; x < texture.width; x++)
-                    {
-                        quint16 pixel = src[y * texture.width + x];
-                        quint8 gray = (pixel >> 8) & 0xFF;
-                        alphaImage.setPixel(x, y, qRgb(gray, gray, gray));
-                    }
-                }
-            }
-        }
-
-        if (!alphaImage.isNull())
-        {
-            if (image.format() != QImage::Format_RGBA8888)
-            {
-                image = image.convertToFormat(QImage::Format_RGBA8888);
-            }
-
-            for (quint32 y = 0; y < texture.height && y < (quint32)alphaImage.height(); y++)
-            {
-                for (quint32 x = 0; x < texture.width && x < (quint32)alphaImage.width(); x++)
-                {
-                    QRgb rgb = image.pixel(x, y);
-                    int alpha = qGray(alphaImage.pixel(x, y));
-                    image.setPixel(x, y, qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), alpha));
-                }
-            }
-        }
-    }
+    ExportOptions options = this->options();
 
-    // Apply texture scale
-    SettingsManager::TextureScale scale = settings.textureScale();
-    if (scale != SettingsManager::Scale100)
+    // Color and alpha channel merged, at the export scale. Textures that were
+    // just previewed or exported before are not decoded again.
+    QImage image = TextureCache::instance().image(texture, TextureCache::Variant::Merged, int(options.textureScale));
+    if (image.isNull())
     {
-        int newWidth = (image.width() * scale) / 100;
-        int newHeight = (image.height() * scale) / 100;
-        image = image.scaled(newWidth, newHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        m_lastError = QString("Failed to decode texture: %1").arg(texture.name);
+        return false;
     }
 
     // Save
-    SettingsManager::TextureFormat format = settings.textureFormat();
+    SettingsManager::TextureFormat format = options.textureFormat;
     QString finalFilename = filename;
     const char* saveFormat = "PNG";
     int quality = -1;
@@ -837,7 +717,7 @@ bool OpfExporter::exportAllTextures(const QVector<Texture>& textures, const QStr
     int exportedCount = 0;
     for (const Texture& tex : textures)
     {
-        if (tex.colorData.isEmpty())
+        if (!tex.hasColorData())
         {
             continue;
         }
@@ -857,16 +737,6 @@ bool OpfExporter::exportAllTextures(const QVector<Texture>& textures, const QStr
 
 bool OpfExporter::exportMaterialToJson(const Material& material, const QString& filename)
 {
-    QJsonObject root;
-    root["name"] = material.name;
-    root["id"] = material.id;
-    root["projectID"] = material.projectID;
-    root["version"] = static_cast<int>(material.version);
-    root["doubleSided"] = material.doubleSided;
-    root["enabledLighting"] = material.enabledLighting;
-    root["textureID"] = material.textureID;
-
-    QJsonDocument doc(root);
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly))
     {
@@ -874,12 +744,26 @@ bool OpfExporter::exportMaterialToJson(const Material& material, const QString&
         return false;
     }
 
-    file.write(doc.toJson(QJsonDocument::Indented));
+    file.write(materialJson(material));
     file.close();
 
     return true;
 }
 
+QByteArray OpfExporter::materialJson(const Material& material)
+{
+    QJsonObject root;
+    root["name"] = material.name;
+    root["id"] = material.id;
+    root["projectID"] = material.projectID;
+    root["version"] = static_cast<int>(material.version);
+    root["doubleSided"] = material.doubleSided;
+    root["enabledLighting"] = material.enabledLighting;
+    root["textureID"] = material.textureID;
+
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
 bool OpfExporter::exportBlenderImportScript(const PackedProject& project, const QString& filename)
 {
     QFile file(filename);
@@ -915,15 +799,48 @@ bool OpfExporter::exportBlenderImportScript(const PackedProject& project, const
     out << "    return script_dir\n\n";
 
     out << "script_dir = get_script_dir()\n";
-    out << "meshes_dir = os.path.join(script_dir, 'meshes')\n\n";
 
-    out << "if not os.path.exists(meshes_dir):\n";
-    out << "    print(f'ERROR: Meshes directory not found: {meshes_dir}')\n";
+    if (options().exportGLB)
+    {
+        // One file per object, hierarchy and transforms included
+        out << "models_dir = os.path.join(script_dir, 'models')\n\n";
+
+        out << "if not os.path.exists(models_dir):\n";
+        out << "    print(f'ERROR: Models directory not found: {models_dir}')\n";
+        out << "else:\n";
+        out << "    main_collection = bpy.data.collections.new('Outforce_Assets')\n";
+        out << "    bpy.context.scene.collection.children.link(main_collection)\n\n";
+
+        out << "    imported = 0\n";
+        out << "    for f in sorted(os.listdir(models_dir)):\n";
+        out << "        if f.endswith('.glb'):\n";
+        out << "            filepath = os.path.join(models_dir, f)\n";
+        out << "            try:\n";
+        out << "                bpy.ops.import_scene.gltf(filepath=filepath)\n";
+        out << "                for obj in bpy.context.selected_objects:\n";
+        out << "                    for coll in obj.users_collection:\n";
+        out << "                        coll.objects.unlink(obj)\n";
+        out << "                    main_collection.objects.link(obj)\n";
+        out << "                imported += 1\n";
+        out << "            except Exception as e:\n";
+        out << "                print(f'Error importing {f}: {e}')\n\n";
+
+        out << "    print(f'Imported {imported} models')\n";
+
+        file.close();
+        return true;
+    }
+
+    out << "meshes_dir = os.path.join(script_dir, 'meshes')\n\n";
+
+    out << "if not os.path.exists(meshes_dir):\n";
+    out << "    print(f'ERROR: Meshes directory not found: {meshes_dir}')\n";
     out << "else:\n";
     out << "    main_collection = bpy.data.collections.new('Outforce_Assets')\n";
     out << "    bpy.context.scene.collection.children.link(main_collection)\n\n";
 
     out << "    imported = 0\n";
+    out << "    imported_objects = {}\n";
     out << "    for root, dirs, files in os.walk(meshes_dir):\n";
     out << "        for f in files:\n";
     out << "            if f.endswith('.obj'):\n";
@@ -935,149 +852,1368 @@ bool OpfExporter::exportBlenderImportScript(const PackedProject& project, const
     out << "                        for coll in obj.users_collection:\n";
     out << "                            coll.objects.unlink(obj)\n";
     out << "                        main_collection.objects.link(obj)\n";
+    out << "                        imported_objects[os.path.normpath(filepath)] = obj\n";
     out << "                    imported += 1\n";
     out << "                except Exception as e:\n";
     out << "                    print(f'Error importing {f}: {e}')\n\n";
 
-    out << "    print(f'Imported {imported} meshes')\n";
+    // Meshes skipped by deduplication become linked copies of the shared one
+    out << "    manifest_path = os.path.join(script_dir, 'dedup_manifest.json')\n";
+    out << "    if os.path.exists(manifest_path):\n";
+    out << "        with open(manifest_path) as manifest_file:\n";
+    out << "            manifest = json.load(manifest_file)\n";
+    out << "        for entry in manifest.get('meshes', {}).get('duplicates', []):\n";
+    out << "            source = imported_objects.get(os.path.normpath(os.path.join(script_dir, entry['sharedFile'])))\n";
+    out << "            if source:\n";
+    out << "                copy = source.copy()\n";
+    out << "                copy.name = os.path.splitext(os.path.basename(entry['file']))[0]\n";
+    out << "                main_collection.objects.link(copy)\n";
+    out << "                imported += 1\n\n";
+
+    out << "    print(f'Imported {imported} meshes')\n";
+
+    file.close();
+    return true;
+}
+
+bool OpfExporter::exportAll(const PackedProject& project, const QString& directory)
+{
+    m_currentProgress = 0;
+    m_progressMaximum = project.objects.size() + project.textures.size() + project.materials.size() + 5;
+
+    ExportOptions options = this->options();
+
+    QDir dir(directory);
+    if (!dir.exists())
+    {
+        if (!dir.mkpath("."))
+        {
+            m_lastError = QString("Cannot create directory: %1").arg(directory);
+            return false;
+        }
+    }
+
+    // Object JSON is written on the pool and reads the statistics cache
+    project.updateSubtreeStats();
+
+    // Export templates.json
+    if (options.exportJSON)
+    {
+        if (!updateProgress("Exporting templates.json..."))
+        {
+            return false;
+        }
+        QString templatesPath = dir.filePath("templates.json");
+
+        if (!exportTemplatesToJson(project, templatesPath))
+        {
+            return false;
+        }
+    }
+
+    // Create subdirectories
+    dir.mkdir("objects");
+    if (options.exportOBJ) dir.mkdir("meshes");
+    if (options.exportGLB) dir.mkdir("models");
+    if (options.exportPNG) dir.mkdir("textures");
+    if (options.exportJSON) dir.mkdir("materials");
+
+    // Collect the jobs (directories are created here, on one thread)
+    QVector<ExportJob> jobs;
+    int objectCount = 0;
+    int meshCount = 0;
+
+    for (const Object* obj : project.objects)
+    {
+        if (!obj) continue;
+
+        QString safeName = sanitizeFilename(obj->name);
+
+        if (options.exportJSON)
+        {
+            ExportJob job{ ExportJob::ObjectJson };
+            job.object = obj;
+            job.record = obj->uniqueID;
+            job.filename = dir.filePath(QString("objects/%1_%2.json").arg(safeName).arg(obj->uniqueID));
+            jobs.append(job);
+            objectCount++;
+        }
+
+        // FIXED: Check children's meshes too
+        if (options.exportOBJ && obj->subtreeStats().meshes > 0)
+        {
+            QDir meshDir(dir.filePath(QString("meshes/%1_%2").arg(safeName).arg(obj->uniqueID)));
+            if (!meshDir.mkpath("."))
+            {
+                qWarning() << "Cannot create directory:" << meshDir.path();
+                continue;
+            }
+
+            QVector<MeshFile> meshes;
+            collectObjectMeshes(*obj, meshDir, meshes);
+            for (const MeshFile& file : meshes)
+            {
+                ExportJob job{ ExportJob::MeshObj };
+                job.mesh = file.mesh;
+                job.record = obj->uniqueID;
+                job.filename = file.filename;
+                jobs.append(job);
+            }
+
+            // FIXED: Count all meshes including children
+            meshCount += obj->subtreeStats().meshes;
+        }
+
+        if (options.exportGLB && obj->subtreeStats().meshes > 0)
+        {
+            ExportJob job{ ExportJob::ObjectGlb };
+            job.object = obj;
+            job.record = obj->uniqueID;
+            job.filename = dir.filePath(QString("models/%1_%2.glb").arg(safeName).arg(obj->uniqueID));
+            jobs.append(job);
+        }
+    }
+
+    if (options.exportPNG)
+    {
+        for (const Texture& tex : project.textures)
+        {
+            if (!tex.hasColorData()) continue;
+
+            ExportJob job{ ExportJob::TextureImage };
+            job.texture = &tex;
+            job.record = tex.id;
+            job.filename = dir.filePath(QString("textures/%1_%2.png").arg(sanitizeFilename(tex.name)).arg(tex.id));
+            jobs.append(job);
+        }
+    }
+
+    if (options.exportJSON)
+    {
+        for (const Material& mat : project.materials)
+        {
+            ExportJob job{ ExportJob::MaterialJson };
+            job.material = &mat;
+            job.record = mat.id;
+            job.filename = dir.filePath(QString("materials/%1_%2.json").arg(sanitizeFilename(mat.name)).arg(mat.id));
+            jobs.append(job);
+        }
+    }
+
+    // Before anything compares or hashes jobs by their files
+    dropOverwrittenJobs(jobs);
+
+    m_textureAliases.clear();
+    m_dedupSummary = QJsonObject();
+    if (options.deduplicate)
+    {
+        if (!updateProgress("Finding duplicate meshes and textures..."))
+        {
+            return false;
+        }
+        QJsonObject manifest = deduplicateJobs(jobs, dir, options);
+
+        // The import script resolves duplicates through it, so a short write fails the export
+        QSaveFile manifestFile(dir.filePath("dedup_manifest.json"));
+        if (!manifestFile.open(QIODevice::WriteOnly))
+        {
+            m_lastError = QString("Cannot write file: %1").arg(manifestFile.fileName());
+            return false;
+        }
+
+        manifestFile.write(QJsonDocument(manifest).toJson(QJsonDocument::Indented));
+
+        if (!manifestFile.commit())
+        {
+            m_lastError = QString("Cannot write file: %1").arg(manifestFile.fileName());
+            return false;
+        }
+    }
+
+    // Files of the previous run, and of this one
+    ExportManifest previousFiles;
+    ExportManifest files;
+    QVector<quint64> sourceHashes;
+    m_incrementalSummary = QJsonObject();
+    if (options.incremental)
+    {
+        if (!updateProgress("Comparing with the previous export..."))
+        {
+            return false;
+        }
+        previousFiles = readExportManifest(dir);
+        skipUnchangedJobs(jobs, sourceHashes, previousFiles, files, dir, project, options);
+    }
+
+    // The aliases point into 'project', drop them with the jobs
+    QVector<bool> succeeded;
+    bool exported = runExportJobs(jobs, project, options, &succeeded);
+    m_textureAliases.clear();
+    if (!exported)
+    {
+        return false;
+    }
+
+    if (options.incremental && !finishIncrementalExport(jobs, sourceHashes, succeeded, previousFiles, files, dir, project, options))
+    {
+        return false;
+    }
+
+    // Export Blender script
+    if (options.exportBlenderScript)
+    {
+        if (!updateProgress("Creating Blender import script..."))
+        {
+            return false;
+        }
+        QString scriptPath = dir.filePath("import_to_blender.py");
+        exportBlenderImportScript(project, scriptPath);
+    }
+
+    qDebug() << "Export complete:" << objectCount << "objects," << meshCount << "meshes (including children)";
+    return true;
+}
+
+// ============================================================================
+// DEDUPLICATION
+// ============================================================================
+
+namespace {
+
+// Everything the OBJ and MTL files are made of, except the mesh name
+quint64 meshContentHash(const Mesh& mesh)
+{
+    VertexView vertices = mesh.vertices();
+    ArrayView<Vector2D> texCoords = vertices.texCoords();
+    ArrayView<uint16> indices = mesh.indices();
+
+    quint64 hash = contentHash(&mesh.materialID, sizeof(mesh.materialID), quint64(mesh.bufferType));
+    hash = contentHash(vertices.positions().constData(), qint64(vertices.size()) * qint64(sizeof(Vector3D)), hash);
+    hash = contentHash(vertices.normals().constData(), qint64(vertices.size()) * qint64(sizeof(Vector3D)), hash);
+    hash = contentHash(texCoords.constData(), qint64(texCoords.size()) * qint64(sizeof(Vector2D)), hash);
+    return contentHash(indices.constData(), qint64(indices.size()) * qint64(sizeof(uint16)), hash);
+}
+
+// The payloads plus every field TextureDecoder reads; 0 if the payloads
+// cannot be read, so the texture is exported on its own
+quint64 textureContentHash(const Texture& texture)
+{
+    TexturePayloadScope payload(texture);
+    if (!payload.isLoaded())
+    {
+        return 0;
+    }
+
+    const qint32 format[] = {
+        qint32(texture.width), qint32(texture.height),
+        texture.colorBitsPerPixel, texture.alphaBitsPerPixel,
+        texture.colorBitmapType, texture.alphaBitmapType,
+        texture.hasAlphaChannel
+    };
+
+    quint64 hash = contentHash(format, sizeof(format));
+    hash = contentHash(texture.colorData, hash);
+    return contentHash(texture.alphaData, hash);
+}
+
+double dedupRatio(int total, int unique)
+{
+    return unique > 0 ? double(total) / unique : 1.0;
+}
+
+// Runs work(0) ... work(count - 1) on a temporary pool and waits for them
+void runOnPool(int count, int threadCount, const std::function<void(int)>& work)
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, threadCount > 0 ? threadCount : QThread::idealThreadCount()));
+    for (int i = 0; i < count; i++)
+    {
+        pool.start(QRunnable::create([&work, i]() { work(i); }));
+    }
+    pool.waitForDone();
+}
+
+} // namespace
+
+QJsonObject OpfExporter::deduplicateJobs(QVector<ExportJob>& jobs, const QDir& dir, const ExportOptions& options)
+{
+    // Hashing reads every payload once, so it runs on the pool as well
+    QVector<quint64> hashes(jobs.size(), 0);
+    quint64* hashData = hashes.data();
+    runOnPool(jobs.size(), options.threadCount, [&](int i) {
+        const ExportJob& job = jobs.at(i);
+        if (job.type == ExportJob::MeshObj)
+        {
+            hashData[i] = meshContentHash(*job.mesh);
+        }
+        else if (job.type == ExportJob::TextureImage)
+        {
+            hashData[i] = textureContentHash(*job.texture);
+        }
+    });
+
+    auto outputFile = [&](const ExportJob& job) {
+        return dir.relativeFilePath(jobOutputFiles(job, options).first());
+    };
+
+    // The first job with a given content is exported, later ones refer to it
+    // (64-bit hashes, collisions are not checked for)
+    QHash<quint64, int> firstMesh;
+    QHash<quint64, int> firstTexture;
+    QJsonArray meshDuplicates;
+    QJsonArray textureDuplicates;
+    int meshTotal = 0;
+    int textureTotal = 0;
+
+    QVector<ExportJob> kept;
+    kept.reserve(jobs.size());
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        const ExportJob& job = jobs[i];
+        bool isMesh = job.type == ExportJob::MeshObj;
+        if (!isMesh && job.type != ExportJob::TextureImage)
+        {
+            kept.append(job);
+            continue;
+        }
+
+        if (isMesh)
+        {
+            meshTotal++;
+        }
+        else
+        {
+            textureTotal++;
+        }
+
+        QHash<quint64, int>& first = isMesh ? firstMesh : firstTexture;
+        auto existing = first.constFind(hashes[i]);
+        if (hashes[i] == 0 || existing == first.constEnd())
+        {
+            if (hashes[i] != 0)
+            {
+                first.insert(hashes[i], i);
+            }
+            kept.append(job);
+            continue;
+        }
+
+        const ExportJob& shared = jobs[existing.value()];
+        if (shared.filename == job.filename)
+        {
+            continue;   // same file listed twice, written once anyway
+        }
+
+        QJsonObject duplicate;
+        duplicate["file"] = outputFile(job);
+        duplicate["sharedFile"] = outputFile(shared);
+        if (isMesh)
+        {
+            meshDuplicates.append(duplicate);
+        }
+        else
+        {
+            duplicate["id"] = job.texture->id;
+            duplicate["sharedID"] = shared.texture->id;
+            textureDuplicates.append(duplicate);
+            m_textureAliases.insert(job.texture->id, shared.texture);
+        }
+    }
+    jobs = kept;
+
+    int meshUnique = meshTotal - meshDuplicates.size();
+    int textureUnique = textureTotal - textureDuplicates.size();
+
+    QJsonObject summary;
+    summary["meshes"] = meshTotal;
+    summary["uniqueMeshes"] = meshUnique;
+    summary["textures"] = textureTotal;
+    summary["uniqueTextures"] = textureUnique;
+    summary["meshDedupRatio"] = dedupRatio(meshTotal, meshUnique);
+    summary["textureDedupRatio"] = dedupRatio(textureTotal, textureUnique);
+    summary["dedupRatio"] = dedupRatio(meshTotal + textureTotal, meshUnique + textureUnique);
+    m_dedupSummary = summary;
+
+    QJsonObject meshes;
+    meshes["total"] = meshTotal;
+    meshes["unique"] = meshUnique;
+    meshes["dedupRatio"] = summary.value("meshDedupRatio");
+    meshes["duplicates"] = meshDuplicates;
+
+    QJsonObject textures;
+    textures["total"] = textureTotal;
+    textures["unique"] = textureUnique;
+    textures["dedupRatio"] = summary.value("textureDedupRatio");
+    textures["duplicates"] = textureDuplicates;
+
+    QJsonObject manifest;
+    manifest["version"] = 1;
+    manifest["dedupRatio"] = summary.value("dedupRatio");
+    manifest["meshes"] = meshes;
+    manifest["textures"] = textures;
+
+    qDebug() << "Deduplication:" << meshUnique << "of" << meshTotal << "meshes and"
+             << textureUnique << "of" << textureTotal << "textures are unique";
+    return manifest;
+}
+
+// ============================================================================
+// INCREMENTAL EXPORT
+// ============================================================================
+
+namespace {
+
+const char* const kExportManifestFile = "export_manifest.json";
+
+// Bumped whenever an exporter writes different bytes for the same records,
+// so the next incremental export writes everything again
+const int kExportManifestVersion = 2;
+
+// Chains contentHash over the fields it is given, one at a time, so struct
+// padding never ends up in a hash
+class SourceHash
+{
+public:
+    template<typename T>
+    SourceHash& add(const T& value)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "add plain values only");
+        m_hash = contentHash(&value, sizeof(T), m_hash);
+        return *this;
+    }
+
+    SourceHash& add(const Vector3D& value)
+    {
+        return add(value.x).add(value.y).add(value.z);
+    }
+
+    SourceHash& add(const QString& text)
+    {
+        m_hash = contentHash(text.constData(), qint64(text.size()) * qint64(sizeof(QChar)), m_hash);
+        return *this;
+    }
+
+    SourceHash& add(const QByteArray& bytes)
+    {
+        m_hash = contentHash(bytes, m_hash);
+        return *this;
+    }
+
+    quint64 value() const { return m_hash; }
+
+private:
+    quint64 m_hash = 0;
+};
+
+// The pass fields GlbWriter turns into material and sampler properties
+void addRenderPass(SourceHash& hash, const RenderPassSettings& settings, const RenderPassStage& stage)
+{
+    hash.add(settings.alphaBlending).add(settings.testForAlphaBlending).add(settings.alphaReference);
+    hash.add(stage.textureID).add(stage.textureAddressU).add(stage.textureAddressV);
+    hash.add(stage.maxTextureMagnificationFilter).add(stage.maxTextureMinificationFilter).add(stage.maxTextureMipmapFilter);
+}
+
+// Textures a GLB of 'object' embeds, subtree included
+void addGlbTextures(const Object& object, const PackedProject& project, QSet<const Texture*>& textures)
+{
+    for (const Mesh& mesh : object.meshes())
+    {
+        const Material* material = project.findMaterialByID(mesh.materialID);
+        const Texture* texture = material && material->textureID != -1 ? project.findTextureByID(material->textureID) : nullptr;
+        if (texture)
+        {
+            textures.insert(texture);
+        }
+    }
+
+    for (const Object* child : object.children)
+    {
+        if (child)
+        {
+            addGlbTextures(*child, project, textures);
+        }
+    }
+}
+
+bool hashFile(const QString& filename, quint64& hash)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    qint64 size = file.size();
+    const uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+    hash = mapped ? contentHash(mapped, size) : contentHash(file.readAll());
+    return true;
+}
+
+} // namespace
+
+QStringList OpfExporter::jobOutputFiles(const ExportJob& job, const ExportOptions& options)
+{
+    if (job.type == ExportJob::MeshObj)
+    {
+        QFileInfo info(job.filename);
+        return { job.filename, info.dir().filePath(info.completeBaseName() + ".mtl") };
+    }
+
+    // Textures are saved as .jpg in JPEG mode
+    if (job.type == ExportJob::TextureImage && options.textureFormat == SettingsManager::JPEG)
+    {
+        QString filename = job.filename;
+        filename.replace(QRegularExpression("\\.png$", QRegularExpression::CaseInsensitiveOption), ".jpg");
+        return { filename };
+    }
+
+    return { job.filename };
+}
+
+quint64 OpfExporter::jobSourceHash(const ExportJob& job, const PackedProject& project, const ExportOptions& options,
+                                   const QHash<const Texture*, quint64>& textureHashes)
+{
+    // 0 = cannot tell, the job always runs
+    SourceHash hash;
+    hash.add(int(job.type));
+
+    switch (job.type)
+    {
+    case ExportJob::ObjectJson:
+        hash.add(objectJson(*job.object));
+        break;
+
+    case ExportJob::MaterialJson:
+        hash.add(materialJson(*job.material));
+        break;
+
+    case ExportJob::MeshObj:
+    {
+        // The MTL file names the texture
+        const Texture* texture = findTextureForMaterial(job.mesh->materialID, project);
+        hash.add(job.mesh->name).add(meshContentHash(*job.mesh)).add(options.objPrecision);
+        hash.add(texture ? sanitizeFilename(texture->name) : QString()).add(texture ? texture->id : -1);
+        break;
+    }
+
+    case ExportJob::TextureImage:
+    {
+        quint64 content = textureHashes.value(job.texture, 0);
+        if (content == 0)
+        {
+            return 0;
+        }
+        hash.add(content).add(options.textureFormat).add(options.textureScale);
+        break;
+    }
+
+    case ExportJob::ObjectGlb:
+    {
+        // Everything GlbWriter reads: the subtree, its materials and textures
+        bool readable = true;
+        std::function<void(const Object&)> addObject = [&](const Object& object) {
+            hash.add(object.name).add(object.className).add(object.uniqueID);
+            hash.add(object.position).add(object.rotation).add(object.scaling);
+
+            hash.add(object.meshes().size());
+            for (const Mesh& mesh : object.meshes())
+            {
+                hash.add(meshContentHash(mesh));
+
+                const Material* material = project.findMaterialByID(mesh.materialID);
+                if (!material)
+                {
+                    continue;
+                }
+                hash.add(materialJson(*material));
+                for (const RenderPass1Stage& pass : material->renderPasses1Stage) addRenderPass(hash, pass.settings, pass.stages[0]);
+                for (const RenderPass2Stage& pass : material->renderPasses2Stage) addRenderPass(hash, pass.settings, pass.stages[0]);
+                for (const RenderPass3Stage& pass : material->renderPasses3Stage) addRenderPass(hash, pass.settings, pass.stages[0]);
+
+                const Texture* texture = material->textureID != -1 ? project.findTextureByID(material->textureID) : nullptr;
+                if (!texture)
+                {
+                    continue;
+                }
+                if (options.embedGlbTextures)
+                {
+                    quint64 content = textureHashes.value(texture, 0);
+                    readable = readable && content != 0;
+                    hash.add(content).add(options.textureScale);
+                }
+                else
+                {
+                    const Texture& file = canonicalTexture(*texture);
+                    hash.add(sanitizeFilename(file.name)).add(file.id).add(options.textureFormat);
+                }
+            }
+
+            hash.add(object.children.size());
+            for (const Object* child : object.children)
+            {
+                if (child)
+                {
+                    addObject(*child);
+                }
+            }
+        };
+        addObject(*job.object);
+
+        if (!readable)
+        {
+            return 0;
+        }
+        break;
+    }
+    }
+
+    return hash.value();
+}
+
+OpfExporter::ExportManifest OpfExporter::readExportManifest(const QDir& dir)
+{
+    ExportManifest manifest;
+
+    QFile file(dir.filePath(kExportManifestFile));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return manifest;
+    }
+
+    // Written by an older exporter: everything is written again
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != kExportManifestVersion)
+    {
+        return manifest;
+    }
+
+    const QJsonObject files = root.value("files").toObject();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it)
+    {
+        QJsonObject entry = it.value().toObject();
+
+        ManifestEntry record;
+        record.source = entry.value("source").toString().toULongLong(nullptr, 16);
+        record.output = entry.value("output").toString().toULongLong(nullptr, 16);
+        record.type = entry.value("type").toInt(-1);
+        record.record = entry.value("record").toInt();
+        manifest.insert(it.key(), record);
+    }
+    return manifest;
+}
+
+bool OpfExporter::writeExportManifest(const QDir& dir, const ExportManifest& manifest)
+{
+    QJsonObject files;
+    for (auto it = manifest.constBegin(); it != manifest.constEnd(); ++it)
+    {
+        QJsonObject entry;
+        entry["source"] = QString::number(it.value().source, 16);
+        entry["output"] = QString::number(it.value().output, 16);
+        entry["type"] = it.value().type;
+        entry["record"] = it.value().record;
+        files[it.key()] = entry;
+    }
+
+    QJsonObject root;
+    root["version"] = kExportManifestVersion;
+    root["generated"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["files"] = files;
+
+    // Replaced atomically, an interrupted export keeps the old manifest
+    QSaveFile file(dir.filePath(kExportManifestFile));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        m_lastError = QString("Cannot write file: %1").arg(file.fileName());
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+
+    if (!file.commit())
+    {
+        m_lastError = QString("Cannot write file: %1").arg(file.fileName());
+        return false;
+    }
+    return true;
+}
+
+void OpfExporter::skipUnchangedJobs(QVector<ExportJob>& jobs, QVector<quint64>& sourceHashes, const ExportManifest& previous,
+                                    ExportManifest& next, const QDir& dir, const PackedProject& project, const ExportOptions& options)
+{
+    // Paths are worked out here, QDir is not safe to share between threads
+    QVector<QStringList> files(jobs.size());
+    QVector<QStringList> relativeFiles(jobs.size());
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        files[i] = jobOutputFiles(jobs[i], options);
+        for (const QString& filename : std::as_const(files[i]))
+        {
+            relativeFiles[i].append(dir.relativeFilePath(filename));
+        }
+    }
+
+    // A texture is read by its PNG job and by every GLB embedding it, so
+    // each one is hashed once up front and the jobs look it up
+    QSet<const Texture*> textureSet;
+    for (const ExportJob& job : std::as_const(jobs))
+    {
+        if (job.type == ExportJob::TextureImage)
+        {
+            textureSet.insert(job.texture);
+        }
+        else if (job.type == ExportJob::ObjectGlb && options.embedGlbTextures)
+        {
+            addGlbTextures(*job.object, project, textureSet);
+        }
+    }
+
+    QVector<const Texture*> textures(textureSet.constBegin(), textureSet.constEnd());
+    QVector<quint64> textureContent(textures.size(), 0);
+    quint64* textureContentData = textureContent.data();
+    runOnPool(textures.size(), options.threadCount, [&](int i) {
+        textureContentData[i] = textureContentHash(*textures.at(i));
+    });
+
+    QHash<const Texture*, quint64> textureHashes;
+    textureHashes.reserve(textures.size());
+    for (int i = 0; i < textures.size(); i++)
+    {
+        textureHashes.insert(textures[i], textureContent[i]);
+    }
+
+    // Source hashes and the check, which reads the old files, run on the pool
+    sourceHashes.fill(0, jobs.size());
+    QVector<char> unchanged(jobs.size(), 0);
+    quint64* sourceData = sourceHashes.data();
+    char* unchangedData = unchanged.data();
+
+    runOnPool(jobs.size(), options.threadCount, [&](int i) {
+        quint64 source = jobSourceHash(jobs.at(i), project, options, textureHashes);
+        sourceData[i] = source;
+        if (source == 0)
+        {
+            return;
+        }
+
+        // Files edited or deleted since are written again
+        for (int f = 0; f < files.at(i).size(); f++)
+        {
+            ManifestEntry entry = previous.value(relativeFiles.at(i).at(f));
+            quint64 output = 0;
+            if (entry.source != source || !hashFile(files.at(i).at(f), output) || output != entry.output)
+            {
+                return;
+            }
+        }
+        unchangedData[i] = 1;
+    });
+
+    QVector<ExportJob> kept;
+    QVector<quint64> keptHashes;
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        if (unchanged[i])
+        {
+            for (const QString& relative : std::as_const(relativeFiles[i]))
+            {
+                next.insert(relative, previous.value(relative));
+            }
+        }
+        else
+        {
+            kept.append(jobs[i]);
+            keptHashes.append(sourceHashes[i]);
+        }
+    }
 
-    file.close();
-    return true;
+    qDebug() << "Incremental export:" << jobs.size() - kept.size() << "of" << jobs.size() << "jobs are up to date";
+    jobs = kept;
+    sourceHashes = keptHashes;
 }
 
-bool OpfExporter::exportAll(const PackedProject& project, const QString& directory, QProgressDialog* progress)
+bool OpfExporter::finishIncrementalExport(const QVector<ExportJob>& jobs, const QVector<quint64>& sourceHashes, const QVector<bool>& succeeded,
+                                          const ExportManifest& previous, ExportManifest& next, const QDir& dir,
+                                          const PackedProject& project, const ExportOptions& options)
 {
-    m_currentProgress = 0;
+    int unchangedFiles = next.size();
 
-    SettingsManager& settings = SettingsManager::instance();
-
-    QDir dir(directory);
-    if (!dir.exists())
+    // Failed jobs are left out of the manifest, so they run again next time,
+    // but their files are not deleted either
+    QSet<QString> current;
+    QVector<QStringList> files(jobs.size());
+    for (int i = 0; i < jobs.size(); i++)
     {
-        if (!dir.mkpath("."))
+        files[i] = jobOutputFiles(jobs[i], options);
+        for (const QString& filename : std::as_const(files[i]))
         {
-            m_lastError = QString("Cannot create directory: %1").arg(directory);
-            return false;
+            current.insert(dir.relativeFilePath(filename));
         }
     }
 
-    // Export templates.json
-    if (settings.exportJSON())
+    QVector<quint64> outputs;
+    QVector<QString> outputFiles;
+    QVector<int> outputJobs;
+    for (int i = 0; i < jobs.size(); i++)
     {
-        updateProgress(progress, "Exporting templates.json...");
-        QString templatesPath = dir.filePath("templates.json");
+        if (!succeeded.value(i))
+        {
+            continue;
+        }
+        for (const QString& filename : std::as_const(files[i]))
+        {
+            outputFiles.append(filename);
+            outputJobs.append(i);
+        }
+    }
 
-        if (!exportTemplatesToJson(project, templatesPath))
+    outputs.fill(0, outputFiles.size());
+    QVector<char> hashed(outputFiles.size(), 0);
+    quint64* outputData = outputs.data();
+    char* hashedData = hashed.data();
+    runOnPool(outputFiles.size(), options.threadCount, [&](int i) {
+        hashedData[i] = hashFile(outputFiles.at(i), outputData[i]);
+    });
+
+    for (int i = 0; i < outputFiles.size(); i++)
+    {
+        if (hashed[i])
         {
-            return false;
+            const int job = outputJobs[i];
+            ManifestEntry entry;
+            entry.source = sourceHashes.value(job);
+            entry.output = outputs[i];
+            entry.type = jobs[job].type;
+            entry.record = jobs[job].record;
+            next.insert(dir.relativeFilePath(outputFiles[i]), entry);
         }
     }
 
-    // Create subdirectories
-    dir.mkdir("objects");
-    if (settings.exportOBJ()) dir.mkdir("meshes");
-    if (settings.exportPNG()) dir.mkdir("textures");
-    if (settings.exportJSON()) dir.mkdir("materials");
+    int writtenFiles = next.size() - unchangedFiles;
 
-    // Export objects
-    int objectCount = 0;
-    int meshCount = 0;
+    // Files of records that are gone. Only paths the manifest itself lists
+    // are touched, never anything outside the export directory.
+    auto recordExists = [&](const ManifestEntry& entry) {
+        switch (entry.type)
+        {
+        case ExportJob::ObjectJson:
+        case ExportJob::MeshObj:
+        case ExportJob::ObjectGlb:
+            return project.findObjectByID(entry.record) != nullptr;
+        case ExportJob::TextureImage:
+            return project.findTextureByID(entry.record) != nullptr;
+        case ExportJob::MaterialJson:
+            return project.findMaterialByID(entry.record) != nullptr;
+        }
+        return false;
+    };
+    auto typeExported = [&](const ManifestEntry& entry) {
+        switch (entry.type)
+        {
+        case ExportJob::ObjectJson:
+        case ExportJob::MaterialJson:
+            return options.exportJSON;
+        case ExportJob::MeshObj:
+            return options.exportOBJ;
+        case ExportJob::ObjectGlb:
+            return options.exportGLB;
+        case ExportJob::TextureImage:
+            return options.exportPNG;
+        }
+        return true;
+    };
 
-    for (const Object* obj : project.objects)
+    int deleted = 0;
+    for (auto it = previous.constBegin(); it != previous.constEnd(); ++it)
     {
-        if (progress && progress->wasCanceled()) return false;
-        if (!obj) continue;
-
-        updateProgress(progress, QString("Exporting object: %1...").arg(obj->name));
+        const QString& relative = it.key();
+        if (next.contains(relative) || current.contains(relative) ||
+            QDir::isAbsolutePath(relative) || relative.split('/').contains(".."))
+        {
+            continue;
+        }
 
-        QString safeName = sanitizeFilename(obj->name);
+        // Kinds left out of this run, and files of records that are still
+        // there (a renamed record, a mesh now deduplicated), stay tracked
+        if (!typeExported(it.value()) || recordExists(it.value()))
+        {
+            next.insert(relative, it.value());
+            continue;
+        }
 
-        if (settings.exportJSON())
+        if (QFile::remove(dir.filePath(relative)))
         {
-            QString jsonFile = dir.filePath(QString("objects/%1_%2.json").arg(safeName).arg(obj->uniqueID));
-            if (exportObject(*obj, jsonFile))
+            deleted++;
+
+            // Per-object mesh directories that are empty now
+            QString parent = QFileInfo(relative).path();
+            if (parent != ".")
             {
-                objectCount++;
+                dir.rmdir(parent);
             }
         }
+    }
+
+    QJsonObject summary;
+    summary["unchangedFiles"] = unchangedFiles;
+    summary["writtenFiles"] = writtenFiles;
+    summary["deletedFiles"] = deleted;
+    m_incrementalSummary = summary;
+
+    qDebug() << "Incremental export:" << writtenFiles << "files written," << unchangedFiles << "unchanged," << deleted << "deleted";
+    return writeExportManifest(dir, next);
+}
+
+bool OpfExporter::runExportJob(const ExportJob& job, const PackedProject& project)
+{
+    switch (job.type)
+    {
+    case ExportJob::ObjectJson:
+        return exportObject(*job.object, job.filename);
+    case ExportJob::MeshObj:
+        return exportMeshToObj(*job.mesh, job.filename, project);
+    case ExportJob::ObjectGlb:
+        return exportObjectToGlb(*job.object, job.filename, project);
+    case ExportJob::TextureImage:
+        return exportTextureToPng(*job.texture, job.filename);
+    case ExportJob::MaterialJson:
+        return exportMaterialToJson(*job.material, job.filename);
+    }
+    return false;
+}
+
+void OpfExporter::dropOverwrittenJobs(QVector<ExportJob>& jobs)
+{
+    // Names that come up twice (same sanitized name and id) were overwritten
+    // in list order by the serial export; keep only the last job for each
+    QHash<QString, int> lastJob;
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        lastJob.insert(jobs[i].filename, i);
+    }
 
-        // FIXED: Use hasAnyMeshesRecursive to check children too
-        if (settings.exportOBJ() && hasAnyMeshesRecursive(*obj))
+    QVector<ExportJob> kept;
+    kept.reserve(lastJob.size());
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        if (lastJob.value(jobs[i].filename) == i)
         {
-            QString meshDir = dir.filePath(QString("meshes/%1_%2").arg(safeName).arg(obj->uniqueID));
-            if (exportObjectMeshes(*obj, meshDir, project))
+            kept.append(jobs[i]);
+        }
+    }
+    jobs = kept;
+}
+
+bool OpfExporter::runExportJobs(const QVector<ExportJob>& jobs, const PackedProject& project, const ExportOptions& options,
+                                QVector<bool>* succeeded)
+{
+    // Each job reports into its own slot; nothing is shared but counters
+    QVector<QString> errors(jobs.size());
+    QVector<bool> finished(jobs.size(), false);
+    QString* jobErrors = errors.data();
+    bool* jobFinished = finished.data();
+    const ExportJob* jobData = jobs.constData();
+    std::atomic<int> completed(0);
+    std::atomic<bool> canceled(false);
+
+    int threadCount = options.threadCount > 0 ? options.threadCount : QThread::idealThreadCount();
+    int base = m_currentProgress;
+    m_progressMaximum = base + jobs.size() + 1;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, threadCount));
+
+    for (int index = 0; index < jobs.size(); index++)
+    {
+        pool.start(QRunnable::create([&, index]() {
+            if (canceled)
             {
-                // FIXED: Count all meshes including children
-                meshCount += countAllMeshesRecursive(*obj);
+                return;
             }
-        }
+
+            // A private exporter per job: m_lastError is not shared
+            OpfExporter worker;
+            worker.setOptions(options);
+            worker.m_textureAliases = m_textureAliases;
+            if (worker.runExportJob(jobData[index], project))
+            {
+                jobFinished[index] = true;
+            }
+            else
+            {
+                jobErrors[index] = worker.lastError().isEmpty() ? QString("Failed to export %1").arg(jobData[index].filename) : worker.lastError();
+            }
+            completed++;
+        }));
     }
 
-    // Export textures
-    if (settings.exportPNG())
+    // Progress and cancellation are handled here, on the calling thread
+    int reported = -1;
+    while (!pool.waitForDone(50))
     {
-        for (int i = 0; i < project.textures.size(); i++)
+        int done = completed;
+        if (done != reported)
         {
-            if (progress && progress->wasCanceled()) return false;
+            reported = done;
+            emit statusChanged(QString("Exporting files: %1 / %2...").arg(done).arg(jobs.size()));
+        }
+
+        m_currentProgress = base + done;
+        if (!canceled && !reportProgress())
+        {
+            canceled = true;
+            pool.clear();
+        }
+    }
+
+    m_currentProgress = base + completed;
+
+    if (succeeded)
+    {
+        *succeeded = finished;
+    }
 
-            const Texture& tex = project.textures[i];
-            updateProgress(progress, QString("Exporting texture: %1...").arg(tex.name));
+    if (canceled)
+    {
+        m_lastError = "Export canceled";
+        return false;
+    }
 
-            if (!tex.colorData.isEmpty())
+    int failures = 0;
+    QString firstError;
+    for (int index = 0; index < jobs.size(); index++)
+    {
+        if (!errors[index].isEmpty())
+        {
+            qWarning() << errors[index];
+            if (failures++ == 0)
             {
-                QString safeName = sanitizeFilename(tex.name);
-                QString filename = dir.filePath(QString("textures/%1_%2.png").arg(safeName).arg(tex.id));
-                exportTextureToPng(tex, filename);
+                firstError = errors[index];
             }
         }
     }
 
-    // Export materials
-    if (settings.exportJSON())
+    qDebug() << "Exported" << jobs.size() - failures << "of" << jobs.size() << "files on" << threadCount << "threads";
+
+    if (failures > 0)
     {
-        for (const Material& mat : project.materials)
+        m_lastError = failures == 1 ? firstError : QString("%1 of %2 files could not be exported, first: %3").arg(failures).arg(jobs.size()).arg(firstError);
+        return false;
+    }
+    return true;
+}
+
+bool OpfExporter::exportObjectFiles(const Object& object, const QDir& dir, const PackedProject& project, int& objectCount, int& meshCount)
+{
+    ExportOptions options = this->options();
+    QString safeName = sanitizeFilename(object.name);
+    bool success = true;
+
+    if (options.exportJSON)
+    {
+        QString jsonFile = dir.filePath(QString("objects/%1_%2.json").arg(safeName).arg(object.uniqueID));
+        if (exportObject(object, jsonFile))
+        {
+            objectCount++;
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    // FIXED: Check children's meshes too
+    if (options.exportOBJ && object.subtreeStats().meshes > 0)
+    {
+        QString meshDir = dir.filePath(QString("meshes/%1_%2").arg(safeName).arg(object.uniqueID));
+        if (exportObjectMeshes(object, meshDir, project))
+        {
+            // FIXED: Count all meshes including children
+            meshCount += object.subtreeStats().meshes;
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    if (options.exportGLB && object.subtreeStats().meshes > 0)
+    {
+        QString glbFile = dir.filePath(QString("models/%1_%2.glb").arg(safeName).arg(object.uniqueID));
+        if (!exportObjectToGlb(object, glbFile, project))
+        {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+// ============================================================================
+// STREAMING EXPORTS
+// ============================================================================
+
+namespace {
+
+// Forwards OpfParser::parseStreaming callbacks to lambdas
+class CallbackVisitor : public OpfVisitor
+{
+public:
+    std::function<bool(const PackedProject&)> onHeader;
+    std::function<bool(const EventDesc&)> onEventDesc;
+    std::function<bool(const Texture&)> onTexture;
+    std::function<bool(const Material&)> onMaterial;
+    std::function<bool(const Object&)> onObject;
+
+    bool visitHeader(const PackedProject& header) override
+    {
+        return onHeader ? onHeader(header) : true;
+    }
+
+    bool visitEventDesc(const EventDesc& event) override
+    {
+        return onEventDesc ? onEventDesc(event) : true;
+    }
+
+    bool visitTexture(const Texture& texture) override
+    {
+        return onTexture ? onTexture(texture) : true;
+    }
+
+    bool visitMaterial(const Material& material) override
+    {
+        return onMaterial ? onMaterial(material) : true;
+    }
+
+    bool visitObject(Object* object) override
+    {
+        QScopedPointer<Object> owned(object);
+        peakObjects = qMax(peakObjects, 1 + owned->subtreeStats().descendants);
+        return onObject ? onObject(*owned) : true;
+    }
+
+    // Each object is deleted once visited, so this is the largest subtree
+    int peakObjects = 0;
+};
+
+// Header fields of the project skeleton (objects are never copied)
+void copyProjectInfo(PackedProject& skeleton, const PackedProject& header)
+{
+    skeleton.header = header.header;
+    skeleton.version = header.version;
+    skeleton.projectName = header.projectName;
+    skeleton.author = header.author;
+    skeleton.email = header.email;
+    skeleton.description = header.description;
+    skeleton.projectID = header.projectID;
+    skeleton.dependencies = header.dependencies;
+}
+
+// Keeps the metadata of a streamed texture for the project skeleton
+void appendTextureInfo(PackedProject& skeleton, const Texture& texture)
+{
+    skeleton.addTexture(texture);
+    skeleton.textures.last().clearBitmapData();
+    skeleton.textures.last().dataSource.reset();
+}
+
+} // namespace
+
+bool OpfExporter::exportAllStreaming(const QString& opfFilename, const QString& directory)
+{
+    m_currentProgress = 0;
+
+    ExportOptions options = this->options();
+
+    QDir dir(directory);
+    if (!dir.exists())
+    {
+        if (!dir.mkpath("."))
         {
-            if (progress && progress->wasCanceled()) return false;
+            m_lastError = QString("Cannot create directory: %1").arg(directory);
+            return false;
+        }
+    }
+
+    dir.mkdir("objects");
+    if (options.exportOBJ) dir.mkdir("meshes");
+    if (options.exportGLB) dir.mkdir("models");
+    if (options.exportPNG) dir.mkdir("textures");
+    if (options.exportJSON) dir.mkdir("materials");
+
+    // Everything but the objects and texture payloads. Materials and textures
+    // precede the object section, so mesh MTL lookups work as usual.
+    PackedProject skeleton;
+    QJsonArray templates;
+    int objectCount = 0;
+    int meshCount = 0;
 
-            updateProgress(progress, QString("Exporting material: %1...").arg(mat.name));
+    // Like exportAll, a failed file fails the export but not the others
+    int failures = 0;
+    QString firstError;
+    auto fileExported = [&](bool exported) {
+        if (!exported && failures++ == 0)
+        {
+            firstError = m_lastError;
+        }
+    };
 
+    CallbackVisitor visitor;
+    visitor.onHeader = [&](const PackedProject& header) {
+        copyProjectInfo(skeleton, header);
+        return true;
+    };
+    visitor.onEventDesc = [&](const EventDesc& event) {
+        skeleton.eventDescs.append(event);
+        return true;
+    };
+    visitor.onTexture = [&](const Texture& tex) {
+        if (options.exportPNG && tex.hasColorData())
+        {
+            emit statusChanged(QString("Exporting texture: %1...").arg(tex.name));
+            QString safeName = sanitizeFilename(tex.name);
+            fileExported(exportTextureToPng(tex, dir.filePath(QString("textures/%1_%2.png").arg(safeName).arg(tex.id))));
+        }
+        appendTextureInfo(skeleton, tex);
+        return true;
+    };
+    visitor.onMaterial = [&](const Material& mat) {
+        if (options.exportJSON)
+        {
             QString safeName = sanitizeFilename(mat.name);
-            QString filename = dir.filePath(QString("materials/%1_%2.json").arg(safeName).arg(mat.id));
-            exportMaterialToJson(mat, filename);
+            fileExported(exportMaterialToJson(mat, dir.filePath(QString("materials/%1_%2.json").arg(safeName).arg(mat.id))));
         }
+        skeleton.addMaterial(mat);
+        return true;
+    };
+    visitor.onObject = [&](const Object& obj) {
+        emit statusChanged(QString("Exporting object: %1...").arg(obj.name));
+        fileExported(exportObjectFiles(obj, dir, skeleton, objectCount, meshCount));
+        appendTemplateEntries(templates, obj);
+        return true;
+    };
+
+    OpfParser parser;
+    bool parsed = parser.parseStreaming(opfFilename, visitor);
+    m_peakObjectsHeld = visitor.peakObjects;
+    if (!parsed)
+    {
+        m_lastError = parser.lastError();
+        return false;
     }
 
-    // Export Blender script
-    if (settings.exportBlenderScript())
+    if (options.exportJSON)
     {
-        updateProgress(progress, "Creating Blender import script...");
-        QString scriptPath = dir.filePath("import_to_blender.py");
-        exportBlenderImportScript(project, scriptPath);
+        emit statusChanged("Exporting templates.json...");
+        if (!writeTemplatesJson(skeleton, templates, dir.filePath("templates.json")))
+        {
+            return false;
+        }
     }
 
-    qDebug() << "Export complete:" << objectCount << "objects," << meshCount << "meshes (including children)";
+    if (options.exportBlenderScript)
+    {
+        emit statusChanged("Creating Blender import script...");
+        exportBlenderImportScript(skeleton, dir.filePath("import_to_blender.py"));
+    }
+
+    qDebug() << "Streaming export complete:" << objectCount << "objects," << meshCount << "meshes (including children)";
+
+    if (failures > 0)
+    {
+        m_lastError = failures == 1 ? firstError : QString("%1 records could not be exported, first: %2").arg(failures).arg(firstError);
+        return false;
+    }
     return true;
 }
 
-void OpfExporter::updateProgress(QProgressDialog* progress, const QString& status)
+bool OpfExporter::exportAssetListStreaming(const QString& opfFilename, const QString& filename)
 {
-    m_currentProgress++;
+    PackedProject skeleton;
+    AssetListObjects list;
 
-    if (progress)
+    CallbackVisitor visitor;
+    visitor.onHeader = [&](const PackedProject& header) {
+        copyProjectInfo(skeleton, header);
+        return true;
+    };
+    visitor.onTexture = [&](const Texture& tex) {
+        appendTextureInfo(skeleton, tex);
+        return true;
+    };
+    visitor.onMaterial = [&](const Material& mat) {
+        skeleton.addMaterial(mat);
+        return true;
+    };
+    visitor.onObject = [&](const Object& obj) {
+        addToAssetList(list, &obj);
+        return true;
+    };
+
+    // Only texture dimensions are listed, so payloads are never read
+    OpfParser parser;
+    parser.setTextureLoadMode(OpfParser::TextureLoadMode::Lazy);
+    bool parsed = parser.parseStreaming(opfFilename, visitor);
+    m_peakObjectsHeld = visitor.peakObjects;
+    if (!parsed)
     {
-        progress->setValue(m_currentProgress);
+        m_lastError = parser.lastError();
+        return false;
     }
 
+    return writeAssetList(skeleton, list, filename);
+}
+
+bool OpfExporter::updateProgress(const QString& status)
+{
+    m_currentProgress++;
+
     if (!status.isEmpty())
     {
         emit statusChanged(status);
     }
 
-    QApplication::processEvents();
+    return reportProgress();
+}
+
+bool OpfExporter::reportProgress()
+{
+    if (m_progressCallback && !m_progressCallback(m_currentProgress, qMax(m_progressMaximum, m_currentProgress)))
+    {
+        m_lastError = "Export canceled";
+        return false;
+    }
+    return true;
 }
 
 
 bool OpfExporter::exportAssetListToTxt(const PackedProject& project, const QString& filename)
+{
+    AssetListObjects list;
+    for (const Object* obj : project.objects)
+    {
+        addToAssetList(list, obj);
+    }
+
+    return writeAssetList(project, list, filename);
+}
+
+void OpfExporter::addToAssetList(AssetListObjects& list, const Object* obj)
+{
+    if (!obj) return;
+
+    list.objectCount++;
+    list.totalMeshes += obj->subtreeStats().meshes;
+    list.totalChildren += obj->subtreeStats().descendants;
+
+    AssetListObjects::Category& category = list.categories[obj->getCategory()];
+    category.count++;
+
+    QTextStream out(&category.listing);
+    writeObjectToList(out, obj, 0);
+}
+
+bool OpfExporter::writeAssetList(const PackedProject& project, const AssetListObjects& list, const QString& filename)
 {
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
@@ -1101,49 +2237,25 @@ bool OpfExporter::exportAssetListToTxt(const PackedProject& project, const QStri
 
     // Summary
     out << "=== SUMMARY ===\n";
-    out << QString("Objects: %1\n").arg(project.objects.size());
+    out << QString("Objects: %1\n").arg(list.objectCount);
     out << QString("Textures: %1\n").arg(project.textures.size());
     out << QString("Materials: %1\n").arg(project.materials.size());
     out << QString("Dependencies: %1\n").arg(project.dependencies.size());
     out << "\n";
 
-    // Count total meshes
-    int totalMeshes = 0;
-    int totalChildren = 0;
-    for (const Object* obj : project.objects)
-    {
-        if (obj)
-        {
-            totalMeshes += countAllMeshesRecursive(*obj);
-            totalChildren += countChildrenRecursive(obj);
-        }
-    }
-    out << QString("Total Meshes (including children): %1\n").arg(totalMeshes);
-    out << QString("Total Child Objects: %1\n").arg(totalChildren);
+    out << QString("Total Meshes (including children): %1\n").arg(list.totalMeshes);
+    out << QString("Total Child Objects: %1\n").arg(list.totalChildren);
     out << "\n";
 
     // Objects - grouped by category
     out << "================================================================================\n";
-    out << QString("OBJECTS (%1)\n").arg(project.objects.size());
+    out << QString("OBJECTS (%1)\n").arg(list.objectCount);
     out << "================================================================================\n\n";
 
-    QMap<QString, QVector<const Object*>> categorized;
-    for (const Object* obj : project.objects)
-    {
-        if (obj)
-        {
-            categorized[obj->getCategory()].append(obj);
-        }
-    }
-
-    for (auto it = categorized.begin(); it != categorized.end(); ++it)
+    for (auto it = list.categories.begin(); it != list.categories.end(); ++it)
     {
-        out << QString("--- %1 (%2) ---\n").arg(it.key()).arg(it.value().size());
-
-        for (const Object* obj : it.value())
-        {
-            writeObjectToList(out, obj, 0);
-        }
+        out << QString("--- %1 (%2) ---\n").arg(it.key()).arg(it.value().count);
+        out << it.value().listing;
         out << "\n";
     }
 
@@ -1220,7 +2332,7 @@ void OpfExporter::writeObjectToList(QTextStream& out, const Object* obj, int dep
     QString prefix = (depth == 0) ? "" : "[child] ";
 
     int meshCount = obj->meshes().size();
-    int totalMeshCount = countAllMeshesRecursive(*obj);
+    int totalMeshCount = obj->subtreeStats().meshes;
 
     out << indent << prefix << obj->name;
     out << QString(" (ID: %1/%2)").arg(obj->uniqueID).arg(obj->projectID);
@@ -1255,19 +2367,6 @@ void OpfExporter::writeObjectToList(QTextStream& out, const Object* obj, int dep
     }
 }
 
-int OpfExporter::countChildrenRecursive(const Object* obj)
-{
-    if (!obj) return 0;
-
-    int count = obj->children.size();
-    for (const Object* child : obj->children)
-    {
-        count += countChildrenRecursive(child);
-    }
-    return count;
-}
-
-
 } // namespace Opf
 
 
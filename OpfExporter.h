@@ -2,14 +2,53 @@
 #define OPFEXPORTER_H
 
 #include "OpfStructs.h"
+#include "SettingsManager.h"
 #include <QString>
 #include <QObject>
 #include <QDir>
-
-class QProgressDialog;
+#include <QJsonArray>
+#include <QMap>
+#include <QHash>
+#include <QJsonObject>
+#include <functional>
 
 namespace Opf {
 
+// What to export and how. Taken from SettingsManager unless set explicitly
+// with OpfExporter::setOptions(); export jobs only ever see a copy.
+struct ExportOptions
+{
+    bool exportOBJ = true;
+    bool exportPNG = true;
+    bool exportJSON = true;
+    bool exportBlenderScript = true;
+
+    // One binary glTF file per top-level object, textures embedded or
+    // referenced from the textures directory
+    bool exportGLB = false;
+    bool embedGlbTextures = true;
+
+    // exportAll writes meshes and textures with identical content only once
+    // and lists the duplicates in dedup_manifest.json
+    bool deduplicate = false;
+
+    // exportAll only writes files whose source records or settings changed
+    // since the run recorded in export_manifest.json, and deletes files of
+    // records that are gone
+    bool incremental = false;
+
+    SettingsManager::TextureFormat textureFormat = SettingsManager::PNG;
+    SettingsManager::TextureScale textureScale = SettingsManager::Scale100;
+
+    // Worker threads for exportAll, 0 = QThread::idealThreadCount()
+    int threadCount = 0;
+
+    // Decimals of OBJ coordinates, or ObjWriter::kShortestPrecision
+    int objPrecision = 6;
+
+    static ExportOptions fromSettings();
+};
+
 class OpfExporter : public QObject
 {
     Q_OBJECT
@@ -17,6 +56,10 @@ class OpfExporter : public QObject
 public:
     explicit OpfExporter(QObject* parent = nullptr);
 
+    void setOptions(const ExportOptions& options);
+    void resetOptions();    // back to the current SettingsManager values
+    ExportOptions options() const;
+
     // Export templates to JSON for Map Editor
     bool exportTemplatesToJson(const PackedProject& project, const QString& filename);
 
@@ -29,6 +72,9 @@ public:
     // Export mesh to OBJ format
     bool exportMeshToObj(const Mesh& mesh, const QString& filename, const PackedProject& project);
 
+    // Export an object with its children to a GLB file
+    bool exportObjectToGlb(const Object& object, const QString& filename, const PackedProject& project);
+
     // Export all meshes of an object to OBJ files
     bool exportObjectMeshes(const Object& object, const QString& directory, const PackedProject& project);
 
@@ -50,14 +96,36 @@ public:
     // Export Blender import script
     bool exportBlenderImportScript(const PackedProject& project, const QString& filename);
 
-    // Export all assets with progress tracking
-    bool exportAll(const PackedProject& project, const QString& directory, QProgressDialog* progress = nullptr);
+    // Export all assets with progress tracking. Object, mesh, texture and
+    // material files are written by independent jobs on a thread pool.
+    // Fails if any file could not be written; the others are kept.
+    bool exportAll(const PackedProject& project, const QString& directory);
+
+    // Called by exportAll on the calling thread, at least every 50 ms while
+    // files are written: 'value' steps of 'maximum' are done (the maximum
+    // grows once the jobs are known). Returning false cancels the export.
+    using ProgressCallback = std::function<bool(int value, int maximum)>;
+    void setProgressCallback(const ProgressCallback& callback) { m_progressCallback = callback; }
 
     QString lastError() const { return m_lastError; }
 
+    // Counts and dedup ratio of the last exportAll with deduplication
+    QJsonObject dedupSummary() const { return m_dedupSummary; }
+
+    // Written, unchanged and deleted file counts of the last incremental exportAll
+    QJsonObject incrementalSummary() const { return m_incrementalSummary; }
+
     // Export asset list to text file for verification
     bool exportAssetListToTxt(const PackedProject& project, const QString& filename);
 
+    // Same as exportAll / exportAssetListToTxt, but reads the .opf with
+    // OpfParser::parseStreaming so only one object is held in memory at a time
+    bool exportAllStreaming(const QString& opfFilename, const QString& directory);
+    bool exportAssetListStreaming(const QString& opfFilename, const QString& filename);
+
+    // Most objects, children included, held at once by the last streaming export
+    int peakObjectsHeld() const { return m_peakObjectsHeld; }
+
 signals:
     void progressUpdated(int value);
     void statusChanged(const QString& status);
@@ -65,22 +133,133 @@ signals:
 private:
     QString m_lastError;
     int m_currentProgress;
+    int m_progressMaximum;
+    ProgressCallback m_progressCallback;
+    ExportOptions m_options;
+    bool m_hasOptions;
+
+    // Deduplicated textures: id of a skipped texture -> the exported one
+    QHash<int32, const Texture*> m_textureAliases;
+    QJsonObject m_dedupSummary;
+    QJsonObject m_incrementalSummary;
+    int m_peakObjectsHeld;
+
+    const Texture& canonicalTexture(const Texture& texture) const;
+
+    // File contents of exportObject / exportMaterialToJson
+    static QByteArray objectJson(const Object& object);
+    static QByteArray materialJson(const Material& material);
 
     // Cross-platform filename sanitization
     QString sanitizeFilename(const QString& filename);
 
-    // Helper function
-    void updateProgress(QProgressDialog* progress, const QString& status = QString());
+    // Progress callback helpers; false means the export was canceled
+    bool updateProgress(const QString& status = QString());
+    bool reportProgress();
+
+    // Mesh of an object subtree and the OBJ file it is exported to
+    struct MeshFile
+    {
+        const Mesh* mesh;
+        QString filename;
+    };
+
+    void collectObjectMeshes(const Object& object, const QDir& dir, QVector<MeshFile>& meshes);
 
     // NEW: Recursive helper for deeply nested children
-    void exportObjectMeshesRecursiveHelper(const Object& object, const QDir& dir, const PackedProject& project, const QString& parentPrefix);
+    void collectNestedMeshes(const Object& object, const QDir& dir, const QString& parentPrefix, QVector<MeshFile>& meshes);
 
     // Helper for writing object hierarchy to text
     void writeObjectToList(QTextStream& out, const Object* obj, int depth);
 
-    // Helper for counting children recursively
-    int countChildrenRecursive(const Object* obj);
+    // Template entries of one top-level object (and its children)
+    void appendTemplateEntries(QJsonArray& templates, const Object& object);
+    bool writeTemplatesJson(const PackedProject& project, const QJsonArray& templates, const QString& filename);
+
+    // Object section of the asset list, built one object at a time
+    struct AssetListObjects
+    {
+        struct Category
+        {
+            int count = 0;
+            QString listing;
+        };
+
+        int objectCount = 0;
+        int totalMeshes = 0;
+        int totalChildren = 0;
+        QMap<QString, Category> categories;
+    };
+
+    void addToAssetList(AssetListObjects& list, const Object* obj);
+    bool writeAssetList(const PackedProject& project, const AssetListObjects& list, const QString& filename);
+
+    // One file written by exportAll. Jobs only read the project and never
+    // share an output file, so they can run in any order.
+    struct ExportJob
+    {
+        enum Type
+        {
+            ObjectJson,
+            MeshObj,
+            ObjectGlb,
+            TextureImage,
+            MaterialJson
+        };
+
+        Type type;
+        const Object* object = nullptr;
+        const Mesh* mesh = nullptr;
+        const Texture* texture = nullptr;
+        const Material* material = nullptr;
+        int32 record = 0;       // id of the object, texture or material the file belongs to
+        QString filename;
+    };
+
+    bool runExportJob(const ExportJob& job, const PackedProject& project);
+
+    // Files a job writes; the first one is ExportJob::filename as saved
+    static QStringList jobOutputFiles(const ExportJob& job, const ExportOptions& options);
+
+    // Keeps only the last job writing each file
+    static void dropOverwrittenJobs(QVector<ExportJob>& jobs);
+
+    // Drops mesh and texture jobs whose content was seen before and returns
+    // the manifest of what they were replaced with
+    QJsonObject deduplicateJobs(QVector<ExportJob>& jobs, const QDir& dir, const ExportOptions& options);
+    // Fails if a job failed or the export was canceled. 'succeeded', if
+    // given, is set per job either way.
+    bool runExportJobs(const QVector<ExportJob>& jobs, const PackedProject& project, const ExportOptions& options,
+                       QVector<bool>* succeeded = nullptr);
+
+    // Incremental export, see ExportOptions::incremental
+    struct ManifestEntry
+    {
+        quint64 source = 0;     // record and settings the file was made from
+        quint64 output = 0;     // file contents
+        int type = -1;          // ExportJob::Type that wrote the file
+        int32 record = 0;       // ExportJob::record
+    };
+    using ExportManifest = QHash<QString, ManifestEntry>;   // by path relative to the export directory
+
+    // 'textureHashes' holds textureContentHash() of every texture the job reads
+    quint64 jobSourceHash(const ExportJob& job, const PackedProject& project, const ExportOptions& options,
+                          const QHash<const Texture*, quint64>& textureHashes);
+    static ExportManifest readExportManifest(const QDir& dir);
+    bool writeExportManifest(const QDir& dir, const ExportManifest& manifest);
+
+    // Drops jobs whose files are up to date; their entries are copied to 'next'
+    void skipUnchangedJobs(QVector<ExportJob>& jobs, QVector<quint64>& sourceHashes, const ExportManifest& previous,
+                           ExportManifest& next, const QDir& dir, const PackedProject& project, const ExportOptions& options);
+
+    // Records the files the jobs wrote, deletes files of the previous run
+    // whose record is gone from 'project' and saves the new manifest
+    bool finishIncrementalExport(const QVector<ExportJob>& jobs, const QVector<quint64>& sourceHashes, const QVector<bool>& succeeded,
+                                 const ExportManifest& previous, ExportManifest& next, const QDir& dir,
+                                 const PackedProject& project, const ExportOptions& options);
 
+    // Per-object part of exportAllStreaming
+    bool exportObjectFiles(const Object& object, const QDir& dir, const PackedProject& project, int& objectCount, int& meshCount);
 
 };
 
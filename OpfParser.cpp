@@ -1,13 +1,73 @@
 #include "OpfParser.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
 #include <QDebug>
+#include <atomic>
 
 namespace Opf {
 
-OpfParser::OpfParser() : m_stream(nullptr)
+// ============================================================================
+// ON-DISK SIZES OF FIXED-LAYOUT BLOCKS
+// ============================================================================
+
+namespace {
+const int kTextureFixedSize = 53;          // size .. exportAlphaJPEGQuality
+const int kBitmapFixedSize = 21;           // bitsPerPixel .. bitmapInfoHeaderSize
+const int kMaterialFixedSize = 14;         // projectID .. excludeFromExport
+const int kRenderPassSettingsSize = 225;   // incl. stipple pattern and Material7
+const int kRenderPassStageSize = 33;
+const int kObjectIdentitySize = 9;         // isUnknown .. excludeFromExport
+const int kObjectTransformSize = 43;       // position .. isBillboard
+const int kObjectTemplateSize = 76;        // 6 x Vector3D + face buffer count
+const int kMeshMaterialSize = 10;          // vertexFormat .. materialID
+const int kMeshHeaderSize = 76;            // textureWrapType .. numTextureMorphs
+const int kMeshBlendSize = 71;             // srcVertex .. numFaces
+const int kLightSize = 105;
+const int kVertexSize = 24;                // position + normal
+
+// Offsets of the counts the boundary scan needs inside the mesh blocks
+const int kMeshHeaderMorphSizeOffset = 60;
+const int kMeshBlendBufferTypeOffset = 63;
+
+// Below this many top-level objects the thread pool is not worth it
+const uint32 kMinParallelObjects = 64;
+
+// Minimum distance between two progress callbacks
+const qint64 kProgressStep = 256 * 1024;
+}
+
+OpfParser::OpfParser() : m_backend(Backend::MemoryMapped), m_textureLoadMode(TextureLoadMode::Eager), m_maxThreadCount(0), m_objectStorage(ObjectStorage::Heap), m_visitor(nullptr), m_arena(nullptr), m_stream(nullptr), m_cursor(nullptr), m_truncated(false),
+    m_section(Section::Header), m_fileSize(0), m_lastReported(0), m_canceled(false)
 {
 }
 
 bool OpfParser::parse(const QString& filename, PackedProject& project)
+{
+    m_visitor = nullptr;
+    return parseFile(filename, project);
+}
+
+bool OpfParser::parseStreaming(const QString& filename, OpfVisitor& visitor)
+{
+    // Header and dependencies are collected here; every other record goes
+    // straight to the visitor
+    PackedProject header;
+
+    m_visitor = &visitor;
+    bool success = parseFile(filename, header);
+    m_visitor = nullptr;
+
+    if (success)
+    {
+        visitor.visitEnd();
+    }
+    return success;
+}
+
+bool OpfParser::parseFile(const QString& filename, PackedProject& project)
 {
     QFile file(filename);
     if (!file.open(QIODevice::ReadOnly))
@@ -31,83 +91,214 @@ bool OpfParser::parse(const QString& filename, PackedProject& project)
         return false;
     }
 
-    QDataStream stream(&file);
-    stream.setByteOrder(QDataStream::LittleEndian);
-    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
-    m_stream = &stream;
+    m_truncated = false;
+    m_canceled = false;
+    m_fileSize = fileSize;
+    m_lastReported = 0;
 
-    try {
-        // 1. Parse header
-        if (!parseHeader(project))
+    if (m_textureLoadMode == TextureLoadMode::Lazy)
+    {
+        m_textureSource = QSharedPointer<TextureDataSource>::create(QFileInfo(filename).absoluteFilePath());
+    }
+
+    if (!m_visitor && m_objectStorage == ObjectStorage::Arena)
+    {
+        if (!project.objectArena)
         {
-            file.close();
-            return false;
+            project.objectArena.reset(new ObjectArena());
         }
+        m_arena = project.objectArena.data();
+    }
 
-        qDebug() << "Project:" << project.projectName;
-        qDebug() << "Version:" << project.version;
-        qDebug() << "Author:" << project.author;
+    // Streamed objects share the header's name table
+    m_names = project.names;
 
-        // 2. Parse dependencies
-        if (!parseDependencies(project))
+    // Streaming gives every object its own pool (see parseObjects)
+    if (!m_visitor)
+    {
+        if (!project.geometry)
         {
-            file.close();
-            return false;
+            project.geometry = QSharedPointer<GeometryPool>::create();
         }
+        m_geometry = project.geometry;
+    }
 
-        // 3. Parse event descriptors
-        if (!parseEventDescs(project))
+    uchar* mapped = nullptr;
+    if (m_backend == Backend::MemoryMapped)
+    {
+        mapped = file.map(0, fileSize);
+        if (!mapped)
         {
-            file.close();
-            return false;
+            qWarning() << "Cannot memory-map" << filename << "- falling back to stream backend:" << file.errorString();
         }
+    }
+
+    ByteCursor cursor;
+    QDataStream stream;
+
+    if (mapped)
+    {
+        cursor = ByteCursor(mapped, fileSize);
+        m_cursor = &cursor;
+    }
+
+    else
+    {
+        stream.setDevice(&file);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        m_stream = &stream;
+    }
+
+    bool success = false;
+
+    try {
+        success = parseSections(project);
+    }
+
+    catch (const std::exception& e)
+    {
+        m_lastError = QString("Exception during parsing: %1").arg(e.what());
+    }
+    catch (...)
+    {
+        m_lastError = "Unknown exception during parsing";
+    }
+
+    m_cursor = nullptr;
+    m_stream = nullptr;
+    m_scratch.clear();
+    m_textureSource.reset();
+    m_arena = nullptr;
+    m_geometry.reset();
+    m_names.reset();
+
+    if (mapped)
+    {
+        file.unmap(mapped);
+    }
+    file.close();
 
-        // 4. Parse textures
-        if (!parseTextures(project))
+    if (success)
+    {
+        if (m_truncated)
         {
-            file.close();
-            return false;
+            qWarning() << "Unexpected end of file in" << filename << "- missing fields were left at their defaults";
         }
 
-        // 5. Parse materials
-        if (!parseMaterials(project))
+        if (m_visitor)
         {
-            file.close();
-            return false;
+            qDebug() << "Successfully streamed OPF file:" << filename;
+            return true;
         }
 
-        // 6. Parse objects
-        if (!parseObjects(project))
+        project.geometry->squeeze();
+        project.rebuildIndex();
+        project.updateSubtreeStats();
+
+        // Records of a truncated file cannot be copied back verbatim
+        if (!m_truncated)
         {
-            file.close();
-            return false;
+            QFileInfo info(filename);
+            project.sourceFile = info.absoluteFilePath();
+            project.sourceSize = fileSize;
+            project.sourceModified = info.lastModified().toMSecsSinceEpoch();
         }
 
-        file.close();
-
-        qDebug() << "Successfully parsed OPF file:" << filename;
+        qDebug() << "Successfully parsed OPF file:" << filename << (mapped ? "(memory-mapped)" : "(stream)");
         qDebug() << "  Dependencies:" << project.dependencies.size();
         qDebug() << "  Events:" << project.eventDescs.size();
         qDebug() << "  Textures:" << project.textures.size();
         qDebug() << "  Materials:" << project.materials.size();
         qDebug() << "  Objects:" << project.objects.size();
+    }
 
-        return true;
+    return success;
+}
 
+bool OpfParser::parseSections(PackedProject& project)
+{
+    // 1. Parse header
+    if (!enterSection(Section::Header) || !parseHeader(project))
+    {
+        return false;
     }
 
-    catch (const std::exception& e)
+    qDebug() << "Project:" << project.projectName;
+    qDebug() << "Version:" << project.version;
+    qDebug() << "Author:" << project.author;
+
+    // 2. Parse dependencies
+    if (!enterSection(Section::Dependencies) || !parseDependencies(project))
     {
-        m_lastError = QString("Exception during parsing: %1").arg(e.what());
-        file.close();
         return false;
     }
-    catch (...)
+
+    if (m_visitor && !m_visitor->visitHeader(project))
     {
-        m_lastError = "Unknown exception during parsing";
-        file.close();
+        return stoppedByVisitor();
+    }
+
+    // 3. Parse event descriptors
+    if (!enterSection(Section::Events) || !parseEventDescs(project))
+    {
+        return false;
+    }
+
+    // 4. Parse textures
+    if (!enterSection(Section::Textures) || !parseTextures(project))
+    {
+        return false;
+    }
+
+    // 5. Parse materials
+    if (!enterSection(Section::Materials) || !parseMaterials(project))
+    {
+        return false;
+    }
+
+    // 6. Parse objects
+    if (!enterSection(Section::Objects) || !parseObjects(project))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool OpfParser::stoppedByVisitor()
+{
+    m_lastError = "Parsing stopped by visitor";
+    return false;
+}
+
+bool OpfParser::enterSection(Section section)
+{
+    m_section = section;
+    m_lastReported = -kProgressStep;
+    return reportProgress();
+}
+
+bool OpfParser::reportProgress()
+{
+    return reportProgress(position());
+}
+
+bool OpfParser::reportProgress(qint64 position)
+{
+    if (!m_progressCallback || position - m_lastReported < kProgressStep)
+    {
+        return true;
+    }
+
+    m_lastReported = position;
+    if (!m_progressCallback(m_section, position, m_fileSize))
+    {
+        m_canceled = true;
+        m_lastError = "Loading canceled";
         return false;
     }
+    return true;
 }
 
 // ============================================================================
@@ -189,6 +380,15 @@ bool OpfParser::parseEventDescs(PackedProject& project)
         EventDesc event;
         event.trigger = read<int32>();
         event.name = readOutforceString();
+
+        if (m_visitor)
+        {
+            if (!m_visitor->visitEventDesc(event))
+            {
+                return stoppedByVisitor();
+            }
+            continue;
+        }
         project.eventDescs.append(event);
     }
 
@@ -210,17 +410,38 @@ bool OpfParser::parseTextures(PackedProject& project)
     }
 
     qDebug() << "Parsing" << count << "textures...";
-    project.textures.reserve(count);
+    if (!m_visitor)
+    {
+        project.textures.reserve(count);
+    }
 
     for (uint32 i = 0; i < count; i++)
     {
         Texture texture;
+        qint64 begin = position();
         if (!parseTexture(texture))
         {
             qWarning() << "Failed to parse texture" << (i + 1) << "/" << count;
             continue;
         }
-        project.textures.append(texture);
+        texture.source = SourceRange{ begin, position() - begin };
+
+        if (m_visitor)
+        {
+            if (!m_visitor->visitTexture(texture))
+            {
+                return stoppedByVisitor();
+            }
+        }
+        else
+        {
+            project.textures.append(texture);
+        }
+
+        if (!reportProgress())
+        {
+            return false;
+        }
     }
 
     return true;
@@ -233,45 +454,48 @@ bool OpfParser::parseTexture(Texture& texture)
     texture.colorFile = readOutforceString();
     texture.alphaFile = readOutforceString();
 
+    BlockReader block(readBlock(kTextureFixedSize));
+
     // Size
-    texture.size = readVector2D_uint32();
+    texture.size.x = block.read<uint32>();
+    texture.size.y = block.read<uint32>();
     texture.width = texture.size.x;
     texture.height = texture.size.y;
 
     // IDs
-    texture.id = read<int32>();
+    texture.id = block.read<int32>();
 
     // Bit depths
-    texture.colorBitDepthInFile = read<int32>();
-    texture.colorBitDepthInMemory = read<int32>();
-    texture.alphaBitDepthInFile = read<int32>();
-    texture.alphaBitDepthInMemory = read<int32>();
+    texture.colorBitDepthInFile = block.read<int32>();
+    texture.colorBitDepthInMemory = block.read<int32>();
+    texture.alphaBitDepthInFile = block.read<int32>();
+    texture.alphaBitDepthInMemory = block.read<int32>();
 
     // Flags
-    texture.colorDither = read<uint8>();
-    texture.alphaDither = read<uint8>();
-    texture.inverseAlpha = read<uint8>();
-    texture.betterQuality = read<uint8>();
-    texture.hasColorChannel = read<uint8>();
-    texture.hasAlphaChannel = read<uint8>();
-    texture.grayScale = read<uint8>();
-    texture.multiTexture = read<uint8>();
-    texture.maxCap = read<int32>();
+    texture.colorDither = block.read<uint8>();
+    texture.alphaDither = block.read<uint8>();
+    texture.inverseAlpha = block.read<uint8>();
+    texture.betterQuality = block.read<uint8>();
+    texture.hasColorChannel = block.read<uint8>();
+    texture.hasAlphaChannel = block.read<uint8>();
+    texture.grayScale = block.read<uint8>();
+    texture.multiTexture = block.read<uint8>();
+    texture.maxCap = block.read<int32>();
 
     // Project ID and version
-    texture.projectID = read<uint16>();
-    texture.version = read<uint32>();
+    texture.projectID = block.read<uint16>();
+    texture.version = block.read<uint32>();
 
     // More flags
-    texture.mipMap = read<uint8>();
-    texture.override = static_cast<EOverride>(read<uint8>());
-    texture.excludeFromExport = read<uint8>();
+    texture.mipMap = block.read<uint8>();
+    texture.override = static_cast<EOverride>(block.read<uint8>());
+    texture.excludeFromExport = block.read<uint8>();
 
     // Export quality settings
-    texture.exportColorQuality = static_cast<EBitmapType>(read<uint8>());
-    texture.exportAlphaQuality = static_cast<EBitmapType>(read<uint8>());
-    texture.exportColorJPEGQuality = read<uint8>();
-    texture.exportAlphaJPEGQuality = read<uint8>();
+    texture.exportColorQuality = static_cast<EBitmapType>(block.read<uint8>());
+    texture.exportAlphaQuality = static_cast<EBitmapType>(block.read<uint8>());
+    texture.exportColorJPEGQuality = block.read<uint8>();
+    texture.exportAlphaJPEGQuality = block.read<uint8>();
 
     // Color bitmap
     if (texture.hasColorChannel)
@@ -299,27 +523,34 @@ bool OpfParser::parseTexture(Texture& texture)
         texture.alphaData = texture.alphaBitmap.bitmapData;
     }
 
+    // Lazy mode: payloads stay in the file until first access
+    if (m_textureSource && texture.colorBitmap.bitmapData.isEmpty() && texture.alphaBitmap.bitmapData.isEmpty())
+    {
+        texture.dataSource = m_textureSource;
+    }
+
     return true;
 }
 
 bool OpfParser::parseBitmap(Bitmap& bitmap)
 {
-    bitmap.bitsPerPixel = read<int32>();
-    bitmap.width = read<int32>();
-    bitmap.height = read<int32>();
-    bitmap.lineSize = read<int32>();
-    bitmap.bitmapType = static_cast<EBitmapType>(read<uint8>());
-    bitmap.bitmapInfoHeaderSize = read<uint32>();
+    BlockReader block(readBlock(kBitmapFixedSize));
+    bitmap.bitsPerPixel = block.read<int32>();
+    bitmap.width = block.read<int32>();
+    bitmap.height = block.read<int32>();
+    bitmap.lineSize = block.read<int32>();
+    bitmap.bitmapType = static_cast<EBitmapType>(block.read<uint8>());
+    bitmap.bitmapInfoHeaderSize = block.read<uint32>();
 
     // Parse bitmap info header
-    qint64 startPos = m_stream->device()->pos();
+    qint64 startPos = position();
     if (!parseBitmapInfoHeader(bitmap.bitmapInfoHeader, bitmap.bitmapInfoHeaderSize))
     {
         return false;
     }
 
     // Read any extra header data
-    qint64 currentPos = m_stream->device()->pos();
+    qint64 currentPos = position();
     qint64 expectedEndPos = startPos + bitmap.bitmapInfoHeaderSize;
     if (currentPos < expectedEndPos)
     {
@@ -344,27 +575,39 @@ bool OpfParser::parseBitmap(Bitmap& bitmap)
         dataSize = read<uint32>();
     }
 
-    bitmap.bitmapData = readBytes(dataSize);
+    bitmap.dataOffset = position();
+    bitmap.dataSize = dataSize;
+
+    if (m_textureSource && qint64(dataSize) <= remaining())
+    {
+        // Lazy mode: only remember where the payload is
+        skip(dataSize);
+    }
+
+    else
+    {
+        bitmap.bitmapData = readBytes(dataSize);
+    }
 
     return true;
 }
 
 bool OpfParser::parseBitmapInfoHeader(BitmapInfoHeader& header, uint32 headerSize)
 {
-    qint64 startPos = m_stream->device()->pos();
+    qint64 startPos = position();
     qint64 endPos = startPos + headerSize;
 
-    if (m_stream->device()->pos() < endPos) header.size = read<uint32>();
-    if (m_stream->device()->pos() < endPos) header.width = read<int32>();
-    if (m_stream->device()->pos() < endPos) header.height = read<int32>();
-    if (m_stream->device()->pos() < endPos) header.planes = read<uint16>();
-    if (m_stream->device()->pos() < endPos) header.bitCount = read<uint16>();
-    if (m_stream->device()->pos() < endPos) header.compression = read<uint32>();
-    if (m_stream->device()->pos() < endPos) header.sizeImage = read<uint32>();
-    if (m_stream->device()->pos() < endPos) header.xPelsPerMeter = read<int32>();
-    if (m_stream->device()->pos() < endPos) header.yPelsPerMeter = read<int32>();
-    if (m_stream->device()->pos() < endPos) header.clrUsed = read<uint32>();
-    if (m_stream->device()->pos() < endPos) header.clrImportant = read<uint32>();
+    if (position() < endPos) header.size = read<uint32>();
+    if (position() < endPos) header.width = read<int32>();
+    if (position() < endPos) header.height = read<int32>();
+    if (position() < endPos) header.planes = read<uint16>();
+    if (position() < endPos) header.bitCount = read<uint16>();
+    if (position() < endPos) header.compression = read<uint32>();
+    if (position() < endPos) header.sizeImage = read<uint32>();
+    if (position() < endPos) header.xPelsPerMeter = read<int32>();
+    if (position() < endPos) header.yPelsPerMeter = read<int32>();
+    if (position() < endPos) header.clrUsed = read<uint32>();
+    if (position() < endPos) header.clrImportant = read<uint32>();
 
     return true;
 }
@@ -383,17 +626,38 @@ bool OpfParser::parseMaterials(PackedProject& project)
     }
 
     qDebug() << "Parsing" << count << "materials...";
-    project.materials.reserve(count);
+    if (!m_visitor)
+    {
+        project.materials.reserve(count);
+    }
 
     for (uint32 i = 0; i < count; i++)
     {
         Material material;
+        qint64 begin = position();
         if (!parseMaterial(material))
         {
             qWarning() << "Failed to parse material" << (i + 1) << "/" << count;
             continue;
         }
-        project.materials.append(material);
+        material.source = SourceRange{ begin, position() - begin };
+
+        if (m_visitor)
+        {
+            if (!m_visitor->visitMaterial(material))
+            {
+                return stoppedByVisitor();
+            }
+        }
+        else
+        {
+            project.materials.append(material);
+        }
+
+        if (!reportProgress())
+        {
+            return false;
+        }
     }
 
     return true;
@@ -402,13 +666,15 @@ bool OpfParser::parseMaterials(PackedProject& project)
 bool OpfParser::parseMaterial(Material& material)
 {
     material.name = readOutforceString();
-    material.projectID = read<uint16>();
-    material.id = read<int32>();
-    material.version = read<uint32>();
-    material.doubleSided = read<uint8>();
-    material.enabledLighting = read<uint8>();
-    material.override = static_cast<EOverride>(read<uint8>());
-    material.excludeFromExport = read<uint8>();
+
+    BlockReader block(readBlock(kMaterialFixedSize));
+    material.projectID = block.read<uint16>();
+    material.id = block.read<int32>();
+    material.version = block.read<uint32>();
+    material.doubleSided = block.read<uint8>();
+    material.enabledLighting = block.read<uint8>();
+    material.override = static_cast<EOverride>(block.read<uint8>());
+    material.excludeFromExport = block.read<uint8>();
 
     material.textureID = -1;  // Default
 
@@ -472,88 +738,79 @@ bool OpfParser::parseMaterial(Material& material)
 
 bool OpfParser::parseRenderPassSettings(RenderPassSettings& settings)
 {
-    settings.antialias = read<uint8>();
-    settings.perspectiveCorrection = read<uint8>();
-    settings.fillMode = static_cast<EFillMode>(read<uint8>());
-    settings.shadeMode = static_cast<EShadeMode>(read<uint8>());
-    settings.linePattern_RepeatFactor = read<uint16>();
-    settings.linePattern_LinePattern = read<uint16>();
-    settings.pixelOperation = static_cast<EPixelOperation>(read<uint8>());
-    settings.writeToZBuffer = read<uint8>();
-    settings.testForAlphaBlending = read<uint8>();
-    settings.alphaReference = read<uint8>();
-    settings.alphaFunction = static_cast<ECmpFunction>(read<uint8>());
-    settings.drawLastPixel = read<uint8>();
-    settings.sourceBlendMode = static_cast<EBlend>(read<uint8>());
-    settings.destBlendMode = static_cast<EBlend>(read<uint8>());
-    settings.zCompareFunction = static_cast<ECmpFunction>(read<uint8>());
-    settings.alphaBlending = read<uint8>();
-    settings.affectedByFog = read<uint8>();
-    settings.specularEnable = read<uint8>();
-    settings.stippled = read<uint8>();
-    settings.edgeAntialias = read<uint8>();
-    settings.colorKeying = read<uint8>();
-    settings.zBias = read<uint8>();
-    settings.textureFactorColor = read<uint32>();
+    BlockReader block(readBlock(kRenderPassSettingsSize));
+
+    settings.antialias = block.read<uint8>();
+    settings.perspectiveCorrection = block.read<uint8>();
+    settings.fillMode = static_cast<EFillMode>(block.read<uint8>());
+    settings.shadeMode = static_cast<EShadeMode>(block.read<uint8>());
+    settings.linePattern_RepeatFactor = block.read<uint16>();
+    settings.linePattern_LinePattern = block.read<uint16>();
+    settings.pixelOperation = static_cast<EPixelOperation>(block.read<uint8>());
+    settings.writeToZBuffer = block.read<uint8>();
+    settings.testForAlphaBlending = block.read<uint8>();
+    settings.alphaReference = block.read<uint8>();
+    settings.alphaFunction = static_cast<ECmpFunction>(block.read<uint8>());
+    settings.drawLastPixel = block.read<uint8>();
+    settings.sourceBlendMode = static_cast<EBlend>(block.read<uint8>());
+    settings.destBlendMode = static_cast<EBlend>(block.read<uint8>());
+    settings.zCompareFunction = static_cast<ECmpFunction>(block.read<uint8>());
+    settings.alphaBlending = block.read<uint8>();
+    settings.affectedByFog = block.read<uint8>();
+    settings.specularEnable = block.read<uint8>();
+    settings.stippled = block.read<uint8>();
+    settings.edgeAntialias = block.read<uint8>();
+    settings.colorKeying = block.read<uint8>();
+    settings.zBias = block.read<uint8>();
+    settings.textureFactorColor = block.read<uint32>();
 
     // Stipple pattern (32 x uint32)
     for (int i = 0; i < 32; i++)
     {
-        settings.stipplePattern[i] = read<uint32>();
+        settings.stipplePattern[i] = block.read<uint32>();
     }
 
-    settings.useVertexColorWhenLighting = read<uint8>();
+    settings.useVertexColorWhenLighting = block.read<uint8>();
 
     // Material7
-    if (!parseMaterial7(settings.materialDescription))
-    {
-        return false;
-    }
-
-    return true;
-}
+    decodeMaterial7(block, settings.materialDescription);
 
-bool OpfParser::parseMaterial7(Material7& mat)
-{
-    if (!parseColorValue(mat.diffuse)) return false;
-    if (!parseColorValue(mat.ambient)) return false;
-    if (!parseColorValue(mat.specular)) return false;
-    if (!parseColorValue(mat.emissive)) return false;
-    mat.power = read<fp32>();
     return true;
 }
 
-bool OpfParser::parseColorValue(ColorValue& color)
+void OpfParser::decodeMaterial7(BlockReader& reader, Material7& mat)
 {
-    color.red = read<fp32>();
-    color.green = read<fp32>();
-    color.blue = read<fp32>();
-    color.alpha = read<fp32>();
-    return true;
+    mat.diffuse = reader.readColorValue();
+    mat.ambient = reader.readColorValue();
+    mat.specular = reader.readColorValue();
+    mat.emissive = reader.readColorValue();
+    mat.power = reader.read<fp32>();
 }
 
 bool OpfParser::parseRenderPassStage(RenderPassStage& stage)
 {
-    stage.colorArg1 = static_cast<ETextureStageArg>(read<uint8>());
-    stage.colorArg2 = static_cast<ETextureStageArg>(read<uint8>());
-    stage.colorOp = static_cast<ETextureStageOperation>(read<uint8>());
-    stage.alphaArg1 = static_cast<ETextureStageArg>(read<uint8>());
-    stage.alphaArg2 = static_cast<ETextureStageArg>(read<uint8>());
-    stage.alphaOp = static_cast<ETextureStageOperation>(read<uint8>());
-    stage.textureCoordinateIndex = read<uint8>();
-    stage.textureAddressU = static_cast<ETextureAddress>(read<uint8>());
-    stage.textureAddressV = static_cast<ETextureAddress>(read<uint8>());
-    stage.borderColor = read<uint32>();
-    stage.maxTextureMagnificationFilter = static_cast<ETextureMagnificationFilter>(read<uint8>());
-    stage.maxTextureMinificationFilter = static_cast<ETextureMinificationFilter>(read<uint8>());
-    stage.maxTextureMipmapFilter = static_cast<ETextureMipmapFilter>(read<uint8>());
-    stage.mipmapLODBias = read<fp32>();
-    stage.minMipmapLevel = read<uint8>();
-    stage.maxAnisotropy = read<uint8>();
-    stage.wrapping = static_cast<EWrapFlag>(read<uint8>());
-    stage.textureProjectID = read<uint16>();
-    stage.textureID = read<int32>();
-    stage.textureStageInTexture = read<int32>();
+    BlockReader block(readBlock(kRenderPassStageSize));
+
+    stage.colorArg1 = static_cast<ETextureStageArg>(block.read<uint8>());
+    stage.colorArg2 = static_cast<ETextureStageArg>(block.read<uint8>());
+    stage.colorOp = static_cast<ETextureStageOperation>(block.read<uint8>());
+    stage.alphaArg1 = static_cast<ETextureStageArg>(block.read<uint8>());
+    stage.alphaArg2 = static_cast<ETextureStageArg>(block.read<uint8>());
+    stage.alphaOp = static_cast<ETextureStageOperation>(block.read<uint8>());
+    stage.textureCoordinateIndex = block.read<uint8>();
+    stage.textureAddressU = static_cast<ETextureAddress>(block.read<uint8>());
+    stage.textureAddressV = static_cast<ETextureAddress>(block.read<uint8>());
+    stage.borderColor = block.read<uint32>();
+    stage.maxTextureMagnificationFilter = static_cast<ETextureMagnificationFilter>(block.read<uint8>());
+    stage.maxTextureMinificationFilter = static_cast<ETextureMinificationFilter>(block.read<uint8>());
+    stage.maxTextureMipmapFilter = static_cast<ETextureMipmapFilter>(block.read<uint8>());
+    stage.mipmapLODBias = block.read<fp32>();
+    stage.minMipmapLevel = block.read<uint8>();
+    stage.maxAnisotropy = block.read<uint8>();
+    stage.wrapping = static_cast<EWrapFlag>(block.read<uint8>());
+    stage.textureProjectID = block.read<uint16>();
+    stage.textureID = block.read<int32>();
+    stage.textureStageInTexture = block.read<int32>();
 
     return true;
 }
@@ -572,20 +829,194 @@ bool OpfParser::parseObjects(PackedProject& project)
     }
 
     qDebug() << "Parsing" << count << "objects...";
+
+    // Streaming: one object subtree at a time, handed to the visitor
+    if (m_visitor)
+    {
+        for (uint32 i = 0; i < count; i++)
+        {
+            // Geometry is freed together with the visitor's object
+            m_geometry = QSharedPointer<GeometryPool>::create();
+
+            Object* object = newObject();
+            qint64 begin = position();
+            if (!parseObject(*object))
+            {
+                qWarning() << "Failed to parse object" << (i + 1) << "/" << count;
+                delete object;
+                continue;
+            }
+            object->source = SourceRange{ begin, position() - begin };
+
+            if (!m_visitor->visitObject(object))
+            {
+                return stoppedByVisitor();
+            }
+
+            if (!reportProgress())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
     project.objects.reserve(count);
 
+    if (m_cursor && count >= kMinParallelObjects)
+    {
+        qint64 sectionStart = m_cursor->pos();
+        if (parseObjectsParallel(count, project))
+        {
+            return true;
+        }
+
+        if (m_canceled)
+        {
+            return false;
+        }
+
+        // Fall back to the serial parser so malformed data is handled
+        // exactly as before
+        m_cursor->seek(sectionStart);
+    }
+
     for (uint32 i = 0; i < count; i++)
     {
-        Object* object = new Object();
+        Object* object = newObject();
+        qint64 begin = position();
         if (!parseObject(*object))
         {
             qWarning() << "Failed to parse object" << (i + 1) << "/" << count;
-            delete object;
+            discardObject(object);
             continue;
         }
+        object->source = SourceRange{ begin, position() - begin };
         project.objects.append(object);
+
+        if (!reportProgress())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool OpfParser::parseObjectsParallel(uint32 count, PackedProject& project)
+{
+    int threadCount = m_maxThreadCount > 0 ? m_maxThreadCount : QThread::idealThreadCount();
+    if (threadCount <= 1)
+    {
+        return false;
+    }
+
+    // Phase 1: find the byte range of every top-level object
+    QVector<ObjectRange> ranges;
+    if (!scanObjects(count, ranges))
+    {
+        qDebug() << "Object boundary scan failed, parsing serially";
+        return false;
+    }
+
+    // Phase 2: decode the ranges on a thread pool, each task with its own
+    // parser and cursor over the shared mapping
+    QVector<Object*> parsed(count, nullptr);
+    Object** results = parsed.data();
+    const ObjectRange* objectRanges = ranges.constData();
+    std::atomic<bool> failed(false);
+    std::atomic<qint64> parsedBytes(0);
+    const uchar* data = m_cursor->data();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+
+    // Each batch gets its own geometry pool (and arena, if used); they are
+    // merged in order afterwards
+    int batchSize = qMax(1, int(count) / (threadCount * 4));
+    QVector<QSharedPointer<ObjectArena>> arenas;
+    QVector<QSharedPointer<GeometryPool>> geometries;
+    for (int first = 0; first < int(count); first += batchSize)
+    {
+        if (m_arena)
+        {
+            arenas.append(QSharedPointer<ObjectArena>::create());
+        }
+        geometries.append(QSharedPointer<GeometryPool>::create());
+    }
+
+    for (int first = 0, batch = 0; first < int(count); first += batchSize, batch++)
+    {
+        int last = qMin(first + batchSize, int(count));
+        ObjectArena* arena = m_arena ? arenas[batch].data() : nullptr;
+        QSharedPointer<GeometryPool> geometry = geometries[batch];
+        pool.start(QRunnable::create([&, first, last, arena, geometry]() {
+            OpfParser worker;
+            worker.m_arena = arena;
+            worker.m_geometry = geometry;
+            worker.m_names = m_names;
+            for (int i = first; i < last && !failed; i++)
+            {
+                ByteCursor cursor(data, objectRanges[i].end);
+                cursor.seek(objectRanges[i].begin);
+                worker.m_cursor = &cursor;
+
+                Object* object = worker.newObject();
+                if (!worker.parseObject(*object) || !cursor.atEnd() || worker.m_truncated)
+                {
+                    worker.discardObject(object);
+                    failed = true;
+                    break;
+                }
+                object->source = SourceRange{ objectRanges[i].begin, objectRanges[i].end - objectRanges[i].begin };
+                results[i] = object;
+                parsedBytes += object->source.size;
+            }
+            worker.m_cursor = nullptr;
+        }));
     }
 
+    // Progress is reported from this thread while the pool works
+    qint64 sectionStart = ranges.isEmpty() ? 0 : ranges.first().begin;
+    while (!pool.waitForDone(50))
+    {
+        if (!failed && !reportProgress(sectionStart + parsedBytes))
+        {
+            failed = true;
+        }
+    }
+
+    if (failed)
+    {
+        // Arena objects go away with 'arenas'
+        if (!m_arena)
+        {
+            qDeleteAll(parsed);
+        }
+        if (!m_canceled)
+        {
+            qDebug() << "Parallel object parse failed, parsing serially";
+        }
+        return false;
+    }
+
+    for (const QSharedPointer<ObjectArena>& arena : std::as_const(arenas))
+    {
+        m_arena->merge(*arena);
+    }
+
+    for (int first = 0, batch = 0; first < int(count); first += batchSize, batch++)
+    {
+        GeometryPool::Offsets base = m_geometry->append(*geometries[batch]);
+        int last = qMin(first + batchSize, int(count));
+        for (int i = first; i < last; i++)
+        {
+            rebaseGeometry(*parsed[i], base);
+        }
+    }
+
+    project.objects += parsed;
+    qDebug() << "  Parsed" << count << "objects on" << threadCount << "threads";
     return true;
 }
 
@@ -593,14 +1024,15 @@ bool OpfParser::parseObject(Object& object)
 {
     try {
         // Class name
-        object.className = readOutforceString();
+        object.setClassName(readOutforceString());
 
         // Flags and IDs
-        object.isUnknown = read<uint8>();
-        object.projectID = read<uint16>();
-        object.uniqueID = read<int32>();
-        object.override = static_cast<EOverride>(read<uint8>());
-        object.excludeFromExport = read<uint8>();
+        BlockReader identity(readBlock(kObjectIdentitySize));
+        object.isUnknown = identity.read<uint8>();
+        object.projectID = identity.read<uint16>();
+        object.uniqueID = identity.read<int32>();
+        object.override = static_cast<EOverride>(identity.read<uint8>());
+        object.excludeFromExport = identity.read<uint8>();
 
         // Name
         object.name = readOutforceString();
@@ -613,15 +1045,16 @@ bool OpfParser::parseObject(Object& object)
         }
 
         // Transform
-        object.position = readVector3D();
-        object.rotation = readVector3D();
-        object.scaling = readVector3D();
+        BlockReader transform(readBlock(kObjectTransformSize));
+        object.position = transform.readVector3D();
+        object.rotation = transform.readVector3D();
+        object.scaling = transform.readVector3D();
 
         // Version and flags
-        object.version = read<uint32>();
-        object.isDisabled = read<uint8>();
-        object.disableTree = read<uint8>();
-        object.isBillboard = read<uint8>();
+        object.version = transform.read<uint32>();
+        object.isDisabled = transform.read<uint8>();
+        object.disableTree = transform.read<uint8>();
+        object.isBillboard = transform.read<uint8>();
 
         // Object template (contains meshes)
         if (!parseObjectTemplate(object.objectTemplate))
@@ -651,26 +1084,17 @@ bool OpfParser::parseObject(Object& object)
         {
             return false;
         }
-
-        // Debug: print custom settings
-        if (!object.customSettings.isEmpty())
-        {
-            qDebug() << "  Object" << object.name << "has" << object.customSettings.size() << "custom settings:";
-            for (const auto& setting : object.customSettings)
-            {
-                qDebug() << "    " << setting.name << "=" << setting.value;
-            }
-        }
+        object.updateSettingsIndex();
 
         // Children
         uint32 childCount = read<uint32>();
         object.children.reserve(childCount);
         for (uint32 i = 0; i < childCount; i++)
         {
-            Object* child = new Object();
+            Object* child = newObject();
             if (!parseObject(*child))
             {
-                delete child;
+                discardObject(child);
                 return false;
             }
             object.children.append(child);
@@ -689,16 +1113,18 @@ bool OpfParser::parseObject(Object& object)
 
 bool OpfParser::parseObjectTemplate(ObjectTemplate& templ)
 {
+    BlockReader block(readBlock(kObjectTemplateSize));
+
     // Physical transforms
-    templ.physicalScaling = readVector3D();
-    templ.physicalPosition = readVector3D();
-    templ.physicalRotation = readVector3D();
-    templ.lastPhysicalScaling = readVector3D();
-    templ.lastPhysicalPosition = readVector3D();
-    templ.lastPhysicalRotation = readVector3D();
+    templ.physicalScaling = block.readVector3D();
+    templ.physicalPosition = block.readVector3D();
+    templ.physicalRotation = block.readVector3D();
+    templ.lastPhysicalScaling = block.readVector3D();
+    templ.lastPhysicalPosition = block.readVector3D();
+    templ.lastPhysicalRotation = block.readVector3D();
 
     // Face buffers (meshes)
-    uint32 faceBufferCount = read<uint32>();
+    uint32 faceBufferCount = block.read<uint32>();
     if (faceBufferCount > 100)
     {
         qWarning() << "Suspicious face buffer count:" << faceBufferCount;
@@ -721,104 +1147,84 @@ bool OpfParser::parseObjectTemplate(ObjectTemplate& templ)
 
 bool OpfParser::parseFaceBuffer(Mesh& mesh)
 {
-    // Vertex format
-    mesh.vertexFormat = static_cast<EVertexFormat>(read<int32>());
-
-    // Material
-    mesh.materialProjectID = read<uint16>();
-    mesh.materialID = read<int32>();
+    // Vertex format and material
+    BlockReader materialBlock(readBlock(kMeshMaterialSize));
+    mesh.vertexFormat = static_cast<EVertexFormat>(materialBlock.read<int32>());
+    mesh.materialProjectID = materialBlock.read<uint16>();
+    mesh.materialID = materialBlock.read<int32>();
 
     // Name
     mesh.name = readOutforceString();
 
+    BlockReader header(readBlock(kMeshHeaderSize));
+
     // Texture wrapping
-    mesh.textureWrapType = static_cast<ETextureWrapType>(read<uint32>());
-    mesh.textureOrigin = readVector3D();
-    mesh.textureRotation = readVector3D();
-    mesh.textureScale = readVector2D();
-    mesh.texturePosition = readVector2D();
+    mesh.textureWrapType = static_cast<ETextureWrapType>(header.read<uint32>());
+    mesh.textureOrigin = header.readVector3D();
+    mesh.textureRotation = header.readVector3D();
+    mesh.textureScale = header.readVector2D();
+    mesh.texturePosition = header.readVector2D();
 
     // Position and bounds
-    mesh.position = readVector3D();
-    mesh.boundRadius = read<fp32>();
+    mesh.position = header.readVector3D();
+    mesh.boundRadius = header.read<fp32>();
 
     // Morph data
-    mesh.morphSize = read<int32>();
-    int32 numVertexMorphs = read<int32>();
-    int32 numColorMorphs = read<int32>();
-    int32 numTextureMorphs = read<int32>();
-
-    // Parse vertex morph targets
-    mesh.vertexMorphTargets.reserve(numVertexMorphs);
+    mesh.morphSize = header.read<int32>();
+    int32 numVertexMorphs = header.read<int32>();
+    int32 numColorMorphs = header.read<int32>();
+    int32 numTextureMorphs = header.read<int32>();
+
+    // Morph targets are stored back to back in the geometry pool
+    mesh.geometry = m_geometry;
+    mesh.vertexOffset = m_geometry->positions.size();
     for (int32 i = 0; i < numVertexMorphs; i++)
     {
-        VertexMorphTarget target;
-        if (!parseVertexMorphTarget(target, mesh.morphSize))
+        if (!parseVertexMorphTarget(mesh))
         {
             return false;
         }
-
-        // Store first morph as main vertices
-        if (i == 0 && !target.vertices.isEmpty())
-        {
-            mesh.vertices = target.vertices;
-        }
-
-        mesh.vertexMorphTargets.append(target);
     }
 
-    // Parse color morph targets
-    mesh.colorMorphTargets.reserve(numColorMorphs);
+    mesh.colorOffset = m_geometry->colors.size();
     for (int32 i = 0; i < numColorMorphs; i++)
     {
-        ColorMorphTarget target;
-        if (!parseColorMorphTarget(target, mesh.morphSize))
+        if (!parseColorMorphTarget(mesh))
         {
             return false;
         }
-        mesh.colorMorphTargets.append(target);
     }
 
-    // Parse texture morph targets
-    mesh.textureMorphTargets.reserve(numTextureMorphs);
+    // Texture morph target 0 doubles as the texture coordinates of
+    // Mesh::vertices()
+    mesh.texCoordOffset = m_geometry->texCoords.size();
     for (int32 i = 0; i < numTextureMorphs; i++)
     {
-        TextureMorphTarget target;
-        if (!parseTextureMorphTarget(target, mesh.morphSize))
+        if (!parseTextureMorphTarget(mesh))
         {
             return false;
         }
-
-        // Store first morph as main texture coordinates
-        if (i == 0 && !target.textureCoordinates.isEmpty())
-        {
-            for (int j = 0; j < mesh.vertices.size() && j < target.textureCoordinates.size(); j++)
-            {
-                mesh.vertices[j].texCoord = target.textureCoordinates[j];
-            }
-        }
-
-        mesh.textureMorphTargets.append(target);
     }
 
     // Morph blend parameters
-    mesh.srcVertex = read<int32>();
-    mesh.srcColor = read<int32>();
-    for (int i = 0; i < 3; i++) mesh.srcTexture[i] = read<int32>();
+    BlockReader blend(readBlock(kMeshBlendSize));
+    mesh.srcVertex = blend.read<int32>();
+    mesh.srcColor = blend.read<int32>();
+    for (int i = 0; i < 3; i++) mesh.srcTexture[i] = blend.read<int32>();
 
-    mesh.dstVertex = read<int32>();
-    mesh.dstColor = read<int32>();
-    for (int i = 0; i < 3; i++) mesh.dstTexture[i] = read<int32>();
+    mesh.dstVertex = blend.read<int32>();
+    mesh.dstColor = blend.read<int32>();
+    for (int i = 0; i < 3; i++) mesh.dstTexture[i] = blend.read<int32>();
 
-    mesh.amountVertex = read<fp32>();
-    mesh.amountColor = read<fp32>();
-    for (int i = 0; i < 3; i++) mesh.amountTexture[i] = read<fp32>();
+    mesh.amountVertex = blend.read<fp32>();
+    mesh.amountColor = blend.read<fp32>();
+    for (int i = 0; i < 3; i++) mesh.amountTexture[i] = blend.read<fp32>();
 
-    for (int i = 0; i < 3; i++) mesh.dstEnvironment[i] = read<uint8>();
+    for (int i = 0; i < 3; i++) mesh.dstEnvironment[i] = blend.read<uint8>();
 
     // Face buffer type and count
-    mesh.bufferType = static_cast<EBufferType>(read<int32>());
-    mesh.numFaces = read<int32>();
+    mesh.bufferType = static_cast<EBufferType>(blend.read<int32>());
+    mesh.numFaces = blend.read<int32>();
     mesh.primitiveType = static_cast<int>(mesh.bufferType);
 
     if (mesh.numFaces < 0 || mesh.numFaces > 100000)
@@ -829,92 +1235,138 @@ bool OpfParser::parseFaceBuffer(Mesh& mesh)
 
     // Read indices
     int indexCount = mesh.numFaces * static_cast<int>(mesh.bufferType);
-    mesh.indices.reserve(indexCount);
-    for (int i = 0; i < indexCount; i++)
+    if (indexCount > 0)
     {
-        mesh.indices.append(read<uint16>());
+        if (!checkArraySize(indexCount, sizeof(uint16), "index"))
+        {
+            return false;
+        }
+
+        const uchar* indices = readBlock(qint64(indexCount) * sizeof(uint16));
+        mesh.indexOffset = GeometryPool::allocate(m_geometry->indices, indexCount);
+        mesh.indexCount = indexCount;
+        memcpy(m_geometry->indices.data() + mesh.indexOffset, indices, qint64(indexCount) * sizeof(uint16));
     }
 
     // Group morph targets
     int32 numGroupMorphs = read<int32>();
-    mesh.groupMorphTargets.reserve(numGroupMorphs);
+    mesh.groupOffset = m_geometry->groups.size();
     for (int32 i = 0; i < numGroupMorphs; i++)
     {
-        GroupMorphTarget target;
-        if (!parseGroupMorphTarget(target, mesh.morphSize))
+        if (!parseGroupMorphTarget(mesh))
         {
             return false;
         }
-        mesh.groupMorphTargets.append(target);
     }
 
     return true;
 }
 
-bool OpfParser::parseVertexMorphTarget(VertexMorphTarget& target, int32 morphSize)
+bool OpfParser::parseVertexMorphTarget(Mesh& mesh)
 {
-    target.vertices.reserve(morphSize);
-    for (int32 i = 0; i < morphSize; i++)
+    int32 morphSize = mesh.morphSize;
+    if (morphSize > 0)
     {
-        Vertex v;
-        v.position = readVector3D();
-        v.normal = readVector3D();
-        target.vertices.append(v);
+        if (!checkArraySize(morphSize, kVertexSize, "vertex"))
+        {
+            return false;
+        }
+
+        BlockReader block(readBlock(qint64(morphSize) * kVertexSize));
+        int32 offset = m_geometry->allocateVertices(morphSize);
+        Vector3D* positions = m_geometry->positions.data() + offset;
+        Vector3D* normals = m_geometry->normals.data() + offset;
+        for (int32 i = 0; i < morphSize; i++)
+        {
+            positions[i] = block.readVector3D();
+            normals[i] = block.readVector3D();
+        }
     }
-    target.name = readOutforceString();
+    mesh.vertexMorphNames.append(readOutforceString());
+    mesh.numVertexMorphs++;
     return true;
 }
 
-bool OpfParser::parseColorMorphTarget(ColorMorphTarget& target, int32 morphSize)
+bool OpfParser::parseColorMorphTarget(Mesh& mesh)
 {
-    target.colors.reserve(morphSize);
-    for (int32 i = 0; i < morphSize; i++)
+    int32 morphSize = mesh.morphSize;
+    if (morphSize > 0)
     {
-        target.colors.append(read<uint32>());
+        if (!checkArraySize(morphSize, sizeof(uint32), "color"))
+        {
+            return false;
+        }
+
+        const uchar* block = readBlock(qint64(morphSize) * sizeof(uint32));
+        int32 offset = GeometryPool::allocate(m_geometry->colors, morphSize);
+        memcpy(m_geometry->colors.data() + offset, block, qint64(morphSize) * sizeof(uint32));
     }
+    mesh.numColorMorphs++;
     return true;
 }
 
-bool OpfParser::parseTextureMorphTarget(TextureMorphTarget& target, int32 morphSize)
+bool OpfParser::parseTextureMorphTarget(Mesh& mesh)
 {
-    target.textureCoordinates.reserve(morphSize);
-    for (int32 i = 0; i < morphSize; i++)
+    int32 morphSize = mesh.morphSize;
+    if (morphSize > 0)
     {
-        target.textureCoordinates.append(readVector2D());
+        if (!checkArraySize(morphSize, 2 * sizeof(fp32), "texture coordinate"))
+        {
+            return false;
+        }
+
+        BlockReader block(readBlock(qint64(morphSize) * 2 * sizeof(fp32)));
+        int32 offset = GeometryPool::allocate(m_geometry->texCoords, morphSize);
+        Vector2D* texCoords = m_geometry->texCoords.data() + offset;
+        for (int32 i = 0; i < morphSize; i++)
+        {
+            texCoords[i] = block.readVector2D();
+        }
     }
+    mesh.numTextureMorphs++;
     return true;
 }
 
-bool OpfParser::parseGroupMorphTarget(GroupMorphTarget& target, int32 morphSize)
+bool OpfParser::parseGroupMorphTarget(Mesh& mesh)
 {
-    target.groups.reserve(morphSize);
-    for (int32 i = 0; i < morphSize; i++)
+    int32 morphSize = mesh.morphSize;
+    if (morphSize > 0)
     {
-        target.groups.append(read<uint8>());
+        if (!checkArraySize(morphSize, sizeof(uint8), "group"))
+        {
+            return false;
+        }
+
+        const uchar* block = readBlock(morphSize);
+        int32 offset = GeometryPool::allocate(m_geometry->groups, morphSize);
+        memcpy(m_geometry->groups.data() + offset, block, morphSize);
     }
+    mesh.numGroupMorphs++;
     return true;
 }
 
 bool OpfParser::parseLight(Light& light)
 {
-    if (!parseColorValue(light.diffuse)) return false;
-    if (!parseColorValue(light.ambient)) return false;
-    if (!parseColorValue(light.specular)) return false;
+    BlockReader block(readBlock(kLightSize));
+
+    light.diffuse = block.readColorValue();
+    light.ambient = block.readColorValue();
+    light.specular = block.readColorValue();
 
-    light.lightType = static_cast<ELightType>(read<uint32>());
+    light.lightType = static_cast<ELightType>(block.read<uint32>());
 
-    light.attenuation0 = read<fp32>();
-    light.attenuation1 = read<fp32>();
-    light.attenuation2 = read<fp32>();
+    light.attenuation0 = block.read<fp32>();
+    light.attenuation1 = block.read<fp32>();
+    light.attenuation2 = block.read<fp32>();
 
-    light.falloff = read<fp32>();
-    light.phi = read<fp32>();
-    light.range = read<fp32>();
-    light.theta = read<fp32>();
+    light.falloff = block.read<fp32>();
+    light.phi = block.read<fp32>();
+    light.range = block.read<fp32>();
+    light.theta = block.read<fp32>();
 
-    light.active = read<uint8>();
-    light.position = readVector3D();
-    light.rotation = readVector3D();
+    light.active = block.read<uint8>();
+    light.position = block.readVector3D();
+    light.rotation = block.readVector3D();
 
     return true;
 }
@@ -927,7 +1379,7 @@ bool OpfParser::parseCustomSettings(QVector<CustomSetting>& settings)
     for (uint32 i = 0; i < count; i++)
     {
         CustomSetting setting;
-        setting.name = readOutforceString();
+        setting.setName(readOutforceString(), *m_names);
         setting.value = readOutforceString();
         settings.append(setting);
     }
@@ -935,6 +1387,135 @@ bool OpfParser::parseCustomSettings(QVector<CustomSetting>& settings)
     return true;
 }
 
+// ============================================================================
+// BOUNDARY SCAN
+// ============================================================================
+
+bool OpfParser::scanObjects(uint32 count, QVector<ObjectRange>& ranges)
+{
+    ranges.reserve(count);
+    for (uint32 i = 0; i < count; i++)
+    {
+        ObjectRange range;
+        range.begin = m_cursor->pos();
+        if (!skipObject())
+        {
+            return false;
+        }
+        range.end = m_cursor->pos();
+        ranges.append(range);
+    }
+    return true;
+}
+
+bool OpfParser::skipObject()
+{
+    // className, identity block, name, transform block
+    if (!skipString()) return false;
+    if (!m_cursor->take(kObjectIdentitySize)) return false;
+    if (!skipString()) return false;
+    if (!m_cursor->take(kObjectTransformSize)) return false;
+
+    // Object template: transforms followed by the face buffer count
+    const uchar* templ = m_cursor->take(kObjectTemplateSize);
+    if (!templ) return false;
+
+    uint32 faceBufferCount;
+    memcpy(&faceBufferCount, templ + kObjectTemplateSize - sizeof(uint32), sizeof(uint32));
+    if (faceBufferCount > 100) return false;
+
+    for (uint32 i = 0; i < faceBufferCount; i++)
+    {
+        if (!skipFaceBuffer()) return false;
+    }
+
+    // Light
+    const uchar* hasLight = m_cursor->take(1);
+    if (!hasLight) return false;
+    if (*hasLight && !m_cursor->take(kLightSize)) return false;
+
+    // Reserved byte
+    if (!m_cursor->take(1)) return false;
+
+    // Custom settings
+    const uchar* countData = m_cursor->take(sizeof(uint32));
+    if (!countData) return false;
+
+    uint32 settingCount;
+    memcpy(&settingCount, countData, sizeof(uint32));
+    for (uint32 i = 0; i < settingCount; i++)
+    {
+        if (!skipString() || !skipString()) return false;
+    }
+
+    // Children
+    countData = m_cursor->take(sizeof(uint32));
+    if (!countData) return false;
+
+    uint32 childCount;
+    memcpy(&childCount, countData, sizeof(uint32));
+    for (uint32 i = 0; i < childCount; i++)
+    {
+        if (!skipObject()) return false;
+    }
+
+    return true;
+}
+
+bool OpfParser::skipFaceBuffer()
+{
+    if (!m_cursor->take(kMeshMaterialSize)) return false;
+    if (!skipString()) return false;
+
+    const uchar* header = m_cursor->take(kMeshHeaderSize);
+    if (!header) return false;
+
+    BlockReader counts(header + kMeshHeaderMorphSizeOffset);
+    qint64 morphSize = qMax(counts.read<int32>(), 0);
+    int32 numVertexMorphs = counts.read<int32>();
+    int32 numColorMorphs = counts.read<int32>();
+    int32 numTextureMorphs = counts.read<int32>();
+
+    for (int32 i = 0; i < numVertexMorphs; i++)
+    {
+        if (!m_cursor->take(morphSize * kVertexSize)) return false;
+        if (!skipString()) return false;
+    }
+
+    if (numColorMorphs > 0 && !m_cursor->take(numColorMorphs * morphSize * sizeof(uint32))) return false;
+    if (numTextureMorphs > 0 && !m_cursor->take(numTextureMorphs * morphSize * 2 * sizeof(fp32))) return false;
+
+    const uchar* blend = m_cursor->take(kMeshBlendSize);
+    if (!blend) return false;
+
+    BlockReader faces(blend + kMeshBlendBufferTypeOffset);
+    int32 bufferType = faces.read<int32>();
+    int32 numFaces = faces.read<int32>();
+    if (numFaces < 0 || numFaces > 100000) return false;
+
+    qint64 indexCount = qint64(numFaces) * bufferType;
+    if (indexCount > 0 && !m_cursor->take(indexCount * sizeof(uint16))) return false;
+
+    const uchar* groupData = m_cursor->take(sizeof(int32));
+    if (!groupData) return false;
+
+    int32 numGroupMorphs;
+    memcpy(&numGroupMorphs, groupData, sizeof(int32));
+    if (numGroupMorphs > 0 && !m_cursor->take(numGroupMorphs * morphSize)) return false;
+
+    return true;
+}
+
+bool OpfParser::skipString()
+{
+    const uchar* lengthData = m_cursor->take(sizeof(uint16));
+    if (!lengthData) return false;
+
+    uint16 length;
+    memcpy(&length, lengthData, sizeof(uint16));
+    return m_cursor->take(length) != nullptr;
+}
+
 // ============================================================================
 // HELPER FUNCTIONS
 // ============================================================================
@@ -944,11 +1525,8 @@ QString OpfParser::readOutforceString()
     uint16 length = read<uint16>();
     if (length == 0) return QString();
 
-    QByteArray data(length, 0);
-    m_stream->readRawData(data.data(), length);
-
     // Convert from Windows-1252 to UTF-8
-    return QString::fromLatin1(data);
+    return QString::fromLatin1(reinterpret_cast<const char*>(readBlock(length)), length);
 }
 
 QString OpfParser::readOutforceString32()
@@ -956,24 +1534,114 @@ QString OpfParser::readOutforceString32()
     uint32 length = read<uint32>();
     if (length == 0) return QString();
 
-    QByteArray data(length, 0);
-    m_stream->readRawData(data.data(), length);
+    if (!checkArraySize(static_cast<int32>(qMin<uint32>(length, INT_MAX)), 1, "string"))
+    {
+        return QString();
+    }
 
-    return QString::fromLatin1(data);
+    return QString::fromLatin1(reinterpret_cast<const char*>(readBlock(length)), length);
 }
 
 QString OpfParser::readStaticString(int length)
 {
-    QByteArray data(length, 0);
-    m_stream->readRawData(data.data(), length);
+    const char* data = reinterpret_cast<const char*>(readBlock(length));
+    return QString::fromLatin1(data, static_cast<int>(qstrnlen(data, length)));
+}
+
+void OpfParser::rebaseGeometry(Object& object, const GeometryPool::Offsets& base)
+{
+    for (Mesh& mesh : object.meshes())
+    {
+        mesh.geometry = m_geometry;
+        mesh.vertexOffset += base.vertex;
+        mesh.texCoordOffset += base.texCoord;
+        mesh.colorOffset += base.color;
+        mesh.groupOffset += base.group;
+        mesh.indexOffset += base.index;
+    }
+
+    for (Object* child : object.children)
+    {
+        if (child)
+        {
+            rebaseGeometry(*child, base);
+        }
+    }
+}
+
+Object* OpfParser::newObject()
+{
+    Object* object = m_arena ? m_arena->create() : new Object();
+    object->setNameTable(m_names);
+    return object;
+}
+
+void OpfParser::discardObject(Object* object)
+{
+    if (!object->arenaAllocated)
+    {
+        delete object;
+    }
+}
+
+qint64 OpfParser::position() const
+{
+    if (m_cursor)
+    {
+        return m_cursor->pos();
+    }
+    return m_stream->device()->pos();
+}
+
+qint64 OpfParser::remaining() const
+{
+    if (m_cursor)
+    {
+        return m_cursor->remaining();
+    }
+    return m_stream->device()->size() - m_stream->device()->pos();
+}
+
+const uchar* OpfParser::readBlock(qint64 size)
+{
+    if (size <= 0)
+    {
+        return reinterpret_cast<const uchar*>(m_scratch.constData());
+    }
 
-    int nullPos = data.indexOf('\0');
-    if (nullPos >= 0)
+    if (m_cursor)
     {
-        data = data.left(nullPos);
+        const uchar* block = m_cursor->take(size);
+        if (block)
+        {
+            return block;
+        }
+
+        // Past the end: hand out zeroes, like the stream backend does
+        m_truncated = true;
+        m_cursor->skipToEnd();
+        m_scratch.fill('\0', size);
+        return reinterpret_cast<const uchar*>(m_scratch.constData());
+    }
+
+    m_scratch.resize(size);
+    qint64 bytesRead = qMax<qint64>(m_stream->readRawData(m_scratch.data(), size), 0);
+    if (bytesRead < size)
+    {
+        m_truncated = true;
+        memset(m_scratch.data() + bytesRead, 0, size - bytesRead);
     }
+    return reinterpret_cast<const uchar*>(m_scratch.constData());
+}
 
-    return QString::fromLatin1(data);
+bool OpfParser::checkArraySize(int32 count, int elementSize, const char* what)
+{
+    if (count < 0 || qint64(count) * elementSize > remaining())
+    {
+        qWarning() << "Invalid" << what << "count:" << count << "exceeds remaining file data";
+        return false;
+    }
+    return true;
 }
 
 Vector2D OpfParser::readVector2D()
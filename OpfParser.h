@@ -2,22 +2,120 @@
 #define OPFPARSER_H
 
 #include "OpfStructs.h"
+#include "OpfByteCursor.h"
+#include "OpfVisitor.h"
 #include <QFile>
 #include <QDataStream>
+#include <functional>
 
 namespace Opf {
 
 class OpfParser
 {
 public:
+    // Stream: QDataStream over QFile (original backend)
+    // MemoryMapped: maps the whole file and decodes from a ByteCursor
+    enum class Backend
+    {
+        Stream,
+        MemoryMapped
+    };
+
     OpfParser();
 
     bool parse(const QString& filename, PackedProject& project);
+
+    // SAX-style parse: records are passed to 'visitor' as they are decoded
+    // instead of being collected into a PackedProject (see OpfVisitor)
+    bool parseStreaming(const QString& filename, OpfVisitor& visitor);
     QString lastError() const { return m_lastError; }
 
+    void setBackend(Backend backend) { m_backend = backend; }
+    Backend backend() const { return m_backend; }
+
+    // Eager: texture payloads are read during parse (original behaviour)
+    // Lazy: only their offset and size are recorded; pixels are fetched from
+    // the file on first access (Texture::ensureBitmapData)
+    enum class TextureLoadMode
+    {
+        Eager,
+        Lazy
+    };
+
+    void setTextureLoadMode(TextureLoadMode mode) { m_textureLoadMode = mode; }
+    TextureLoadMode textureLoadMode() const { return m_textureLoadMode; }
+
+    // Threads used for the object section (memory-mapped backend only).
+    // 0 = QThread::idealThreadCount(), 1 = always parse serially.
+    void setMaxThreadCount(int count) { m_maxThreadCount = count; }
+    int maxThreadCount() const { return m_maxThreadCount; }
+
+    // Heap: every object is a separate allocation (original behaviour)
+    // Arena: objects live in PackedProject::objectArena and are freed in
+    // one go with the project. Ignored by parseStreaming().
+    enum class ObjectStorage
+    {
+        Heap,
+        Arena
+    };
+
+    void setObjectStorage(ObjectStorage storage) { m_objectStorage = storage; }
+    ObjectStorage objectStorage() const { return m_objectStorage; }
+
+    // Sections in file order, as reported to the progress callback
+    enum class Section
+    {
+        Header,
+        Dependencies,
+        Events,
+        Textures,
+        Materials,
+        Objects
+    };
+
+    // Called on the parsing thread at every section start and then about
+    // every 256 KB, with the current file offset. Returning false cancels:
+    // the parse fails and wasCanceled() is true.
+    using ProgressCallback = std::function<bool(Section section, qint64 position, qint64 total)>;
+
+    void setProgressCallback(const ProgressCallback& callback) { m_progressCallback = callback; }
+    bool wasCanceled() const { return m_canceled; }
+
+    // The last parse ran into the end of the file: it succeeded, but missing
+    // fields were left at their defaults and PackedProject::sourceFile is
+    // not set
+    bool wasTruncated() const { return m_truncated; }
+
 private:
     QString m_lastError;
+    Backend m_backend;
+    TextureLoadMode m_textureLoadMode;
+    int m_maxThreadCount;
+    ObjectStorage m_objectStorage;
+    OpfVisitor* m_visitor;
+    ObjectArena* m_arena;
+    QSharedPointer<GeometryPool> m_geometry;
+    QSharedPointer<NameTable> m_names;
+    QSharedPointer<TextureDataSource> m_textureSource;
     QDataStream* m_stream;
+    ByteCursor* m_cursor;
+    QByteArray m_scratch;
+    bool m_truncated;
+
+    ProgressCallback m_progressCallback;
+    Section m_section;
+    qint64 m_fileSize;
+    qint64 m_lastReported;
+    bool m_canceled;
+
+    bool parseFile(const QString& filename, PackedProject& project);
+    bool parseSections(PackedProject& project);
+    bool stoppedByVisitor();
+
+    // Progress callback helpers; false means the parse was canceled
+    bool enterSection(Section section);
+    bool reportProgress();
+    bool reportProgress(qint64 position);
 
     // ========================================================================
     // MAIN PARSING FUNCTIONS
@@ -29,6 +127,7 @@ private:
     bool parseTextures(PackedProject& project);
     bool parseMaterials(PackedProject& project);
     bool parseObjects(PackedProject& project);
+    bool parseObjectsParallel(uint32 count, PackedProject& project);
 
     // ========================================================================
     // TEXTURE PARSING
@@ -45,8 +144,7 @@ private:
     bool parseMaterial(Material& material);
     bool parseRenderPassSettings(RenderPassSettings& settings);
     bool parseRenderPassStage(RenderPassStage& stage);
-    bool parseMaterial7(Material7& mat);
-    bool parseColorValue(ColorValue& color);
+    void decodeMaterial7(BlockReader& reader, Material7& mat);
 
     // ========================================================================
     // OBJECT PARSING
@@ -58,11 +156,34 @@ private:
     bool parseLight(Light& light);
     bool parseCustomSettings(QVector<CustomSetting>& settings);
 
-    // Morph targets
-    bool parseVertexMorphTarget(VertexMorphTarget& target, int32 morphSize);
-    bool parseColorMorphTarget(ColorMorphTarget& target, int32 morphSize);
-    bool parseTextureMorphTarget(TextureMorphTarget& target, int32 morphSize);
-    bool parseGroupMorphTarget(GroupMorphTarget& target, int32 morphSize);
+    // Morph targets (appended to m_geometry, mesh.morphSize elements each)
+    bool parseVertexMorphTarget(Mesh& mesh);
+    bool parseColorMorphTarget(Mesh& mesh);
+    bool parseTextureMorphTarget(Mesh& mesh);
+    bool parseGroupMorphTarget(Mesh& mesh);
+
+    // ========================================================================
+    // BOUNDARY SCAN (parallel object parsing)
+    // ========================================================================
+
+    // Byte range of one top-level object, absolute file offsets
+    struct ObjectRange
+    {
+        qint64 begin;
+        qint64 end;
+    };
+
+    // Walks the object section without decoding it. Only reads the counts
+    // needed to find where each object ends; fails on anything the full
+    // parser would reject or that runs past the end of the file.
+    bool scanObjects(uint32 count, QVector<ObjectRange>& ranges);
+    bool skipObject();
+    bool skipFaceBuffer();
+    bool skipString();
+
+    // Points the meshes of a batch-parsed object at m_geometry after its
+    // batch pool was appended at 'base'
+    void rebaseGeometry(Object& object, const GeometryPool::Offsets& base);
 
     // ========================================================================
     // HELPER FUNCTIONS
@@ -76,13 +197,43 @@ private:
     Vector2D_uint32 readVector2D_uint32();
     Vertex readVertex();
 
+    // Allocates from m_arena when set, with names interned in m_names.
+    // Discarded arena objects are simply left to the arena.
+    Object* newObject();
+    void discardObject(Object* object);
+
+    // Current offset in the file and bytes left after it
+    qint64 position() const;
+    qint64 remaining() const;
+
+    // Reads a fixed-size block with a single bounds check. The returned
+    // pointer is only valid until the next readBlock() call.
+    const uchar* readBlock(qint64 size);
+
+    // Validates an array payload of count * elementSize bytes
+    bool checkArraySize(int32 count, int elementSize, const char* what);
+
     // Safe template read function
     template<typename T>
     T read()
     {
         T value{};
+        if (m_cursor)
+        {
+            const uchar* data = m_cursor->take(sizeof(T));
+            if (!data)
+            {
+                m_truncated = true;
+                m_cursor->skipToEnd();
+                return value;
+            }
+            memcpy(&value, data, sizeof(T));
+            return value;
+        }
+
         if (m_stream->atEnd())
         {
+            m_truncated = true;
             return value;
         }
         m_stream->readRawData(reinterpret_cast<char*>(&value), sizeof(T));
@@ -92,12 +243,29 @@ private:
     // Skip bytes
     void skip(int bytes)
     {
+        if (m_cursor)
+        {
+            if (!m_cursor->take(bytes))
+            {
+                m_truncated = true;
+                m_cursor->skipToEnd();
+            }
+            return;
+        }
         m_stream->skipRawData(bytes);
     }
 
     // Read raw bytes
     QByteArray readBytes(int count)
     {
+        if (count <= 0)
+        {
+            return QByteArray();
+        }
+        if (m_cursor)
+        {
+            return QByteArray(reinterpret_cast<const char*>(readBlock(count)), count);
+        }
         QByteArray data(count, 0);
         m_stream->readRawData(data.data(), count);
         return data;
@@ -1,11 +1,21 @@
 #ifndef OPFSTRUCTS_H
 #define OPFSTRUCTS_H
 
+#include "NameTable.h"
 #include <QString>
 #include <QVector>
 #include <QMap>
+#include <QHash>
 #include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QScopedPointer>
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <new>
+#include <utility>
 
 namespace Opf {
 
@@ -316,9 +326,17 @@ struct CustomSetting
 {
     QString name;   // e.g., "CanBuildUnit", "MaxHealth", "BuildTime", "Cost"
     QString value;  // The value
+    uint32 nameId = NameTable::kNoName;  // id of 'name' in the object's NameTable
 
     CustomSetting() = default;
-    CustomSetting(const QString& n, const QString& v) : name(n), value(v) {}
+    CustomSetting(const QString& n, const QString& v, NameTable& names) : value(v) { setName(n, names); }
+
+    // Interns the name; use this instead of assigning 'name'
+    void setName(const QString& n, NameTable& names)
+    {
+        nameId = names.intern(n);
+        name = names.name(nameId);
+    }
 };
 
 // ============================================================================
@@ -350,9 +368,115 @@ struct Bitmap
     uint32 bitmapInfoHeaderSize = 0;
     BitmapInfoHeader bitmapInfoHeader;
     QByteArray extraHeaderData;
-    QByteArray bitmapData;
+
+    // Pixel payload. Mutable so lazily loaded textures can fill it on first
+    // access through a const Texture (see Texture::ensureBitmapData).
+    mutable QByteArray bitmapData;
+
+    // Where the payload lives in the source file
+    qint64 dataOffset = -1;
+    uint32 dataSize = 0;
+};
+
+// ============================================================================
+// SOURCE RANGE (incremental saving)
+// ============================================================================
+
+// Absolute byte range a texture, material or top-level object was parsed
+// from. OpfWriter::writeIncremental() copies these bytes for records that
+// were not modified instead of encoding them again.
+struct SourceRange
+{
+    qint64 offset = -1;
+    qint64 size = 0;
+
+    bool isValid() const { return offset >= 0 && size > 0; }
+};
+
+// ============================================================================
+// TEXTURE DATA SOURCE (lazy texture loading)
+// ============================================================================
+
+// The .opf file that lazily loaded textures fetch their payloads from.
+// Shared by every texture of a project; reads are serialized.
+class TextureDataSource
+{
+public:
+    explicit TextureDataSource(const QString& filename) : m_file(filename) {}
+
+    QString fileName() const { return m_file.fileName(); }
+
+    QByteArray read(qint64 offset, qint64 size)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (!m_file.isOpen() && !m_file.open(QIODevice::ReadOnly))
+        {
+            return QByteArray();
+        }
+
+        if (!m_file.seek(offset))
+        {
+            return QByteArray();
+        }
+
+        QByteArray data = m_file.read(size);
+        if (data.size() != size)
+        {
+            return QByteArray();
+        }
+        return data;
+    }
+
+    // Releases the file handle, e.g. before the file is replaced. The
+    // file is opened again by the next read().
+    void close()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_file.close();
+    }
+
+private:
+    QFile m_file;
+    QMutex m_mutex;
+};
+
+// Monotonic counter used to order texture payload accesses (LRU eviction)
+inline quint64 nextTextureAccessTick()
+{
+    static std::atomic<quint64> tick(0);
+    return ++tick;
+}
+
+// A Texture's last access tick. Written by every thread that reads the
+// payloads, so it is atomic (relaxed: it only orders evictions), and
+// copyable so that textures stay copyable.
+class TextureAccessTick
+{
+public:
+    TextureAccessTick() = default;
+    TextureAccessTick(const TextureAccessTick& other) : m_value(other.load()) {}
+    TextureAccessTick& operator=(const TextureAccessTick& other)
+    {
+        store(other.load());
+        return *this;
+    }
+
+    quint64 load() const { return m_value.load(std::memory_order_relaxed); }
+    void store(quint64 value) { m_value.store(value, std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
 };
 
+// Guards loading, pinning and releasing a texture's payloads. Striped by
+// address: textures share a few mutexes, and a texture always uses the same.
+inline QMutex& texturePayloadMutex(const void* texture)
+{
+    static QMutex mutexes[16];
+    return mutexes[qHash(texture) % 16];
+}
+
 // ============================================================================
 // TEXTURE (from Outforce_Texture.h) - 100% COMPLETE
 // ============================================================================
@@ -403,13 +527,28 @@ struct Texture
     int alphaBitsPerPixel = 0;
     uint8 colorBitmapType = 0;
     uint8 alphaBitmapType = 0;
-    QByteArray colorData;
-    QByteArray alphaData;
+    mutable QByteArray colorData;
+    mutable QByteArray alphaData;
 
     // Full bitmap structures (for complete data preservation)
     Bitmap colorBitmap;
     Bitmap alphaBitmap;
 
+    // Lazy loading: when set, payloads stay in this file until first access.
+    // Mutable because loading and evicting do not change the texture itself.
+    mutable QSharedPointer<TextureDataSource> dataSource;
+    mutable TextureAccessTick lastAccess;
+
+    // TexturePayloadScopes holding the payloads, and whether the last one
+    // to go releases them. Guarded by texturePayloadMutex().
+    mutable int payloadPins = 0;
+    mutable bool releaseWhenUnpinned = false;
+
+    // Incremental saving: where the record came from, and whether it was
+    // edited since
+    SourceRange source;
+    bool modified = false;
+
     // Utility methods
     void clearBitmapData()
     {
@@ -419,10 +558,141 @@ struct Texture
         alphaBitmap.bitmapData.clear();
     }
 
+    // Resident payload bytes. colorData/alphaData normally share their buffer
+    // with the bitmap, so shared buffers are only counted once.
     size_t memoryUsage() const
     {
-        return colorData.size() + alphaData.size() + colorBitmap.bitmapData.size() + alphaBitmap.bitmapData.size();
+        size_t usage = colorBitmap.bitmapData.size() + alphaBitmap.bitmapData.size();
+        if (colorData.constData() != colorBitmap.bitmapData.constData())
+        {
+            usage += colorData.size();
+        }
+        if (alphaData.constData() != alphaBitmap.bitmapData.constData())
+        {
+            usage += alphaData.size();
+        }
+        return usage;
+    }
+
+    bool hasColorData() const
+    {
+        return !colorData.isEmpty() || (dataSource && colorBitmap.dataSize > 0);
+    }
+
+    bool hasAlphaData() const
+    {
+        return !alphaData.isEmpty() || (dataSource && alphaBitmap.dataSize > 0);
+    }
+
+    // Payload sizes, whether or not the payload is resident
+    qint64 colorDataSize() const { return colorData.isEmpty() ? colorBitmap.dataSize : colorData.size(); }
+    qint64 alphaDataSize() const { return alphaData.isEmpty() ? alphaBitmap.dataSize : alphaData.size(); }
+
+    bool isBitmapDataLoaded() const
+    {
+        bool colorLoaded = !hasColorChannel || colorBitmap.dataSize == 0 || !colorBitmap.bitmapData.isEmpty();
+        bool alphaLoaded = !hasAlphaChannel || alphaBitmap.dataSize == 0 || !alphaBitmap.bitmapData.isEmpty();
+        return colorLoaded && alphaLoaded;
+    }
+
+    // Fetches lazily loaded payloads from the source file. Returns false if
+    // the file could not be read. Not safe to call concurrently on the same
+    // texture; threads that share one use TexturePayloadScope.
+    bool ensureBitmapData() const
+    {
+        lastAccess.store(nextTextureAccessTick());
+
+        if (!dataSource || isBitmapDataLoaded())
+        {
+            return true;
+        }
+
+        if (hasColorChannel && colorBitmap.dataSize > 0 && colorBitmap.bitmapData.isEmpty())
+        {
+            colorBitmap.bitmapData = dataSource->read(colorBitmap.dataOffset, colorBitmap.dataSize);
+            if (colorBitmap.bitmapData.isEmpty())
+            {
+                return false;
+            }
+            colorData = colorBitmap.bitmapData;
+        }
+
+        if (hasAlphaChannel && alphaBitmap.dataSize > 0 && alphaBitmap.bitmapData.isEmpty())
+        {
+            alphaBitmap.bitmapData = dataSource->read(alphaBitmap.dataOffset, alphaBitmap.dataSize);
+            if (alphaBitmap.bitmapData.isEmpty())
+            {
+                return false;
+            }
+            alphaData = alphaBitmap.bitmapData;
+        }
+
+        return true;
+    }
+
+    // Drops payloads that can be fetched again from the source file.
+    // Eagerly loaded textures are left untouched.
+    void releaseBitmapData() const
+    {
+        if (!dataSource)
+        {
+            return;
+        }
+
+        colorData.clear();
+        alphaData.clear();
+        colorBitmap.bitmapData.clear();
+        alphaBitmap.bitmapData.clear();
+    }
+
+    // Loads everything and stops reading from the source file, e.g. before
+    // the file is overwritten
+    bool detachDataSource() const
+    {
+        if (!ensureBitmapData())
+        {
+            return false;
+        }
+        dataSource.reset();
+        return true;
+    }
+};
+
+// Makes a texture's payloads resident for the lifetime of the scope and
+// releases them again if they were not loaded before. Scopes on different
+// threads may share a texture: the payloads are loaded once and released
+// when the last scope ends.
+class TexturePayloadScope
+{
+public:
+    explicit TexturePayloadScope(const Texture& texture)
+        : m_texture(texture)
+    {
+        QMutexLocker locker(&texturePayloadMutex(&texture));
+        if (texture.payloadPins++ == 0)
+        {
+            texture.releaseWhenUnpinned = !texture.isBitmapDataLoaded();
+        }
+        m_loaded = texture.ensureBitmapData();
+    }
+
+    ~TexturePayloadScope()
+    {
+        QMutexLocker locker(&texturePayloadMutex(&m_texture));
+        if (--m_texture.payloadPins == 0 && m_texture.releaseWhenUnpinned)
+        {
+            m_texture.releaseBitmapData();
+        }
     }
+
+    bool isLoaded() const { return m_loaded; }
+
+    TexturePayloadScope(const TexturePayloadScope&) = delete;
+    TexturePayloadScope& operator=(const TexturePayloadScope&) = delete;
+
+private:
+    const Texture& m_texture;
+    bool m_loaded;
 };
 
 // ============================================================================
@@ -539,6 +809,11 @@ struct Material
     QVector<RenderPass1Stage> renderPasses1Stage;
     QVector<RenderPass2Stage> renderPasses2Stage;
     QVector<RenderPass3Stage> renderPasses3Stage;
+
+    // Incremental saving: where the record came from, and whether it was
+    // edited since
+    SourceRange source;
+    bool modified = false;
 };
 
 // ============================================================================
@@ -554,25 +829,155 @@ struct Vertex
     Vertex() = default;
 };
 
-struct VertexMorphTarget
+// ============================================================================
+// GEOMETRY POOL - contiguous structure-of-arrays mesh storage
+// ============================================================================
+//
+// All geometry of a project lives in a handful of flat arrays, one per
+// attribute. A mesh stores offsets into them: its vertex morph targets are
+// numVertexMorphs consecutive runs of morphSize positions (and normals),
+// and likewise for texture coordinates, colors and groups. Indices are one
+// run of indexCount values. Nothing is duplicated: Mesh::vertices() is a
+// view over morph target 0, not a copy.
+
+// Read-only view of 'size' consecutive elements
+template<typename T>
+class ArrayView
 {
-    QVector<Vertex> vertices;
-    QString name;
+public:
+    ArrayView() = default;
+    ArrayView(const T* data, int size) : m_data(data), m_size(size) {}
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    const T* constData() const { return m_data; }
+    const T& operator[](int i) const { return m_data[i]; }
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+
+private:
+    const T* m_data = nullptr;
+    int m_size = 0;
 };
 
-struct ColorMorphTarget
+class GeometryPool
 {
+public:
+    QVector<Vector3D> positions;
+    QVector<Vector3D> normals;      // parallel to positions
+    QVector<Vector2D> texCoords;
     QVector<Color> colors;
-};
+    QVector<uint8> groups;
+    QVector<uint16> indices;
 
-struct TextureMorphTarget
-{
-    QVector<Vector2D> textureCoordinates;
+    // Appends 'count' default-initialized elements and returns the offset
+    // of the first one
+    template<typename T>
+    static int32 allocate(QVector<T>& array, int32 count)
+    {
+        int32 offset = array.size();
+        array.resize(offset + count);
+        return offset;
+    }
+
+    int32 allocateVertices(int32 count)
+    {
+        normals.resize(positions.size() + count);
+        return allocate(positions, count);
+    }
+
+    // Offsets at which another pool's arrays were appended by append()
+    struct Offsets
+    {
+        int32 vertex = 0;
+        int32 texCoord = 0;
+        int32 color = 0;
+        int32 group = 0;
+        int32 index = 0;
+    };
+
+    Offsets append(const GeometryPool& other)
+    {
+        Offsets base;
+        base.vertex = positions.size();
+        base.texCoord = texCoords.size();
+        base.color = colors.size();
+        base.group = groups.size();
+        base.index = indices.size();
+
+        positions += other.positions;
+        normals += other.normals;
+        texCoords += other.texCoords;
+        colors += other.colors;
+        groups += other.groups;
+        indices += other.indices;
+        return base;
+    }
+
+    void squeeze()
+    {
+        positions.squeeze();
+        normals.squeeze();
+        texCoords.squeeze();
+        colors.squeeze();
+        groups.squeeze();
+        indices.squeeze();
+    }
+
+    size_t memoryUsage() const
+    {
+        return positions.size() * sizeof(Vector3D) + normals.size() * sizeof(Vector3D) + texCoords.size() * sizeof(Vector2D) + colors.size() * sizeof(Color) + groups.size() * sizeof(uint8) + indices.size() * sizeof(uint16);
+    }
 };
 
-struct GroupMorphTarget
+// Vertices assembled on the fly from positions, normals and (optional)
+// texture coordinates in a GeometryPool
+class VertexView
 {
-    QVector<uint8> groups;
+public:
+    VertexView() = default;
+    VertexView(const Vector3D* positions, const Vector3D* normals, const Vector2D* texCoords, int size) : m_positions(positions), m_normals(normals), m_texCoords(texCoords), m_size(size) {}
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    Vertex operator[](int i) const
+    {
+        Vertex v;
+        v.position = m_positions[i];
+        v.normal = m_normals[i];
+        if (m_texCoords)
+        {
+            v.texCoord = m_texCoords[i];
+        }
+        return v;
+    }
+
+    ArrayView<Vector3D> positions() const { return ArrayView<Vector3D>(m_positions, m_size); }
+    ArrayView<Vector3D> normals() const { return ArrayView<Vector3D>(m_normals, m_size); }
+    ArrayView<Vector2D> texCoords() const { return ArrayView<Vector2D>(m_texCoords, m_texCoords ? m_size : 0); }
+
+    class const_iterator
+    {
+    public:
+        const_iterator(const VertexView* view, int index) : m_view(view), m_index(index) {}
+        Vertex operator*() const { return (*m_view)[m_index]; }
+        const_iterator& operator++() { ++m_index; return *this; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+    private:
+        const VertexView* m_view;
+        int m_index;
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_size); }
+
+private:
+    const Vector3D* m_positions = nullptr;
+    const Vector3D* m_normals = nullptr;
+    const Vector2D* m_texCoords = nullptr;
+    int m_size = 0;
 };
 
 struct Mesh
@@ -594,12 +999,13 @@ struct Mesh
     Vector3D position;
     fp32 boundRadius = 0.0f;
 
-    // Morph data
+    // Morph data (each target holds morphSize elements in 'geometry')
     int32 morphSize = 0;
-    QVector<VertexMorphTarget> vertexMorphTargets;
-    QVector<ColorMorphTarget> colorMorphTargets;
-    QVector<TextureMorphTarget> textureMorphTargets;
-    QVector<GroupMorphTarget> groupMorphTargets;
+    int32 numVertexMorphs = 0;
+    int32 numColorMorphs = 0;
+    int32 numTextureMorphs = 0;
+    int32 numGroupMorphs = 0;
+    QVector<QString> vertexMorphNames;
 
     // Morph blend parameters
     int32 srcVertex = 0;
@@ -617,14 +1023,74 @@ struct Mesh
     EBufferType bufferType = EBufferType::Triangles;
     int32 numFaces = 0;
 
-    // Vertex and index data (simplified for export)
-    QVector<Vertex> vertices;
-    QVector<uint16> indices;
+    // Location of this mesh's data in 'geometry'
+    QSharedPointer<GeometryPool> geometry;
+    int32 vertexOffset = 0;
+    int32 texCoordOffset = 0;
+    int32 colorOffset = 0;
+    int32 groupOffset = 0;
+    int32 indexOffset = 0;
+    int32 indexCount = 0;
 
     // Legacy compatibility
     int primitiveType = 3;
 
     Mesh() = default;
+
+    // Vertex morph target 0 with texture morph target 0 as coordinates
+    int vertexCount() const { return numVertexMorphs > 0 ? qMax(morphSize, 0) : 0; }
+
+    VertexView vertices() const
+    {
+        int count = vertexCount();
+        if (!geometry || count == 0)
+        {
+            return VertexView();
+        }
+        const Vector2D* texCoords = numTextureMorphs > 0 ? geometry->texCoords.constData() + texCoordOffset : nullptr;
+        return VertexView(geometry->positions.constData() + vertexOffset, geometry->normals.constData() + vertexOffset, texCoords, count);
+    }
+
+    ArrayView<uint16> indices() const
+    {
+        return geometry ? ArrayView<uint16>(geometry->indices.constData() + indexOffset, indexCount) : ArrayView<uint16>();
+    }
+
+    ArrayView<Vector3D> morphPositions(int target) const
+    {
+        return morphRange(geometry ? geometry->positions.constData() : nullptr, vertexOffset, target, numVertexMorphs);
+    }
+
+    ArrayView<Vector3D> morphNormals(int target) const
+    {
+        return morphRange(geometry ? geometry->normals.constData() : nullptr, vertexOffset, target, numVertexMorphs);
+    }
+
+    ArrayView<Vector2D> morphTexCoords(int target) const
+    {
+        return morphRange(geometry ? geometry->texCoords.constData() : nullptr, texCoordOffset, target, numTextureMorphs);
+    }
+
+    ArrayView<Color> morphColors(int target) const
+    {
+        return morphRange(geometry ? geometry->colors.constData() : nullptr, colorOffset, target, numColorMorphs);
+    }
+
+    ArrayView<uint8> morphGroups(int target) const
+    {
+        return morphRange(geometry ? geometry->groups.constData() : nullptr, groupOffset, target, numGroupMorphs);
+    }
+
+private:
+    template<typename T>
+    ArrayView<T> morphRange(const T* data, int32 offset, int target, int32 targetCount) const
+    {
+        if (!data || target < 0 || target >= targetCount || morphSize <= 0)
+        {
+            return ArrayView<T>();
+        }
+        return ArrayView<T>(data + offset + target * morphSize, morphSize);
+    }
 };
 
 // ============================================================================
@@ -664,14 +1130,103 @@ struct ObjectTemplate
     QVector<Mesh> faceBuffers;
 };
 
+// ============================================================================
+// SUBTREE STATISTICS - cached totals of an object and its descendants
+// ============================================================================
+
+struct SubtreeStats
+{
+    int meshes = 0;
+    int vertices = 0;
+    int faces = 0;
+    int descendants = 0;
+
+    // Vertex positions of all meshes as stored (child transforms are not
+    // applied, as in the OBJ export); hasBounds is false without vertices
+    bool hasBounds = false;
+    Vector3D boundsMin;
+    Vector3D boundsMax;
+
+    void addBounds(const Vector3D& minimum, const Vector3D& maximum)
+    {
+        if (!hasBounds)
+        {
+            boundsMin = minimum;
+            boundsMax = maximum;
+            hasBounds = true;
+            return;
+        }
+        boundsMin = Vector3D(qMin(boundsMin.x, minimum.x), qMin(boundsMin.y, minimum.y), qMin(boundsMin.z, minimum.z));
+        boundsMax = Vector3D(qMax(boundsMax.x, maximum.x), qMax(boundsMax.y, maximum.y), qMax(boundsMax.z, maximum.z));
+    }
+};
+
 // ============================================================================
 // OBJECT (from Outforce_Object.h) - 100% COMPLETE
 // ============================================================================
 
+// ============================================================================
+// OBJECT CATEGORY - grouping of objects by class name
+// ============================================================================
+
+enum class ObjectCategory : uint8
+{
+    Units,
+    Buildings,
+    Weapons,
+    Projectiles,
+    Effects,
+    Environment,
+    Other
+};
+
+inline ObjectCategory objectCategoryOf(const QString& className)
+{
+    if (className.contains("Unit")) return ObjectCategory::Units;
+    if (className.contains("Base") || className.contains("Building")) return ObjectCategory::Buildings;
+    if (className.contains("Weapon")) return ObjectCategory::Weapons;
+    if (className.contains("Projectile")) return ObjectCategory::Projectiles;
+    if (className.contains("Effect")) return ObjectCategory::Effects;
+    if (className.contains("Environment") || className.contains("Env")) return ObjectCategory::Environment;
+    return ObjectCategory::Other;
+}
+
+inline QString objectCategoryName(ObjectCategory category)
+{
+    switch (category)
+    {
+    case ObjectCategory::Units: return "Units";
+    case ObjectCategory::Buildings: return "Buildings";
+    case ObjectCategory::Weapons: return "Weapons";
+    case ObjectCategory::Projectiles: return "Projectiles";
+    case ObjectCategory::Effects: return "Effects";
+    case ObjectCategory::Environment: return "Environment";
+    case ObjectCategory::Other: break;
+    }
+    return "Other";
+}
+
+// False if 'name' is not one of the objectCategoryName() values
+inline bool objectCategoryFromName(const QString& name, ObjectCategory& category)
+{
+    for (int i = 0; i <= int(ObjectCategory::Other); i++)
+    {
+        if (objectCategoryName(ObjectCategory(i)) == name)
+        {
+            category = ObjectCategory(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+struct PackedProject;
+
 struct Object
 {
     // Class and identification
     QString className;
+    uint32 classNameId = NameTable::kNoName;  // id in nameTable(), see setClassName()
     QString name;
     uint16 projectID = 0;
     int32 uniqueID = 0;
@@ -704,109 +1259,346 @@ struct Object
     // Hierarchy
     QVector<Object*> children;
 
-    // Convenience: direct mesh access (reference to objectTemplate.faceBuffers)
-    QVector<Mesh>& meshes() { return objectTemplate.faceBuffers; }
-    const QVector<Mesh>& meshes() const { return objectTemplate.faceBuffers; }
-
-    // Category helper
-    QString getCategory() const
+    // Allocated by an ObjectArena: never deleted individually, destroyed
+    // together with the arena
+    bool arenaAllocated = false;
+
+    // Incremental saving: where the record came from (top-level objects
+    // only), and whether this object itself was edited since. The setting
+    // mutators below and the PackedProject mutators set 'modified'; code
+    // that edits other fields directly sets it itself. The whole top-level
+    // subtree is then written again.
+    SourceRange source;
+    bool modified = false;
+
+    // ========================================================================
+    // SUBTREE STATISTICS
+    // ========================================================================
+    //
+    // Computed once per object from the children's cached values, so a whole
+    // tree costs one post-order pass (PackedProject::updateSubtreeStats() runs
+    // it at load). Call invalidateSubtreeStats() after changing meshes or
+    // children; it clears the cache of this object and its ancestors.
+
+    const SubtreeStats& subtreeStats() const
     {
-        if (className.contains("Unit")) return "Units";
-        if (className.contains("Base") || className.contains("Building")) return "Buildings";
-        if (className.contains("Weapon")) return "Weapons";
-        if (className.contains("Projectile")) return "Projectiles";
-        if (className.contains("Effect")) return "Effects";
-        if (className.contains("Environment") || className.contains("Env")) return "Environment";
-        return "Other";
+        if (!m_subtreeStatsValid)
+        {
+            updateSubtreeStats();
+        }
+        return m_subtreeStats;
     }
 
-    // Custom setting helpers
-    QString getCustomSetting(const QString& settingName) const
+    void updateSubtreeStats() const
     {
-        for (const auto& setting : customSettings)
+        SubtreeStats stats;
+        for (const Mesh& mesh : meshes())
         {
-            if (setting.name == settingName)
+            stats.meshes++;
+            stats.vertices += mesh.vertexCount();
+            stats.faces += mesh.indexCount / 3;
+
+            ArrayView<Vector3D> positions = mesh.vertices().positions();
+            if (!positions.isEmpty())
             {
-                return setting.value;
+                Vector3D minimum = positions[0];
+                Vector3D maximum = positions[0];
+                for (const Vector3D& p : positions)
+                {
+                    minimum = Vector3D(qMin(minimum.x, p.x), qMin(minimum.y, p.y), qMin(minimum.z, p.z));
+                    maximum = Vector3D(qMax(maximum.x, p.x), qMax(maximum.y, p.y), qMax(maximum.z, p.z));
+                }
+                stats.addBounds(minimum, maximum);
             }
         }
-        return QString();
-    }
 
-    void setCustomSetting(const QString& settingName, const QString& value)
-    {
-        for (auto& setting : customSettings)
+        for (const Object* child : children)
         {
-            if (setting.name == settingName)
+            if (!child)
+            {
+                continue;
+            }
+            child->m_parent = this;
+
+            const SubtreeStats& childStats = child->subtreeStats();
+            stats.meshes += childStats.meshes;
+            stats.vertices += childStats.vertices;
+            stats.faces += childStats.faces;
+            stats.descendants += 1 + childStats.descendants;
+            if (childStats.hasBounds)
             {
-                setting.value = value;
-                return;
+                stats.addBounds(childStats.boundsMin, childStats.boundsMax);
             }
         }
-        customSettings.append(CustomSetting(settingName, value));
+
+        m_subtreeStats = stats;
+        m_subtreeStatsValid = true;
     }
 
-    bool hasCustomSetting(const QString& settingName) const
+    void invalidateSubtreeStats() const
     {
-        for (const auto& setting : customSettings)
+        // An ancestor is only valid if all of its descendants are, so the
+        // walk can stop at the first one that is already invalid
+        for (const Object* object = this; object && object->m_subtreeStatsValid; object = object->m_parent)
         {
-            if (setting.name == settingName)
-            {
-                return true;
-            }
+            object->m_subtreeStatsValid = false;
         }
-        return false;
     }
 
-    void removeCustomSetting(const QString& settingName)
+    // Set by the statistics pass and the project mutators, nullptr for
+    // top-level objects
+    const Object* parentObject() const { return m_parent; }
+
+    // Convenience: direct mesh access (reference to objectTemplate.faceBuffers)
+    QVector<Mesh>& meshes() { return objectTemplate.faceBuffers; }
+    const QVector<Mesh>& meshes() const { return objectTemplate.faceBuffers; }
+
+    // Category helpers
+    ObjectCategory category() const
     {
-        for (int i = 0; i < customSettings.size(); ++i)
-        {
-            if (customSettings[i].name == settingName)
-            {
-                customSettings.removeAt(i);
-                return;
-            }
-        }
+        return objectCategoryOf(className);
     }
 
-    // CanBuildUnit specific helpers
-    QStringList getCanBuildUnits() const
+    QString getCategory() const
     {
-        QStringList units;
-        for (const auto& setting : customSettings)
-        {
-            if (setting.name == "CanBuildUnit")
-            {
-                units.append(setting.value);
-            }
-        }
-        return units;
+        return objectCategoryName(category());
     }
 
-    void addCanBuildUnit(const QString& unitName)
+    // Interns the class name
+    void setClassName(const QString& name)
     {
-        customSettings.append(CustomSetting("CanBuildUnit", unitName));
+        NameTable& table = names();
+        classNameId = table.intern(name);
+        className = table.name(classNameId);
     }
 
-    void removeCanBuildUnit(const QString& unitName)
+    // ========================================================================
+    // NAME TABLE
+    // ========================================================================
+    //
+    // Class and setting names are interned in the table of the project the
+    // object belongs to. Objects from a parser, the project cache or
+    // PackedProject::createObject() start out with it; any other object gets
+    // a table of its own on first use, and PackedProject::addObject() moves
+    // it over to the project's.
+
+    const QSharedPointer<NameTable>& nameTable() const { return m_names; }
+
+    // Interns the names of this object and its children in 'table'
+    void setNameTable(const QSharedPointer<NameTable>& table)
     {
-        for (int i = customSettings.size() - 1; i >= 0; --i)
+        if (m_names != table)
         {
-            if (customSettings[i].name == "CanBuildUnit" && customSettings[i].value == unitName)
+            m_names = table;
+            if (classNameId != NameTable::kNoName)
             {
-                customSettings.removeAt(i);
+                setClassName(className);
             }
+            for (CustomSetting& setting : customSettings)
+            {
+                setting.setName(setting.name, *m_names);
+            }
+            updateSettingsIndex();
         }
-    }
 
-    void clearCanBuildUnits()
+        for (Object* child : children)
+        {
+            if (child)
+            {
+                child->setNameTable(table);
+            }
+        }
+    }
+
+    // ========================================================================
+    // CUSTOM SETTINGS
+    // ========================================================================
+    //
+    // Names are compared as NameTable ids: a query hashes the name once, then
+    // scans the ids of an object with few settings or binary-searches a
+    // sorted position table for one with many. The *(uint32) overloads take
+    // an id from nameTable() and skip the hash as well. The mutators below
+    // keep the position table current and mark the object modified; call
+    // updateSettingsIndex() after adding, removing or renaming entries of
+    // customSettings directly.
+
+    QString getCustomSetting(const QString& settingName) const
+    {
+        return getCustomSetting(findName(settingName));
+    }
+
+    QString getCustomSetting(uint32 nameId) const
+    {
+        int pos = findSetting(nameId);
+        return pos >= 0 ? customSettings[pos].value : QString();
+    }
+
+    // Changes the first setting with this name, or adds one
+    void setCustomSetting(const QString& settingName, const QString& value)
+    {
+        int pos = findSetting(findName(settingName));
+        if (pos >= 0)
+        {
+            setCustomSettingValue(pos, value);
+            return;
+        }
+        addCustomSetting(settingName, value);
+    }
+
+    void setCustomSettingValue(int pos, const QString& value)
+    {
+        customSettings[pos].value = value;
+        modified = true;
+    }
+
+    // Appends a setting, even if one with this name exists
+    void addCustomSetting(const QString& settingName, const QString& value)
+    {
+        customSettings.append(CustomSetting(settingName, value, names()));
+        updateSettingsIndex();
+        modified = true;
+    }
+
+    void renameCustomSetting(int pos, const QString& settingName)
+    {
+        customSettings[pos].setName(settingName, names());
+        updateSettingsIndex();
+        modified = true;
+    }
+
+    bool hasCustomSetting(const QString& settingName) const
+    {
+        return hasCustomSetting(findName(settingName));
+    }
+
+    bool hasCustomSetting(uint32 nameId) const
+    {
+        return findSetting(nameId) >= 0;
+    }
+
+    void removeCustomSetting(const QString& settingName)
+    {
+        int pos = findSetting(findName(settingName));
+        if (pos >= 0)
+        {
+            removeCustomSettingAt(pos);
+        }
+    }
+
+    void removeCustomSettingAt(int pos)
+    {
+        customSettings.removeAt(pos);
+        updateSettingsIndex();
+        modified = true;
+    }
+
+    // CanBuildUnit specific helpers
+    QStringList getCanBuildUnits() const
+    {
+        QStringList units;
+        if (!isSettingsIndexed())
+        {
+            for (const CustomSetting& setting : customSettings)
+            {
+                if (setting.nameId == NameTable::kCanBuildUnit)
+                {
+                    units.append(setting.value);
+                }
+            }
+            return units;
+        }
+
+        for (auto it = firstIndexedSetting(NameTable::kCanBuildUnit);
+             it != m_settingsIndex.constEnd() && customSettings[*it].nameId == NameTable::kCanBuildUnit; ++it)
+        {
+            units.append(customSettings[*it].value);
+        }
+        return units;
+    }
+
+    bool canBuildUnits() const
+    {
+        return hasCustomSetting(NameTable::kCanBuildUnit);
+    }
+
+    void addCanBuildUnit(const QString& unitName)
+    {
+        addCustomSetting("CanBuildUnit", unitName);
+    }
+
+    void removeCanBuildUnit(const QString& unitName)
     {
         for (int i = customSettings.size() - 1; i >= 0; --i)
         {
-            if (customSettings[i].name == "CanBuildUnit")
+            if (customSettings[i].nameId == NameTable::kCanBuildUnit && customSettings[i].value == unitName)
             {
                 customSettings.removeAt(i);
+                modified = true;
+            }
+        }
+        updateSettingsIndex();
+    }
+
+    void clearCanBuildUnits()
+    {
+        for (int i = customSettings.size() - 1; i >= 0; --i)
+        {
+            if (customSettings[i].nameId == NameTable::kCanBuildUnit)
+            {
+                customSettings.removeAt(i);
+                modified = true;
+            }
+        }
+        updateSettingsIndex();
+    }
+
+    // Rebuilds the position table; small objects go without one
+    void updateSettingsIndex()
+    {
+        if (customSettings.size() <= kScannedSettings)
+        {
+            m_settingsIndex = QVector<quint32>();
+            return;
+        }
+
+        m_settingsIndex.resize(customSettings.size());
+        for (int i = 0; i < customSettings.size(); i++)
+        {
+            m_settingsIndex[i] = quint32(i);
+        }
+        // Equal names stay in order, so lookups find the first one
+        std::sort(m_settingsIndex.begin(), m_settingsIndex.end(), [this](quint32 a, quint32 b) {
+            uint32 nameA = customSettings[a].nameId;
+            uint32 nameB = customSettings[b].nameId;
+            return nameA < nameB || (nameA == nameB && a < b);
+        });
+    }
+
+    // True if this object or any of its children was edited
+    bool isSubtreeModified() const
+    {
+        if (modified)
+        {
+            return true;
+        }
+        for (const Object* child : children)
+        {
+            if (child && child->isSubtreeModified())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clearModified()
+    {
+        modified = false;
+        for (Object* child : children)
+        {
+            if (child)
+            {
+                child->clearModified();
             }
         }
     }
@@ -814,8 +1606,171 @@ struct Object
     // Destructor
     ~Object()
     {
-        qDeleteAll(children);
+        for (Object* child : children)
+        {
+            if (child && !child->arenaAllocated)
+            {
+                delete child;
+            }
+        }
     }
+
+private:
+    friend struct PackedProject;
+
+    mutable SubtreeStats m_subtreeStats;
+    mutable bool m_subtreeStatsValid = false;
+    mutable const Object* m_parent = nullptr;
+
+    QSharedPointer<NameTable> m_names;
+
+    // Positions in customSettings ordered by name id, for objects with more
+    // than kScannedSettings settings
+    static const int kScannedSettings = 8;
+    QVector<quint32> m_settingsIndex;
+
+    NameTable& names()
+    {
+        if (!m_names)
+        {
+            m_names = QSharedPointer<NameTable>::create();
+        }
+        return *m_names;
+    }
+
+    uint32 findName(const QString& name) const
+    {
+        return m_names ? m_names->find(name) : NameTable::kNoName;
+    }
+
+    bool isSettingsIndexed() const
+    {
+        return !m_settingsIndex.isEmpty() && m_settingsIndex.size() == customSettings.size();
+    }
+
+    QVector<quint32>::const_iterator firstIndexedSetting(uint32 nameId) const
+    {
+        return std::lower_bound(m_settingsIndex.constBegin(), m_settingsIndex.constEnd(), nameId, [this](quint32 pos, uint32 id) {
+            return customSettings[pos].nameId < id;
+        });
+    }
+
+    // Position of the first setting with this name id, or -1
+    int findSetting(uint32 nameId) const
+    {
+        if (nameId == NameTable::kNoName)
+        {
+            return -1;
+        }
+
+        if (!isSettingsIndexed())
+        {
+            for (int i = 0; i < customSettings.size(); i++)
+            {
+                if (customSettings[i].nameId == nameId)
+                {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        auto it = firstIndexedSetting(nameId);
+        if (it == m_settingsIndex.constEnd() || customSettings[*it].nameId != nameId)
+        {
+            return -1;
+        }
+        return int(*it);
+    }
+};
+
+// ============================================================================
+// OBJECT ARENA - chunked storage for a project's object trees
+// ============================================================================
+//
+// Objects are constructed in place in large chunks instead of one heap
+// block each, so loading does a few hundred allocations instead of tens of
+// thousands and closing destroys chunk by chunk without walking the trees.
+// Object::children still holds plain pointers, so the Object* API works
+// unchanged. Heap-allocated objects may be mixed in (they are deleted by
+// their parent or the project as before).
+
+class ObjectArena
+{
+public:
+    ObjectArena() = default;
+
+    ~ObjectArena()
+    {
+        // Unlink arena children first so destruction order does not matter;
+        // heap children are still deleted by their parent
+        for (Chunk* chunk : m_chunks)
+        {
+            Object* objects = chunk->objects();
+            for (int i = 0; i < chunk->used; i++)
+            {
+                QVector<Object*>& children = objects[i].children;
+                children.erase(std::remove_if(children.begin(), children.end(), [](const Object* child) {
+                    return child && child->arenaAllocated;
+                }), children.end());
+            }
+        }
+
+        for (Chunk* chunk : m_chunks)
+        {
+            Object* objects = chunk->objects();
+            for (int i = 0; i < chunk->used; i++)
+            {
+                objects[i].~Object();
+            }
+            delete chunk;
+        }
+    }
+
+    Object* create()
+    {
+        if (m_chunks.isEmpty() || m_chunks.last()->used == kChunkObjects)
+        {
+            m_chunks.append(new Chunk());
+        }
+
+        Chunk* chunk = m_chunks.last();
+        Object* object = new (chunk->objects() + chunk->used) Object();
+        chunk->used++;
+        m_objectCount++;
+
+        object->arenaAllocated = true;
+        return object;
+    }
+
+    // Takes over all objects of 'other' (used to combine per-thread arenas)
+    void merge(ObjectArena& other)
+    {
+        m_chunks += other.m_chunks;
+        m_objectCount += other.m_objectCount;
+
+        other.m_chunks.clear();
+        other.m_objectCount = 0;
+    }
+
+    int objectCount() const { return m_objectCount; }
+
+    ObjectArena(const ObjectArena&) = delete;
+    ObjectArena& operator=(const ObjectArena&) = delete;
+
+private:
+    static const int kChunkObjects = 256;
+
+    struct Chunk
+    {
+        alignas(Object) unsigned char storage[sizeof(Object) * kChunkObjects];
+        int used = 0;
+
+        Object* objects() { return reinterpret_cast<Object*>(storage); }
+    };
+
+    QVector<Chunk*> m_chunks;
+    int m_objectCount = 0;
 };
 
 // ============================================================================
@@ -846,83 +1801,354 @@ struct PackedProject {
     QVector<Material> materials;
     QVector<Object*> objects;
 
+    // Mesh geometry of all objects (see GeometryPool)
+    QSharedPointer<GeometryPool> geometry;
+
+    // Backing storage of arena-allocated objects, if any (see ObjectArena)
+    QScopedPointer<ObjectArena> objectArena;
+
+    // Class and setting names of the objects (see Object::nameTable())
+    QSharedPointer<NameTable> names = QSharedPointer<NameTable>::create();
+
+    // File the records' source ranges refer to, with its size and
+    // modification time (ms since epoch) when it was read. Empty if there is
+    // nothing to copy from, e.g. after a parse that hit a truncated file.
+    QString sourceFile;
+    qint64 sourceSize = 0;
+    qint64 sourceModified = 0;
+
     // Destructor
     ~PackedProject()
     {
-        qDeleteAll(objects);
+        clearObjects();
     }
 
-    // Helper methods
-    Object* findObjectByName(const QString& name) const
+    // Computes the statistics of every object not cached yet in one
+    // post-order pass (see Object::subtreeStats()). Done at load, and before
+    // reading them from several threads.
+    void updateSubtreeStats() const
     {
-        for (Object* obj : objects)
+        for (const Object* obj : objects)
         {
-            if (obj && obj->name == name)
+            if (obj)
             {
-                return obj;
+                obj->subtreeStats();
             }
         }
-        return nullptr;
     }
 
-    Object* findObjectByID(int32 uniqueID) const
+    // New object in the project's arena, or on the heap if it has none
+    Object* createObject()
     {
-        for (Object* obj : objects)
+        Object* object = objectArena ? objectArena->create() : new Object();
+        object->setNameTable(names);
+        return object;
+    }
+
+    // True if any texture, material or object was edited since the
+    // project was read or last saved incrementally
+    bool hasModifiedRecords() const
+    {
+        for (const Texture& tex : textures)
         {
-            if (obj && obj->uniqueID == uniqueID)
+            if (tex.modified)
             {
-                return obj;
+                return true;
             }
         }
-        return nullptr;
+        for (const Material& mat : materials)
+        {
+            if (mat.modified)
+            {
+                return true;
+            }
+        }
+        for (const Object* obj : objects)
+        {
+            if (obj && obj->isSubtreeModified())
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
-    const Texture* findTextureByID(int32 id) const
+    void clearModified()
     {
-        for (const auto& tex : textures)
+        for (Texture& tex : textures)
+        {
+            tex.modified = false;
+        }
+        for (Material& mat : materials)
         {
-            if (tex.id == id)
+            mat.modified = false;
+        }
+        for (Object* obj : objects)
+        {
+            if (obj)
             {
-                return &tex;
+                obj->clearModified();
             }
         }
-        return nullptr;
     }
 
-    Texture* findTextureByID(int32 id)
+    // Destroys all objects and the arena
+    void clearObjects()
     {
-        for (auto& tex : textures)
+        for (Object* obj : objects)
         {
-            if (tex.id == id)
+            if (obj && !obj->arenaAllocated)
             {
-                return &tex;
+                delete obj;
             }
         }
-        return nullptr;
+        objects.clear();
+        objectArena.reset();
+        invalidateIndex();
+    }
+
+    // ========================================================================
+    // LOOKUP INDEX
+    // ========================================================================
+    //
+    // Hash maps from object uniqueID/name (top-level objects and all nested
+    // children) and texture/material id to the record. Built on first lookup
+    // or by rebuildIndex(). Top-level objects win over children, and earlier
+    // entries over later ones, matching the original linear scans.
+    //
+    // The mutators below drop the index; code that edits the asset lists,
+    // ids or names directly must call invalidateIndex() before the next
+    // lookup. Once built, lookups only read the hash maps and take no lock,
+    // so any number of threads may query a project nobody is editing.
+
+    Object* findObjectByName(const QString& name) const
+    {
+        ensureIndex();
+        return m_objectsByName.value(name, nullptr);
+    }
+
+    Object* findObjectByID(int32 uniqueID) const
+    {
+        ensureIndex();
+        return m_objectsByID.value(uniqueID, nullptr);
+    }
+
+    const Texture* findTextureByID(int32 id) const
+    {
+        int index = textureIndexOf(id);
+        return index >= 0 ? &textures[index] : nullptr;
+    }
+
+    Texture* findTextureByID(int32 id)
+    {
+        int index = textureIndexOf(id);
+        return index >= 0 ? &textures[index] : nullptr;
     }
 
     const Material* findMaterialByID(int32 id) const
     {
-        for (const auto& mat : materials)
+        int index = materialIndexOf(id);
+        return index >= 0 ? &materials[index] : nullptr;
+    }
+
+    Material* findMaterialByID(int32 id)
+    {
+        int index = materialIndexOf(id);
+        return index >= 0 ? &materials[index] : nullptr;
+    }
+
+    // Position in 'textures' / 'materials', or -1
+    int textureIndexOf(int32 id) const
+    {
+        ensureIndex();
+        return m_textureIndex.value(id, -1);
+    }
+
+    int materialIndexOf(int32 id) const
+    {
+        ensureIndex();
+        return m_materialIndex.value(id, -1);
+    }
+
+    // Builds the index now, e.g. after loading; not while others look up
+    void rebuildIndex() const
+    {
+        QMutexLocker locker(&m_indexMutex);
+        buildIndex();
+    }
+
+    void invalidateIndex() const
+    {
+        m_indexValid.store(false, std::memory_order_release);
+    }
+
+    // ========================================================================
+    // MUTATORS (keep the lookup index in sync)
+    // ========================================================================
+    //
+    // Added, renamed and edited records are marked modified, and so is the
+    // parent an object is added to or taken from, so an incremental save
+    // writes them again.
+
+    // Takes ownership of a heap or createObject() object.
+    // 'parent' = nullptr adds a top-level object.
+    void addObject(Object* object, Object* parent = nullptr)
+    {
+        object->setNameTable(names);
+        object->modified = true;
+        if (parent)
         {
-            if (mat.id == id)
-            {
-                return &mat;
-            }
+            parent->children.append(object);
+            parent->invalidateSubtreeStats();
+            parent->modified = true;
+            object->m_parent = parent;
         }
-        return nullptr;
+        else
+        {
+            objects.append(object);
+        }
+        invalidateIndex();
     }
 
-    Material* findMaterialByID(int32 id)
+    // Detaches 'object' (top-level or nested) without deleting it.
+    // Returns false if it is not part of this project. Arena-allocated
+    // objects stay valid until the project is cleared.
+    bool takeObject(Object* object)
+    {
+        bool found = objects.removeOne(object);
+        for (int i = 0; !found && i < objects.size(); i++)
+        {
+            found = objects[i] && takeChild(*objects[i], object);
+        }
+
+        if (found)
+        {
+            invalidateIndex();
+        }
+        return found;
+    }
+
+    void renameObject(Object* object, const QString& name)
+    {
+        object->name = name;
+        object->modified = true;
+        invalidateIndex();
+    }
+
+    void addTexture(const Texture& texture)
+    {
+        textures.append(texture);
+        textures.last().modified = true;
+        invalidateIndex();
+    }
+
+    // For editing a texture or material in place; nullptr if there is no
+    // such record. Call invalidateIndex() after changing its id.
+    Texture* editTexture(int32 id)
     {
-        for (auto& mat : materials)
+        Texture* texture = findTextureByID(id);
+        if (texture)
         {
-            if (mat.id == id)
+            texture->modified = true;
+        }
+        return texture;
+    }
+
+    Material* editMaterial(int32 id)
+    {
+        Material* material = findMaterialByID(id);
+        if (material)
+        {
+            material->modified = true;
+        }
+        return material;
+    }
+
+    bool removeTextureByID(int32 id)
+    {
+        int index = textureIndexOf(id);
+        if (index < 0)
+        {
+            return false;
+        }
+        textures.removeAt(index);
+        invalidateIndex();
+        return true;
+    }
+
+    void addMaterial(const Material& material)
+    {
+        materials.append(material);
+        materials.last().modified = true;
+        invalidateIndex();
+    }
+
+    bool removeMaterialByID(int32 id)
+    {
+        int index = materialIndexOf(id);
+        if (index < 0)
+        {
+            return false;
+        }
+        materials.removeAt(index);
+        invalidateIndex();
+        return true;
+    }
+
+    // Resident texture payload bytes
+    size_t textureMemoryUsage() const
+    {
+        size_t total = 0;
+        for (const auto& tex : textures)
+        {
+            QMutexLocker locker(&texturePayloadMutex(&tex));
+            total += tex.memoryUsage();
+        }
+        return total;
+    }
+
+    // Releases lazily loaded texture payloads, least recently used first,
+    // until the resident total fits in budgetBytes. 'keep' is never evicted.
+    // Returns the number of bytes freed.
+    size_t enforceTextureMemoryBudget(size_t budgetBytes, const Texture* keep = nullptr)
+    {
+        size_t total = textureMemoryUsage();
+        if (total <= budgetBytes)
+        {
+            return 0;
+        }
+
+        // Textures in use by a TexturePayloadScope (e.g. an export job) stay
+        QVector<const Texture*> candidates;
+        for (const auto& tex : std::as_const(textures))
+        {
+            QMutexLocker locker(&texturePayloadMutex(&tex));
+            if (&tex != keep && tex.dataSource && tex.payloadPins == 0 && tex.memoryUsage() > 0)
+            {
+                candidates.append(&tex);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Texture* a, const Texture* b) {
+            return a->lastAccess.load() < b->lastAccess.load();
+        });
+
+        size_t freed = 0;
+        for (const Texture* tex : candidates)
+        {
+            if (total - freed <= budgetBytes)
+            {
+                break;
+            }
+            QMutexLocker locker(&texturePayloadMutex(tex));
+            if (tex->payloadPins > 0)
             {
-                return &mat;
+                continue;
             }
+            freed += tex->memoryUsage();
+            tex->releaseBitmapData();
         }
-        return nullptr;
+        return freed;
     }
 
     // Get all objects that can build units
@@ -931,7 +2157,7 @@ struct PackedProject {
         QVector<Object*> result;
         for (Object* obj : objects)
         {
-            if (obj && !obj->getCanBuildUnits().isEmpty())
+            if (obj && obj->canBuildUnits())
             {
                 result.append(obj);
             }
@@ -942,10 +2168,22 @@ struct PackedProject {
     // Get all unit names (for CanBuildUnit dropdown)
     QStringList getAllUnitNames() const
     {
+        // Class names are interned, so each distinct one is checked once
+        QHash<uint32, bool> isUnitClass;
         QStringList names;
         for (Object* obj : objects)
         {
-            if (obj && obj->className.contains("Unit"))
+            if (!obj)
+            {
+                continue;
+            }
+
+            auto it = isUnitClass.constFind(obj->classNameId);
+            if (it == isUnitClass.constEnd() || obj->classNameId == NameTable::kNoName)
+            {
+                it = isUnitClass.insert(obj->classNameId, obj->className.contains("Unit"));
+            }
+            if (it.value())
             {
                 names.append(obj->name);
             }
@@ -968,6 +2206,112 @@ struct PackedProject {
         names.sort();
         return names;
     }
+
+private:
+    // Serializes building; lookups of a built index only check m_indexValid
+    mutable QMutex m_indexMutex;
+    mutable std::atomic<bool> m_indexValid{false};
+    mutable QHash<int32, Object*> m_objectsByID;
+    mutable QHash<QString, Object*> m_objectsByName;
+    mutable QHash<int32, int> m_textureIndex;
+    mutable QHash<int32, int> m_materialIndex;
+
+    void ensureIndex() const
+    {
+        if (m_indexValid.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        QMutexLocker locker(&m_indexMutex);
+        if (!m_indexValid.load(std::memory_order_relaxed))
+        {
+            buildIndex();
+        }
+    }
+
+    // Caller holds m_indexMutex
+    void buildIndex() const
+    {
+        m_objectsByID.clear();
+        m_objectsByName.clear();
+        m_textureIndex.clear();
+        m_materialIndex.clear();
+
+        m_objectsByID.reserve(objects.size());
+        m_objectsByName.reserve(objects.size());
+        m_textureIndex.reserve(textures.size());
+        m_materialIndex.reserve(materials.size());
+
+        // Reverse order so the first occurrence of an id/name wins
+        for (int i = objects.size() - 1; i >= 0; --i)
+        {
+            if (objects[i])
+            {
+                m_objectsByID.insert(objects[i]->uniqueID, objects[i]);
+                m_objectsByName.insert(objects[i]->name, objects[i]);
+            }
+        }
+
+        for (const Object* obj : objects)
+        {
+            if (obj)
+            {
+                indexChildren(*obj);
+            }
+        }
+
+        for (int i = textures.size() - 1; i >= 0; --i)
+        {
+            m_textureIndex.insert(textures[i].id, i);
+        }
+        for (int i = materials.size() - 1; i >= 0; --i)
+        {
+            m_materialIndex.insert(materials[i].id, i);
+        }
+
+        m_indexValid.store(true, std::memory_order_release);
+    }
+
+    // Children of 'object', depth-first, without overriding existing entries
+    void indexChildren(const Object& object) const
+    {
+        for (Object* child : object.children)
+        {
+            if (!child)
+            {
+                continue;
+            }
+            if (!m_objectsByID.contains(child->uniqueID))
+            {
+                m_objectsByID.insert(child->uniqueID, child);
+            }
+            if (!m_objectsByName.contains(child->name))
+            {
+                m_objectsByName.insert(child->name, child);
+            }
+            indexChildren(*child);
+        }
+    }
+
+    static bool takeChild(Object& parent, Object* object)
+    {
+        if (parent.children.removeOne(object))
+        {
+            parent.invalidateSubtreeStats();
+            parent.modified = true;
+            object->m_parent = nullptr;
+            return true;
+        }
+        for (Object* child : parent.children)
+        {
+            if (child && takeChild(*child, object))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
 };
 
 } // namespace Opf
@@ -0,0 +1,40 @@
+#ifndef OPFVISITOR_H
+#define OPFVISITOR_H
+
+#include "OpfStructs.h"
+
+namespace Opf {
+
+// ============================================================================
+// OPF VISITOR - callbacks for OpfParser::parseStreaming
+// ============================================================================
+//
+// Records are handed over in file order as soon as they are decoded, and
+// nothing is accumulated by the parser. Texture and material records are
+// destroyed when the callback returns (copy what you need). Object
+// subtrees are passed by pointer and owned by the visitor from then on.
+//
+// Returning false from a callback stops parsing.
+
+class OpfVisitor
+{
+public:
+    virtual ~OpfVisitor() = default;
+
+    // Project info and dependencies. Asset lists of 'header' are empty.
+    virtual bool visitHeader(const PackedProject& header) { Q_UNUSED(header); return true; }
+
+    virtual bool visitEventDesc(const EventDesc& event) { Q_UNUSED(event); return true; }
+    virtual bool visitTexture(const Texture& texture) { Q_UNUSED(texture); return true; }
+    virtual bool visitMaterial(const Material& material) { Q_UNUSED(material); return true; }
+
+    // Takes ownership of 'object' (and its children)
+    virtual bool visitObject(Object* object) { delete object; return true; }
+
+    // Called once after the last record of a successful parse
+    virtual void visitEnd() {}
+};
+
+} // namespace Opf
+
+#endif // OPFVISITOR_H
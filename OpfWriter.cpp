@@ -1,29 +1,244 @@
 #include "OpfWriter.h"
+#include "BackupStore.h"
 #include <QFileInfo>
 #include <QDir>
 #include <QDateTime>
 #include <QDebug>
+#include <type_traits>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
 
 namespace Opf {
 
+namespace {
+// Buffered bytes are handed to the file once this much has accumulated;
+// payloads at least this large bypass the buffer
+const int kFlushThreshold = 4 * 1024 * 1024;
+
+// Block size for copies from the source file when the kernel cannot copy
+// for us
+const qint64 kCopyBlockSize = 8 * 1024 * 1024;
+
+bool isSameFile(const QString& a, const QString& b)
+{
+    QString canonicalA = QFileInfo(a).canonicalFilePath();
+    return !canonicalA.isEmpty() && canonicalA == QFileInfo(b).canonicalFilePath();
+}
+}
+
 OpfWriter::OpfWriter()
+    : m_bytesWritten(0), m_failed(false), m_sourceSize(0), m_copiedRecords(0), m_encodedRecords(0)
 {
 }
 
+// Little-endian raw bytes, identical to QDataStream with LittleEndian byte
+// order and SinglePrecision floats on the (little-endian) targets we build
 template<typename T>
 void OpfWriter::writeValue(T value)
 {
-    m_stream << value;
+    static_assert(std::is_trivially_copyable<T>::value, "writeValue needs a trivially copyable type");
+    m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    if (m_buffer.size() >= kFlushThreshold)
+    {
+        flush();
+    }
 }
 
 void OpfWriter::writeBytes(const char* data, qint64 size)
 {
-    m_file.write(data, size);
+    if (size <= 0)
+    {
+        return;
+    }
+
+    if (size >= kFlushThreshold)
+    {
+        // Large payloads (texture bitmaps) go straight to the file
+        flush();
+        if (!m_failed && m_file.write(data, size) != size)
+        {
+            m_failed = true;
+        }
+        m_bytesWritten += size;
+        return;
+    }
+
+    m_buffer.append(data, size);
+    if (m_buffer.size() >= kFlushThreshold)
+    {
+        flush();
+    }
 }
 
 void OpfWriter::writeBytes(const QByteArray& data)
 {
-    m_file.write(data);
+    writeBytes(data.constData(), data.size());
+}
+
+bool OpfWriter::flush()
+{
+    if (!m_buffer.isEmpty())
+    {
+        if (!m_failed && m_file.write(m_buffer) != m_buffer.size())
+        {
+            m_failed = true;
+        }
+        m_bytesWritten += m_buffer.size();
+        m_buffer.resize(0);
+    }
+    return !m_failed;
+}
+
+bool OpfWriter::sectionDone()
+{
+    if (!flushCopy() || !flush())
+    {
+        if (m_lastError.isEmpty())
+        {
+            m_lastError = QString("Write error: %1").arg(m_file.errorString());
+        }
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// SOURCE COPIES
+// ============================================================================
+
+bool OpfWriter::openSource(const PackedProject& project)
+{
+    m_source.close();
+    m_sourceSize = 0;
+
+    if (project.sourceFile.isEmpty())
+    {
+        return false;
+    }
+
+    // Offsets are only meaningful for the exact file they were recorded in
+    QFileInfo info(project.sourceFile);
+    if (!info.exists() || info.size() != project.sourceSize ||
+        info.lastModified().toMSecsSinceEpoch() != project.sourceModified)
+    {
+        qDebug() << "Source file changed since it was read:" << project.sourceFile;
+        return false;
+    }
+
+    m_source.setFileName(project.sourceFile);
+    if (!m_source.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    m_sourceSize = m_source.size();
+    return true;
+}
+
+bool OpfWriter::canCopy(const SourceRange& range) const
+{
+    return m_source.isOpen() && range.isValid() && range.offset + range.size <= m_sourceSize;
+}
+
+qint64 OpfWriter::outputPosition() const
+{
+    qint64 pending = m_pendingCopy.isValid() ? m_pendingCopy.size : 0;
+    return m_bytesWritten + m_buffer.size() + pending;
+}
+
+void OpfWriter::copyRecord(const SourceRange& range, QVector<SourceRange>& outputRanges)
+{
+    outputRanges.append(SourceRange{ outputPosition(), range.size });
+    m_copiedRecords++;
+
+    if (m_pendingCopy.isValid() && m_pendingCopy.offset + m_pendingCopy.size == range.offset)
+    {
+        m_pendingCopy.size += range.size;
+        return;
+    }
+
+    flushCopy();
+    m_pendingCopy = range;
+}
+
+bool OpfWriter::flushCopy()
+{
+    if (!m_pendingCopy.isValid())
+    {
+        return !m_failed;
+    }
+
+    SourceRange range = m_pendingCopy;
+    m_pendingCopy = SourceRange();
+
+    if (!flush())
+    {
+        return false;
+    }
+
+    if (!m_failed && !copyFromSource(range.offset, range.size))
+    {
+        m_failed = true;
+    }
+    return !m_failed;
+}
+
+bool OpfWriter::copyFromSource(qint64 offset, qint64 size)
+{
+#ifdef Q_OS_LINUX
+    // In-kernel copy (reflinked on filesystems that support it). Explicit
+    // offsets leave both file positions alone, so the output is re-synced
+    // with seek() afterwards.
+    loff_t in = offset;
+    loff_t out = m_bytesWritten;
+    while (size > 0)
+    {
+        ssize_t copied = ::copy_file_range(m_source.handle(), &in, m_file.handle(), &out, size_t(size), 0);
+        if (copied <= 0)
+        {
+            break;
+        }
+        size -= copied;
+    }
+
+    offset = in;
+    m_bytesWritten = out;
+    if (!m_file.seek(m_bytesWritten))
+    {
+        m_lastError = QString("Write error: %1").arg(m_file.errorString());
+        return false;
+    }
+#endif
+
+    // Whatever the kernel did not copy (unsupported, cross-device, ...)
+    if (size > 0 && !m_source.seek(offset))
+    {
+        m_lastError = QString("Cannot read %1: %2").arg(m_source.fileName(), m_source.errorString());
+        return false;
+    }
+
+    QByteArray block;
+    while (size > 0)
+    {
+        qint64 chunk = qMin(size, kCopyBlockSize);
+        block.resize(int(chunk));
+        if (m_source.read(block.data(), chunk) != chunk)
+        {
+            m_lastError = QString("Cannot read %1: %2").arg(m_source.fileName(), m_source.errorString());
+            return false;
+        }
+        if (m_file.write(block) != chunk)
+        {
+            m_lastError = QString("Write error: %1").arg(m_file.errorString());
+            return false;
+        }
+        m_bytesWritten += chunk;
+        size -= chunk;
+    }
+
+    return true;
 }
 
 void OpfWriter::writeOutforceString(const QString& str)
@@ -80,84 +295,225 @@ void OpfWriter::writeColorValue(const ColorValue& c)
 
 bool OpfWriter::write(const QString& filename, const PackedProject& project)
 {
-    m_file.setFileName(filename);
-
-    if (!m_file.open(QIODevice::WriteOnly))
+    if (!detachTextureSources(filename, project))
     {
-        m_lastError = QString("Cannot open file for writing: %1").arg(filename);
         return false;
     }
 
-    m_stream.setDevice(&m_file);
-    m_stream.setByteOrder(QDataStream::LittleEndian);
-    m_stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    m_source.close();
+    if (!openTarget(filename))
+    {
+        return false;
+    }
 
     qDebug() << "Writing OPF file:" << filename;
 
-    if (!writeProjectHeader(project))
+    bool success = writeProjectHeader(project) &&
+                   writeDependencies(project.dependencies) &&
+                   writeEventDescs(project.eventDescs) &&
+                   writeTextures(project.textures) &&
+                   writeMaterials(project.materials) &&
+                   writeObjects(project.objects);
+
+    if (!finishTarget(filename, success))
     {
-        m_file.close();
         return false;
     }
 
-    if (!writeDependencies(project.dependencies))
+    qDebug() << "Successfully wrote OPF file:" << m_bytesWritten << "bytes";
+    return true;
+}
+
+bool OpfWriter::writeIncremental(const QString& filename, PackedProject& project)
+{
+    if (!openSource(project))
     {
-        m_file.close();
-        return false;
+        qDebug() << "No usable source file, writing the whole project";
+        return write(filename, project);
     }
 
-    if (!writeEventDescs(project.eventDescs))
+    // Lazily loaded textures that read from the file being replaced: the
+    // ones copied verbatim keep reading from it (at their new offsets, see
+    // below), all others must be loaded now
+    bool inPlace = isSameFile(filename, project.sourceFile);
+    QString target = QFileInfo(filename).canonicalFilePath();
+    QVector<bool> readsTarget(project.textures.size(), false);
+    for (int i = 0; i < project.textures.size(); i++)
     {
-        m_file.close();
-        return false;
+        const Texture& tex = project.textures[i];
+        if (!tex.dataSource || !isSameFile(tex.dataSource->fileName(), target))
+        {
+            continue;
+        }
+        if (inPlace && !tex.modified && canCopy(tex.source))
+        {
+            readsTarget[i] = true;
+            continue;
+        }
+        if (!tex.detachDataSource())
+        {
+            m_lastError = QString("Cannot read texture data for '%1' from %2").arg(tex.name, filename);
+            m_source.close();
+            return false;
+        }
     }
 
-    if (!writeTextures(project.textures))
+    if (!openTarget(filename))
     {
-        m_file.close();
+        m_source.close();
         return false;
     }
 
-    if (!writeMaterials(project.materials))
+    qDebug() << "Writing OPF file incrementally:" << filename << "from" << project.sourceFile;
+
+    bool success = writeProjectHeader(project) &&
+                   writeDependencies(project.dependencies) &&
+                   writeEventDescs(project.eventDescs) &&
+                   writeTextures(project.textures) &&
+                   writeMaterials(project.materials) &&
+                   writeObjects(project.objects);
+
+    // No handles may stay open on the file we are about to replace
+    m_source.close();
+    for (int i = 0; i < project.textures.size(); i++)
+    {
+        if (readsTarget[i])
+        {
+            project.textures[i].dataSource->close();
+        }
+    }
+
+    if (!finishTarget(filename, success))
     {
-        m_file.close();
         return false;
     }
 
-    if (!writeObjects(project.objects))
+    // The project now describes the new file
+    for (int i = 0; i < project.textures.size(); i++)
     {
-        m_file.close();
-        return false;
+        Texture& tex = project.textures[i];
+        if (readsTarget[i])
+        {
+            qint64 delta = m_textureRanges[i].offset - tex.source.offset;
+            if (tex.colorBitmap.dataOffset >= 0)
+            {
+                tex.colorBitmap.dataOffset += delta;
+            }
+            if (tex.alphaBitmap.dataOffset >= 0)
+            {
+                tex.alphaBitmap.dataOffset += delta;
+            }
+        }
+        tex.source = m_textureRanges[i];
+    }
+    for (int i = 0; i < project.materials.size(); i++)
+    {
+        project.materials[i].source = m_materialRanges[i];
     }
+    for (int i = 0; i < project.objects.size(); i++)
+    {
+        if (project.objects[i])
+        {
+            project.objects[i]->source = m_objectRanges[i];
+        }
+    }
+    project.clearModified();
+
+    QFileInfo info(filename);
+    project.sourceFile = info.absoluteFilePath();
+    project.sourceSize = m_bytesWritten;
+    project.sourceModified = info.lastModified().toMSecsSinceEpoch();
+
+    qDebug() << "Successfully wrote OPF file:" << m_bytesWritten << "bytes," << m_copiedRecords << "records copied," << m_encodedRecords << "encoded";
+    return true;
+}
 
-    m_file.close();
+bool OpfWriter::openTarget(const QString& filename)
+{
+    // Writes go to a temporary file next to the target, which replaces it
+    // only in commit()
+    m_file.setFileName(filename);
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Unbuffered))
+    {
+        m_lastError = QString("Cannot open file for writing: %1").arg(filename);
+        return false;
+    }
 
-    qDebug() << "Successfully wrote OPF file:" << m_file.size() << "bytes";
+    m_buffer.clear();
+    m_buffer.reserve(kFlushThreshold + 64 * 1024);
+    m_bytesWritten = 0;
+    m_failed = false;
+    m_lastError.clear();
+    m_pendingCopy = SourceRange();
+    m_copiedRecords = 0;
+    m_encodedRecords = 0;
+    m_textureRanges.clear();
+    m_materialRanges.clear();
+    m_objectRanges.clear();
     return true;
 }
 
-bool OpfWriter::writeBackup(const QString& originalFile, const PackedProject& project)
+bool OpfWriter::finishTarget(const QString& filename, bool success)
 {
-    QFileInfo fileInfo(originalFile);
-    QString backupDir = fileInfo.absolutePath();
-    QString baseName = fileInfo.completeBaseName();
-    QString extension = fileInfo.suffix();
+    m_buffer.clear();
+    m_buffer.squeeze();
 
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
-    QString backupFile = QString("%1/%2_backup_%3.%4")
-                             .arg(backupDir, baseName, timestamp, extension);
+    if (!success)
+    {
+        m_file.cancelWriting();
+        m_file.commit();
+        return false;
+    }
 
+    if (!m_file.commit())
+    {
+        m_lastError = QString("Cannot save %1: %2").arg(filename, m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool OpfWriter::writeBackup(const QString& originalFile, PackedProject& project)
+{
     if (QFile::exists(originalFile))
     {
-        if (!QFile::copy(originalFile, backupFile))
+        BackupStore store(originalFile);
+        if (!store.backup())
+        {
+            m_lastError = QString("Failed to create backup: %1").arg(store.lastError());
+            return false;
+        }
+    }
+
+    return writeIncremental(originalFile, project);
+}
+
+bool OpfWriter::detachTextureSources(const QString& filename, const PackedProject& project)
+{
+    // Lazily loaded textures read their payloads from the source file, which
+    // is about to be replaced if we are writing over it
+    QString target = QFileInfo(filename).canonicalFilePath();
+    if (target.isEmpty())
+    {
+        return true;
+    }
+
+    for (const Texture& tex : project.textures)
+    {
+        if (!tex.dataSource || QFileInfo(tex.dataSource->fileName()).canonicalFilePath() != target)
+        {
+            continue;
+        }
+
+        if (!tex.detachDataSource())
         {
-            m_lastError = QString("Failed to create backup: %1").arg(backupFile);
+            m_lastError = QString("Cannot read texture data for '%1' from %2").arg(tex.name, filename);
             return false;
         }
-        qDebug() << "Created backup:" << backupFile;
     }
 
-    return write(originalFile, project);
+    return true;
 }
 
 bool OpfWriter::writeProjectHeader(const PackedProject& project)
@@ -172,7 +528,7 @@ bool OpfWriter::writeProjectHeader(const PackedProject& project)
 
     qDebug() << "Wrote header - Project:" << project.projectName << "Version:" << project.version;
 
-    return m_stream.status() == QDataStream::Ok;
+    return sectionDone();
 }
 
 bool OpfWriter::writeDependencies(const QVector<QString>& dependencies)
@@ -185,7 +541,7 @@ bool OpfWriter::writeDependencies(const QVector<QString>& dependencies)
     }
 
     qDebug() << "Wrote" << dependencies.size() << "dependencies";
-    return m_stream.status() == QDataStream::Ok;
+    return sectionDone();
 }
 
 bool OpfWriter::writeEventDescs(const QVector<EventDesc>& events)
@@ -199,7 +555,7 @@ bool OpfWriter::writeEventDescs(const QVector<EventDesc>& events)
     }
 
     qDebug() << "Wrote" << events.size() << "event descriptors";
-    return m_stream.status() == QDataStream::Ok;
+    return sectionDone();
 }
 
 bool OpfWriter::writeTextures(const QVector<Texture>& textures)
@@ -208,11 +564,32 @@ bool OpfWriter::writeTextures(const QVector<Texture>& textures)
 
     for (const Texture& tex : textures)
     {
+        if (!tex.modified && canCopy(tex.source))
+        {
+            copyRecord(tex.source, m_textureRanges);
+            continue;
+        }
+
+        TexturePayloadScope payload(tex);
+        if (!payload.isLoaded())
+        {
+            m_lastError = QString("Cannot read texture data for '%1'").arg(tex.name);
+            return false;
+        }
+
+        if (!flushCopy())
+        {
+            return sectionDone();
+        }
+
+        qint64 begin = outputPosition();
         writeTexture(tex);
+        m_textureRanges.append(SourceRange{ begin, outputPosition() - begin });
+        m_encodedRecords++;
     }
 
     qDebug() << "Wrote" << textures.size() << "textures";
-    return m_stream.status() == QDataStream::Ok;
+    return sectionDone();
 }
 
 void OpfWriter::writeTexture(const Texture& texture)
@@ -311,11 +688,25 @@ bool OpfWriter::writeMaterials(const QVector<Material>& materials)
 
     for (const Material& mat : materials)
     {
+        if (!mat.modified && canCopy(mat.source))
+        {
+            copyRecord(mat.source, m_materialRanges);
+            continue;
+        }
+
+        if (!flushCopy())
+        {
+            return sectionDone();
+        }
+
+        qint64 begin = outputPosition();
         writeMaterial(mat);
+        m_materialRanges.append(SourceRange{ begin, outputPosition() - begin });
+        m_encodedRecords++;
     }
 
     qDebug() << "Wrote" << materials.size() << "materials";
-    return m_stream.status() == QDataStream::Ok;
+    return sectionDone();
 }
 
 void OpfWriter::writeMaterial(const Material& material)
@@ -429,14 +820,31 @@ bool OpfWriter::writeObjects(const QVector<Object*>& objects)
 
     for (const Object* obj : objects)
     {
-        if (obj)
+        if (!obj)
+        {
+            m_objectRanges.append(SourceRange());
+            continue;
+        }
+
+        if (!obj->isSubtreeModified() && canCopy(obj->source))
+        {
+            copyRecord(obj->source, m_objectRanges);
+            continue;
+        }
+
+        if (!flushCopy())
         {
-            writeObject(*obj);
+            return sectionDone();
         }
+
+        qint64 begin = outputPosition();
+        writeObject(*obj);
+        m_objectRanges.append(SourceRange{ begin, outputPosition() - begin });
+        m_encodedRecords++;
     }
 
     qDebug() << "Wrote" << objects.size() << "objects";
-    return m_stream.status() == QDataStream::Ok;
+    return sectionDone();
 }
 
 void OpfWriter::writeObject(const Object& obj)
@@ -517,31 +925,33 @@ void OpfWriter::writeMesh(const Mesh& mesh)
     writeValue<fp32>(mesh.boundRadius);
 
     writeValue<int32>(mesh.morphSize);
-    writeValue<int32>(mesh.vertexMorphTargets.size());
-    writeValue<int32>(mesh.colorMorphTargets.size());
-    writeValue<int32>(mesh.textureMorphTargets.size());
+    writeValue<int32>(mesh.numVertexMorphs);
+    writeValue<int32>(mesh.numColorMorphs);
+    writeValue<int32>(mesh.numTextureMorphs);
 
-    for (const VertexMorphTarget& vmt : mesh.vertexMorphTargets)
+    for (int i = 0; i < mesh.numVertexMorphs; i++)
     {
-        for (const Vertex& v : vmt.vertices)
+        ArrayView<Vector3D> positions = mesh.morphPositions(i);
+        ArrayView<Vector3D> normals = mesh.morphNormals(i);
+        for (int v = 0; v < positions.size(); v++)
         {
-            writeVec3(v.position);
-            writeVec3(v.normal);
+            writeVec3(positions[v]);
+            writeVec3(normals[v]);
         }
-        writeOutforceString(vmt.name);
+        writeOutforceString(mesh.vertexMorphNames.value(i));
     }
 
-    for (const ColorMorphTarget& cmt : mesh.colorMorphTargets)
+    for (int i = 0; i < mesh.numColorMorphs; i++)
     {
-        for (Color c : cmt.colors)
+        for (Color c : mesh.morphColors(i))
         {
             writeValue<uint32>(c);
         }
     }
 
-    for (const TextureMorphTarget& tmt : mesh.textureMorphTargets)
+    for (int i = 0; i < mesh.numTextureMorphs; i++)
     {
-        for (const Vector2D& tc : tmt.textureCoordinates)
+        for (const Vector2D& tc : mesh.morphTexCoords(i))
         {
             writeVec2(tc);
         }
@@ -569,15 +979,15 @@ void OpfWriter::writeMesh(const Mesh& mesh)
     writeValue<int32>(static_cast<int32>(mesh.bufferType));
     writeValue<int32>(mesh.numFaces);
 
-    for (uint16 idx : mesh.indices)
+    for (uint16 idx : mesh.indices())
     {
         writeValue<uint16>(idx);
     }
 
-    writeValue<int32>(mesh.groupMorphTargets.size());
-    for (const GroupMorphTarget& gmt : mesh.groupMorphTargets)
+    writeValue<int32>(mesh.numGroupMorphs);
+    for (int i = 0; i < mesh.numGroupMorphs; i++)
     {
-        for (uint8 g : gmt.groups)
+        for (uint8 g : mesh.morphGroups(i))
         {
             writeValue<uint8>(g);
         }
@@ -3,18 +3,34 @@
 
 #include "OpfStructs.h"
 #include <QString>
+#include <QSaveFile>
 #include <QFile>
-#include <QDataStream>
+#include <QByteArray>
 
 namespace Opf {
 
+// Serializes into an in-memory buffer that is flushed to a QSaveFile in
+// large chunks; the target is only replaced (atomically, after fsync) once
+// the whole project was written, so a failed save leaves it untouched.
+//
+// writeIncremental() copies textures, materials and objects that were not
+// modified byte for byte from the file they were parsed from and encodes
+// only the rest.
 class OpfWriter
 {
 public:
     OpfWriter();
 
     bool write(const QString& filename, const PackedProject& project);
-    bool writeBackup(const QString& originalFile, const PackedProject& project);
+
+    // Falls back to a full write() if project.sourceFile is missing or was
+    // changed on disk since it was read. On success the project refers to
+    // the new file (source ranges updated, modified flags cleared).
+    bool writeIncremental(const QString& filename, PackedProject& project);
+
+    // Adds the current file to its BackupStore and saves incrementally
+    // over it
+    bool writeBackup(const QString& originalFile, PackedProject& project);
 
     QString lastError() const { return m_lastError; }
 
@@ -25,10 +41,34 @@ private:
     void writeBytes(const char* data, qint64 size);
     void writeBytes(const QByteArray& data);
 
+    bool openTarget(const QString& filename);
+    bool finishTarget(const QString& filename, bool success);
+
+    // Hands the buffered bytes to the file in one write() call
+    bool flush();
+    bool sectionDone();
+
+    // ========================================================================
+    // SOURCE COPIES (incremental saving)
+    // ========================================================================
+
+    bool openSource(const PackedProject& project);
+    bool canCopy(const SourceRange& range) const;
+
+    // Output offset of the next byte, including queued copies
+    qint64 outputPosition() const;
+
+    // Queues a source range; adjacent ranges are merged into one copy
+    void copyRecord(const SourceRange& range, QVector<SourceRange>& outputRanges);
+    bool flushCopy();
+    bool copyFromSource(qint64 offset, qint64 size);
+
     void writeOutforceString(const QString& str);
     void writeOutforceString32(const QString& str);
     void writeStaticString(const QString& str, int length);
 
+    bool detachTextureSources(const QString& filename, const PackedProject& project);
+
     bool writeProjectHeader(const PackedProject& project);
     bool writeDependencies(const QVector<QString>& dependencies);
     bool writeEventDescs(const QVector<EventDesc>& events);
@@ -52,9 +92,22 @@ private:
     void writeVec2(const Vector2D& v);
     void writeColorValue(const ColorValue& c);
 
-    QFile m_file;
-    QDataStream m_stream;
+    QSaveFile m_file;
+    QByteArray m_buffer;
+    qint64 m_bytesWritten;
+    bool m_failed;
     QString m_lastError;
+
+    QFile m_source;
+    qint64 m_sourceSize;
+    SourceRange m_pendingCopy;
+    int m_copiedRecords;
+    int m_encodedRecords;
+
+    // Where each record of the last write ended up in the output
+    QVector<SourceRange> m_textureRanges;
+    QVector<SourceRange> m_materialRanges;
+    QVector<SourceRange> m_objectRanges;
 };
 
 } // namespace Opf
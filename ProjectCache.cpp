@@ -0,0 +1,917 @@
+#include "ProjectCache.h"
+#include "ContentHash.h"
+#include "OpfByteCursor.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QDebug>
+#include <type_traits>
+
+namespace Opf {
+
+namespace {
+
+const char kCacheMagic[8] = { 'O', 'P', 'F', 'C', 'A', 'C', 'H', 'E' };
+const uint32 kCacheFormatVersion = 3;
+
+// Changes whenever the in-memory layout of a raw-copied record changes
+// (compiler, platform or struct edits), which invalidates old caches
+uint32 layoutFingerprint()
+{
+    uint32 fingerprint = 0;
+    fingerprint = fingerprint * 31 + sizeof(Vector3D);
+    fingerprint = fingerprint * 31 + sizeof(Vector2D);
+    fingerprint = fingerprint * 31 + sizeof(BitmapInfoHeader);
+    fingerprint = fingerprint * 31 + sizeof(RenderPass1Stage);
+    fingerprint = fingerprint * 31 + sizeof(RenderPass2Stage);
+    fingerprint = fingerprint * 31 + sizeof(RenderPass3Stage);
+    fingerprint = fingerprint * 31 + sizeof(Light);
+    fingerprint = fingerprint * 31 + sizeof(SourceRange);
+    return fingerprint;
+}
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32 formatVersion;
+    uint32 layout;
+    qint64 sourceSize;
+    qint64 sourceModified;
+    quint64 sourceHash;
+    quint64 bodyHash;
+};
+
+// ============================================================================
+// CACHE WRITER - appends raw values and arrays to a byte buffer
+// ============================================================================
+
+class CacheWriter
+{
+public:
+    template<typename T>
+    void put(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "cache values must be trivially copyable");
+        m_data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void putArray(const QVector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "cache arrays must be trivially copyable");
+        put<uint32>(values.size());
+        m_data.append(reinterpret_cast<const char*>(values.constData()), values.size() * sizeof(T));
+    }
+
+    template<typename T>
+    void putArray(const ArrayView<T>& values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "cache arrays must be trivially copyable");
+        put<uint32>(values.size());
+        m_data.append(reinterpret_cast<const char*>(values.constData()), values.size() * sizeof(T));
+    }
+
+    void putString(const QString& str)
+    {
+        put<uint32>(str.size());
+        m_data.append(reinterpret_cast<const char*>(str.constData()), str.size() * sizeof(QChar));
+    }
+
+    void putBytes(const QByteArray& bytes)
+    {
+        put<uint32>(bytes.size());
+        m_data.append(bytes);
+    }
+
+    QByteArray& data() { return m_data; }
+
+private:
+    QByteArray m_data;
+};
+
+// ============================================================================
+// CACHE READER - bounds-checked reads from the mapped cache body
+// ============================================================================
+
+class CacheReader
+{
+public:
+    CacheReader(const uchar* data, qint64 size) : m_cursor(data, size), m_ok(true) {}
+
+    bool ok() const { return m_ok; }
+
+    template<typename T>
+    void get(T& value)
+    {
+        const uchar* data = take(sizeof(T));
+        if (data)
+        {
+            memcpy(&value, data, sizeof(T));
+        }
+    }
+
+    template<typename T>
+    T get()
+    {
+        T value{};
+        get(value);
+        return value;
+    }
+
+    template<typename T>
+    void getArray(QVector<T>& values)
+    {
+        uint32 count = get<uint32>();
+        const uchar* data = take(qint64(count) * sizeof(T));
+        if (!data)
+        {
+            return;
+        }
+        values.resize(count);
+        memcpy(values.data(), data, qint64(count) * sizeof(T));
+    }
+
+    // Appends an array to a pool array and returns the offset it was
+    // stored at
+    template<typename T>
+    int32 appendArray(QVector<T>& pool, uint32& count)
+    {
+        int32 offset = pool.size();
+        count = get<uint32>();
+        const uchar* data = take(qint64(count) * sizeof(T));
+        if (data && count > 0)
+        {
+            pool.resize(offset + count);
+            memcpy(pool.data() + offset, data, qint64(count) * sizeof(T));
+        }
+        return offset;
+    }
+
+    // Same, for an array that must hold exactly 'expected' elements
+    template<typename T>
+    int32 appendArray(QVector<T>& pool, qint64 expected)
+    {
+        uint32 count = 0;
+        int32 offset = appendArray(pool, count);
+        if (count != expected)
+        {
+            m_ok = false;
+        }
+        return offset;
+    }
+
+    void getString(QString& str)
+    {
+        uint32 length = get<uint32>();
+        const uchar* data = take(qint64(length) * sizeof(QChar));
+        if (!data)
+        {
+            return;
+        }
+        str = QString(length, Qt::Uninitialized);
+        memcpy(str.data(), data, qint64(length) * sizeof(QChar));
+    }
+
+    QString getString()
+    {
+        QString str;
+        getString(str);
+        return str;
+    }
+
+    void getBytes(QByteArray& bytes)
+    {
+        uint32 size = get<uint32>();
+        const uchar* data = take(size);
+        if (data)
+        {
+            bytes = QByteArray(reinterpret_cast<const char*>(data), size);
+        }
+    }
+
+    // Element count with a sanity bound: every element takes at least one
+    // byte, so a count larger than the remaining data is corrupt
+    uint32 getCount()
+    {
+        uint32 count = get<uint32>();
+        if (qint64(count) > m_cursor.remaining())
+        {
+            m_ok = false;
+            return 0;
+        }
+        return count;
+    }
+
+private:
+    const uchar* take(qint64 size)
+    {
+        if (!m_ok)
+        {
+            return nullptr;
+        }
+        const uchar* data = m_cursor.take(size);
+        if (!data)
+        {
+            m_ok = false;
+        }
+        return data;
+    }
+
+    ByteCursor m_cursor;
+    bool m_ok;
+};
+
+// ============================================================================
+// SERIALIZATION
+// ============================================================================
+
+void writeBitmap(CacheWriter& out, const Bitmap& bitmap)
+{
+    out.put(bitmap.bitsPerPixel);
+    out.put(bitmap.width);
+    out.put(bitmap.height);
+    out.put(bitmap.lineSize);
+    out.put(bitmap.bitmapType);
+    out.put(bitmap.bitmapInfoHeaderSize);
+    out.put(bitmap.bitmapInfoHeader);
+    out.putBytes(bitmap.extraHeaderData);
+    out.put(bitmap.dataOffset);
+    out.put(bitmap.dataSize);
+}
+
+void readBitmap(CacheReader& in, Bitmap& bitmap)
+{
+    in.get(bitmap.bitsPerPixel);
+    in.get(bitmap.width);
+    in.get(bitmap.height);
+    in.get(bitmap.lineSize);
+    in.get(bitmap.bitmapType);
+    in.get(bitmap.bitmapInfoHeaderSize);
+    in.get(bitmap.bitmapInfoHeader);
+    in.getBytes(bitmap.extraHeaderData);
+    in.get(bitmap.dataOffset);
+    in.get(bitmap.dataSize);
+}
+
+void writeTexture(CacheWriter& out, const Texture& texture)
+{
+    out.putString(texture.name);
+    out.putString(texture.colorFile);
+    out.putString(texture.alphaFile);
+    out.put(texture.size);
+    out.put(texture.id);
+    out.put(texture.projectID);
+    out.put(texture.version);
+    out.put(texture.width);
+    out.put(texture.height);
+
+    out.put(texture.colorBitDepthInFile);
+    out.put(texture.colorBitDepthInMemory);
+    out.put(texture.alphaBitDepthInFile);
+    out.put(texture.alphaBitDepthInMemory);
+
+    out.put(texture.colorDither);
+    out.put(texture.alphaDither);
+    out.put(texture.inverseAlpha);
+    out.put(texture.betterQuality);
+    out.put(texture.hasColorChannel);
+    out.put(texture.hasAlphaChannel);
+    out.put(texture.grayScale);
+    out.put(texture.multiTexture);
+    out.put(texture.maxCap);
+    out.put(texture.mipMap);
+
+    out.put(texture.override);
+    out.put(texture.excludeFromExport);
+    out.put(texture.exportColorQuality);
+    out.put(texture.exportAlphaQuality);
+    out.put(texture.exportColorJPEGQuality);
+    out.put(texture.exportAlphaJPEGQuality);
+
+    out.put(texture.colorBitsPerPixel);
+    out.put(texture.alphaBitsPerPixel);
+    out.put(texture.colorBitmapType);
+    out.put(texture.alphaBitmapType);
+
+    writeBitmap(out, texture.colorBitmap);
+    writeBitmap(out, texture.alphaBitmap);
+    out.put(texture.source);
+}
+
+void readTexture(CacheReader& in, Texture& texture)
+{
+    in.getString(texture.name);
+    in.getString(texture.colorFile);
+    in.getString(texture.alphaFile);
+    in.get(texture.size);
+    in.get(texture.id);
+    in.get(texture.projectID);
+    in.get(texture.version);
+    in.get(texture.width);
+    in.get(texture.height);
+
+    in.get(texture.colorBitDepthInFile);
+    in.get(texture.colorBitDepthInMemory);
+    in.get(texture.alphaBitDepthInFile);
+    in.get(texture.alphaBitDepthInMemory);
+
+    in.get(texture.colorDither);
+    in.get(texture.alphaDither);
+    in.get(texture.inverseAlpha);
+    in.get(texture.betterQuality);
+    in.get(texture.hasColorChannel);
+    in.get(texture.hasAlphaChannel);
+    in.get(texture.grayScale);
+    in.get(texture.multiTexture);
+    in.get(texture.maxCap);
+    in.get(texture.mipMap);
+
+    in.get(texture.override);
+    in.get(texture.excludeFromExport);
+    in.get(texture.exportColorQuality);
+    in.get(texture.exportAlphaQuality);
+    in.get(texture.exportColorJPEGQuality);
+    in.get(texture.exportAlphaJPEGQuality);
+
+    in.get(texture.colorBitsPerPixel);
+    in.get(texture.alphaBitsPerPixel);
+    in.get(texture.colorBitmapType);
+    in.get(texture.alphaBitmapType);
+
+    readBitmap(in, texture.colorBitmap);
+    readBitmap(in, texture.alphaBitmap);
+    in.get(texture.source);
+}
+
+void writeMaterial(CacheWriter& out, const Material& material)
+{
+    out.putString(material.name);
+    out.put(material.projectID);
+    out.put(material.id);
+    out.put(material.version);
+    out.put(material.doubleSided);
+    out.put(material.enabledLighting);
+    out.put(material.override);
+    out.put(material.excludeFromExport);
+    out.put(material.textureID);
+    out.putArray(material.renderPasses1Stage);
+    out.putArray(material.renderPasses2Stage);
+    out.putArray(material.renderPasses3Stage);
+    out.put(material.source);
+}
+
+void readMaterial(CacheReader& in, Material& material)
+{
+    in.getString(material.name);
+    in.get(material.projectID);
+    in.get(material.id);
+    in.get(material.version);
+    in.get(material.doubleSided);
+    in.get(material.enabledLighting);
+    in.get(material.override);
+    in.get(material.excludeFromExport);
+    in.get(material.textureID);
+    in.getArray(material.renderPasses1Stage);
+    in.getArray(material.renderPasses2Stage);
+    in.getArray(material.renderPasses3Stage);
+    in.get(material.source);
+}
+
+// Run of 'count' elements of a mesh's pool array
+template<typename T>
+ArrayView<T> meshRange(const Mesh& mesh, const QVector<T> GeometryPool::* array, int32 offset, qint64 count)
+{
+    if (!mesh.geometry || count <= 0)
+    {
+        return ArrayView<T>();
+    }
+    return ArrayView<T>((*mesh.geometry.*array).constData() + offset, int(count));
+}
+
+// Geometry is written per mesh and read back into the project's pool, so
+// meshes that reference other pools are cached correctly as well
+void writeMesh(CacheWriter& out, const Mesh& mesh)
+{
+    out.putString(mesh.name);
+    out.put(mesh.vertexFormat);
+    out.put(mesh.materialProjectID);
+    out.put(mesh.materialID);
+
+    out.put(mesh.textureWrapType);
+    out.put(mesh.textureOrigin);
+    out.put(mesh.textureRotation);
+    out.put(mesh.textureScale);
+    out.put(mesh.texturePosition);
+
+    out.put(mesh.position);
+    out.put(mesh.boundRadius);
+
+    out.put(mesh.morphSize);
+    out.put(mesh.numVertexMorphs);
+    out.put(mesh.numColorMorphs);
+    out.put(mesh.numTextureMorphs);
+    out.put(mesh.numGroupMorphs);
+
+    for (const QString& name : mesh.vertexMorphNames)
+    {
+        out.putString(name);
+    }
+
+    qint64 morphSize = qMax(mesh.morphSize, 0);
+    out.putArray(meshRange(mesh, &GeometryPool::positions, mesh.vertexOffset, mesh.numVertexMorphs * morphSize));
+    out.putArray(meshRange(mesh, &GeometryPool::normals, mesh.vertexOffset, mesh.numVertexMorphs * morphSize));
+    out.putArray(meshRange(mesh, &GeometryPool::colors, mesh.colorOffset, mesh.numColorMorphs * morphSize));
+    out.putArray(meshRange(mesh, &GeometryPool::texCoords, mesh.texCoordOffset, mesh.numTextureMorphs * morphSize));
+    out.putArray(meshRange(mesh, &GeometryPool::groups, mesh.groupOffset, mesh.numGroupMorphs * morphSize));
+
+    out.put(mesh.srcVertex);
+    out.put(mesh.srcColor);
+    out.put(mesh.srcTexture);
+    out.put(mesh.dstVertex);
+    out.put(mesh.dstColor);
+    out.put(mesh.dstTexture);
+    out.put(mesh.amountVertex);
+    out.put(mesh.amountColor);
+    out.put(mesh.amountTexture);
+    out.put(mesh.dstEnvironment);
+
+    out.put(mesh.bufferType);
+    out.put(mesh.numFaces);
+    out.putArray(mesh.indices());
+    out.put(mesh.primitiveType);
+}
+
+void readMesh(CacheReader& in, Mesh& mesh, const QSharedPointer<GeometryPool>& geometry)
+{
+    in.getString(mesh.name);
+    in.get(mesh.vertexFormat);
+    in.get(mesh.materialProjectID);
+    in.get(mesh.materialID);
+
+    in.get(mesh.textureWrapType);
+    in.get(mesh.textureOrigin);
+    in.get(mesh.textureRotation);
+    in.get(mesh.textureScale);
+    in.get(mesh.texturePosition);
+
+    in.get(mesh.position);
+    in.get(mesh.boundRadius);
+
+    in.get(mesh.morphSize);
+    mesh.numVertexMorphs = in.getCount();
+    mesh.numColorMorphs = in.getCount();
+    mesh.numTextureMorphs = in.getCount();
+    mesh.numGroupMorphs = in.getCount();
+
+    mesh.vertexMorphNames.resize(mesh.numVertexMorphs);
+    for (QString& name : mesh.vertexMorphNames)
+    {
+        in.getString(name);
+    }
+
+    qint64 morphSize = qMax(mesh.morphSize, 0);
+    mesh.geometry = geometry;
+    mesh.vertexOffset = in.appendArray(geometry->positions, mesh.numVertexMorphs * morphSize);
+    in.appendArray(geometry->normals, mesh.numVertexMorphs * morphSize);
+    mesh.colorOffset = in.appendArray(geometry->colors, mesh.numColorMorphs * morphSize);
+    mesh.texCoordOffset = in.appendArray(geometry->texCoords, mesh.numTextureMorphs * morphSize);
+    mesh.groupOffset = in.appendArray(geometry->groups, mesh.numGroupMorphs * morphSize);
+
+    in.get(mesh.srcVertex);
+    in.get(mesh.srcColor);
+    in.get(mesh.srcTexture);
+    in.get(mesh.dstVertex);
+    in.get(mesh.dstColor);
+    in.get(mesh.dstTexture);
+    in.get(mesh.amountVertex);
+    in.get(mesh.amountColor);
+    in.get(mesh.amountTexture);
+    in.get(mesh.dstEnvironment);
+
+    in.get(mesh.bufferType);
+    in.get(mesh.numFaces);
+    uint32 indexCount = 0;
+    mesh.indexOffset = in.appendArray(geometry->indices, indexCount);
+    mesh.indexCount = indexCount;
+    in.get(mesh.primitiveType);
+}
+
+// Custom settings are stored as one length table followed by one block of
+// characters, so an object's settings load with two bulk copies
+void writeCustomSettings(CacheWriter& out, const QVector<CustomSetting>& settings)
+{
+    QVector<uint32> lengths;
+    lengths.reserve(settings.size() * 2);
+
+    QString characters;
+    for (const CustomSetting& setting : settings)
+    {
+        lengths.append(setting.name.size());
+        lengths.append(setting.value.size());
+        characters += setting.name;
+        characters += setting.value;
+    }
+
+    out.putArray(lengths);
+    out.putString(characters);
+}
+
+void readCustomSettings(CacheReader& in, QVector<CustomSetting>& settings, NameTable& names)
+{
+    QVector<uint32> lengths;
+    in.getArray(lengths);
+    QString characters = in.getString();
+
+    if (!in.ok())
+    {
+        return;
+    }
+
+    settings.resize(lengths.size() / 2);
+    qsizetype offset = 0;
+    for (int i = 0; i < settings.size(); i++)
+    {
+        settings[i].setName(characters.mid(offset, lengths[i * 2]), names);
+        offset += lengths[i * 2];
+        settings[i].value = characters.mid(offset, lengths[i * 2 + 1]);
+        offset += lengths[i * 2 + 1];
+    }
+}
+
+void writeObject(CacheWriter& out, const Object& object)
+{
+    out.putString(object.className);
+    out.putString(object.name);
+    out.put(object.projectID);
+    out.put(object.uniqueID);
+    out.put(object.version);
+    out.put(object.source);
+
+    out.put(object.isUnknown);
+    out.put(object.override);
+    out.put(object.excludeFromExport);
+    out.put(object.isDisabled);
+    out.put(object.disableTree);
+    out.put(object.isBillboard);
+
+    out.put(object.position);
+    out.put(object.rotation);
+    out.put(object.scaling);
+
+    const ObjectTemplate& templ = object.objectTemplate;
+    out.put(templ.physicalScaling);
+    out.put(templ.physicalPosition);
+    out.put(templ.physicalRotation);
+    out.put(templ.lastPhysicalScaling);
+    out.put(templ.lastPhysicalPosition);
+    out.put(templ.lastPhysicalRotation);
+
+    out.put<uint32>(templ.faceBuffers.size());
+    for (const Mesh& mesh : templ.faceBuffers)
+    {
+        writeMesh(out, mesh);
+    }
+
+    out.put(object.hasLight);
+    out.put(object.light);
+
+    writeCustomSettings(out, object.customSettings);
+
+    out.put<uint32>(object.children.size());
+    for (const Object* child : object.children)
+    {
+        writeObject(out, *child);
+    }
+}
+
+void readObject(CacheReader& in, Object& object, ObjectArena& arena, const QSharedPointer<GeometryPool>& geometry, const QSharedPointer<NameTable>& names)
+{
+    object.setNameTable(names);
+    object.setClassName(in.getString());
+    in.getString(object.name);
+    in.get(object.projectID);
+    in.get(object.uniqueID);
+    in.get(object.version);
+    in.get(object.source);
+
+    in.get(object.isUnknown);
+    in.get(object.override);
+    in.get(object.excludeFromExport);
+    in.get(object.isDisabled);
+    in.get(object.disableTree);
+    in.get(object.isBillboard);
+
+    in.get(object.position);
+    in.get(object.rotation);
+    in.get(object.scaling);
+
+    ObjectTemplate& templ = object.objectTemplate;
+    in.get(templ.physicalScaling);
+    in.get(templ.physicalPosition);
+    in.get(templ.physicalRotation);
+    in.get(templ.lastPhysicalScaling);
+    in.get(templ.lastPhysicalPosition);
+    in.get(templ.lastPhysicalRotation);
+
+    uint32 meshCount = in.getCount();
+    templ.faceBuffers.resize(meshCount);
+    for (Mesh& mesh : templ.faceBuffers)
+    {
+        readMesh(in, mesh, geometry);
+    }
+
+    in.get(object.hasLight);
+    in.get(object.light);
+
+    readCustomSettings(in, object.customSettings, *names);
+    object.updateSettingsIndex();
+
+    uint32 childCount = in.getCount();
+    object.children.reserve(childCount);
+    for (uint32 i = 0; i < childCount && in.ok(); i++)
+    {
+        Object* child = arena.create();
+        readObject(in, *child, arena, geometry, names);
+        object.children.append(child);
+    }
+}
+
+void writeProject(CacheWriter& out, const PackedProject& project)
+{
+    out.putString(project.header);
+    out.put(project.version);
+    out.putString(project.projectName);
+    out.putString(project.author);
+    out.putString(project.email);
+    out.putString(project.description);
+    out.put(project.projectID);
+
+    out.put<uint32>(project.dependencies.size());
+    for (const QString& dependency : project.dependencies)
+    {
+        out.putString(dependency);
+    }
+
+    out.put<uint32>(project.eventDescs.size());
+    for (const EventDesc& event : project.eventDescs)
+    {
+        out.put(event.trigger);
+        out.putString(event.name);
+    }
+
+    out.put<uint32>(project.textures.size());
+    for (const Texture& texture : project.textures)
+    {
+        writeTexture(out, texture);
+    }
+
+    out.put<uint32>(project.materials.size());
+    for (const Material& material : project.materials)
+    {
+        writeMaterial(out, material);
+    }
+
+    out.put<uint32>(project.objects.size());
+    for (const Object* object : project.objects)
+    {
+        writeObject(out, *object);
+    }
+}
+
+void readProject(CacheReader& in, PackedProject& project)
+{
+    in.getString(project.header);
+    in.get(project.version);
+    in.getString(project.projectName);
+    in.getString(project.author);
+    in.getString(project.email);
+    in.getString(project.description);
+    in.get(project.projectID);
+
+    uint32 count = in.getCount();
+    project.dependencies.resize(count);
+    for (QString& dependency : project.dependencies)
+    {
+        in.getString(dependency);
+    }
+
+    count = in.getCount();
+    project.eventDescs.resize(count);
+    for (EventDesc& event : project.eventDescs)
+    {
+        in.get(event.trigger);
+        in.getString(event.name);
+    }
+
+    count = in.getCount();
+    project.textures.resize(count);
+    for (Texture& texture : project.textures)
+    {
+        readTexture(in, texture);
+    }
+
+    count = in.getCount();
+    project.materials.resize(count);
+    for (Material& material : project.materials)
+    {
+        readMaterial(in, material);
+    }
+
+    count = in.getCount();
+    project.objects.reserve(count);
+    project.objectArena.reset(new ObjectArena());
+    project.geometry = QSharedPointer<GeometryPool>::create();
+    for (uint32 i = 0; i < count && in.ok(); i++)
+    {
+        Object* object = project.objectArena->create();
+        readObject(in, *object, *project.objectArena, project.geometry, project.names);
+        project.objects.append(object);
+    }
+}
+
+void resetProject(PackedProject& project)
+{
+    project.clearObjects();
+    project.names = QSharedPointer<NameTable>::create();
+    project.geometry.reset();
+    project.textures.clear();
+    project.materials.clear();
+    project.dependencies.clear();
+    project.eventDescs.clear();
+    project.sourceFile.clear();
+}
+
+} // namespace
+
+// ============================================================================
+// PROJECT CACHE
+// ============================================================================
+
+ProjectCache::ProjectCache()
+{
+}
+
+QString ProjectCache::cachePathFor(const QString& opfFilename)
+{
+    return opfFilename + ".cache";
+}
+
+void ProjectCache::remove(const QString& opfFilename)
+{
+    QFile::remove(cachePathFor(opfFilename));
+}
+
+bool ProjectCache::computeSourceKey(const QString& opfFilename, SourceKey& key)
+{
+    QFile file(opfFilename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        m_lastError = QString("Cannot open file: %1").arg(opfFilename);
+        return false;
+    }
+
+    key.size = file.size();
+    key.modified = QFileInfo(file).lastModified().toMSecsSinceEpoch();
+
+    uchar* mapped = file.map(0, key.size);
+    if (mapped)
+    {
+        key.hash = contentHash(mapped, key.size);
+        file.unmap(mapped);
+    }
+
+    else
+    {
+        key.hash = contentHash(file.readAll());
+    }
+
+    return true;
+}
+
+bool ProjectCache::load(const QString& opfFilename, PackedProject& project)
+{
+    QFile file(cachePathFor(opfFilename));
+    if (!file.exists())
+    {
+        m_lastError = "No cache file";
+        return false;
+    }
+
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(CacheHeader)))
+    {
+        m_lastError = "Cannot read cache file";
+        return false;
+    }
+
+    uchar* mapped = file.map(0, file.size());
+    if (!mapped)
+    {
+        m_lastError = "Cannot map cache file";
+        return false;
+    }
+
+    CacheHeader header;
+    memcpy(&header, mapped, sizeof(header));
+
+    SourceKey key;
+    bool valid = memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) == 0
+                 && header.formatVersion == kCacheFormatVersion
+                 && header.layout == layoutFingerprint();
+
+    if (valid)
+    {
+        // Cheap checks first; the content hash only runs when they pass
+        valid = computeSourceKey(opfFilename, key)
+                && header.sourceSize == key.size
+                && header.sourceModified == key.modified
+                && header.sourceHash == key.hash;
+    }
+
+    const uchar* body = mapped + sizeof(CacheHeader);
+    qint64 bodySize = file.size() - qint64(sizeof(CacheHeader));
+
+    if (valid && contentHash(body, bodySize) != header.bodyHash)
+    {
+        valid = false;
+    }
+
+    if (!valid)
+    {
+        file.unmap(mapped);
+        m_lastError = "Cache is stale";
+        return false;
+    }
+
+    CacheReader reader(body, bodySize);
+    readProject(reader, project);
+
+    file.unmap(mapped);
+
+    if (!reader.ok())
+    {
+        resetProject(project);
+        m_lastError = "Cache file is corrupt";
+        return false;
+    }
+
+    // Texture payloads and the records' source ranges refer to the source
+    // file, which is unchanged
+    project.sourceFile = QFileInfo(opfFilename).absoluteFilePath();
+    project.sourceSize = key.size;
+    project.sourceModified = key.modified;
+
+    QSharedPointer<TextureDataSource> source = QSharedPointer<TextureDataSource>::create(project.sourceFile);
+    for (Texture& texture : project.textures)
+    {
+        texture.dataSource = source;
+    }
+    project.geometry->squeeze();
+    project.rebuildIndex();
+    project.updateSubtreeStats();
+
+    qDebug() << "Loaded project from cache:" << cachePathFor(opfFilename);
+    return true;
+}
+
+bool ProjectCache::save(const QString& opfFilename, const PackedProject& project)
+{
+    SourceKey key;
+    if (!computeSourceKey(opfFilename, key))
+    {
+        return false;
+    }
+
+    CacheWriter writer;
+    writeProject(writer, project);
+
+    CacheHeader header;
+    memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.formatVersion = kCacheFormatVersion;
+    header.layout = layoutFingerprint();
+    header.sourceSize = key.size;
+    header.sourceModified = key.modified;
+    header.sourceHash = key.hash;
+    header.bodyHash = contentHash(writer.data());
+
+    QSaveFile file(cachePathFor(opfFilename));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        m_lastError = QString("Cannot write cache file: %1").arg(file.fileName());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(writer.data());
+
+    if (!file.commit())
+    {
+        m_lastError = QString("Cannot write cache file: %1").arg(file.fileName());
+        return false;
+    }
+
+    qDebug() << "Wrote project cache:" << file.fileName() << (sizeof(header) + writer.data().size()) << "bytes";
+    return true;
+}
+
+} // namespace Opf
@@ -0,0 +1,55 @@
+#ifndef PROJECTCACHE_H
+#define PROJECTCACHE_H
+
+#include "OpfStructs.h"
+#include <QString>
+
+namespace Opf {
+
+// ============================================================================
+// PROJECT CACHE - decoded PackedProject stored next to the .opf
+// ============================================================================
+//
+// "<file>.opf.cache" holds the already-parsed project, keyed by the size,
+// modification time and content hash of the source file. Fixed-layout
+// records and mesh/index/settings arrays are stored as raw contiguous
+// blocks, so loading is a bulk copy out of a memory-mapped file.
+//
+// Texture payloads are not cached: textures are attached to the (unchanged)
+// source file and fetched lazily, see Texture::ensureBitmapData().
+
+class ProjectCache
+{
+public:
+    ProjectCache();
+
+    static QString cachePathFor(const QString& opfFilename);
+
+    // Fills 'project' from the cache if it exists and matches the source
+    // file. On a miss the project is left empty and false is returned.
+    bool load(const QString& opfFilename, PackedProject& project);
+
+    // Writes the cache for a project freshly parsed from 'opfFilename'
+    bool save(const QString& opfFilename, const PackedProject& project);
+
+    // Deletes the cache file, if any
+    static void remove(const QString& opfFilename);
+
+    QString lastError() const { return m_lastError; }
+
+private:
+    struct SourceKey
+    {
+        qint64 size = 0;
+        qint64 modified = 0;
+        quint64 hash = 0;
+    };
+
+    bool computeSourceKey(const QString& opfFilename, SourceKey& key);
+
+    QString m_lastError;
+};
+
+} // namespace Opf
+
+#endif // PROJECTCACHE_H
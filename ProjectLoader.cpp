@@ -0,0 +1,151 @@
+#include "ProjectLoader.h"
+#include "ProjectCache.h"
+#include <QFileInfo>
+#include <QDebug>
+
+namespace Opf {
+
+ProjectLoader::ProjectLoader(QObject* parent)
+    : QObject(parent),
+      m_textureLoadMode(OpfParser::TextureLoadMode::Eager),
+      m_objectStorage(OpfParser::ObjectStorage::Heap),
+      m_maxThreadCount(0),
+      m_useCache(false),
+      m_thread(nullptr),
+      m_result(nullptr),
+      m_cancelRequested(false),
+      m_canceled(false),
+      m_fromCache(false),
+      m_truncated(false)
+{
+}
+
+ProjectLoader::~ProjectLoader()
+{
+    if (m_thread)
+    {
+        cancel();
+        m_thread->wait();
+        delete m_thread;
+    }
+    delete m_result;
+}
+
+QString ProjectLoader::sectionName(OpfParser::Section section)
+{
+    switch (section)
+    {
+    case OpfParser::Section::Header:       return "header";
+    case OpfParser::Section::Dependencies: return "dependencies";
+    case OpfParser::Section::Events:       return "events";
+    case OpfParser::Section::Textures:     return "textures";
+    case OpfParser::Section::Materials:    return "materials";
+    case OpfParser::Section::Objects:      return "objects";
+    }
+    return QString();
+}
+
+void ProjectLoader::start(const QString& filename)
+{
+    if (m_thread)
+    {
+        return;
+    }
+
+    // Reset here rather than on the thread, so that a cancel() before the
+    // thread gets going is not lost
+    m_cancelRequested = false;
+    m_thread = QThread::create([this, filename]() {
+        delete m_result;
+        m_result = loadFile(filename);
+    });
+    connect(m_thread, &QThread::finished, this, &ProjectLoader::onThreadFinished);
+    m_thread->start();
+}
+
+void ProjectLoader::onThreadFinished()
+{
+    delete m_thread;
+    m_thread = nullptr;
+
+    PackedProject* project = m_result;
+    m_result = nullptr;
+
+    if (project)
+    {
+        emit finished(project);
+    }
+    else if (m_canceled)
+    {
+        emit canceled();
+    }
+    else
+    {
+        emit failed(m_lastError);
+    }
+}
+
+PackedProject* ProjectLoader::load(const QString& filename)
+{
+    m_cancelRequested = false;
+    return loadFile(filename);
+}
+
+PackedProject* ProjectLoader::loadFile(const QString& filename)
+{
+    m_filename = filename;
+    m_lastError.clear();
+    m_canceled = false;
+    m_fromCache = false;
+    m_truncated = false;
+
+    QScopedPointer<PackedProject> project(new PackedProject());
+    qint64 total = QFileInfo(filename).size();
+
+    ProjectCache cache;
+    if (m_useCache)
+    {
+        emit progressChanged(0, total, "cache");
+        m_fromCache = cache.load(filename, *project);
+    }
+
+    if (!m_fromCache)
+    {
+        OpfParser parser;
+        parser.setTextureLoadMode(m_textureLoadMode);
+        parser.setObjectStorage(m_objectStorage);
+        parser.setMaxThreadCount(m_maxThreadCount);
+        parser.setProgressCallback([this](OpfParser::Section section, qint64 position, qint64 total) {
+            emit progressChanged(position, total, sectionName(section));
+            return !m_cancelRequested;
+        });
+
+        if (!parser.parse(filename, *project))
+        {
+            m_canceled = parser.wasCanceled();
+            m_lastError = parser.lastError();
+            return nullptr;
+        }
+
+        // A cached copy would come back with sourceFile set, and records
+        // would be copied from, and textures read past the end of, the
+        // damaged file
+        m_truncated = parser.wasTruncated();
+        if (m_useCache && !m_truncated && !cache.save(filename, *project))
+        {
+            qWarning() << "Project cache not written:" << cache.lastError();
+        }
+    }
+
+    if (m_cancelRequested)
+    {
+        m_canceled = true;
+        m_lastError = "Loading canceled";
+        return nullptr;
+    }
+
+    emit progressChanged(total, total, "done");
+    return project.take();
+}
+
+} // namespace Opf
@@ -0,0 +1,93 @@
+#ifndef PROJECTLOADER_H
+#define PROJECTLOADER_H
+
+#include "OpfStructs.h"
+#include "OpfParser.h"
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+
+namespace Opf {
+
+// ============================================================================
+// PROJECT LOADER - reads an .opf (or its cache) on a worker thread
+// ============================================================================
+//
+// start() loads in the background and reports through signals that are
+// delivered on the loader's thread; load() does the same work blocking on
+// the calling thread, for headless use. Progress is the file offset the
+// parser has reached, plus the section it is in.
+
+class ProjectLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectLoader(QObject* parent = nullptr);
+    ~ProjectLoader();
+
+    // Parser settings, used by the next load
+    void setTextureLoadMode(OpfParser::TextureLoadMode mode) { m_textureLoadMode = mode; }
+    void setObjectStorage(OpfParser::ObjectStorage storage) { m_objectStorage = storage; }
+    void setMaxThreadCount(int count) { m_maxThreadCount = count; }
+
+    // Read from / write to the ProjectCache next to the file
+    void setUseCache(bool useCache) { m_useCache = useCache; }
+
+    // Asynchronous: exactly one of finished(), failed() or canceled()
+    // follows. Ignored while a load is running.
+    void start(const QString& filename);
+    bool isRunning() const { return m_thread != nullptr; }
+
+    // Blocking. Returns a new project (owned by the caller) or nullptr,
+    // see lastError() and wasCanceled().
+    PackedProject* load(const QString& filename);
+
+    // May be called from any thread
+    void cancel() { m_cancelRequested = true; }
+    bool wasCanceled() const { return m_canceled; }
+
+    QString fileName() const { return m_filename; }
+    QString lastError() const { return m_lastError; }
+    bool loadedFromCache() const { return m_fromCache; }
+
+    // See OpfParser::wasTruncated(); such files are never cached
+    bool wasTruncated() const { return m_truncated; }
+
+    static QString sectionName(OpfParser::Section section);
+
+signals:
+    // Emitted on the loading thread; queued to receivers on other threads
+    void progressChanged(qint64 position, qint64 total, const QString& section);
+
+    // The receiver takes ownership of 'project'
+    void finished(Opf::PackedProject* project);
+    void failed(const QString& error);
+    void canceled();
+
+private slots:
+    void onThreadFinished();
+
+private:
+    // load() without resetting a pending cancel()
+    PackedProject* loadFile(const QString& filename);
+
+    OpfParser::TextureLoadMode m_textureLoadMode;
+    OpfParser::ObjectStorage m_objectStorage;
+    int m_maxThreadCount;
+    bool m_useCache;
+
+    QThread* m_thread;
+    PackedProject* m_result;
+    std::atomic<bool> m_cancelRequested;
+    bool m_canceled;
+    bool m_fromCache;
+    bool m_truncated;
+    QString m_filename;
+    QString m_lastError;
+};
+
+} // namespace Opf
+
+#endif // PROJECTLOADER_H
@@ -45,6 +45,19 @@ void SettingsDialog::setupUI()
     m_exportBlenderCheck = new QCheckBox("Generate Blender import script", this);
     exportGroupLayout->addWidget(m_exportBlenderCheck);
 
+    m_exportGLBCheck = new QCheckBox("Export GLB models (one file per object)", this);
+    exportGroupLayout->addWidget(m_exportGLBCheck);
+
+    m_embedGlbTexturesCheck = new QCheckBox("Embed textures in GLB models", this);
+    exportGroupLayout->addWidget(m_embedGlbTexturesCheck);
+    connect(m_exportGLBCheck, &QCheckBox::toggled, m_embedGlbTexturesCheck, &QCheckBox::setEnabled);
+
+    m_deduplicateCheck = new QCheckBox("Write identical meshes and textures only once", this);
+    exportGroupLayout->addWidget(m_deduplicateCheck);
+
+    m_incrementalCheck = new QCheckBox("Only write files that changed since the last export", this);
+    exportGroupLayout->addWidget(m_incrementalCheck);
+
     exportLayout->addWidget(exportGroup);
 
     QGroupBox* formatGroup = new QGroupBox("Texture Format", this);
@@ -84,6 +97,55 @@ void SettingsDialog::setupUI()
 
     tabs->addTab(exportTab, "Export");
 
+    // Performance tab
+    QWidget* performanceTab = new QWidget(this);
+    QVBoxLayout* performanceLayout = new QVBoxLayout(performanceTab);
+
+    QGroupBox* textureGroup = new QGroupBox("Texture Data", this);
+    QVBoxLayout* textureLayout = new QVBoxLayout(textureGroup);
+
+    m_lazyTexturesCheck = new QCheckBox("Load texture data on demand (applies to newly opened files)", this);
+    textureLayout->addWidget(m_lazyTexturesCheck);
+
+    QHBoxLayout* budgetLayout = new QHBoxLayout();
+    budgetLayout->addWidget(new QLabel("Texture memory budget:", this));
+
+    m_textureBudgetSpin = new QSpinBox(this);
+    m_textureBudgetSpin->setRange(16, 8192);
+    m_textureBudgetSpin->setSingleStep(64);
+    m_textureBudgetSpin->setSuffix(" MB");
+    budgetLayout->addWidget(m_textureBudgetSpin);
+    budgetLayout->addStretch();
+
+    textureLayout->addLayout(budgetLayout);
+
+    connect(m_lazyTexturesCheck, &QCheckBox::toggled, m_textureBudgetSpin, &QSpinBox::setEnabled);
+
+    QHBoxLayout* decodedCacheLayout = new QHBoxLayout();
+    decodedCacheLayout->addWidget(new QLabel("Decoded image cache:", this));
+
+    m_decodedCacheSpin = new QSpinBox(this);
+    m_decodedCacheSpin->setRange(0, 8192);
+    m_decodedCacheSpin->setSingleStep(64);
+    m_decodedCacheSpin->setSuffix(" MB");
+    decodedCacheLayout->addWidget(m_decodedCacheSpin);
+    decodedCacheLayout->addStretch();
+
+    textureLayout->addLayout(decodedCacheLayout);
+
+    performanceLayout->addWidget(textureGroup);
+
+    QGroupBox* cacheGroup = new QGroupBox("Project Cache", this);
+    QVBoxLayout* cacheLayout = new QVBoxLayout(cacheGroup);
+
+    m_projectCacheCheck = new QCheckBox("Cache parsed projects next to the .opf file for faster re-opening", this);
+    cacheLayout->addWidget(m_projectCacheCheck);
+
+    performanceLayout->addWidget(cacheGroup);
+    performanceLayout->addStretch();
+
+    tabs->addTab(performanceTab, "Performance");
+
     mainLayout->addWidget(tabs);
 
     QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel | QDialogButtonBox::Apply,this);
@@ -104,6 +166,11 @@ void SettingsDialog::loadSettings()
     m_exportJSONCheck->setChecked(settings.exportJSON());
     m_exportMTLCheck->setChecked(settings.exportMTL());
     m_exportBlenderCheck->setChecked(settings.exportBlenderScript());
+    m_exportGLBCheck->setChecked(settings.exportGLB());
+    m_embedGlbTexturesCheck->setChecked(settings.embedGlbTextures());
+    m_embedGlbTexturesCheck->setEnabled(settings.exportGLB());
+    m_deduplicateCheck->setChecked(settings.deduplicateExport());
+    m_incrementalCheck->setChecked(settings.incrementalExport());
 
     if (settings.textureFormat() == SettingsManager::PNG)
     {
@@ -115,6 +182,12 @@ void SettingsDialog::loadSettings()
         m_formatJPEGRadio->setChecked(true);
     }
 
+    m_lazyTexturesCheck->setChecked(settings.lazyTextureLoading());
+    m_textureBudgetSpin->setValue(settings.textureMemoryBudgetMB());
+    m_textureBudgetSpin->setEnabled(settings.lazyTextureLoading());
+    m_decodedCacheSpin->setValue(settings.decodedTextureCacheMB());
+    m_projectCacheCheck->setChecked(settings.useProjectCache());
+
     switch (settings.textureScale())
     {
     case SettingsManager::Scale100:
@@ -138,10 +211,19 @@ void SettingsDialog::saveSettings()
     settings.setExportJSON(m_exportJSONCheck->isChecked());
     settings.setExportMTL(m_exportMTLCheck->isChecked());
     settings.setExportBlenderScript(m_exportBlenderCheck->isChecked());
+    settings.setExportGLB(m_exportGLBCheck->isChecked());
+    settings.setEmbedGlbTextures(m_embedGlbTexturesCheck->isChecked());
+    settings.setDeduplicateExport(m_deduplicateCheck->isChecked());
+    settings.setIncrementalExport(m_incrementalCheck->isChecked());
 
     settings.setTextureFormat(static_cast<SettingsManager::TextureFormat>(m_formatGroup->checkedId()));
 
     settings.setTextureScale(static_cast<SettingsManager::TextureScale>(m_scaleGroup->checkedId()));
+
+    settings.setLazyTextureLoading(m_lazyTexturesCheck->isChecked());
+    settings.setTextureMemoryBudgetMB(m_textureBudgetSpin->value());
+    settings.setDecodedTextureCacheMB(m_decodedCacheSpin->value());
+    settings.setUseProjectCache(m_projectCacheCheck->isChecked());
 }
 
 void SettingsDialog::onAccept()
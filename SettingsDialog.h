@@ -6,6 +6,7 @@
 #include <QRadioButton>
 #include <QButtonGroup>
 #include <QTabWidget>
+#include <QSpinBox>
 
 class SettingsDialog : public QDialog
 {
@@ -28,6 +29,10 @@ private:
     QCheckBox* m_exportJSONCheck;
     QCheckBox* m_exportMTLCheck;
     QCheckBox* m_exportBlenderCheck;
+    QCheckBox* m_exportGLBCheck;
+    QCheckBox* m_embedGlbTexturesCheck;
+    QCheckBox* m_deduplicateCheck;
+    QCheckBox* m_incrementalCheck;
 
     QRadioButton* m_formatPNGRadio;
     QRadioButton* m_formatJPEGRadio;
@@ -37,6 +42,11 @@ private:
     QRadioButton* m_scale50Radio;
     QRadioButton* m_scale25Radio;
     QButtonGroup* m_scaleGroup;
+
+    QCheckBox* m_lazyTexturesCheck;
+    QSpinBox* m_textureBudgetSpin;
+    QSpinBox* m_decodedCacheSpin;
+    QCheckBox* m_projectCacheCheck;
 };
 
 #endif // SETTINGSDIALOG_H
@@ -27,6 +27,26 @@ SettingsManager::SettingsManager() : m_settings(QSettings::IniFormat, QSettings:
         m_settings.setValue("Export/exportBlenderScript", true);
     }
 
+    if (!m_settings.contains("Export/exportGLB"))
+    {
+        m_settings.setValue("Export/exportGLB", false);
+    }
+
+    if (!m_settings.contains("Export/embedGlbTextures"))
+    {
+        m_settings.setValue("Export/embedGlbTextures", true);
+    }
+
+    if (!m_settings.contains("Export/deduplicate"))
+    {
+        m_settings.setValue("Export/deduplicate", false);
+    }
+
+    if (!m_settings.contains("Export/incremental"))
+    {
+        m_settings.setValue("Export/incremental", false);
+    }
+
     if (!m_settings.contains("Export/textureFormat"))
     {
         m_settings.setValue("Export/textureFormat", PNG);
@@ -36,6 +56,26 @@ SettingsManager::SettingsManager() : m_settings(QSettings::IniFormat, QSettings:
     {
         m_settings.setValue("Export/textureScale", Scale100);
     }
+
+    if (!m_settings.contains("Memory/lazyTextureLoading"))
+    {
+        m_settings.setValue("Memory/lazyTextureLoading", true);
+    }
+
+    if (!m_settings.contains("Memory/textureBudgetMB"))
+    {
+        m_settings.setValue("Memory/textureBudgetMB", 256);
+    }
+
+    if (!m_settings.contains("Memory/decodedTextureCacheMB"))
+    {
+        m_settings.setValue("Memory/decodedTextureCacheMB", 256);
+    }
+
+    if (!m_settings.contains("Cache/projectCache"))
+    {
+        m_settings.setValue("Cache/projectCache", true);
+    }
     m_settings.sync();
 }
 
@@ -105,6 +145,50 @@ void SettingsManager::setExportBlenderScript(bool value)
     m_settings.sync();
 }
 
+bool SettingsManager::exportGLB() const
+{
+    return m_settings.value("Export/exportGLB", false).toBool();
+}
+
+void SettingsManager::setExportGLB(bool value)
+{
+    m_settings.setValue("Export/exportGLB", value);
+    m_settings.sync();
+}
+
+bool SettingsManager::embedGlbTextures() const
+{
+    return m_settings.value("Export/embedGlbTextures", true).toBool();
+}
+
+void SettingsManager::setEmbedGlbTextures(bool value)
+{
+    m_settings.setValue("Export/embedGlbTextures", value);
+    m_settings.sync();
+}
+
+bool SettingsManager::deduplicateExport() const
+{
+    return m_settings.value("Export/deduplicate", false).toBool();
+}
+
+void SettingsManager::setDeduplicateExport(bool value)
+{
+    m_settings.setValue("Export/deduplicate", value);
+    m_settings.sync();
+}
+
+bool SettingsManager::incrementalExport() const
+{
+    return m_settings.value("Export/incremental", false).toBool();
+}
+
+void SettingsManager::setIncrementalExport(bool value)
+{
+    m_settings.setValue("Export/incremental", value);
+    m_settings.sync();
+}
+
 SettingsManager::TextureFormat SettingsManager::textureFormat() const
 {
     return static_cast<TextureFormat>(
@@ -128,6 +212,50 @@ void SettingsManager::setTextureScale(TextureScale scale)
     m_settings.sync();
 }
 
+bool SettingsManager::lazyTextureLoading() const
+{
+    return m_settings.value("Memory/lazyTextureLoading", true).toBool();
+}
+
+void SettingsManager::setLazyTextureLoading(bool value)
+{
+    m_settings.setValue("Memory/lazyTextureLoading", value);
+    m_settings.sync();
+}
+
+int SettingsManager::textureMemoryBudgetMB() const
+{
+    return m_settings.value("Memory/textureBudgetMB", 256).toInt();
+}
+
+void SettingsManager::setTextureMemoryBudgetMB(int value)
+{
+    m_settings.setValue("Memory/textureBudgetMB", value);
+    m_settings.sync();
+}
+
+int SettingsManager::decodedTextureCacheMB() const
+{
+    return m_settings.value("Memory/decodedTextureCacheMB", 256).toInt();
+}
+
+void SettingsManager::setDecodedTextureCacheMB(int value)
+{
+    m_settings.setValue("Memory/decodedTextureCacheMB", value);
+    m_settings.sync();
+}
+
+bool SettingsManager::useProjectCache() const
+{
+    return m_settings.value("Cache/projectCache", true).toBool();
+}
+
+void SettingsManager::setUseProjectCache(bool value)
+{
+    m_settings.setValue("Cache/projectCache", value);
+    m_settings.sync();
+}
+
 QStringList SettingsManager::recentFiles() const
 {
     return m_settings.value("Recent/files").toStringList();
@@ -26,6 +26,20 @@ public:
     bool exportBlenderScript() const;
     void setExportBlenderScript(bool value);
 
+    bool exportGLB() const;
+    void setExportGLB(bool value);
+
+    bool embedGlbTextures() const;
+    void setEmbedGlbTextures(bool value);
+
+    // Identical meshes and textures are exported once
+    bool deduplicateExport() const;
+    void setDeduplicateExport(bool value);
+
+    // Only changed files are written, see export_manifest.json
+    bool incrementalExport() const;
+    void setIncrementalExport(bool value);
+
     enum TextureFormat
     {
         PNG = 0,
@@ -45,6 +59,21 @@ public:
     TextureScale textureScale() const;
     void setTextureScale(TextureScale scale);
 
+    // Memory settings
+    bool lazyTextureLoading() const;
+    void setLazyTextureLoading(bool value);
+
+    int textureMemoryBudgetMB() const;
+    void setTextureMemoryBudgetMB(int value);
+
+    // Decoded images kept for preview and export (see TextureCache)
+    int decodedTextureCacheMB() const;
+    void setDecodedTextureCacheMB(int value);
+
+    // Project cache
+    bool useProjectCache() const;
+    void setUseProjectCache(bool value);
+
     // Recent files
     QStringList recentFiles() const;
     void addRecentFile(const QString& filepath);
@@ -0,0 +1,926 @@
+#include "SettingsTable.h"
+#include <QStringView>
+#include <cstring>
+
+namespace Opf {
+
+namespace {
+
+enum class Op
+{
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Contains
+};
+
+// The loops below have no branches on the data, so the compiler turns them
+// into vector compares over whole columns
+template <typename T, typename V>
+void compareNumbers(const T* values, const quint8* present, int count, Op op, V operand, quint8* out)
+{
+    switch (op)
+    {
+    case Op::Equal:
+        for (int i = 0; i < count; i++) out[i] = quint8(V(values[i]) == operand) & present[i];
+        break;
+    case Op::NotEqual:
+        for (int i = 0; i < count; i++) out[i] = quint8(V(values[i]) != operand) & present[i];
+        break;
+    case Op::Less:
+        for (int i = 0; i < count; i++) out[i] = quint8(V(values[i]) < operand) & present[i];
+        break;
+    case Op::LessEqual:
+        for (int i = 0; i < count; i++) out[i] = quint8(V(values[i]) <= operand) & present[i];
+        break;
+    case Op::Greater:
+        for (int i = 0; i < count; i++) out[i] = quint8(V(values[i]) > operand) & present[i];
+        break;
+    case Op::GreaterEqual:
+        for (int i = 0; i < count; i++) out[i] = quint8(V(values[i]) >= operand) & present[i];
+        break;
+    case Op::Contains:
+        break;
+    }
+}
+
+template <typename T>
+bool compareOrdered(const T& a, const T& b, Op op)
+{
+    switch (op)
+    {
+    case Op::Equal: return a == b;
+    case Op::NotEqual: return a != b;
+    case Op::Less: return a < b;
+    case Op::LessEqual: return a <= b;
+    case Op::Greater: return a > b;
+    case Op::GreaterEqual: return a >= b;
+    case Op::Contains: break;
+    }
+    return false;
+}
+
+} // namespace
+
+// ============================================================================
+// QUERY - recursive descent parser that evaluates as it goes
+// ============================================================================
+//
+//   or         := and (("or" | "||") and)*
+//   and        := not (("and" | "&&") not)*
+//   not        := ("not" | "!") not | "(" or ")" | comparison
+//   comparison := name [op value]
+//   value      := number | "text" | 'text' | word
+
+class SettingsTable::Query
+{
+public:
+    // Evaluates rows first .. first + count - 1
+    Query(const SettingsTable& table, int first, int count) : m_table(table), m_first(first), m_count(count) {}
+
+    bool evaluate(const QString& text, QVector<quint8>& mask)
+    {
+        if (!tokenize(text))
+        {
+            return false;
+        }
+        if (peek().type == Token::End)
+        {
+            return fail("Empty query");
+        }
+        if (!parseOr(mask))
+        {
+            return false;
+        }
+        if (peek().type != Token::End)
+        {
+            return fail(QString("Unexpected '%1'").arg(peek().text));
+        }
+        return true;
+    }
+
+    QString error() const { return m_error; }
+
+private:
+    struct Token
+    {
+        enum Type { Word, Number, Text, Operator, Open, Close, And, Or, Not, End };
+
+        Type type = End;
+        QString text;
+        double number = 0.0;
+    };
+
+    const SettingsTable& m_table;
+    int m_first;
+    int m_count;
+    QVector<Token> m_tokens;
+    int m_position = 0;
+    QString m_error;
+
+    bool fail(const QString& message)
+    {
+        m_error = message;
+        return false;
+    }
+
+    const Token& peek() const { return m_tokens[m_position]; }
+    const Token& take() { return m_tokens[m_position < m_tokens.size() - 1 ? m_position++ : m_position]; }
+
+    int rows() const { return m_count; }
+
+    bool tokenize(const QString& text)
+    {
+        int i = 0;
+        while (i < text.size())
+        {
+            QChar c = text[i];
+            if (c.isSpace())
+            {
+                i++;
+                continue;
+            }
+
+            Token token;
+            int start = i;
+
+            if (c == '(' || c == ')')
+            {
+                token.type = c == '(' ? Token::Open : Token::Close;
+                i++;
+            }
+            else if (c == '"' || c == '\'')
+            {
+                int end = text.indexOf(c, i + 1);
+                if (end < 0)
+                {
+                    return fail("Missing closing quote");
+                }
+                token.type = Token::Text;
+                token.text = text.mid(i + 1, end - i - 1);
+                m_tokens.append(token);
+                i = end + 1;
+                continue;
+            }
+            else if (c.isDigit() || ((c == '-' || c == '.') && i + 1 < text.size() && (text[i + 1].isDigit() || text[i + 1] == '.')))
+            {
+                i++;
+                while (i < text.size() && (text[i].isDigit() || text[i] == '.' || text[i] == 'e' || text[i] == 'E' ||
+                                           ((text[i] == '-' || text[i] == '+') && (text[i - 1] == 'e' || text[i - 1] == 'E'))))
+                {
+                    i++;
+                }
+                bool ok = false;
+                token.number = text.mid(start, i - start).toDouble(&ok);
+                if (!ok)
+                {
+                    return fail(QString("Invalid number '%1'").arg(text.mid(start, i - start)));
+                }
+                token.type = Token::Number;
+            }
+            else if (c.isLetter() || c == '_')
+            {
+                while (i < text.size() && (text[i].isLetterOrNumber() || text[i] == '_'))
+                {
+                    i++;
+                }
+                QString word = text.mid(start, i - start).toLower();
+                token.type = word == "and" ? Token::And : word == "or" ? Token::Or : word == "not" ? Token::Not : Token::Word;
+            }
+            else
+            {
+                static const char* const operators[] = { "&&", "||", "==", "!=", "<=", ">=", "=", "<", ">", "~", "!" };
+                for (const char* op : operators)
+                {
+                    if (QStringView(text).mid(i).startsWith(QLatin1String(op)))
+                    {
+                        i += int(strlen(op));
+                        break;
+                    }
+                }
+                if (i == start)
+                {
+                    return fail(QString("Unexpected character '%1'").arg(c));
+                }
+
+                QString op = text.mid(start, i - start);
+                token.type = op == "&&" ? Token::And : op == "||" ? Token::Or : op == "!" ? Token::Not : Token::Operator;
+            }
+
+            if (token.text.isEmpty())
+            {
+                token.text = text.mid(start, i - start);
+            }
+            m_tokens.append(token);
+        }
+
+        Token end;
+        end.text = "end of query";
+        m_tokens.append(end);
+        return true;
+    }
+
+    bool parseOr(QVector<quint8>& mask)
+    {
+        if (!parseAnd(mask))
+        {
+            return false;
+        }
+        while (peek().type == Token::Or)
+        {
+            take();
+            QVector<quint8> right;
+            if (!parseAnd(right))
+            {
+                return false;
+            }
+            quint8* m = mask.data();
+            const quint8* r = right.constData();
+            for (int i = 0, n = rows(); i < n; i++) m[i] |= r[i];
+        }
+        return true;
+    }
+
+    bool parseAnd(QVector<quint8>& mask)
+    {
+        if (!parseNot(mask))
+        {
+            return false;
+        }
+        while (peek().type == Token::And)
+        {
+            take();
+            QVector<quint8> right;
+            if (!parseNot(right))
+            {
+                return false;
+            }
+            quint8* m = mask.data();
+            const quint8* r = right.constData();
+            for (int i = 0, n = rows(); i < n; i++) m[i] &= r[i];
+        }
+        return true;
+    }
+
+    bool parseNot(QVector<quint8>& mask)
+    {
+        if (peek().type == Token::Not)
+        {
+            take();
+            if (!parseNot(mask))
+            {
+                return false;
+            }
+            quint8* m = mask.data();
+            for (int i = 0, n = rows(); i < n; i++) m[i] ^= 1;
+            return true;
+        }
+
+        if (peek().type == Token::Open)
+        {
+            take();
+            if (!parseOr(mask))
+            {
+                return false;
+            }
+            if (peek().type != Token::Close)
+            {
+                return fail(QString("Expected ')' instead of '%1'").arg(peek().text));
+            }
+            take();
+            return true;
+        }
+
+        return parseComparison(mask);
+    }
+
+    bool parseComparison(QVector<quint8>& mask)
+    {
+        Token name = take();
+        if (name.type != Token::Word)
+        {
+            return fail(QString("Expected a setting name instead of '%1'").arg(name.text));
+        }
+
+        int columnIndex = m_table.columnIndex(name.text);
+        if (columnIndex < 0)
+        {
+            return fail(QString("Unknown setting '%1'").arg(name.text));
+        }
+        const Column& column = m_table.m_columns[columnIndex];
+
+        // A name on its own: has the setting
+        if (peek().type != Token::Operator)
+        {
+            mask = column.present.mid(m_first, m_count);
+            return true;
+        }
+
+        QString opText = take().text;
+        Op op = opText == "~" ? Op::Contains : opText == "!=" ? Op::NotEqual : opText == "<" ? Op::Less : opText == "<=" ? Op::LessEqual
+              : opText == ">" ? Op::Greater : opText == ">=" ? Op::GreaterEqual : Op::Equal;
+
+        Token value = take();
+        if (value.type != Token::Number && value.type != Token::Text && value.type != Token::Word)
+        {
+            return fail(QString("Expected a value after '%1' instead of '%2'").arg(opText, value.text));
+        }
+
+        mask.resize(rows());
+        if (column.type == ColumnType::String)
+        {
+            compareText(column, op, value, mask);
+            return true;
+        }
+
+        if (op == Op::Contains)
+        {
+            return fail(QString("'~' needs a text setting, %1 holds numbers").arg(column.name));
+        }
+
+        double number = value.number;
+        bool ok = value.type == Token::Number;
+        if (!ok)
+        {
+            number = value.text.toDouble(&ok);
+        }
+        if (!ok)
+        {
+            return fail(QString("%1 holds numbers, '%2' is not one").arg(column.name, value.text));
+        }
+
+        if (column.type == ColumnType::Int)
+        {
+            compareNumbers(column.ints.constData() + m_first, column.present.constData() + m_first, rows(), op, number, mask.data());
+        }
+        else
+        {
+            // At the column's precision, so Power = 0.1 finds the stored 0.1
+            compareNumbers(column.floats.constData() + m_first, column.present.constData() + m_first, rows(), op, fp32(number), mask.data());
+        }
+        return true;
+    }
+
+    // Decided once per distinct value, then looked up per row
+    void compareText(const Column& column, Op op, const Token& value, QVector<quint8>& mask)
+    {
+        QString text = value.type == Token::Number ? QString::number(value.number) : value.text;
+        bool operandIsNumber = value.type == Token::Number;
+        double operand = operandIsNumber ? value.number : text.toDouble(&operandIsNumber);
+
+        QVector<quint8> matches(column.strings.size() + 1, 0);
+        for (int s = 0; s < column.strings.size(); s++)
+        {
+            const QString& entry = column.strings[s];
+            bool match = false;
+            if (op == Op::Contains)
+            {
+                match = entry.contains(text, Qt::CaseInsensitive);
+            }
+            else
+            {
+                bool entryIsNumber = false;
+                double number = operandIsNumber ? entry.toDouble(&entryIsNumber) : 0.0;
+                match = entryIsNumber ? compareOrdered(number, operand, op)
+                                      : compareOrdered(QString::compare(entry, text, Qt::CaseInsensitive), 0, op);
+            }
+            matches[s + 1] = match;
+        }
+
+        const qint32* ids = column.stringIds.constData() + m_first;
+        const quint8* lookup = matches.constData();
+        quint8* m = mask.data();
+        for (int i = 0, n = rows(); i < n; i++) m[i] = lookup[ids[i]];
+    }
+};
+
+// ============================================================================
+// Complete list of CustomSettings names from IDA reverse engineering
+// ============================================================================
+// Sources: COutforceObject (sub_47E060), CGridMemberTemplate (sub_470400),
+//          CUnitTemplate (sub_46C2A0), CUnitWeaponTemplate (sub_4721C0)
+// Updated: December 2025 - Final version with full IDA analysis
+// Total: ~125 settings
+// ============================================================================
+const QStringList& SettingsTable::knownSettingNames()
+{
+    static const QStringList names = {
+        // =========================================================================
+        // COutforceObject (Base Object Settings - sub_47E060)
+        // Base class for all game objects
+        // =========================================================================
+
+        // --- Identity ---
+        "Name",                      // offset 800 - Object name (string)
+        "Race",                      // offset 720 - Race template reference (string, default "Default")
+
+        // --- Resources ---
+        "ResourceType",              // offset 808 - Resource type ID (int)
+        "ResourceHeld",              // offset 812 - Stored resource amount (float)
+        "ResourceLayers",            // offset 816 - Number of resource layers (int)
+
+        // --- Physics ---
+        "SpreadingSpeed",            // offset 880 - Spreading speed (float)
+        "ExplosionMass",             // offset 884 - Explosion mass, input * 0.001 (float)
+        "OnScreen",                  // offset 889 - Stay on screen (bool)
+        "Power",                     // offset 828 - Battle power (float, default 1.0)
+        "CollisionDamage",           // offset 824 - Collision damage (float, default 1.0)
+        "Density",                   // offset 936 - Object density (float, default 1.0)
+        "UneffectedByPhysics",       // offset 917 - Unaffected by physics (bool)
+
+        // --- Auto Destruction ---
+        "AutoDestructionTime",       // offset 832 - Auto destruction time, input * 0.001 (float)
+        "AutoDestructionRandom",     // offset 836 - Auto destruction random variance, input * 0.001 (float)
+
+        // --- Animation ---
+        "AnimationLoopType",         // offset 524 - Values: "Stop"=0, "NormalLoop"=2
+        "Animate",                   // Values: "OnBuildComplete", "OnFire", or always
+        "AnimationTime",             // Animation duration, input ms * 1193.182 (int)
+        "AnimationStart",            // Animation start offset, input ms * 1193.182 (int)
+        "DisableAnimation",          // offset 865 - Disable animation (bool)
+
+        // --- Auto Rotation ---
+        "AutoRotationH",             // offset 768 - Auto rotation heading/yaw (float)
+        "AutoRotationP",             // offset 772 - Auto rotation pitch (float)
+        "AutoRotationB",             // offset 776 - Auto rotation bank/roll (float)
+
+        // --- Auto Scale ---
+        "AutoScaleX",                // offset 780 - Auto scale X (float)
+        "AutoScaleY",                // offset 784 - Auto scale Y (float)
+        "AutoScaleZ",                // offset 788 - Auto scale Z (float)
+
+        // --- Destruction ---
+        "DestructionMethod",         // offset 852 - "None"=0, "AutoExplosion"=10, or object name=64
+        "DisableOnDestruction",      // offset 864 - Disable on destroy (bool)
+        "DebrisChance",              // offset 868 - Debris spawn chance (float)
+
+        // --- Rendering ---
+        "DisableBoundRadius",        // offset 569 bit3 - Disable bounding radius
+        "DisableClipping",           // offset 888 - Disable view clipping (bool)
+        "Billboard",                 // offset 422 bit1 - Billboard mode, always face camera (bool)
+        "FlatRadiusScaling",         // offset 684 - Flat radius scaling (float, default 1.0)
+
+        // --- Morphing ---
+        "MorphStepTexture",          // offset 568 bit6 - Morph step texture (bool)
+        "MorphStepColor",            // offset 568 bit5 - Morph step color (bool)
+        "MorphStepVertex",           // offset 568 bit4 - Morph step vertex (bool)
+
+        // --- Emitter ---
+        "UseInternalEmitter",        // offset 872/876 - Internal particle emitter ID (string->int)
+
+        // --- Behavior ---
+        "UpdateObject",              // offset 920 - Force object update every frame (bool)
+        "MoveWhenParentDies",        // offset 924 - Movement when parent destroyed (float)
+        "RandomRotation",            // offset 928 - Random initial rotation (bool)
+        "ForceRadius",               // offset 792/796 - Force effect radius (bool/float)
+        "NoTolerance",               // offset 741 - No tolerance (bool)
+
+        // --- Projectile/Homing ---
+        "HomingStrength",            // offset 840/844 - Homing missile strength (bool/float)
+        "DamagePower",               // offset 712 - Pressure wave damage power (float)
+        "DamageRadius",              // offset 716 - Pressure wave damage radius (float)
+
+        // --- Object Sounds ---
+        "SoundCreated",              // offset 892/896 - Sound when object created
+        "SoundLife",                 // offset 900/904 - Sound during object life (looping)
+        "SoundDeath",                // offset 908/912 - Sound when object destroyed
+
+        // =========================================================================
+        // CGridMemberTemplate (Grid/Building Base - sub_470400)
+        // Extends COutforceObject for grid-based structures
+        // =========================================================================
+
+        "TileSize",                  // Grid tile size (parsed but not stored directly)
+        "InvisibleToPathfinder",     // offset 964 - Pathfinder ignores this object (bool)
+        "BuildTime",                 // offset 972 - Construction time (float, default 1.0)
+        "Expense",                   // offset 976 - Resource cost to build (float)
+        "SplashDamageModifier",      // offset 980 - Splash damage multiplier (float, default 1.0)
+        "NoDebris",                  // offset 985 - No debris when destroyed (bool)
+        "NoYCollision",              // offset 986 - No Y-axis collision (bool)
+        "AbsoluteStill",             // offset 987 - Object never moves (bool)
+
+        // =========================================================================
+        // CUnitTemplate (Unit Settings - sub_46C2A0)
+        // Extends CGridMemberTemplate for mobile units and buildings
+        // =========================================================================
+
+        // --- Build System ---
+        "CanBuildUnit",              // Reference to buildable unit template (string, multiple allowed)
+        "ConstructedBy",             // Reference to constructor unit template (string)
+        "HasBuildCaps",              // offset 1010 - Has build capability (bool)
+        "BuildMethod",               // offset 1012 - "Internal"=1, "External"=2
+        "BuildPowerAdd",             // offset 1028 - Build power/speed addition (float)
+        "BuildListPriority",         // offset 1016 - Priority in build list UI (int)
+
+        // --- Resource Production/Consumption ---
+        "Storage",                   // offset 1052 - Resource storage capacity (float)
+        "GivesEnergy",               // offset 1120 - Energy production per tick (float)
+        "GiveEnergy",                // offset 1120 - Alternative spelling
+        "TakesEnergy",               // offset 1124 - Energy consumption per tick (float)
+        "TakeEnergy",                // offset 1124 - Alternative spelling
+        "GivesResources",            // offset 1132 - Resource production per tick (float)
+        "GiveResources",             // offset 1132 - Alternative spelling
+        "TakesResources",            // offset 1136 - Resource consumption per tick (float)
+        "TakeResources",             // offset 1136 - Alternative spelling
+
+        // --- Harvesting ---
+        "CanHarvestType",            // offset 1040 - Harvestable resource type ID (int)
+        "HarvestSpeed",              // offset 1044 - Harvest speed (float)
+        "MaxResourcesHeld",          // offset 1048 - Max resources unit can carry (float)
+        "HasReloadBar",              // offset 1193 - Show reload/progress bar (bool)
+
+        // --- Child Units & Docking ---
+        "AddChildUnit",              // offset 1056 - Child unit template to spawn (string)
+        "ChildUnitOffsetX",          // offset 1060 - Child unit local X offset (float)
+        "ChildUnitOffsetZ",          // offset 1064 - Child unit local Z offset (float)
+        "DockPositionX",             // offset 1068 - Dock position X (float)
+        "DockPositionZ",             // offset 1072 - Dock position Z (float)
+        "DockingAngle",              // offset 1076 - Docking angle (float)
+
+        // --- Combat ---
+        "NumWeapons",                // offset 1164 - Number of weapon slots (int)
+        "HasKamikazeCaps",           // offset 1216 - Kamikaze/suicide attack capability (bool)
+        "SpaceAttack",               // offset 1009 - Can perform space/orbital attack (bool)
+        "DontScanForAttack",         // offset 1192 - Don't auto-acquire targets (bool)
+
+        // --- Movement ---
+        "Speed",                     // offset 1004 - Movement speed (float)
+        "EnergyAcceleration",        // offset 1196 - Energy-based acceleration (float)
+
+        // --- Visibility & Radar ---
+        "VisibleRange",              // offset 1176 - Vision/sight range (float), squared stored at 1180
+        "HasRadarCaps",              // offset 1033 - Has radar capability (bool)
+        "RadarRange",                // offset 1036 - Radar detection range (float)
+        "AntiRadar",                 // offset 1036/1201 - Anti-radar/stealth range (float) + flag
+
+        // --- Special: Warp ---
+        "HasWarpCaps",               // offset 1140 - Has warp/teleport capability (bool)
+        "WarpMaxRange",              // offset 1144 - Maximum warp distance (float)
+        "HasAntiWarpCaps",           // offset 1148 - Has anti-warp field (bool)
+        "HasWarpNukeCaps",           // offset 1213 - Has warp nuke capability (bool)
+
+        // --- Special: Towing ---
+        "HasTowCaps",                // offset 1168 - Can tow other units (bool)
+        "TowMaxCableLength",         // offset 1172 - Maximum tow cable length (float)
+
+        // --- Special: Spotting & Repair ---
+        "HasSpotCaps",               // offset 1080/1084 - Spotting/scouting capability (bool/float)
+        "HasRepairCaps",             // offset 1088 - Repair capability type (int)
+        "PowerTransform",            // offset 1092 - Power/energy transform rate (float)
+
+        // --- Special: Other ---
+        "HasPhasingCaps",            // offset 1212 - Can phase through objects (bool)
+        "LaserFence",                // offset 1202/1204 - Creates laser fence (bool/float range)
+        "LaserFenceDamage",          // offset 1208 - Laser fence damage (float, default 1.0)
+
+        // --- Flags ---
+        "OnlySinglePlayer",          // offset 1032 - Only available in single player (bool)
+        "Friendly",                  // offset 1200 - Friendly to all players (bool)
+        "DisableCUnitUpdate",        // offset 1214 - Disable CUnit update logic (bool)
+
+        // --- Unit Sounds ---
+        "SoundClicked",              // offset 1224/1228 - Sound when unit selected
+        "SoundAttack",               // offset 1232/1236 - Sound when attacking
+        "SoundActive",               // offset 1272/1276 - Sound when activated
+        "SoundDeactive",             // offset 1264/1268 - Sound when deactivated
+        "SoundMove",                 // offset 1240/1244 - Sound when moving
+        "SoundCancel",               // offset 1248/1252 - Sound when order cancelled
+        "SoundDamage",               // offset 1256/1260 - Sound when taking damage
+
+        // =========================================================================
+        // CUnitWeaponTemplate (Weapon Settings - sub_4721C0)
+        // Weapon definitions attached to units
+        // =========================================================================
+
+        "DefineWeapon",              // offset 1028 - Weapon slot definition ID (int)
+        "AngleMovement",             // offset 964 - Turret rotation speed (float, default ~PI)
+        "VisibleRangeWeapon",        // offset 968 - Weapon's visible/firing range (float)
+        "UpdatesReloadBar",          // offset 1026 - Updates unit's reload bar (bool)
+        "NoTargeting",               // offset 972 - Weapon doesn't auto-target (bool)
+
+        "WeaponMethod",              // offset 984 - Weapon firing method:
+        //   "Disabled"=0, "ObjectThrower"=1, "Laser"=2,
+        //   "DirectHit"=3, "Thunder"=4, "ScaleObject"=5
+
+        // --- Projectile Objects ---
+        "ThrowObject",               // offset 988 - Projectile object template (string)
+        "ThrowSpeed",                // offset 1008 - Projectile speed (float)
+        "ScaleObject",               // offset 988 - Scale effect object (string)
+        "FlameObject",               // offset 992 - Muzzle flame effect (string, flag at 1024)
+        "LaserObject",               // offset 1004 - Laser beam object (string)
+        "HitObject",                 // offset 996 - Impact effect object (string, flag at 1025)
+        "TraceObject",               // offset 1000 - Bullet trace/trail object (string, DirectHit only)
+
+        // --- Damage & Timing ---
+        "HitDamage",                 // offset 1016 - Damage per hit (float, default 10.0)
+        "LaserBurnTime",             // offset 976 - Laser burn duration, input ms * 1193.182 (int)
+        "LaserWidth",                // offset 980 - Laser beam width (float)
+        "ReloadTime",                // offset 1012 - Time between shots, input ms * 0.001 (float, default 0.25)
+
+        // --- Weapon Flags ---
+        "LockedRotation",            // offset 1032 - Turret cannot rotate (bool)
+        "ImmediateDestruction",      // offset 1033 - Target destroyed immediately on hit (bool)
+
+        // =========================================================================
+        // Runtime/Spawn Settings (sub_4C25D0 console command, sub_44B220 binary)
+        // Settings applied when objects are placed in the world
+        // =========================================================================
+
+        "InitialRotation",           // offset 796 - Initial rotation in radians (float)
+        "InitialScaling",            // offset 800 - Initial scale modifier (float)
+        "CustomValueX",              // offset 608+0 - Custom value X for special objects (float)
+        "CustomValueY",              // offset 608+4 - Custom value Y for special objects (float)
+        "CustomValueZ"               // offset 608+8 - Custom value Z for special objects (float)
+    };
+    return names;
+}
+
+// ============================================================================
+// SETTINGS TABLE
+// ============================================================================
+
+void SettingsTable::clear()
+{
+    m_objects.clear();
+    m_rows.clear();
+    m_columns.clear();
+    m_columnsByName.clear();
+}
+
+void SettingsTable::build(const PackedProject& project, const QStringList& names)
+{
+    clear();
+
+    for (const QString& name : names)
+    {
+        if (!m_columnsByName.contains(name.toLower()))
+        {
+            Column column;
+            column.name = name;
+            m_columnsByName.insert(name.toLower(), m_columns.size());
+            m_columns.append(column);
+        }
+    }
+
+    // Raw values by column and row, typed once all rows are known
+    QHash<uint32, int> columnsById;
+    QVector<QVector<QString>> values(m_columns.size());
+    for (const Object* object : project.objects)
+    {
+        if (object)
+        {
+            addObject(*object, columnsById, values);
+        }
+    }
+
+    int rowCount = m_objects.size();
+    for (int c = 0; c < m_columns.size(); c++)
+    {
+        Column& column = m_columns[c];
+        QVector<QString>& raw = values[c];
+        column.present.resize(rowCount);
+        raw.resize(rowCount);
+
+        bool allInts = true;
+        bool allNumbers = true;
+        for (int row = 0; row < rowCount && allNumbers; row++)
+        {
+            if (!column.present[row])
+            {
+                continue;
+            }
+            bool ok = false;
+            raw[row].toInt(&ok);
+            allInts = allInts && ok;
+            if (!ok)
+            {
+                raw[row].toDouble(&allNumbers);
+            }
+        }
+
+        column.type = allInts ? ColumnType::Int : allNumbers ? ColumnType::Float : ColumnType::String;
+        switch (column.type)
+        {
+        case ColumnType::Int:
+            column.ints.fill(0, rowCount);
+            for (int row = 0; row < rowCount; row++)
+            {
+                if (column.present[row]) column.ints[row] = raw[row].toInt();
+            }
+            break;
+
+        case ColumnType::Float:
+            column.floats.fill(0.0f, rowCount);
+            for (int row = 0; row < rowCount; row++)
+            {
+                if (column.present[row]) column.floats[row] = fp32(raw[row].toDouble());
+            }
+            break;
+
+        case ColumnType::String:
+        {
+            QHash<QString, int> ids;
+            column.stringIds.fill(0, rowCount);
+            for (int row = 0; row < rowCount; row++)
+            {
+                if (!column.present[row])
+                {
+                    continue;
+                }
+                auto it = ids.constFind(raw[row]);
+                if (it == ids.constEnd())
+                {
+                    column.strings.append(raw[row]);
+                    it = ids.insert(raw[row], column.strings.size());
+                }
+                column.stringIds[row] = it.value();
+            }
+            break;
+        }
+        }
+    }
+}
+
+void SettingsTable::addObject(const Object& object, QHash<uint32, int>& columnsById, QVector<QVector<QString>>& values)
+{
+    int row = m_objects.size();
+    m_rows.insert(&object, row);
+    m_objects.append(&object);
+
+    for (const CustomSetting& setting : object.customSettings)
+    {
+        // Empty values count as missing, so they do not turn a number
+        // column into text
+        if (setting.value.isEmpty())
+        {
+            continue;
+        }
+
+        auto it = columnsById.constFind(setting.nameId);
+        if (it == columnsById.constEnd())
+        {
+            int index = m_columnsByName.value(setting.name.toLower(), -1);
+            if (index < 0)
+            {
+                Column column;
+                column.name = setting.name;
+                index = m_columns.size();
+                m_columnsByName.insert(setting.name.toLower(), index);
+                m_columns.append(column);
+                values.append(QVector<QString>());
+            }
+            it = columnsById.insert(setting.nameId, index);
+        }
+
+        Column& column = m_columns[it.value()];
+        if (column.present.size() <= row)
+        {
+            column.present.resize(row + 1);
+            values[it.value()].resize(row + 1);
+        }
+        if (!column.present[row])
+        {
+            column.present[row] = 1;
+            values[it.value()][row] = setting.value;
+        }
+    }
+
+    for (const Object* child : object.children)
+    {
+        if (child)
+        {
+            addObject(*child, columnsById, values);
+        }
+    }
+}
+
+bool SettingsTable::updateObject(const Object& object)
+{
+    int row = rowOf(&object);
+    if (row < 0)
+    {
+        return false;
+    }
+
+    // The first non-empty value per column, as addObject() takes them
+    QVector<const QString*> values(m_columns.size(), nullptr);
+    for (const CustomSetting& setting : object.customSettings)
+    {
+        if (setting.value.isEmpty())
+        {
+            continue;
+        }
+
+        int index = columnIndex(setting.name);
+        if (index < 0)
+        {
+            return false;
+        }
+        if (!values[index])
+        {
+            values[index] = &setting.value;
+        }
+    }
+
+    // Checked before anything is written, a failed update leaves the row as it was
+    for (int c = 0; c < m_columns.size(); c++)
+    {
+        bool ok = true;
+        if (values[c] && m_columns[c].type == ColumnType::Int)
+        {
+            values[c]->toInt(&ok);
+        }
+        else if (values[c] && m_columns[c].type == ColumnType::Float)
+        {
+            values[c]->toDouble(&ok);
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    for (int c = 0; c < m_columns.size(); c++)
+    {
+        Column& column = m_columns[c];
+        const QString* value = values[c];
+        column.present[row] = value ? 1 : 0;
+
+        switch (column.type)
+        {
+        case ColumnType::Int:
+            column.ints[row] = value ? value->toInt() : 0;
+            break;
+
+        case ColumnType::Float:
+            column.floats[row] = value ? fp32(value->toDouble()) : 0.0f;
+            break;
+
+        case ColumnType::String:
+        {
+            // Values no row uses anymore stay in 'strings', they never match a row
+            int id = 0;
+            if (value)
+            {
+                id = column.strings.indexOf(*value) + 1;
+                if (id == 0)
+                {
+                    column.strings.append(*value);
+                    id = column.strings.size();
+                }
+            }
+            column.stringIds[row] = id;
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+bool SettingsTable::evaluate(const QString& query, QVector<quint8>& mask)
+{
+    Query parser(*this, 0, rowCount());
+    if (!parser.evaluate(query, mask))
+    {
+        m_lastError = parser.error();
+        return false;
+    }
+    return true;
+}
+
+bool SettingsTable::evaluateRow(const QString& query, int row, bool& matches)
+{
+    QVector<quint8> mask;
+    Query parser(*this, row, 1);
+    if (!parser.evaluate(query, mask))
+    {
+        m_lastError = parser.error();
+        return false;
+    }
+    matches = mask[0];
+    return true;
+}
+
+bool SettingsTable::select(const QString& query, QVector<const Object*>& objects)
+{
+    QVector<quint8> mask;
+    if (!evaluate(query, mask))
+    {
+        return false;
+    }
+
+    objects.clear();
+    for (int row = 0; row < m_objects.size(); row++)
+    {
+        if (mask[row])
+        {
+            objects.append(m_objects[row]);
+        }
+    }
+    return true;
+}
+
+} // namespace Opf
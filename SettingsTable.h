@@ -0,0 +1,108 @@
+#ifndef SETTINGSTABLE_H
+#define SETTINGSTABLE_H
+
+#include "OpfStructs.h"
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+namespace Opf {
+
+// ============================================================================
+// SETTINGS TABLE - typed columnar view of the objects' custom settings
+// ============================================================================
+//
+// One row per object (children included, depth-first) and one column per
+// setting name. A column is Int if every value in it parses as an integer,
+// Float if every value parses as a number and String otherwise; objects
+// without the setting, or with an empty value, have no value. Repeated
+// settings (CanBuildUnit) keep their first value, as
+// Object::getCustomSetting() does.
+//
+// Queries are evaluated column by column into a byte per row:
+//
+//   MaxHealth > 500 and Cost < 300
+//   Race = "Default" or not (HasWarp or HasTow)
+//   Name ~ tank
+//
+// Comparisons are = (==), !=, <, <=, >, >= and ~ (text contains), text is
+// compared case-insensitively. A setting name on its own matches the rows
+// that have the setting. Combine with and (&&), or (||), not (!) and
+// parentheses. The table is a snapshot: after editing an object's settings
+// call updateObject(), and build it again if that fails.
+
+class SettingsTable
+{
+public:
+    enum class ColumnType
+    {
+        Int,
+        Float,
+        String
+    };
+
+    // Columns for every setting the objects have, plus 'names' so queries
+    // on known settings nobody uses still parse
+    void build(const PackedProject& project, const QStringList& names = QStringList());
+
+    // Every setting name the game reads, in editor order
+    static const QStringList& knownSettingNames();
+    void clear();
+
+    // Reads the object's settings into its row again. False if that needs a
+    // column the table does not have, or a value does not fit its column's
+    // type; the table is unchanged then. Column types are never narrowed, a
+    // text column that now holds only numbers stays text until build().
+    bool updateObject(const Object& object);
+
+    int rowCount() const { return m_objects.size(); }
+    const Object* object(int row) const { return m_objects[row]; }
+    int rowOf(const Object* object) const { return m_rows.value(object, -1); }
+
+    int columnCount() const { return m_columns.size(); }
+    const QString& columnName(int column) const { return m_columns[column].name; }
+    ColumnType columnType(int column) const { return m_columns[column].type; }
+
+    // Case-insensitive, -1 if there is no such column
+    int columnIndex(const QString& name) const { return m_columnsByName.value(name.toLower(), -1); }
+
+    // One byte per row, 1 where the row matches. False with lastError() if
+    // the query does not parse.
+    bool evaluate(const QString& query, QVector<quint8>& mask);
+
+    // The query for one row only, e.g. after updateObject()
+    bool evaluateRow(const QString& query, int row, bool& matches);
+
+    // The matching objects in row order
+    bool select(const QString& query, QVector<const Object*>& objects);
+
+    QString lastError() const { return m_lastError; }
+
+private:
+    struct Column
+    {
+        QString name;
+        ColumnType type = ColumnType::Int;
+        QVector<quint8> present;        // by row
+
+        // By row, for the column's type
+        QVector<qint32> ints;
+        QVector<fp32> floats;
+        QVector<qint32> stringIds;      // 1-based into 'strings', 0 = no value
+        QStringList strings;
+    };
+
+    class Query;
+
+    void addObject(const Object& object, QHash<uint32, int>& columnsById, QVector<QVector<QString>>& values);
+
+    QVector<const Object*> m_objects;
+    QHash<const Object*, int> m_rows;
+    QVector<Column> m_columns;
+    QHash<QString, int> m_columnsByName;    // lowercased name
+    QString m_lastError;
+};
+
+} // namespace Opf
+
+#endif // SETTINGSTABLE_H
@@ -0,0 +1,237 @@
+#include "TextureCache.h"
+#include "TextureDecoder.h"
+#include <QMutexLocker>
+#include <QDebug>
+#include <climits>
+
+namespace Opf {
+
+namespace {
+
+const qint64 kDefaultBudget = 256LL * 1024 * 1024;
+
+// Neighbours are decoded while the user looks at the current texture; two
+// threads keep up with browsing without competing with exports
+const int kPrefetchThreads = 2;
+
+// The key has 14 bits for the scale
+const int kMaxScalePercent = 0x3FFF;
+
+} // namespace
+
+// ============================================================================
+// TEXTURE CACHE
+// ============================================================================
+
+TextureCache& TextureCache::instance()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+TextureCache::TextureCache()
+    : m_generation(0), m_hits(0), m_misses(0)
+{
+    m_prefetchPool.setMaxThreadCount(kPrefetchThreads);
+    setBudget(kDefaultBudget);
+}
+
+TextureCache::~TextureCache()
+{
+    m_prefetchPool.clear();
+    m_prefetchPool.waitForDone();
+}
+
+void TextureCache::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_images.setMaxCost(int(qBound<qint64>(0, bytes / 1024, INT_MAX)));
+}
+
+qint64 TextureCache::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_images.maxCost()) * 1024;
+}
+
+qint64 TextureCache::totalBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_images.totalCost()) * 1024;
+}
+
+TextureCache::Key TextureCache::keyFor(const Texture& texture, Variant variant, int scalePercent)
+{
+    // Without an alpha channel the merged image is the color image
+    if (variant == Variant::Merged && !texture.hasAlphaChannel)
+    {
+        variant = Variant::Color;
+    }
+
+    return (quint64(texture.projectID) << 48) | (quint64(quint32(texture.id)) << 16) |
+           (quint64(variant) << 14) | quint64(scalePercent & kMaxScalePercent);
+}
+
+QImage TextureCache::decode(const Texture& texture, Variant variant)
+{
+    switch (variant)
+    {
+    case Variant::Color:  return TextureDecoder::decodeColor(texture);
+    case Variant::Alpha:  return TextureDecoder::decodeAlpha(texture);
+    case Variant::Merged: return TextureDecoder::decode(texture);
+    }
+    return QImage();
+}
+
+QImage TextureCache::cachedImage(Key key)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // object() also marks the entry as most recently used
+    QImage* cached = m_images.object(key);
+    return cached ? *cached : QImage();
+}
+
+void TextureCache::insert(const Key& key, const QImage& image, quint64 generation)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Decoded from a project that has been closed since
+    if (generation != m_generation)
+    {
+        return;
+    }
+
+    int cost = int(qBound<qint64>(1, image.sizeInBytes() / 1024, INT_MAX));
+    m_images.insert(key, new QImage(image), cost);
+}
+
+bool TextureCache::contains(const Texture& texture, Variant variant, int scalePercent) const
+{
+    scalePercent = qBound(1, scalePercent, kMaxScalePercent);
+    QMutexLocker locker(&m_mutex);
+    return m_images.contains(keyFor(texture, variant, scalePercent));
+}
+
+QImage TextureCache::image(const Texture& texture, Variant variant, int scalePercent)
+{
+    scalePercent = qBound(1, scalePercent, kMaxScalePercent);
+    Key key = keyFor(texture, variant, scalePercent);
+
+    quint64 generation;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (QImage* cached = m_images.object(key))
+        {
+            m_hits++;
+            return *cached;
+        }
+        generation = m_generation;
+    }
+    m_misses++;
+
+    QImage result;
+    if (scalePercent != 100)
+    {
+        QImage full = image(texture, variant, 100);
+        if (!full.isNull())
+        {
+            int width = qMax(1, full.width() * scalePercent / 100);
+            int height = qMax(1, full.height() * scalePercent / 100);
+            result = full.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+    }
+    else
+    {
+        // Both channels may be cached separately, e.g. after the preview
+        // showed color and alpha
+        if (variant == Variant::Merged && texture.hasAlphaChannel)
+        {
+            QImage color = cachedImage(keyFor(texture, Variant::Color, 100));
+            QImage alpha = color.isNull() ? QImage() : cachedImage(keyFor(texture, Variant::Alpha, 100));
+            if (!alpha.isNull())
+            {
+                result = TextureDecoder::mergeAlpha(color, alpha);
+            }
+        }
+
+        if (result.isNull())
+        {
+            // Payloads fetched just for this decode are dropped again afterwards
+            TexturePayloadScope payload(texture);
+            if (!payload.isLoaded())
+            {
+                qWarning() << "Failed to read texture data:" << texture.name;
+                return QImage();
+            }
+            result = decode(texture, variant);
+        }
+    }
+
+    if (!result.isNull())
+    {
+        insert(key, result, generation);
+    }
+    return result;
+}
+
+void TextureCache::prefetch(const QVector<const Texture*>& textures, Variant variant)
+{
+    for (const Texture* texture : textures)
+    {
+        if (!texture || !texture->hasColorData())
+        {
+            continue;
+        }
+
+        Key key = keyFor(*texture, variant, 100);
+        quint64 generation;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_images.contains(key) || m_pending.contains(key))
+            {
+                continue;
+            }
+            m_pending.insert(key);
+            generation = m_generation;
+        }
+
+        // The copy shares the payload buffers and data source, but reads
+        // into its own members, so the GUI thread can keep using the original.
+        // Export jobs may be loading the original's payloads meanwhile.
+        Texture copy;
+        {
+            QMutexLocker locker(&texturePayloadMutex(texture));
+            copy = *texture;
+        }
+        m_prefetchPool.start([this, copy, variant, key, generation]() {
+            QImage image;
+            if (copy.ensureBitmapData())
+            {
+                image = decode(copy, variant);
+            }
+
+            {
+                QMutexLocker locker(&m_mutex);
+                m_pending.remove(key);
+            }
+
+            if (!image.isNull())
+            {
+                insert(key, image, generation);
+            }
+        });
+    }
+}
+
+void TextureCache::clear()
+{
+    m_prefetchPool.clear();
+
+    QMutexLocker locker(&m_mutex);
+    m_images.clear();
+    m_pending.clear();
+    m_generation++;
+}
+
+} // namespace Opf
@@ -0,0 +1,88 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include "OpfStructs.h"
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <atomic>
+
+namespace Opf {
+
+// ============================================================================
+// TEXTURE CACHE - decoded texture images, shared by preview and export
+// ============================================================================
+//
+// Process-wide LRU cache of TextureDecoder output, keyed by texture and
+// variant, limited to a byte budget. Safe to use from any thread; decoding
+// happens outside the lock, so workers that miss decode in parallel.
+// Entries are only identified by project and texture id, so the cache must
+// be cleared whenever a different project is loaded.
+
+class TextureCache
+{
+public:
+    enum class Variant
+    {
+        Color,      // color channel only
+        Alpha,      // alpha channel as grayscale
+        Merged      // color with alpha merged in
+    };
+
+    static TextureCache& instance();
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+
+    // The decoded image, from the cache or decoded (and cached) now.
+    // Lazily loaded payloads are read for the decode and released again.
+    // 'scalePercent' other than 100 caches a smoothly scaled copy; it is
+    // clamped to 1..16383.
+    QImage image(const Texture& texture, Variant variant, int scalePercent = 100);
+
+    bool contains(const Texture& texture, Variant variant, int scalePercent = 100) const;
+
+    // Decodes textures that are not cached yet on a background thread.
+    // The textures are copied, so they may be released or destroyed before
+    // the work is done.
+    void prefetch(const QVector<const Texture*>& textures, Variant variant);
+
+    // Drops all entries and discards prefetches still running
+    void clear();
+
+    qint64 totalBytes() const;
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+
+private:
+    TextureCache();
+    ~TextureCache();
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Project id, texture id, variant and scale packed into one integer
+    typedef quint64 Key;
+
+    static Key keyFor(const Texture& texture, Variant variant, int scalePercent);
+    static QImage decode(const Texture& texture, Variant variant);
+
+    QImage cachedImage(Key key);
+    void insert(const Key& key, const QImage& image, quint64 generation);
+
+    // Costs are in KB so that large budgets fit QCache's int costs
+    QCache<Key, QImage> m_images;
+    mutable QMutex m_mutex;
+    QSet<Key> m_pending;
+    quint64 m_generation;
+
+    QThreadPool m_prefetchPool;
+
+    std::atomic<quint64> m_hits;
+    std::atomic<quint64> m_misses;
+};
+
+} // namespace Opf
+
+#endif // TEXTURECACHE_H
@@ -0,0 +1,630 @@
+#include "TextureDecoder.h"
+#include <QDebug>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define OPF_TEXTURE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(OPF_TEXTURE_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#define OPF_TEXTURE_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 instructions in functions marked for it;
+// MSVC accepts the intrinsics anywhere
+#if defined(__GNUC__)
+#define OPF_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define OPF_TARGET_AVX2
+#endif
+
+namespace Opf {
+
+namespace TextureDecoder {
+
+namespace {
+
+// ============================================================================
+// SCALAR KERNELS
+// ============================================================================
+
+void rgb565ToRgb888Scalar(const quint16* src, uchar* dst, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        quint16 pixel = src[i];
+        dst[0] = uchar(((pixel >> 11) & 0x1F) << 3);
+        dst[1] = uchar(((pixel >> 5) & 0x3F) << 2);
+        dst[2] = uchar((pixel & 0x1F) << 3);
+        dst += 3;
+    }
+}
+
+void rgb565ToRgba8888Scalar(const quint16* src, uchar* dst, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        quint16 pixel = src[i];
+        dst[0] = uchar(((pixel >> 11) & 0x1F) << 3);
+        dst[1] = uchar(((pixel >> 5) & 0x3F) << 2);
+        dst[2] = uchar((pixel & 0x1F) << 3);
+        dst[3] = 0xFF;
+        dst += 4;
+    }
+}
+
+void gray16ToGray8Scalar(const quint16* src, uchar* dst, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        dst[i] = uchar(src[i] >> 8);
+    }
+}
+
+void setAlphaScalar(uchar* rgba, const uchar* alpha, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        rgba[i * 4 + 3] = alpha[i];
+    }
+}
+
+void rgb888AlphaToRgba8888Scalar(const uchar* rgb, const uchar* alpha, uchar* dst, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        dst[0] = rgb[0];
+        dst[1] = rgb[1];
+        dst[2] = rgb[2];
+        dst[3] = alpha[i];
+        rgb += 3;
+        dst += 4;
+    }
+}
+
+// ============================================================================
+// SSE2 KERNELS
+// ============================================================================
+
+#ifdef OPF_TEXTURE_SSE2
+
+// Eight 5:6:5 pixels to eight R,G,B,255 pixels in 'lo' (0-3) and 'hi' (4-7)
+inline void expandRgb565Sse2(__m128i pixels, __m128i& lo, __m128i& hi)
+{
+    const __m128i r = _mm_slli_epi16(_mm_srli_epi16(pixels, 11), 3);
+    const __m128i g = _mm_and_si128(_mm_srli_epi16(pixels, 3), _mm_set1_epi16(0xFC));
+    const __m128i b = _mm_and_si128(_mm_slli_epi16(pixels, 3), _mm_set1_epi16(0xF8));
+
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, _mm_set1_epi16(short(0xFF00)));
+
+    lo = _mm_unpacklo_epi16(rg, ba);
+    hi = _mm_unpackhi_epi16(rg, ba);
+}
+
+void rgb565ToRgba8888Sse2(const quint16* src, uchar* dst, int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i lo, hi;
+        expandRgb565Sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), lo, hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), hi);
+    }
+    rgb565ToRgba8888Scalar(src + i, dst + i * 4, count - i);
+}
+
+// SSE2 has no byte shuffle, so the 4-to-3 byte packing is done from a
+// stack buffer; the channel arithmetic is still eight pixels at a time
+void rgb565ToRgb888Sse2(const quint16* src, uchar* dst, int count)
+{
+    alignas(16) uchar rgba[32];
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i lo, hi;
+        expandRgb565Sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), lo, hi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(rgba), lo);
+        _mm_store_si128(reinterpret_cast<__m128i*>(rgba + 16), hi);
+
+        uchar* out = dst + i * 3;
+        for (int j = 0; j < 8; j++)
+        {
+            out[j * 3 + 0] = rgba[j * 4 + 0];
+            out[j * 3 + 1] = rgba[j * 4 + 1];
+            out[j * 3 + 2] = rgba[j * 4 + 2];
+        }
+    }
+    rgb565ToRgb888Scalar(src + i, dst + i * 3, count - i);
+}
+
+void gray16ToGray8Sse2(const quint16* src, uchar* dst, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i a = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), 8);
+        const __m128i b = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+    }
+    gray16ToGray8Scalar(src + i, dst + i, count - i);
+}
+
+void setAlphaSse2(uchar* rgba, const uchar* alpha, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        // Alpha bytes moved to the top byte of each 32-bit pixel
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + i));
+        const __m128i a16lo = _mm_unpacklo_epi8(zero, a);
+        const __m128i a16hi = _mm_unpackhi_epi8(zero, a);
+        const __m128i a32[4] = {
+            _mm_unpacklo_epi16(zero, a16lo), _mm_unpackhi_epi16(zero, a16lo),
+            _mm_unpacklo_epi16(zero, a16hi), _mm_unpackhi_epi16(zero, a16hi)
+        };
+
+        for (int k = 0; k < 4; k++)
+        {
+            __m128i* p = reinterpret_cast<__m128i*>(rgba + (i + k * 4) * 4);
+            _mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(_mm_loadu_si128(p), colorMask), a32[k]));
+        }
+    }
+    setAlphaScalar(rgba + i * 4, alpha + i, count - i);
+}
+
+#endif // OPF_TEXTURE_SSE2
+
+// ============================================================================
+// AVX2 KERNELS
+// ============================================================================
+
+#ifdef OPF_TEXTURE_AVX2
+
+// Sixteen 5:6:5 pixels to R,G,B,255; 'lo' holds pixels 0-3 and 8-11, 'hi'
+// pixels 4-7 and 12-15 (unpacking works within 128-bit lanes)
+OPF_TARGET_AVX2 inline void expandRgb565Avx2(__m256i pixels, __m256i& lo, __m256i& hi)
+{
+    const __m256i r = _mm256_slli_epi16(_mm256_srli_epi16(pixels, 11), 3);
+    const __m256i g = _mm256_and_si256(_mm256_srli_epi16(pixels, 3), _mm256_set1_epi16(0xFC));
+    const __m256i b = _mm256_and_si256(_mm256_slli_epi16(pixels, 3), _mm256_set1_epi16(0xF8));
+
+    const __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+    const __m256i ba = _mm256_or_si256(b, _mm256_set1_epi16(short(0xFF00)));
+
+    lo = _mm256_unpacklo_epi16(rg, ba);
+    hi = _mm256_unpackhi_epi16(rg, ba);
+}
+
+OPF_TARGET_AVX2 void rgb565ToRgba8888Avx2(const quint16* src, uchar* dst, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i lo, hi;
+        expandRgb565Avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), lo, hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    rgb565ToRgba8888Scalar(src + i, dst + i * 4, count - i);
+}
+
+OPF_TARGET_AVX2 void rgb565ToRgb888Avx2(const quint16* src, uchar* dst, int count)
+{
+    // R,G,B,A x4 to R,G,B x4 in the low 12 bytes of each lane
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i lo, hi;
+        expandRgb565Avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), lo, hi);
+        lo = _mm256_shuffle_epi8(lo, pack);
+        hi = _mm256_shuffle_epi8(hi, pack);
+
+        // Each store writes 4 bytes past its 12, which the next one
+        // overwrites; the last one writes exactly 12
+        uchar* out = dst + i * 3;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm256_castsi256_si128(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 24), _mm256_extracti128_si256(lo, 1));
+
+        const __m128i last = _mm256_extracti128_si256(hi, 1);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 36), last);
+        const int tail = _mm_cvtsi128_si32(_mm_srli_si128(last, 8));
+        memcpy(out + 44, &tail, sizeof(tail));
+    }
+    rgb565ToRgb888Scalar(src + i, dst + i * 3, count - i);
+}
+
+OPF_TARGET_AVX2 void gray16ToGray8Avx2(const quint16* src, uchar* dst, int count)
+{
+    int i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const __m256i a = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), 8);
+        const __m256i b = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16)), 8);
+
+        // packus interleaves the lanes of a and b; restore pixel order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+    }
+    gray16ToGray8Scalar(src + i, dst + i, count - i);
+}
+
+OPF_TARGET_AVX2 void setAlphaAvx2(uchar* rgba, const uchar* alpha, int count)
+{
+    const __m256i colorMask = _mm256_set1_epi32(0x00FFFFFF);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i a = _mm256_slli_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(alpha + i))), 24);
+        __m256i* p = reinterpret_cast<__m256i*>(rgba + i * 4);
+        _mm256_storeu_si256(p, _mm256_or_si256(_mm256_and_si256(_mm256_loadu_si256(p), colorMask), a));
+    }
+    setAlphaScalar(rgba + i * 4, alpha + i, count - i);
+}
+
+OPF_TARGET_AVX2 void rgb888AlphaToRgba8888Avx2(const uchar* rgb, const uchar* alpha, uchar* dst, int count)
+{
+    // R,G,B x4 to R,G,B,0 x4
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+    // Each iteration reads 16 bytes for 12, so stop while 4 more remain
+    int i = 0;
+    for (; i + 6 <= count; i += 4)
+    {
+        const __m128i color = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3)), spread);
+
+        int alphaBytes;
+        memcpy(&alphaBytes, alpha + i, sizeof(alphaBytes));
+        const __m128i a = _mm_slli_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(alphaBytes)), 24);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(color, a));
+    }
+    rgb888AlphaToRgba8888Scalar(rgb + i * 3, alpha + i, dst + i * 4, count - i);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    if (!osSavesYmm)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+}
+
+#endif // OPF_TEXTURE_AVX2
+
+const RowKernels kScalarKernels = {
+    rgb565ToRgb888Scalar,
+    rgb565ToRgba8888Scalar,
+    gray16ToGray8Scalar,
+    setAlphaScalar,
+    rgb888AlphaToRgba8888Scalar
+};
+
+#ifdef OPF_TEXTURE_SSE2
+const RowKernels kSse2Kernels = {
+    rgb565ToRgb888Sse2,
+    rgb565ToRgba8888Sse2,
+    gray16ToGray8Sse2,
+    setAlphaSse2,
+    rgb888AlphaToRgba8888Scalar     // needs a byte shuffle (SSSE3)
+};
+#endif
+
+#ifdef OPF_TEXTURE_AVX2
+const RowKernels kAvx2Kernels = {
+    rgb565ToRgb888Avx2,
+    rgb565ToRgba8888Avx2,
+    gray16ToGray8Avx2,
+    setAlphaAvx2,
+    rgb888AlphaToRgba8888Avx2
+};
+#endif
+
+InstructionSet detectInstructionSet()
+{
+#ifdef OPF_TEXTURE_AVX2
+    if (cpuHasAvx2())
+    {
+        return InstructionSet::AVX2;
+    }
+#endif
+#ifdef OPF_TEXTURE_SSE2
+    return InstructionSet::SSE2;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+bool hasPayload(const QByteArray& data, int width, int height, int bytesPerPixel)
+{
+    return width > 0 && height > 0 && qint64(data.size()) >= qint64(width) * height * bytesPerPixel;
+}
+
+const uchar* payloadRow(const QByteArray& data, int width, int bytesPerPixel, int y)
+{
+    return reinterpret_cast<const uchar*>(data.constData()) + qint64(y) * width * bytesPerPixel;
+}
+
+} // namespace
+
+// ============================================================================
+// KERNEL SELECTION
+// ============================================================================
+
+bool isSupported(InstructionSet isa)
+{
+    switch (isa)
+    {
+    case InstructionSet::Scalar:
+        return true;
+    case InstructionSet::SSE2:
+#ifdef OPF_TEXTURE_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case InstructionSet::AVX2:
+#ifdef OPF_TEXTURE_AVX2
+        return activeInstructionSet() == InstructionSet::AVX2;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const char* instructionSetName(InstructionSet isa)
+{
+    switch (isa)
+    {
+    case InstructionSet::Scalar: return "scalar";
+    case InstructionSet::SSE2:   return "SSE2";
+    case InstructionSet::AVX2:   return "AVX2";
+    }
+    return "unknown";
+}
+
+InstructionSet activeInstructionSet()
+{
+    static const InstructionSet isa = detectInstructionSet();
+    return isa;
+}
+
+const RowKernels& kernels(InstructionSet isa)
+{
+    if (!isSupported(isa))
+    {
+        return kScalarKernels;
+    }
+
+    switch (isa)
+    {
+#ifdef OPF_TEXTURE_AVX2
+    case InstructionSet::AVX2:
+        return kAvx2Kernels;
+#endif
+#ifdef OPF_TEXTURE_SSE2
+    case InstructionSet::SSE2:
+        return kSse2Kernels;
+#endif
+    default:
+        return kScalarKernels;
+    }
+}
+
+const RowKernels& kernels()
+{
+    return kernels(activeInstructionSet());
+}
+
+// ============================================================================
+// DECODING
+// ============================================================================
+
+QImage decodeColor(const Texture& texture)
+{
+    QImage image;
+
+    if (texture.colorBitmapType != 0)
+    {
+        image.loadFromData(texture.colorData, "JPEG");
+        if (image.isNull())
+        {
+            qWarning() << "Failed to decode JPEG:" << texture.name;
+        }
+        return image;
+    }
+
+    int width = int(texture.width);
+    int height = int(texture.height);
+    int bytesPerPixel = texture.colorBitsPerPixel / 8;
+
+    if (texture.colorBitsPerPixel != 16 && texture.colorBitsPerPixel != 24 && texture.colorBitsPerPixel != 32)
+    {
+        qWarning() << "Unsupported bit depth:" << texture.colorBitsPerPixel;
+        return image;
+    }
+
+    if (!hasPayload(texture.colorData, width, height, bytesPerPixel))
+    {
+        qWarning() << "Texture" << texture.name << "has less color data than its size needs";
+        return image;
+    }
+
+    image = QImage(width, height, texture.colorBitsPerPixel == 32 ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+    if (image.isNull())
+    {
+        return image;
+    }
+
+    const RowKernels& k = kernels();
+    for (int y = 0; y < height; y++)
+    {
+        const uchar* src = payloadRow(texture.colorData, width, bytesPerPixel, y);
+        if (texture.colorBitsPerPixel == 16)
+        {
+            k.rgb565ToRgb888(reinterpret_cast<const quint16*>(src), image.scanLine(y), width);
+        }
+        else
+        {
+            memcpy(image.scanLine(y), src, size_t(width) * bytesPerPixel);
+        }
+    }
+
+    return image;
+}
+
+QImage decodeAlpha(const Texture& texture)
+{
+    QImage image;
+
+    if (!texture.hasAlphaChannel || texture.alphaData.isEmpty())
+    {
+        return image;
+    }
+
+    if (texture.alphaBitmapType != 0)
+    {
+        image.loadFromData(texture.alphaData, "JPEG");
+        if (image.isNull() || image.format() == QImage::Format_Grayscale8)
+        {
+            return image;
+        }
+
+        // Color JPEG: alpha is the gray level of each pixel
+        QImage rgb = image.convertToFormat(QImage::Format_RGB32);
+        image = QImage(rgb.size(), QImage::Format_Grayscale8);
+        for (int y = 0; y < rgb.height(); y++)
+        {
+            const QRgb* src = reinterpret_cast<const QRgb*>(rgb.constScanLine(y));
+            uchar* dst = image.scanLine(y);
+            for (int x = 0; x < rgb.width(); x++)
+            {
+                dst[x] = uchar(qGray(src[x]));
+            }
+        }
+        return image;
+    }
+
+    int width = int(texture.width);
+    int height = int(texture.height);
+    int bytesPerPixel = texture.alphaBitsPerPixel / 8;
+
+    if ((texture.alphaBitsPerPixel != 8 && texture.alphaBitsPerPixel != 16) ||
+        !hasPayload(texture.alphaData, width, height, bytesPerPixel))
+    {
+        return image;
+    }
+
+    image = QImage(width, height, QImage::Format_Grayscale8);
+    if (image.isNull())
+    {
+        return image;
+    }
+
+    const RowKernels& k = kernels();
+    for (int y = 0; y < height; y++)
+    {
+        const uchar* src = payloadRow(texture.alphaData, width, bytesPerPixel, y);
+        if (texture.alphaBitsPerPixel == 16)
+        {
+            k.gray16ToGray8(reinterpret_cast<const quint16*>(src), image.scanLine(y), width);
+        }
+        else
+        {
+            memcpy(image.scanLine(y), src, size_t(width));
+        }
+    }
+
+    return image;
+}
+
+QImage decode(const Texture& texture)
+{
+    QImage alpha = decodeAlpha(texture);
+    if (alpha.isNull())
+    {
+        return decodeColor(texture);
+    }
+
+    const RowKernels& k = kernels();
+    int width = int(texture.width);
+    int height = int(texture.height);
+    int bitsPerPixel = texture.colorBitsPerPixel;
+
+    // Common case: raw 16/24-bit color and a matching alpha plane are
+    // combined in one pass
+    if (texture.colorBitmapType == 0 && (bitsPerPixel == 16 || bitsPerPixel == 24) &&
+        alpha.width() == width && alpha.height() == height &&
+        hasPayload(texture.colorData, width, height, bitsPerPixel / 8))
+    {
+        QImage image(width, height, QImage::Format_RGBA8888);
+        for (int y = 0; y < height; y++)
+        {
+            const uchar* src = payloadRow(texture.colorData, width, bitsPerPixel / 8, y);
+            uchar* dst = image.scanLine(y);
+            if (bitsPerPixel == 16)
+            {
+                k.rgb565ToRgba8888(reinterpret_cast<const quint16*>(src), dst, width);
+                k.setAlpha(dst, alpha.constScanLine(y), width);
+            }
+            else
+            {
+                k.rgb888AlphaToRgba8888(src, alpha.constScanLine(y), dst, width);
+            }
+        }
+        return image;
+    }
+
+    return mergeAlpha(decodeColor(texture), alpha);
+}
+
+QImage mergeAlpha(const QImage& color, const QImage& alpha)
+{
+    if (color.isNull() || alpha.isNull() || alpha.format() != QImage::Format_Grayscale8)
+    {
+        return color;
+    }
+
+    QImage image = color.convertToFormat(QImage::Format_RGBA8888);
+
+    // Pixels outside the alpha plane stay opaque
+    const RowKernels& k = kernels();
+    int rows = qMin(image.height(), alpha.height());
+    int columns = qMin(image.width(), alpha.width());
+    for (int y = 0; y < rows; y++)
+    {
+        k.setAlpha(image.scanLine(y), alpha.constScanLine(y), columns);
+    }
+
+    return image;
+}
+
+} // namespace TextureDecoder
+
+} // namespace Opf
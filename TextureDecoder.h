@@ -0,0 +1,67 @@
+#ifndef TEXTUREDECODER_H
+#define TEXTUREDECODER_H
+
+#include "OpfStructs.h"
+#include <QImage>
+
+namespace Opf {
+
+// ============================================================================
+// TEXTURE DECODER - texture payloads to QImage
+// ============================================================================
+//
+// Raw bitmaps are converted a scanline at a time by the row kernels below,
+// writing straight into QImage::scanLine(). Each kernel has a scalar
+// version and SSE2 / AVX2 versions; the fastest one the CPU supports is
+// picked on first use. All versions produce identical output.
+
+namespace TextureDecoder {
+
+enum class InstructionSet { Scalar, SSE2, AVX2 };
+
+struct RowKernels
+{
+    // 5:6:5 pixels to R,G,B bytes / R,G,B,255 bytes
+    void (*rgb565ToRgb888)(const quint16* src, uchar* dst, int count);
+    void (*rgb565ToRgba8888)(const quint16* src, uchar* dst, int count);
+
+    // 16-bit gray to 8-bit (high byte)
+    void (*gray16ToGray8)(const quint16* src, uchar* dst, int count);
+
+    // Replaces the A byte of R,G,B,A pixels with 'alpha'
+    void (*setAlpha)(uchar* rgba, const uchar* alpha, int count);
+
+    // R,G,B bytes plus a separate alpha plane to R,G,B,A bytes
+    void (*rgb888AlphaToRgba8888)(const uchar* rgb, const uchar* alpha, uchar* dst, int count);
+};
+
+// Kernels of 'isa', or the scalar ones if it is not available here
+const RowKernels& kernels(InstructionSet isa);
+
+// Kernels used by the decode functions
+const RowKernels& kernels();
+InstructionSet activeInstructionSet();
+bool isSupported(InstructionSet isa);
+const char* instructionSetName(InstructionSet isa);
+
+// The texture's payloads must be loaded (see TexturePayloadScope).
+// All return a null image if the data cannot be decoded.
+
+// Color channel only
+QImage decodeColor(const Texture& texture);
+
+// Alpha channel as Format_Grayscale8
+QImage decodeAlpha(const Texture& texture);
+
+// Color with the alpha channel merged in, if the texture has one
+QImage decode(const Texture& texture);
+
+// 'color' as Format_RGBA8888 with 'alpha' (Format_Grayscale8) as its alpha
+// channel. Pixels outside the alpha image stay opaque.
+QImage mergeAlpha(const QImage& color, const QImage& alpha);
+
+} // namespace TextureDecoder
+
+} // namespace Opf
+
+#endif // TEXTUREDECODER_H
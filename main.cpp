@@ -1,9 +1,22 @@
 #include "ui/MainWindow.h"
+#include "CommandLine.h"
 #include <QApplication>
+#include <QCoreApplication>
 #include <QStyleFactory>
 
 int main(int argc, char *argv[])
 {
+    // Batch commands run without widgets, so they also work without a display
+    if (Opf::CommandLine::isRequested(argc, argv))
+    {
+        QCoreApplication app(argc, argv);
+        app.setApplicationName("The Outforce - UnitDeveloper Tool.");
+        app.setApplicationVersion("2.0.0");
+        app.setOrganizationName("OutforceModding");
+
+        return Opf::CommandLine().run(app.arguments());
+    }
+
     QApplication app(argc, argv);
 
     app.setApplicationName("The Outforce - UnitDeveloper Tool.");